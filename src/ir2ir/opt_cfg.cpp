@@ -0,0 +1,171 @@
+#include "opt_cfg.h"
+#include <algorithm>
+
+namespace opt {
+
+CFG::CFG(koopa_raw_function_t func) {
+  entry = SliceAt<BB>(func->bbs, 0);
+  CalcRPO();
+  for (BB bb : rpo) {
+    succs[bb] = GetSuccessors(bb);
+    preds[bb];
+  }
+  for (BB bb : rpo) {
+    for (BB succ : succs[bb]) {
+      preds[succ].push_back(bb);
+    }
+  }
+  CalcDominators();
+  CalcDomFrontier();
+}
+
+bool CFG::IsReachable(BB bb) const {
+  return order.find(bb) != order.end();
+}
+
+bool CFG::Dominates(BB a, BB b) const {
+  if (!IsReachable(a) || !IsReachable(b))
+    return false;
+  // 沿着支配树往上走，rpo序号只会变小
+  int target = order.at(a);
+  while (order.at(b) > target) {
+    b = idom.at(b);
+  }
+  return a == b;
+}
+
+void CFG::CalcRPO() {
+  set<BB> visited = {entry};
+  vector<pair<BB, vector<BB>>> stack;
+  stack.emplace_back(entry, GetSuccessors(entry));
+  while (!stack.empty()) {
+    auto& top = stack.back();
+    if (!top.second.empty()) {
+      BB succ = top.second.back();
+      top.second.pop_back();
+      if (visited.insert(succ).second) {
+        stack.emplace_back(succ, GetSuccessors(succ));
+      }
+    } else {
+      rpo.push_back(top.first);
+      stack.pop_back();
+    }
+  }
+  std::reverse(rpo.begin(), rpo.end());
+  for (size_t i = 0; i < rpo.size(); ++i) {
+    order[rpo[i]] = i;
+  }
+}
+
+void CFG::CalcDominators() {
+  // Cooper, Harvey, Kennedy. A Simple, Fast Dominance Algorithm
+  idom[entry] = entry;
+  auto intersect = [&](BB a, BB b) {
+    while (a != b) {
+      while (order[a] > order[b])
+        a = idom[a];
+      while (order[b] > order[a])
+        b = idom[b];
+    }
+    return a;
+  };
+
+  bool changed = true;
+  while (changed) {
+    changed = false;
+    for (size_t i = 1; i < rpo.size(); ++i) {
+      BB bb = rpo[i];
+      BB new_idom = nullptr;
+      for (BB pred : preds[bb]) {
+        if (idom.find(pred) == idom.end())
+          continue;
+        new_idom = new_idom == nullptr ? pred : intersect(pred, new_idom);
+      }
+      if (idom[bb] != new_idom) {
+        idom[bb] = new_idom;
+        changed = true;
+      }
+    }
+  }
+
+  for (size_t i = 1; i < rpo.size(); ++i) {
+    dom_children[idom[rpo[i]]].push_back(rpo[i]);
+  }
+}
+
+void CFG::CalcDomFrontier() {
+  for (BB bb : rpo) {
+    dom_frontier[bb];
+    if (preds[bb].size() < 2)
+      continue;
+    for (BB pred : preds[bb]) {
+      BB runner = pred;
+      while (runner != idom[bb]) {
+        dom_frontier[runner].insert(bb);
+        runner = idom[runner];
+      }
+    }
+  }
+}
+
+bool RemoveUnreachableBlocks(koopa_raw_function_t func) {
+  if (func->bbs.len == 0)
+    return false;
+  CFG cfg(func);
+  if (cfg.rpo.size() == func->bbs.len)
+    return false;
+
+  // 原地压缩，保持原来的顺序
+  auto& bbs = Mutable(func)->bbs;
+  size_t len = 0;
+  for (size_t i = 0; i < bbs.len; ++i) {
+    if (cfg.IsReachable(SliceAt<BB>(bbs, i)))
+      bbs.buffer[len++] = bbs.buffer[i];
+  }
+  bbs.len = len;
+  return true;
+}
+
+// 按目标基本块原来的参数，原地删掉对应的实参
+static void EraseArgs(BB target,
+                      koopa_raw_slice_t& args,
+                      const set<koopa_raw_value_t>& params) {
+  size_t len = 0;
+  for (size_t i = 0; i < args.len; ++i) {
+    if (!params.count(SliceAt<koopa_raw_value_t>(target->params, i)))
+      args.buffer[len++] = args.buffer[i];
+  }
+  args.len = len;
+}
+
+void EraseBlockParams(koopa_raw_function_t func,
+                      const set<koopa_raw_value_t>& params) {
+  if (params.empty())
+    return;
+  // 先改实参，要用到原来的参数列表
+  for (size_t i = 0; i < func->bbs.len; ++i) {
+    RawValue term = Mutable(GetTerminator(SliceAt<BB>(func->bbs, i)));
+    if (term->kind.tag == KOOPA_RVT_JUMP) {
+      auto& jump = term->kind.data.jump;
+      EraseArgs(jump.target, jump.args, params);
+    } else if (term->kind.tag == KOOPA_RVT_BRANCH) {
+      auto& branch = term->kind.data.branch;
+      EraseArgs(branch.true_bb, branch.true_args, params);
+      EraseArgs(branch.false_bb, branch.false_args, params);
+    }
+  }
+  for (size_t i = 0; i < func->bbs.len; ++i) {
+    auto& bb_params = Mutable(SliceAt<BB>(func->bbs, i))->params;
+    size_t len = 0;
+    for (size_t j = 0; j < bb_params.len; ++j) {
+      auto param = SliceAt<koopa_raw_value_t>(bb_params, j);
+      if (params.count(param))
+        continue;
+      Mutable(param)->kind.data.block_arg_ref.index = len;
+      bb_params.buffer[len++] = param;
+    }
+    bb_params.len = len;
+  }
+}
+
+}  // namespace opt
@@ -0,0 +1,54 @@
+#pragma once
+
+#include <map>
+#include <set>
+#include <utility>
+#include <vector>
+#include "opt_util.h"
+
+namespace opt {
+
+using std::map, std::set, std::pair;
+
+typedef koopa_raw_basic_block_t BB;
+
+// 函数的控制流图和支配树，只包含从入口可达的基本块
+// 修改了基本块或跳转之后需要重新构造
+class CFG {
+ public:
+  CFG(koopa_raw_function_t func);
+
+  // 入口
+  BB entry;
+  // 逆后序排列的基本块，入口在最前
+  vector<BB> rpo;
+  map<BB, vector<BB>> preds;
+  map<BB, vector<BB>> succs;
+  // 直接支配者，入口的是自己
+  map<BB, BB> idom;
+  // 支配树上的孩子
+  map<BB, vector<BB>> dom_children;
+  // 支配边界
+  map<BB, set<BB>> dom_frontier;
+
+  bool IsReachable(BB bb) const;
+  // a是否支配b
+  bool Dominates(BB a, BB b) const;
+
+ private:
+  // 基本块在rpo中的位置
+  map<BB, int> order;
+
+  void CalcRPO();
+  void CalcDominators();
+  void CalcDomFrontier();
+};
+
+// 删掉从入口不可达的基本块，有删除时返回true
+bool RemoveUnreachableBlocks(koopa_raw_function_t func);
+// 删掉基本块参数，以及所有跳转中对应位置的实参
+// 参数必须已经没有使用，剩下的参数重新编号
+void EraseBlockParams(koopa_raw_function_t func,
+                      const set<koopa_raw_value_t>& params);
+
+}  // namespace opt
@@ -0,0 +1,34 @@
+#include "opt_ir2ir.h"
+#include "sysy2ir/ir_gen.h"
+
+namespace opt {
+
+void BuildPipeline(PassManager& manager, const int& opt_level) {
+  auto& raw = ir::IRGenerator::getInstance().rawCore;
+  if (opt_level >= 1) {
+    manager.AddPass(std::make_unique<Mem2Reg>(raw));
+    manager.AddPass(std::make_unique<TailRecursionElim>(raw));
+    // 被调用者先提升好局部变量，估计的大小才准
+    if (opt_level >= 2)
+      manager.AddPass(std::make_unique<Inliner>(raw));
+    manager.AddPass(std::make_unique<SCCP>(raw));
+    manager.AddPass(std::make_unique<LICM>(raw));
+    manager.AddPass(std::make_unique<IVStrengthReduce>(raw));
+    manager.AddPass(std::make_unique<GVN>());
+    manager.AddPass(std::make_unique<DCE>());
+    manager.AddPass(std::make_unique<SimplifyCFG>(raw));
+    manager.AddPass(std::make_unique<BlockLayout>());
+  }
+}
+
+void ir2ir(const koopa_raw_program_t& program,
+           const int& opt_level,
+           const bool& time_passes) {
+  PassManager manager;
+  BuildPipeline(manager, opt_level);
+  manager.Run(program);
+  if (time_passes)
+    manager.Report();
+}
+
+}  // namespace opt
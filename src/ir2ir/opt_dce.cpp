@@ -0,0 +1,160 @@
+#include "opt_dce.h"
+
+namespace opt {
+
+// 删掉之后会改变程序行为的指令
+static bool HasSideEffect(koopa_raw_value_t inst) {
+  switch (inst->kind.tag) {
+    case KOOPA_RVT_STORE:
+    case KOOPA_RVT_CALL:
+      return true;
+    default:
+      return IsTerminator(inst);
+  }
+}
+
+DCE::DCE() {}
+
+bool DCE::RunOnFunction(koopa_raw_function_t func) {
+  Clear();
+  CollectDeadStores(func);
+  CollectIncoming(func);
+
+  for (size_t i = 0; i < func->bbs.len; ++i) {
+    BB bb = SliceAt<BB>(func->bbs, i);
+    for (size_t j = 0; j < bb->insts.len; ++j) {
+      auto inst = SliceAt<koopa_raw_value_t>(bb->insts, j);
+      if (HasSideEffect(inst) && !dead_stores.count(inst))
+        MarkLive(inst);
+    }
+  }
+  while (!worklist.empty()) {
+    auto value = worklist.back();
+    worklist.pop_back();
+    Propagate(value);
+  }
+  return Sweep(func);
+}
+
+void DCE::Clear() {
+  live.clear();
+  worklist.clear();
+  param_pos.clear();
+  incoming_args.clear();
+  dead_stores.clear();
+}
+
+void DCE::CollectDeadStores(koopa_raw_function_t func) {
+  map<koopa_raw_value_t, vector<koopa_raw_value_t>> users;
+  vector<koopa_raw_value_t> allocs;
+  for (size_t i = 0; i < func->bbs.len; ++i) {
+    BB bb = SliceAt<BB>(func->bbs, i);
+    for (size_t j = 0; j < bb->insts.len; ++j) {
+      auto inst = SliceAt<koopa_raw_value_t>(bb->insts, j);
+      if (inst->kind.tag == KOOPA_RVT_ALLOC)
+        allocs.push_back(inst);
+      for (auto op : GetOperands(inst)) {
+        users[op].push_back(inst);
+      }
+    }
+  }
+
+  for (auto alloc : allocs) {
+    // 从alloc出发的地址只用来算地址和当store的目标
+    vector<koopa_raw_value_t> stores;
+    vector<koopa_raw_value_t> ptrs = {alloc};
+    bool dead = true;
+    while (dead && !ptrs.empty()) {
+      auto ptr = ptrs.back();
+      ptrs.pop_back();
+      for (auto user : users[ptr]) {
+        const auto& kind = user->kind;
+        if (kind.tag == KOOPA_RVT_STORE && kind.data.store.dest == ptr &&
+            kind.data.store.value != ptr) {
+          stores.push_back(user);
+        } else if ((kind.tag == KOOPA_RVT_GET_PTR &&
+                    kind.data.get_ptr.src == ptr) ||
+                   (kind.tag == KOOPA_RVT_GET_ELEM_PTR &&
+                    kind.data.get_elem_ptr.src == ptr)) {
+          ptrs.push_back(user);
+        } else {
+          dead = false;
+          break;
+        }
+      }
+    }
+    if (dead)
+      dead_stores.insert(stores.begin(), stores.end());
+  }
+}
+
+void DCE::CollectIncoming(koopa_raw_function_t func) {
+  for (size_t i = 0; i < func->bbs.len; ++i) {
+    BB bb = SliceAt<BB>(func->bbs, i);
+    for (size_t j = 0; j < bb->params.len; ++j) {
+      param_pos[SliceAt<koopa_raw_value_t>(bb->params, j)] = {bb, j};
+    }
+    auto term = GetTerminator(bb);
+    if (term->kind.tag == KOOPA_RVT_JUMP) {
+      const auto& jump = term->kind.data.jump;
+      incoming_args[jump.target].push_back(&jump.args);
+    } else if (term->kind.tag == KOOPA_RVT_BRANCH) {
+      const auto& branch = term->kind.data.branch;
+      incoming_args[branch.true_bb].push_back(&branch.true_args);
+      incoming_args[branch.false_bb].push_back(&branch.false_args);
+    }
+  }
+}
+
+void DCE::MarkLive(koopa_raw_value_t value) {
+  auto tag = value->kind.tag;
+  // 常量、全局变量、函数参数不用管
+  if (tag == KOOPA_RVT_INTEGER || tag == KOOPA_RVT_ZERO_INIT ||
+      tag == KOOPA_RVT_UNDEF || tag == KOOPA_RVT_AGGREGATE ||
+      tag == KOOPA_RVT_FUNC_ARG_REF || tag == KOOPA_RVT_GLOBAL_ALLOC)
+    return;
+  if (live.insert(value).second)
+    worklist.push_back(value);
+}
+
+void DCE::Propagate(koopa_raw_value_t value) {
+  const auto& kind = value->kind;
+  if (kind.tag == KOOPA_RVT_BLOCK_ARG_REF) {
+    // 参数活了，每条入边上对应的实参也活了
+    auto pos = param_pos.at(value);
+    for (auto args : incoming_args[pos.first]) {
+      MarkLive(SliceAt<koopa_raw_value_t>(*args, pos.second));
+    }
+  } else if (kind.tag == KOOPA_RVT_BRANCH) {
+    MarkLive(kind.data.branch.cond);
+  } else if (kind.tag != KOOPA_RVT_JUMP) {
+    for (auto op : GetOperands(value)) {
+      MarkLive(op);
+    }
+  }
+}
+
+bool DCE::Sweep(koopa_raw_function_t func) {
+  bool changed = false;
+  set<koopa_raw_value_t> dead_params;
+  for (size_t i = 0; i < func->bbs.len; ++i) {
+    RawBB bb = Mutable(SliceAt<BB>(func->bbs, i));
+    for (size_t j = 0; j < bb->params.len; ++j) {
+      auto param = SliceAt<koopa_raw_value_t>(bb->params, j);
+      if (!live.count(param))
+        dead_params.insert(param);
+    }
+    size_t len = 0;
+    for (size_t j = 0; j < bb->insts.len; ++j) {
+      auto inst = SliceAt<koopa_raw_value_t>(bb->insts, j);
+      if (live.count(inst))
+        bb->insts.buffer[len++] = inst;
+    }
+    changed |= len != bb->insts.len;
+    bb->insts.len = len;
+  }
+  EraseBlockParams(func, dead_params);
+  return changed || !dead_params.empty();
+}
+
+}  // namespace opt
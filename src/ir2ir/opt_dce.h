@@ -0,0 +1,38 @@
+#pragma once
+
+#include "opt_cfg.h"
+#include "opt_pass.h"
+
+namespace opt {
+
+// 激进的死代码删除，从有副作用的指令出发标记，没标记到的都删掉
+// 基本块参数只在被用到时才把对应的实参标记为活
+// 只被store过、从来没有被读的局部变量，store也算死的
+class DCE : public FunctionPass {
+ public:
+  DCE();
+  const string Name() const override { return "dce"; }
+  bool RunOnFunction(koopa_raw_function_t func) override;
+
+ private:
+  // 活的指令和参数
+  set<koopa_raw_value_t> live;
+  vector<koopa_raw_value_t> worklist;
+  // 参数所在的基本块和位置
+  map<koopa_raw_value_t, pair<BB, size_t>> param_pos;
+  // 跳到每个基本块的实参列表
+  map<BB, vector<const koopa_raw_slice_t*>> incoming_args;
+  // 只写不读的局部变量上的store
+  set<koopa_raw_value_t> dead_stores;
+
+  void Clear();
+  void CollectDeadStores(koopa_raw_function_t func);
+  void CollectIncoming(koopa_raw_function_t func);
+  void MarkLive(koopa_raw_value_t value);
+  // 标记value用到的值
+  void Propagate(koopa_raw_value_t value);
+  // 删掉没标记的指令和参数
+  bool Sweep(koopa_raw_function_t func);
+};
+
+}  // namespace opt
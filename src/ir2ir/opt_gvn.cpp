@@ -0,0 +1,126 @@
+#include "opt_gvn.h"
+#include <algorithm>
+
+namespace opt {
+
+static bool IsCommutative(koopa_raw_binary_op_t op) {
+  switch (op) {
+    case KOOPA_RBO_ADD:
+    case KOOPA_RBO_MUL:
+    case KOOPA_RBO_AND:
+    case KOOPA_RBO_OR:
+    case KOOPA_RBO_XOR:
+    case KOOPA_RBO_EQ:
+    case KOOPA_RBO_NOT_EQ:
+      return true;
+    default:
+      return false;
+  }
+}
+
+GVN::GVN() : available(), replace() {}
+
+bool GVN::RunOnFunction(koopa_raw_function_t func) {
+  Clear();
+  bool changed = RemoveUnreachableBlocks(func);
+  CFG cfg(func);
+  Visit(cfg.entry, cfg);
+  if (replace.empty())
+    return changed;
+  Rewrite(func);
+  return true;
+}
+
+void GVN::Clear() {
+  available.clear();
+  replace.clear();
+}
+
+void GVN::Visit(BB bb, const CFG& cfg) {
+  auto resolve = [this](koopa_raw_value_t value) { return Resolve(value); };
+  // 离开这个块时要删掉的表达式
+  vector<ExprKey> pushed;
+  for (size_t j = 0; j < bb->insts.len; ++j) {
+    auto inst = SliceAt<koopa_raw_value_t>(bb->insts, j);
+    // 操作数的定义支配这里，已经处理过了
+    ReplaceOperands(inst, resolve);
+    ExprKey key;
+    if (!GetKey(inst, key))
+      continue;
+    auto it = available.find(key);
+    if (it != available.end()) {
+      replace[inst] = it->second;
+    } else {
+      available.emplace(key, inst);
+      pushed.push_back(key);
+    }
+  }
+
+  auto children = cfg.dom_children.find(bb);
+  if (children != cfg.dom_children.end()) {
+    for (BB child : children->second) {
+      Visit(child, cfg);
+    }
+  }
+
+  for (const auto& key : pushed) {
+    available.erase(key);
+  }
+}
+
+const koopa_raw_value_t GVN::Resolve(koopa_raw_value_t value) {
+  auto it = replace.find(value);
+  while (it != replace.end()) {
+    value = it->second;
+    it = replace.find(value);
+  }
+  return value;
+}
+
+bool GVN::GetKey(koopa_raw_value_t inst, ExprKey& key) {
+  auto operand = [](koopa_raw_value_t value) {
+    if (value->kind.tag == KOOPA_RVT_INTEGER)
+      return Operand(nullptr, value->kind.data.integer.value);
+    return Operand(value, 0);
+  };
+  const auto& kind = inst->kind;
+  switch (kind.tag) {
+    case KOOPA_RVT_BINARY: {
+      Operand lhs = operand(kind.data.binary.lhs);
+      Operand rhs = operand(kind.data.binary.rhs);
+      // 可交换的运算把操作数排个序，a+b和b+a算同一个
+      if (IsCommutative(kind.data.binary.op) && rhs < lhs)
+        std::swap(lhs, rhs);
+      key = ExprKey(kind.tag, kind.data.binary.op, lhs, rhs);
+      return true;
+    }
+    case KOOPA_RVT_GET_PTR:
+      key = ExprKey(kind.tag, 0, operand(kind.data.get_ptr.src),
+                    operand(kind.data.get_ptr.index));
+      return true;
+    case KOOPA_RVT_GET_ELEM_PTR:
+      key = ExprKey(kind.tag, 0, operand(kind.data.get_elem_ptr.src),
+                    operand(kind.data.get_elem_ptr.index));
+      return true;
+    default:
+      return false;
+  }
+}
+
+void GVN::Rewrite(koopa_raw_function_t func) {
+  auto resolve = [this](koopa_raw_value_t value) { return Resolve(value); };
+  for (size_t i = 0; i < func->bbs.len; ++i) {
+    RawBB bb = Mutable(SliceAt<BB>(func->bbs, i));
+    size_t len = 0;
+    for (size_t j = 0; j < bb->insts.len; ++j) {
+      auto inst = SliceAt<koopa_raw_value_t>(bb->insts, j);
+      if (replace.count(inst))
+        continue;
+      ReplaceOperands(inst, resolve);
+      bb->insts.buffer[len++] = inst;
+    }
+    bb->insts.len = len;
+  }
+}
+
+}  // namespace opt
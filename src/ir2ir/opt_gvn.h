@@ -0,0 +1,38 @@
+#pragma once
+
+#include <tuple>
+#include "opt_cfg.h"
+#include "opt_pass.h"
+
+namespace opt {
+
+// 全局值编号，删掉被支配的重复计算
+// 只处理没有副作用的binary、getptr、getelemptr，load可能读到不同的值
+// 沿支配树遍历，块里算过的表达式在被它支配的块里都能直接用
+class GVN : public FunctionPass {
+ public:
+  GVN();
+  const string Name() const override { return "gvn"; }
+  bool RunOnFunction(koopa_raw_function_t func) override;
+
+ private:
+  // 操作数，整数常量每次生成的都是新值，按数值比较
+  typedef pair<koopa_raw_value_t, int> Operand;
+  // 指令种类、运算符、两个操作数
+  typedef std::tuple<int, int, Operand, Operand> ExprKey;
+
+  // 当前支配路径上可用的表达式
+  map<ExprKey, koopa_raw_value_t> available;
+  // 重复的指令替换成的值
+  map<koopa_raw_value_t, koopa_raw_value_t> replace;
+
+  void Clear();
+  void Visit(BB bb, const CFG& cfg);
+  const koopa_raw_value_t Resolve(koopa_raw_value_t value);
+  // 不是纯计算时返回false
+  bool GetKey(koopa_raw_value_t inst, ExprKey& key);
+  // 删掉重复的指令
+  void Rewrite(koopa_raw_function_t func);
+};
+
+}  // namespace opt
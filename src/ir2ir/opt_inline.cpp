@@ -0,0 +1,297 @@
+#include "opt_inline.h"
+#include <algorithm>
+#include "opt_loop.h"
+
+namespace opt {
+
+// 这么小的函数总是展开
+static const size_t SMALL_SIZE = 30;
+// 只有一处调用时，展开后不会多出代码
+static const size_t SINGLE_CALL_SIZE = 200;
+// 递归函数展开一层的阈值
+static const size_t RECURSIVE_SIZE = 12;
+// 调用者展开后的大小上限
+static const size_t CALLER_BUDGET = 2000;
+
+Inliner::Inliner(ir::RawProgramManager& _raw) : raw(_raw), inline_count(0) {}
+
+bool Inliner::Run(const koopa_raw_program_t& program) {
+  Clear();
+  BuildCallGraph(program);
+  FindSCCs();
+  bool changed = false;
+  for (auto func : order) {
+    changed |= InlineCalls(func);
+  }
+  return changed;
+}
+
+void Inliner::Clear() {
+  callees.clear();
+  call_sites.clear();
+  scc_id.clear();
+  scc_recursive.clear();
+  order.clear();
+  sizes.clear();
+  inlinable.clear();
+}
+
+void Inliner::BuildCallGraph(const koopa_raw_program_t& program) {
+  for (size_t i = 0; i < program.funcs.len; ++i) {
+    auto func = SliceAt<koopa_raw_function_t>(program.funcs, i);
+    if (func->bbs.len == 0)
+      continue;
+    auto& list = callees[func];
+    for (size_t j = 0; j < func->bbs.len; ++j) {
+      BB bb = SliceAt<BB>(func->bbs, j);
+      for (size_t k = 0; k < bb->insts.len; ++k) {
+        auto inst = SliceAt<koopa_raw_value_t>(bb->insts, k);
+        if (inst->kind.tag != KOOPA_RVT_CALL)
+          continue;
+        auto callee = inst->kind.data.call.callee;
+        call_sites[callee]++;
+        if (callee->bbs.len != 0)
+          list.push_back(callee);
+      }
+    }
+    sizes[func] = CountInsts(func);
+    if (IsInlinable(func))
+      inlinable.insert(func);
+  }
+}
+
+void Inliner::FindSCCs() {
+  map<koopa_raw_function_t, int> index, low;
+  vector<koopa_raw_function_t> stack;
+  set<koopa_raw_function_t> on_stack;
+  int counter = 0;
+
+  std::function<void(koopa_raw_function_t)> visit =
+      [&](koopa_raw_function_t func) {
+        index[func] = low[func] = counter++;
+        stack.push_back(func);
+        on_stack.insert(func);
+        bool self_call = false;
+        for (auto callee : callees[func]) {
+          if (callee == func)
+            self_call = true;
+          if (!index.count(callee)) {
+            visit(callee);
+            low[func] = std::min(low[func], low[callee]);
+          } else if (on_stack.count(callee)) {
+            low[func] = std::min(low[func], index[callee]);
+          }
+        }
+        if (low[func] != index[func])
+          return;
+        int id = scc_recursive.size();
+        size_t begin = stack.size();
+        do {
+          --begin;
+        } while (stack[begin] != func);
+        for (size_t i = begin; i < stack.size(); ++i) {
+          scc_id[stack[i]] = id;
+          on_stack.erase(stack[i]);
+          order.push_back(stack[i]);
+        }
+        scc_recursive.push_back(stack.size() - begin > 1 || self_call);
+        stack.resize(begin);
+      };
+
+  for (auto& item : callees) {
+    if (!index.count(item.first))
+      visit(item.first);
+  }
+}
+
+size_t Inliner::CountInsts(koopa_raw_function_t func) {
+  size_t size = 0;
+  for (size_t i = 0; i < func->bbs.len; ++i) {
+    size += SliceAt<BB>(func->bbs, i)->insts.len;
+  }
+  return size;
+}
+
+bool Inliner::IsInlinable(koopa_raw_function_t func) {
+  // 有循环的函数调用开销占比很小，展开反而增加调用者的寄存器压力
+  if (!LoopNest(CFG(func)).loops.empty())
+    return false;
+  for (size_t i = 0; i < func->bbs.len; ++i) {
+    BB bb = SliceAt<BB>(func->bbs, i);
+    for (size_t j = 0; j < bb->insts.len; ++j) {
+      auto inst = SliceAt<koopa_raw_value_t>(bb->insts, j);
+      if (inst->kind.tag == KOOPA_RVT_ALLOC &&
+          inst->ty->data.pointer.base->tag == KOOPA_RTT_ARRAY)
+        return false;
+    }
+  }
+  return true;
+}
+
+bool Inliner::ShouldInline(koopa_raw_function_t caller,
+                           koopa_raw_function_t callee) {
+  if (!inlinable.count(callee) || scc_id.at(callee) == scc_id.at(caller))
+    return false;
+  size_t size = sizes.at(callee);
+  if (sizes.at(caller) + size > CALLER_BUDGET)
+    return false;
+  if (scc_recursive[scc_id.at(callee)])
+    return size <= RECURSIVE_SIZE;
+  return size <= SMALL_SIZE ||
+         (call_sites[callee] == 1 && size <= SINGLE_CALL_SIZE);
+}
+
+bool Inliner::InlineCalls(koopa_raw_function_t caller) {
+  bool changed = false;
+  // 展开后调用之后的指令挪到新块里，新块还要接着找
+  vector<RawBB> worklist;
+  for (size_t i = 0; i < caller->bbs.len; ++i) {
+    worklist.push_back(Mutable(SliceAt<BB>(caller->bbs, i)));
+  }
+  std::reverse(worklist.begin(), worklist.end());
+  while (!worklist.empty()) {
+    RawBB bb = worklist.back();
+    worklist.pop_back();
+    for (size_t j = 0; j < bb->insts.len; ++j) {
+      auto inst = SliceAt<koopa_raw_value_t>(bb->insts, j);
+      if (inst->kind.tag != KOOPA_RVT_CALL ||
+          !ShouldInline(caller, inst->kind.data.call.callee))
+        continue;
+      auto callee = inst->kind.data.call.callee;
+      call_sites[callee]--;
+      worklist.push_back(InlineCall(caller, bb, j));
+      sizes[caller] = CountInsts(caller);
+      changed = true;
+      break;
+    }
+  }
+  return changed;
+}
+
+// 跳转和调用的实参slice要复制一份，之后原地替换时不能改到被调用者
+static void CopyArgs(koopa_raw_slice_t& args, ir::RawProgramManager& raw) {
+  vector<const void*> items(args.buffer, args.buffer + args.len);
+  args = raw.NewSlice(items, KOOPA_RSIK_VALUE);
+}
+
+RawBB Inliner::InlineCall(koopa_raw_function_t caller, RawBB bb, size_t index) {
+  auto call = SliceAt<koopa_raw_value_t>(bb->insts, index);
+  auto callee = call->kind.data.call.callee;
+  // 名字加上前缀，保证在调用者里不重名
+  string prefix = "inline" + std::to_string(inline_count++) + "_";
+  auto rename = [&](const char* name) {
+    string str(name);
+    return str.substr(0, 1) + prefix + str.substr(1);
+  };
+
+  map<koopa_raw_value_t, koopa_raw_value_t> values;
+  map<BB, BB> blocks;
+  for (size_t i = 0; i < callee->params.len; ++i) {
+    values[SliceAt<koopa_raw_value_t>(callee->params, i)] =
+        SliceAt<koopa_raw_value_t>(call->kind.data.call.args, i);
+  }
+
+  // 先建好所有基本块和参数，指令可能用到后面块里的值
+  vector<pair<BB, RawBB>> copies;
+  for (size_t i = 0; i < callee->bbs.len; ++i) {
+    BB origin = SliceAt<BB>(callee->bbs, i);
+    RawBB copy = raw.NewBasicBlock(rename(origin->name));
+    vector<const void*> params;
+    for (size_t j = 0; j < origin->params.len; ++j) {
+      auto param = SliceAt<koopa_raw_value_t>(origin->params, j);
+      RawValue new_param = raw.NewBlockArgRef(j, param->ty);
+      values[param] = new_param;
+      params.push_back(new_param);
+    }
+    copy->params = raw.NewSlice(params, KOOPA_RSIK_VALUE);
+    blocks[origin] = copy;
+    copies.emplace_back(origin, copy);
+  }
+
+  // ret改成带着返回值跳到调用之后
+  RawBB cont = raw.NewBasicBlock("%" + prefix + "cont");
+  RawValue result = nullptr;
+  if (call->ty->tag != KOOPA_RTT_UNIT) {
+    result = raw.NewBlockArgRef(0, call->ty);
+    cont->params = raw.NewSlice({result}, KOOPA_RSIK_VALUE);
+  }
+
+  vector<RawValue> new_insts;
+  for (auto& [origin, copy] : copies) {
+    vector<const void*> insts;
+    for (size_t j = 0; j < origin->insts.len; ++j) {
+      auto inst = SliceAt<koopa_raw_value_t>(origin->insts, j);
+      RawValue new_inst;
+      if (inst->kind.tag == KOOPA_RVT_RETURN) {
+        new_inst = raw.NewJump(cont);
+        if (result != nullptr)
+          new_inst->kind.data.jump.args =
+              raw.NewSlice({inst->kind.data.ret.value}, KOOPA_RSIK_VALUE);
+      } else {
+        new_inst = raw.NewValue(inst->kind.tag, inst->ty);
+        new_inst->kind = inst->kind;
+        if (inst->name != nullptr)
+          new_inst->name = raw.NewName(rename(inst->name));
+        auto& data = new_inst->kind.data;
+        if (inst->kind.tag == KOOPA_RVT_JUMP) {
+          data.jump.target = blocks.at(data.jump.target);
+          CopyArgs(data.jump.args, raw);
+        } else if (inst->kind.tag == KOOPA_RVT_BRANCH) {
+          data.branch.true_bb = blocks.at(data.branch.true_bb);
+          data.branch.false_bb = blocks.at(data.branch.false_bb);
+          CopyArgs(data.branch.true_args, raw);
+          CopyArgs(data.branch.false_args, raw);
+        } else if (inst->kind.tag == KOOPA_RVT_CALL) {
+          CopyArgs(data.call.args, raw);
+        }
+        values[inst] = new_inst;
+      }
+      new_insts.push_back(new_inst);
+      insts.push_back(new_inst);
+    }
+    copy->insts = raw.NewSlice(insts, KOOPA_RSIK_VALUE);
+  }
+  auto remap = [&](koopa_raw_value_t value) {
+    auto it = values.find(value);
+    return it == values.end() ? value : it->second;
+  };
+  for (auto inst : new_insts) {
+    ReplaceOperands(inst, remap);
+  }
+
+  // 调用之后的指令挪到cont，原来的块跳到展开的入口
+  vector<const void*> head(bb->insts.buffer, bb->insts.buffer + index);
+  vector<const void*> tail(bb->insts.buffer + index + 1,
+                           bb->insts.buffer + bb->insts.len);
+  head.push_back(raw.NewJump(copies.front().second));
+  bb->insts = raw.NewSlice(head, KOOPA_RSIK_VALUE);
+  cont->insts = raw.NewSlice(tail, KOOPA_RSIK_VALUE);
+
+  vector<const void*> bbs;
+  for (size_t i = 0; i < caller->bbs.len; ++i) {
+    BB cur = SliceAt<BB>(caller->bbs, i);
+    bbs.push_back(cur);
+    if (cur != bb)
+      continue;
+    for (auto& item : copies) {
+      bbs.push_back(item.second);
+    }
+    bbs.push_back(cont);
+  }
+  Mutable(caller)->bbs = raw.NewSlice(bbs, KOOPA_RSIK_BASIC_BLOCK);
+
+  if (result != nullptr) {
+    auto replace = [&](koopa_raw_value_t value) -> koopa_raw_value_t {
+      return value == call ? result : value;
+    };
+    for (size_t i = 0; i < caller->bbs.len; ++i) {
+      BB cur = SliceAt<BB>(caller->bbs, i);
+      for (size_t j = 0; j < cur->insts.len; ++j) {
+        ReplaceOperands(SliceAt<koopa_raw_value_t>(cur->insts, j), replace);
+      }
+    }
+  }
+  return cont;
+}
+
+}  // namespace opt
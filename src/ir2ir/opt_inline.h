@@ -0,0 +1,51 @@
+#pragma once
+
+#include "opt_cfg.h"
+#include "opt_pass.h"
+
+namespace opt {
+
+// 函数内联，按调用图自底向上处理，被调用者先内联好再考虑展开到调用者里
+// 小函数，或者只有一处调用的函数在预算内展开
+// 递归函数不会展开到自己的强连通分量里，展开到外面时用更小的阈值
+// 有循环或者局部数组的函数不展开
+// 流式生成时之前的函数体已经释放，只能看到声明，不会内联
+class Inliner : public Pass {
+ public:
+  Inliner(ir::RawProgramManager& _raw);
+  const string Name() const override { return "inline"; }
+  bool Run(const koopa_raw_program_t& program) override;
+
+ private:
+  ir::RawProgramManager& raw;
+
+  // 调用图，只有有函数体的函数
+  map<koopa_raw_function_t, vector<koopa_raw_function_t>> callees;
+  // 每个函数在整个程序里被调用的次数
+  map<koopa_raw_function_t, int> call_sites;
+  // 函数所在的强连通分量编号，和分量是否有环
+  map<koopa_raw_function_t, int> scc_id;
+  vector<bool> scc_recursive;
+  // 自底向上的顺序
+  vector<koopa_raw_function_t> order;
+  // 函数的指令数
+  map<koopa_raw_function_t, size_t> sizes;
+  // 可以展开的函数
+  set<koopa_raw_function_t> inlinable;
+  // 给展开出来的基本块和变量起名用
+  int inline_count;
+
+  void Clear();
+  void BuildCallGraph(const koopa_raw_program_t& program);
+  // Tarjan算法，分量按被调用者在前的顺序产生
+  void FindSCCs();
+  size_t CountInsts(koopa_raw_function_t func);
+  // 没有循环，也没有会让调用者栈帧变大的局部数组
+  bool IsInlinable(koopa_raw_function_t func);
+  bool ShouldInline(koopa_raw_function_t caller, koopa_raw_function_t callee);
+  bool InlineCalls(koopa_raw_function_t caller);
+  // 在bb的第index条指令处展开，返回放后半部分指令的新基本块
+  RawBB InlineCall(koopa_raw_function_t caller, RawBB bb, size_t index);
+};
+
+}  // namespace opt
@@ -0,0 +1,32 @@
+#pragma once
+
+#include "koopa.h"
+#include "opt_dce.h"
+#include "opt_gvn.h"
+#include "opt_inline.h"
+#include "opt_ivsr.h"
+#include "opt_layout.h"
+#include "opt_licm.h"
+#include "opt_mem2reg.h"
+#include "opt_pass.h"
+#include "opt_sccp.h"
+#include "opt_simplifycfg.h"
+#include "opt_tailrec.h"
+
+namespace opt {
+
+/* core.cpp */
+// 按优化等级构造pass流水线
+// -O0: 不优化
+// -O1: 把局部变量提升成SSA值，尾递归改成循环，常量传播，
+//      外提循环不变量，削减循环里的下标计算，删掉重复计算和死代码，
+//      整理控制流，重排基本块
+// -O2: -perf使用，在-O1基础上内联小函数
+// 流式生成时每次只能看到一个函数，跨函数的pass不会生效
+void BuildPipeline(PassManager& manager, const int& opt_level);
+// 在内存中原地优化raw program，time_passes时打印每个pass的耗时
+void ir2ir(const koopa_raw_program_t& program,
+           const int& opt_level,
+           const bool& time_passes);
+
+}  // namespace opt
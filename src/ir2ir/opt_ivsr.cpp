@@ -0,0 +1,214 @@
+#include "opt_ivsr.h"
+
+namespace opt {
+
+IVStrengthReduce::IVStrengthReduce(ir::RawProgramManager& _raw) : raw(_raw) {}
+
+bool IVStrengthReduce::RunOnFunction(koopa_raw_function_t func) {
+  Clear();
+  bool changed = RemoveUnreachableBlocks(func);
+  changed |= InsertPreheaders(func, raw);
+  CFG cfg(func);
+  LoopNest nest(cfg);
+  CollectDefs(func);
+  // 内层先做，外层循环的归纳变量还能削减内层前置块里算初值的指令
+  for (Loop* loop : nest.loops) {
+    BB preheader = GetOrInsertPreheader(func, *loop, cfg, raw);
+    if (ReduceLoop(*loop, preheader, cfg)) {
+      Rewrite(func);
+      changed = true;
+    }
+  }
+  return changed;
+}
+
+void IVStrengthReduce::Clear() {
+  def_block.clear();
+  replace.clear();
+}
+
+void IVStrengthReduce::CollectDefs(koopa_raw_function_t func) {
+  for (size_t i = 0; i < func->bbs.len; ++i) {
+    BB bb = SliceAt<BB>(func->bbs, i);
+    for (size_t j = 0; j < bb->params.len; ++j) {
+      def_block[SliceAt<koopa_raw_value_t>(bb->params, j)] = bb;
+    }
+    for (size_t j = 0; j < bb->insts.len; ++j) {
+      def_block[SliceAt<koopa_raw_value_t>(bb->insts, j)] = bb;
+    }
+  }
+}
+
+bool IVStrengthReduce::GetKey(
+    koopa_raw_value_t inst,
+    const Loop& loop,
+    const map<koopa_raw_value_t, InductionVar>& ivs,
+    Key& key) {
+  const auto& kind = inst->kind;
+  koopa_raw_value_t src = nullptr, index = nullptr;
+  if (kind.tag == KOOPA_RVT_GET_PTR) {
+    src = kind.data.get_ptr.src;
+    index = kind.data.get_ptr.index;
+  } else if (kind.tag == KOOPA_RVT_GET_ELEM_PTR) {
+    src = kind.data.get_elem_ptr.src;
+    index = kind.data.get_elem_ptr.index;
+  } else if (kind.tag == KOOPA_RVT_BINARY &&
+             kind.data.binary.op == KOOPA_RBO_MUL) {
+    auto lhs = kind.data.binary.lhs, rhs = kind.data.binary.rhs;
+    if (!ivs.count(lhs))
+      std::swap(lhs, rhs);
+    if (!ivs.count(lhs))
+      return false;
+    if (rhs->kind.tag == KOOPA_RVT_INTEGER) {
+      key = Key(kind.tag, nullptr, rhs->kind.data.integer.value, lhs);
+      return true;
+    }
+    // 乘数是循环外的值
+    auto it = def_block.find(rhs);
+    if (it != def_block.end() && loop.Contains(it->second))
+      return false;
+    key = Key(kind.tag, rhs, 0, lhs);
+    return true;
+  } else {
+    return false;
+  }
+
+  if (!ivs.count(index))
+    return false;
+  // 基址要在循环外
+  auto it = def_block.find(src);
+  if (it != def_block.end() && loop.Contains(it->second))
+    return false;
+  key = Key(kind.tag, src, 0, index);
+  return true;
+}
+
+bool IVStrengthReduce::ReduceLoop(const Loop& loop,
+                                  BB preheader,
+                                  const CFG& cfg) {
+  map<koopa_raw_value_t, InductionVar> ivs;
+  for (const auto& iv : FindInductionVars(loop, preheader)) {
+    ivs.emplace(iv.param, iv);
+  }
+  if (ivs.empty())
+    return false;
+
+  // 相同的地址计算共用一个新参数
+  map<Key, koopa_raw_value_t> reduced;
+  for (BB bb : cfg.rpo) {
+    if (!loop.Contains(bb))
+      continue;
+    for (size_t j = 0; j < bb->insts.len; ++j) {
+      auto inst = SliceAt<koopa_raw_value_t>(bb->insts, j);
+      Key key;
+      if (!GetKey(inst, loop, ivs, key))
+        continue;
+      auto it = reduced.find(key);
+      if (it == reduced.end()) {
+        const auto& iv = ivs.at(std::get<3>(key));
+        it = reduced.emplace(key, NewReducedParam(inst, iv, loop, preheader))
+                 .first;
+      }
+      replace[inst] = it->second;
+    }
+  }
+  return !reduced.empty();
+}
+
+// 在跳转的实参最后加一个
+static void AppendArg(koopa_raw_slice_t& args,
+                      koopa_raw_value_t arg,
+                      ir::RawProgramManager& raw) {
+  vector<const void*> items(args.buffer, args.buffer + args.len);
+  items.push_back(arg);
+  args = raw.NewSlice(items, KOOPA_RSIK_VALUE);
+}
+
+koopa_raw_value_t IVStrengthReduce::NewReducedParam(koopa_raw_value_t inst,
+                                                    const InductionVar& iv,
+                                                    const Loop& loop,
+                                                    BB preheader) {
+  BB header = loop.header, latch = loop.latches[0];
+  const auto& kind = inst->kind;
+
+  RawBB raw_header = Mutable(header);
+  vector<const void*> params(raw_header->params.buffer,
+                             raw_header->params.buffer +
+                                 raw_header->params.len);
+  RawValue param = raw.NewBlockArgRef(params.size(), inst->ty);
+  params.push_back(param);
+  raw_header->params = raw.NewSlice(params, KOOPA_RSIK_VALUE);
+
+  // 初值是归纳变量的初值代进去算，每次回到头时加上一步
+  RawValue init, next;
+  vector<koopa_raw_value_t> setup;
+  if (kind.tag == KOOPA_RVT_BINARY) {
+    auto factor = kind.data.binary.lhs == iv.param ? kind.data.binary.rhs
+                                                   : kind.data.binary.lhs;
+    if (factor->kind.tag == KOOPA_RVT_INTEGER) {
+      unsigned k = factor->kind.data.integer.value;
+      if (iv.init->kind.tag == KOOPA_RVT_INTEGER)
+        init = raw.NewInteger(static_cast<int>(
+            static_cast<unsigned>(iv.init->kind.data.integer.value) * k));
+      else
+        init = raw.NewBinary(KOOPA_RBO_MUL, iv.init, factor);
+      next = raw.NewBinary(
+          KOOPA_RBO_ADD, param,
+          raw.NewInteger(static_cast<int>(static_cast<unsigned>(iv.step) * k)));
+    } else {
+      // 步长step * factor也要在前置块里算
+      koopa_raw_value_t stride = factor;
+      if (iv.step != 1) {
+        stride = raw.NewBinary(KOOPA_RBO_MUL, factor, raw.NewInteger(iv.step));
+        setup.push_back(stride);
+      }
+      if (iv.init->kind.tag == KOOPA_RVT_INTEGER &&
+          iv.init->kind.data.integer.value == 0)
+        init = raw.NewInteger(0);
+      else
+        init = raw.NewBinary(KOOPA_RBO_MUL, iv.init, factor);
+      next = raw.NewBinary(KOOPA_RBO_ADD, param, stride);
+    }
+  } else {
+    if (kind.tag == KOOPA_RVT_GET_PTR)
+      init = raw.NewGetPtr(kind.data.get_ptr.src, iv.init);
+    else
+      init = raw.NewGetElemPtr(kind.data.get_elem_ptr.src, iv.init);
+    next = raw.NewGetPtr(param, raw.NewInteger(iv.step));
+  }
+
+  if (init->kind.tag != KOOPA_RVT_INTEGER)
+    setup.push_back(init);
+  InsertBeforeTerminator(preheader, setup, raw);
+  for (auto value : setup) {
+    def_block[value] = preheader;
+  }
+  InsertBeforeTerminator(latch, {next}, raw);
+  def_block[param] = header;
+  def_block[next] = latch;
+  AppendArg(*GetEdgeArgs(preheader, header), init, raw);
+  AppendArg(*GetEdgeArgs(latch, header), next, raw);
+  return param;
+}
+
+void IVStrengthReduce::Rewrite(koopa_raw_function_t func) {
+  auto resolve = [this](koopa_raw_value_t value) {
+    auto it = replace.find(value);
+    return it == replace.end() ? value : it->second;
+  };
+  for (size_t i = 0; i < func->bbs.len; ++i) {
+    RawBB bb = Mutable(SliceAt<BB>(func->bbs, i));
+    size_t len = 0;
+    for (size_t j = 0; j < bb->insts.len; ++j) {
+      auto inst = SliceAt<koopa_raw_value_t>(bb->insts, j);
+      if (replace.count(inst))
+        continue;
+      ReplaceOperands(inst, resolve);
+      bb->insts.buffer[len++] = inst;
+    }
+    bb->insts.len = len;
+  }
+  replace.clear();
+}
+
+}  // namespace opt
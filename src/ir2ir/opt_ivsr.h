@@ -0,0 +1,47 @@
+#pragma once
+
+#include <tuple>
+#include "opt_loop.h"
+#include "opt_pass.h"
+
+namespace opt {
+
+// 归纳变量强度削减
+// 循环里以基本归纳变量i为下标的getptr/getelemptr，基址在循环外时，
+// 改成头上新加的指针参数，每次回到头时往后挪step个元素，循环里就不用乘法了
+// i * k（k是常量或者循环外的值）也同样改成每次加step * k的新参数
+class IVStrengthReduce : public FunctionPass {
+ public:
+  IVStrengthReduce(ir::RawProgramManager& _raw);
+  const string Name() const override { return "ivsr"; }
+  bool RunOnFunction(koopa_raw_function_t func) override;
+
+ private:
+  // 指令种类、基址或乘数、归纳变量
+  typedef std::tuple<int, koopa_raw_value_t, int, koopa_raw_value_t> Key;
+
+  ir::RawProgramManager& raw;
+
+  // 指令和参数所在的基本块
+  map<koopa_raw_value_t, BB> def_block;
+  // 被削减掉的指令替换成的新参数
+  map<koopa_raw_value_t, koopa_raw_value_t> replace;
+
+  void Clear();
+  void CollectDefs(koopa_raw_function_t func);
+  // 可以削减时填好key
+  bool GetKey(koopa_raw_value_t inst,
+              const Loop& loop,
+              const map<koopa_raw_value_t, InductionVar>& ivs,
+              Key& key);
+  bool ReduceLoop(const Loop& loop, BB preheader, const CFG& cfg);
+  // 为一组相同的指令新建参数，返回新参数
+  koopa_raw_value_t NewReducedParam(koopa_raw_value_t inst,
+                                    const InductionVar& iv,
+                                    const Loop& loop,
+                                    BB preheader);
+  // 删掉被削减的指令，替换所有使用
+  void Rewrite(koopa_raw_function_t func);
+};
+
+}  // namespace opt
@@ -0,0 +1,134 @@
+#include "opt_layout.h"
+#include <algorithm>
+#include "opt_loop.h"
+
+namespace opt {
+
+// 每深一层循环，估计多执行的倍数
+static const double LOOP_WEIGHT = 10;
+// 条件跳转离开循环的概率
+static const double EXIT_PROB = 0.1;
+
+BlockLayout::BlockLayout() {}
+
+bool BlockLayout::RunOnFunction(koopa_raw_function_t func) {
+  if (func->bbs.len <= 2)
+    return false;
+  Clear();
+  CFG cfg(func);
+  CollectEdges(cfg);
+  BuildChains(cfg);
+  vector<BB> order = PlaceChains(cfg);
+
+  // 不可达的块留在最后
+  for (size_t i = 0; i < func->bbs.len; ++i) {
+    BB bb = SliceAt<BB>(func->bbs, i);
+    if (!cfg.IsReachable(bb))
+      order.push_back(bb);
+  }
+  bool changed = false;
+  auto& bbs = Mutable(func)->bbs;
+  for (size_t i = 0; i < bbs.len; ++i) {
+    if (bbs.buffer[i] != order[i]) {
+      bbs.buffer[i] = order[i];
+      changed = true;
+    }
+  }
+  return changed;
+}
+
+void BlockLayout::Clear() {
+  edges.clear();
+  chain_of.clear();
+  chains.clear();
+}
+
+void BlockLayout::CollectEdges(const CFG& cfg) {
+  LoopNest nest(cfg);
+  for (BB bb : cfg.rpo) {
+    double freq = 1;
+    for (int d = nest.GetDepth(bb); d > 0; --d) {
+      freq *= LOOP_WEIGHT;
+    }
+    const auto& succs = cfg.succs.at(bb);
+    if (succs.size() == 1 || (succs.size() == 2 && succs[0] == succs[1])) {
+      edges.push_back({bb, succs[0], freq});
+      continue;
+    }
+    if (succs.size() != 2)
+      continue;
+
+    // 只有一边离开当前循环时，认为留在循环里的一边更可能
+    Loop* loop = nest.GetLoop(bb);
+    bool exit0 = loop != nullptr && !loop->Contains(succs[0]);
+    bool exit1 = loop != nullptr && !loop->Contains(succs[1]);
+    double prob0 = 0.5;
+    if (exit0 && !exit1)
+      prob0 = EXIT_PROB;
+    else if (!exit0 && exit1)
+      prob0 = 1 - EXIT_PROB;
+    edges.push_back({bb, succs[0], freq * prob0});
+    edges.push_back({bb, succs[1], freq * (1 - prob0)});
+  }
+}
+
+void BlockLayout::BuildChains(const CFG& cfg) {
+  for (BB bb : cfg.rpo) {
+    chain_of[bb] = chains.size();
+    chains.push_back({bb});
+  }
+  // 权重相同时按rpo的顺序
+  std::stable_sort(edges.begin(), edges.end(),
+                   [](const Edge& a, const Edge& b) {
+                     return a.weight > b.weight;
+                   });
+  for (const auto& edge : edges) {
+    size_t from = chain_of[edge.from];
+    size_t to = chain_of[edge.to];
+    // 入口必须在最前面
+    if (from == to || edge.to == cfg.entry)
+      continue;
+    if (chains[from].back() != edge.from || chains[to].front() != edge.to)
+      continue;
+    for (BB bb : chains[to]) {
+      chain_of[bb] = from;
+      chains[from].push_back(bb);
+    }
+    chains[to].clear();
+  }
+}
+
+vector<BB> BlockLayout::PlaceChains(const CFG& cfg) {
+  // 每条链和已放好的块之间最重的边
+  vector<double> scores(chains.size(), -1);
+  vector<bool> placed(chains.size(), false);
+  vector<BB> order;
+  size_t next = chain_of[cfg.entry];
+  while (true) {
+    placed[next] = true;
+    for (BB bb : chains[next]) {
+      order.push_back(bb);
+    }
+    for (const auto& edge : edges) {
+      size_t to = chain_of[edge.to];
+      if (chain_of[edge.from] == next && !placed[to])
+        scores[to] = std::max(scores[to], edge.weight);
+    }
+
+    // 分数相同时选链头在rpo里靠前的，链的编号就是链头的rpo序号
+    bool found = false;
+    for (size_t i = 0; i < chains.size(); ++i) {
+      if (placed[i] || chains[i].empty())
+        continue;
+      if (!found || scores[i] > scores[next]) {
+        next = i;
+        found = true;
+      }
+    }
+    if (!found)
+      break;
+  }
+  return order;
+}
+
+}  // namespace opt
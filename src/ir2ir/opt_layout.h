@@ -0,0 +1,39 @@
+#pragma once
+
+#include "opt_cfg.h"
+#include "opt_pass.h"
+
+namespace opt {
+
+// 重排基本块，让跳转尽量变成直接往下执行
+// 按估计的边频率从高到低把块连成链（Pettis-Hansen），再把链排起来
+// 块的频率按循环嵌套深度估计，离开循环的边认为不太会走
+// 后端会删掉跳到下一个块的j
+class BlockLayout : public FunctionPass {
+ public:
+  BlockLayout();
+  const string Name() const override { return "layout"; }
+  bool RunOnFunction(koopa_raw_function_t func) override;
+
+ private:
+  // 控制流边和估计的执行次数
+  struct Edge {
+    BB from;
+    BB to;
+    double weight;
+  };
+
+  vector<Edge> edges;
+  // 每个块所在的链，链里的块按顺序排列
+  map<BB, size_t> chain_of;
+  vector<vector<BB>> chains;
+
+  void Clear();
+  void CollectEdges(const CFG& cfg);
+  // 从大到小处理边，from是链尾、to是链头时把两条链接起来
+  void BuildChains(const CFG& cfg);
+  // 入口所在的链放最前，之后每次选和已放好的块联系最紧的链
+  vector<BB> PlaceChains(const CFG& cfg);
+};
+
+}  // namespace opt
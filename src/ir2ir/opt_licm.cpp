@@ -0,0 +1,199 @@
+#include "opt_licm.h"
+
+namespace opt {
+
+LICM::LICM(ir::RawProgramManager& _raw) : raw(_raw) {}
+
+bool LICM::RunOnFunction(koopa_raw_function_t func) {
+  Clear();
+  bool changed = RemoveUnreachableBlocks(func);
+
+  // 先给所有循环建好前置块，再重新分析
+  changed |= InsertPreheaders(func, raw);
+  CFG cfg(func);
+  LoopNest nest(cfg);
+  CollectDefs(func);
+  for (Loop* loop : nest.loops) {
+    BB preheader = GetOrInsertPreheader(func, *loop, cfg, raw);
+    changed |= HoistLoop(*loop, preheader, cfg);
+  }
+  for (Loop* loop : nest.loops) {
+    if (loop->parent != nullptr)
+      continue;
+    BB preheader = GetOrInsertPreheader(func, *loop, cfg, raw);
+    changed |= MaterializeGlobals(*loop, preheader, cfg);
+  }
+  return changed;
+}
+
+void LICM::Clear() {
+  def_block.clear();
+  has_call = false;
+  store_bases.clear();
+  exiting.clear();
+}
+
+void LICM::CollectDefs(koopa_raw_function_t func) {
+  for (size_t i = 0; i < func->bbs.len; ++i) {
+    BB bb = SliceAt<BB>(func->bbs, i);
+    for (size_t j = 0; j < bb->params.len; ++j) {
+      def_block[SliceAt<koopa_raw_value_t>(bb->params, j)] = bb;
+    }
+    for (size_t j = 0; j < bb->insts.len; ++j) {
+      def_block[SliceAt<koopa_raw_value_t>(bb->insts, j)] = bb;
+    }
+  }
+}
+
+bool LICM::IsInvariant(koopa_raw_value_t value, const Loop& loop) {
+  // 常量、全局变量和函数参数都不在基本块里
+  auto it = def_block.find(value);
+  return it == def_block.end() || !loop.Contains(it->second);
+}
+
+koopa_raw_value_t LICM::GetBase(koopa_raw_value_t ptr) {
+  while (true) {
+    const auto& kind = ptr->kind;
+    if (kind.tag == KOOPA_RVT_GET_PTR)
+      ptr = kind.data.get_ptr.src;
+    else if (kind.tag == KOOPA_RVT_GET_ELEM_PTR)
+      ptr = kind.data.get_elem_ptr.src;
+    else if (kind.tag == KOOPA_RVT_GLOBAL_ALLOC || kind.tag == KOOPA_RVT_ALLOC)
+      return ptr;
+    else
+      return nullptr;
+  }
+}
+
+bool LICM::MayAlias(koopa_raw_value_t base) {
+  for (auto store_base : store_bases) {
+    if (base != nullptr && store_base != nullptr) {
+      if (base == store_base)
+        return true;
+      continue;
+    }
+    // 不知道的指针来自参数，不会指向这个函数自己的局部变量
+    auto known = base != nullptr ? base : store_base;
+    if (known == nullptr || known->kind.tag != KOOPA_RVT_ALLOC)
+      return true;
+  }
+  return false;
+}
+
+bool LICM::CanHoist(koopa_raw_value_t inst,
+                    BB bb,
+                    const Loop& loop,
+                    const CFG& cfg) {
+  const auto& kind = inst->kind;
+  switch (kind.tag) {
+    case KOOPA_RVT_BINARY: {
+      const auto& binary = kind.data.binary;
+      if (!IsInvariant(binary.lhs, loop) || !IsInvariant(binary.rhs, loop))
+        return false;
+      if (binary.op == KOOPA_RBO_DIV || binary.op == KOOPA_RBO_MOD)
+        return binary.rhs->kind.tag == KOOPA_RVT_INTEGER &&
+               binary.rhs->kind.data.integer.value != 0;
+      return true;
+    }
+    case KOOPA_RVT_GET_PTR:
+      return IsInvariant(kind.data.get_ptr.src, loop) &&
+             IsInvariant(kind.data.get_ptr.index, loop);
+    case KOOPA_RVT_GET_ELEM_PTR:
+      return IsInvariant(kind.data.get_elem_ptr.src, loop) &&
+             IsInvariant(kind.data.get_elem_ptr.index, loop);
+    case KOOPA_RVT_LOAD: {
+      auto src = kind.data.load.src;
+      if (has_call || !IsInvariant(src, loop) || MayAlias(GetBase(src)))
+        return false;
+      // 变量本身总能读，算出来的地址只在原来就一定会读时才能提前读
+      if (src->kind.tag == KOOPA_RVT_GLOBAL_ALLOC ||
+          src->kind.tag == KOOPA_RVT_ALLOC)
+        return true;
+      if (exiting.empty())
+        return false;
+      for (BB exit : exiting) {
+        if (!cfg.Dominates(bb, exit))
+          return false;
+      }
+      return true;
+    }
+    default:
+      return false;
+  }
+}
+
+bool LICM::HoistLoop(const Loop& loop, BB preheader, const CFG& cfg) {
+  has_call = false;
+  store_bases.clear();
+  exiting.clear();
+  for (BB bb : cfg.rpo) {
+    if (!loop.Contains(bb))
+      continue;
+    for (size_t j = 0; j < bb->insts.len; ++j) {
+      auto inst = SliceAt<koopa_raw_value_t>(bb->insts, j);
+      if (inst->kind.tag == KOOPA_RVT_CALL)
+        has_call = true;
+      else if (inst->kind.tag == KOOPA_RVT_STORE)
+        store_bases.push_back(GetBase(inst->kind.data.store.dest));
+    }
+    // ret也算离开循环
+    auto succs = cfg.succs.at(bb);
+    bool exits = succs.empty();
+    for (BB succ : succs) {
+      exits |= !loop.Contains(succ);
+    }
+    if (exits)
+      exiting.push_back(bb);
+  }
+
+  // 按rpo处理，操作数被提出去之后，后面用到它的指令也能提
+  vector<koopa_raw_value_t> hoisted;
+  for (BB bb : cfg.rpo) {
+    if (!loop.Contains(bb))
+      continue;
+    auto& insts = Mutable(bb)->insts;
+    size_t len = 0;
+    for (size_t j = 0; j < insts.len; ++j) {
+      auto inst = SliceAt<koopa_raw_value_t>(insts, j);
+      if (CanHoist(inst, bb, loop, cfg)) {
+        hoisted.push_back(inst);
+        def_block[inst] = preheader;
+        continue;
+      }
+      insts.buffer[len++] = inst;
+    }
+    insts.len = len;
+  }
+  InsertBeforeTerminator(preheader, hoisted, raw);
+  return !hoisted.empty();
+}
+
+bool LICM::MaterializeGlobals(const Loop& loop,
+                              BB preheader,
+                              const CFG& cfg) {
+  map<koopa_raw_value_t, koopa_raw_value_t> ptrs;
+  vector<koopa_raw_value_t> created;
+  auto replace = [&](koopa_raw_value_t value) -> koopa_raw_value_t {
+    if (value->kind.tag != KOOPA_RVT_GLOBAL_ALLOC)
+      return value;
+    auto it = ptrs.find(value);
+    if (it == ptrs.end()) {
+      // getptr @g, 0和@g的类型一样
+      RawValue ptr = raw.NewGetPtr(value, raw.NewInteger(0));
+      created.push_back(ptr);
+      it = ptrs.emplace(value, ptr).first;
+    }
+    return it->second;
+  };
+  for (BB bb : cfg.rpo) {
+    if (!loop.Contains(bb))
+      continue;
+    for (size_t j = 0; j < bb->insts.len; ++j) {
+      ReplaceOperands(SliceAt<koopa_raw_value_t>(bb->insts, j), replace);
+    }
+  }
+  InsertBeforeTerminator(preheader, created, raw);
+  return !created.empty();
+}
+
+}  // namespace opt
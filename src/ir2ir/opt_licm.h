@@ -0,0 +1,46 @@
+#pragma once
+
+#include "opt_loop.h"
+#include "opt_pass.h"
+
+namespace opt {
+
+// 循环不变量外提，从内层循环往外层做，提到循环的前置块里
+// binary、getptr、getelemptr的操作数都在循环外时可以提出去
+// 除法和取模只在除数是非零常量时才提，避免引入除零
+// load还要求循环里没有call，也没有可能写同一个对象的store，
+// 并且地址是变量本身，或者所在的块在每次离开循环前都会执行
+// 最后在最外层循环的前置块里取一次全局变量的地址，循环里不用每次重新取
+class LICM : public FunctionPass {
+ public:
+  LICM(ir::RawProgramManager& _raw);
+  const string Name() const override { return "licm"; }
+  bool RunOnFunction(koopa_raw_function_t func) override;
+
+ private:
+  ir::RawProgramManager& raw;
+
+  // 指令和参数所在的基本块，外提之后改成前置块
+  map<koopa_raw_value_t, BB> def_block;
+  // 当前循环里有没有call，所有store写的变量，离开循环前的最后一个块
+  bool has_call;
+  vector<koopa_raw_value_t> store_bases;
+  vector<BB> exiting;
+
+  void Clear();
+  void CollectDefs(koopa_raw_function_t func);
+  // 值在循环外定义，或者是常量、全局变量
+  bool IsInvariant(koopa_raw_value_t value, const Loop& loop);
+  // 地址指向的变量，不知道时返回nullptr
+  koopa_raw_value_t GetBase(koopa_raw_value_t ptr);
+  bool MayAlias(koopa_raw_value_t base);
+  bool CanHoist(koopa_raw_value_t inst,
+                BB bb,
+                const Loop& loop,
+                const CFG& cfg);
+  bool HoistLoop(const Loop& loop, BB preheader, const CFG& cfg);
+  // 把循环里用到的全局变量地址换成前置块里算好的指针
+  bool MaterializeGlobals(const Loop& loop, BB preheader, const CFG& cfg);
+};
+
+}  // namespace opt
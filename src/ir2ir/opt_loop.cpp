@@ -0,0 +1,229 @@
+#include "opt_loop.h"
+#include <algorithm>
+
+namespace opt {
+
+Loop::Loop(BB _header)
+    : header(_header), blocks(), latches(), parent(nullptr), depth(0) {}
+
+bool Loop::Contains(BB bb) const {
+  return blocks.count(bb) != 0;
+}
+
+LoopNest::LoopNest(const CFG& cfg) {
+  // 找回边，按头在rpo中的顺序建立循环
+  map<BB, Loop*> header_loop;
+  for (BB bb : cfg.rpo) {
+    for (BB succ : cfg.succs.at(bb)) {
+      if (!cfg.Dominates(succ, bb))
+        continue;
+      auto it = header_loop.find(succ);
+      if (it == header_loop.end()) {
+        storage.push_back(std::make_unique<Loop>(succ));
+        it = header_loop.emplace(succ, storage.back().get()).first;
+      }
+      it->second->latches.push_back(bb);
+    }
+  }
+
+  // 从回边起点沿前驱往回走，走到头为止
+  for (auto& loop : storage) {
+    loop->blocks.insert(loop->header);
+    vector<BB> worklist(loop->latches.begin(), loop->latches.end());
+    while (!worklist.empty()) {
+      BB bb = worklist.back();
+      worklist.pop_back();
+      if (!loop->blocks.insert(bb).second)
+        continue;
+      for (BB pred : cfg.preds.at(bb)) {
+        worklist.push_back(pred);
+      }
+    }
+  }
+
+  // 父循环是包含自己的头的最小的循环
+  for (auto& loop : storage) {
+    for (auto& other : storage) {
+      if (other == loop || !other->Contains(loop->header) ||
+          other->blocks.size() <= loop->blocks.size())
+        continue;
+      if (loop->parent == nullptr ||
+          other->blocks.size() < loop->parent->blocks.size())
+        loop->parent = other.get();
+    }
+  }
+  for (auto& loop : storage) {
+    if (loop->parent != nullptr)
+      loop->parent->children.push_back(loop.get());
+    for (Loop* cur = loop.get(); cur != nullptr; cur = cur->parent) {
+      loop->depth++;
+    }
+    loops.push_back(loop.get());
+  }
+  std::stable_sort(loops.begin(), loops.end(), [](Loop* a, Loop* b) {
+    return a->depth > b->depth;
+  });
+
+  // 越深的循环越小，先记录的就是最内层
+  for (Loop* loop : loops) {
+    for (BB bb : loop->blocks) {
+      block_loop.emplace(bb, loop);
+    }
+  }
+}
+
+Loop* LoopNest::GetLoop(BB bb) const {
+  auto it = block_loop.find(bb);
+  return it == block_loop.end() ? nullptr : it->second;
+}
+
+int LoopNest::GetDepth(BB bb) const {
+  Loop* loop = GetLoop(bb);
+  return loop == nullptr ? 0 : loop->depth;
+}
+
+// 把term中跳到from的边改成跳到to
+static void RetargetEdges(koopa_raw_value_t term, BB from, BB to) {
+  auto& kind = Mutable(term)->kind;
+  if (kind.tag == KOOPA_RVT_JUMP) {
+    if (kind.data.jump.target == from)
+      kind.data.jump.target = to;
+  } else if (kind.tag == KOOPA_RVT_BRANCH) {
+    if (kind.data.branch.true_bb == from)
+      kind.data.branch.true_bb = to;
+    if (kind.data.branch.false_bb == from)
+      kind.data.branch.false_bb = to;
+  }
+}
+
+BB GetOrInsertPreheader(koopa_raw_function_t func,
+                        Loop& loop,
+                        const CFG& cfg,
+                        ir::RawProgramManager& raw) {
+  BB header = loop.header;
+  set<BB> outside;
+  size_t edges = 0;
+  for (BB pred : cfg.preds.at(header)) {
+    if (!loop.Contains(pred)) {
+      outside.insert(pred);
+      edges++;
+    }
+  }
+  if (edges == 1 &&
+      GetTerminator(*outside.begin())->kind.tag == KOOPA_RVT_JUMP)
+    return *outside.begin();
+
+  // 参数原样传给头
+  RawBB preheader = raw.NewBasicBlock(std::string(header->name) + "_ph");
+  vector<const void*> params;
+  for (size_t i = 0; i < header->params.len; ++i) {
+    auto param = SliceAt<koopa_raw_value_t>(header->params, i);
+    params.push_back(raw.NewBlockArgRef(i, param->ty));
+  }
+  preheader->params = raw.NewSlice(params, KOOPA_RSIK_VALUE);
+  RawValue jump = raw.NewJump(header);
+  jump->kind.data.jump.args = raw.NewSlice(params, KOOPA_RSIK_VALUE);
+  preheader->insts = raw.NewSlice({jump}, KOOPA_RSIK_VALUE);
+
+  for (BB pred : outside) {
+    RetargetEdges(GetTerminator(pred), header, preheader);
+  }
+
+  // 放在头前面
+  vector<const void*> bbs;
+  for (size_t i = 0; i < func->bbs.len; ++i) {
+    BB bb = SliceAt<BB>(func->bbs, i);
+    if (bb == header)
+      bbs.push_back(preheader);
+    bbs.push_back(bb);
+  }
+  Mutable(func)->bbs = raw.NewSlice(bbs, KOOPA_RSIK_BASIC_BLOCK);
+
+  for (Loop* cur = loop.parent; cur != nullptr; cur = cur->parent) {
+    cur->blocks.insert(preheader);
+  }
+  return preheader;
+}
+
+void InsertBeforeTerminator(BB bb,
+                            const vector<koopa_raw_value_t>& insts,
+                            ir::RawProgramManager& raw) {
+  if (insts.empty())
+    return;
+  RawBB raw_bb = Mutable(bb);
+  vector<const void*> items(raw_bb->insts.buffer,
+                            raw_bb->insts.buffer + raw_bb->insts.len - 1);
+  items.insert(items.end(), insts.begin(), insts.end());
+  items.push_back(GetTerminator(bb));
+  raw_bb->insts = raw.NewSlice(items, KOOPA_RSIK_VALUE);
+}
+
+bool InsertPreheaders(koopa_raw_function_t func, ir::RawProgramManager& raw) {
+  CFG cfg(func);
+  LoopNest nest(cfg);
+  size_t len = func->bbs.len;
+  for (Loop* loop : nest.loops) {
+    GetOrInsertPreheader(func, *loop, cfg, raw);
+  }
+  return func->bbs.len != len;
+}
+
+koopa_raw_slice_t* GetEdgeArgs(BB latch, BB target) {
+  auto& kind = Mutable(GetTerminator(latch))->kind;
+  if (kind.tag == KOOPA_RVT_JUMP) {
+    return kind.data.jump.target == target ? &kind.data.jump.args : nullptr;
+  }
+  if (kind.tag != KOOPA_RVT_BRANCH)
+    return nullptr;
+  auto& branch = kind.data.branch;
+  if (branch.true_bb == target && branch.false_bb != target)
+    return &branch.true_args;
+  if (branch.false_bb == target && branch.true_bb != target)
+    return &branch.false_args;
+  return nullptr;
+}
+
+// value是否是param加减一个常量，是时返回步长
+static bool GetStep(koopa_raw_value_t value,
+                    koopa_raw_value_t param,
+                    int& step) {
+  if (value->kind.tag != KOOPA_RVT_BINARY)
+    return false;
+  const auto& binary = value->kind.data.binary;
+  auto lhs = binary.lhs, rhs = binary.rhs;
+  if (binary.op == KOOPA_RBO_ADD && lhs->kind.tag == KOOPA_RVT_INTEGER)
+    std::swap(lhs, rhs);
+  if (lhs != param || rhs->kind.tag != KOOPA_RVT_INTEGER)
+    return false;
+  int imm = rhs->kind.data.integer.value;
+  if (binary.op == KOOPA_RBO_ADD) {
+    step = imm;
+    return true;
+  }
+  if (binary.op == KOOPA_RBO_SUB) {
+    step = static_cast<int>(0u - static_cast<unsigned>(imm));
+    return true;
+  }
+  return false;
+}
+
+vector<InductionVar> FindInductionVars(const Loop& loop, BB preheader) {
+  vector<InductionVar> ret;
+  if (loop.latches.size() != 1)
+    return ret;
+  BB header = loop.header;
+  auto init_args = GetEdgeArgs(preheader, header);
+  auto latch_args = GetEdgeArgs(loop.latches[0], header);
+  if (init_args == nullptr || latch_args == nullptr)
+    return ret;
+  for (size_t i = 0; i < header->params.len; ++i) {
+    auto param = SliceAt<koopa_raw_value_t>(header->params, i);
+    auto next = SliceAt<koopa_raw_value_t>(*latch_args, i);
+    int step;
+    if (param->ty->tag == KOOPA_RTT_INT32 && GetStep(next, param, step))
+      ret.push_back({param, SliceAt<koopa_raw_value_t>(*init_args, i), step});
+  }
+  return ret;
+}
+
+}  // namespace opt
@@ -0,0 +1,72 @@
+#pragma once
+
+#include <memory>
+#include "opt_cfg.h"
+
+namespace opt {
+
+using std::unique_ptr;
+
+// 自然循环：回边的目标是头，能不经过头走到回边起点的块都在循环里
+// 同一个头的多条回边算一个循环
+struct Loop {
+  BB header;
+  // 循环里的基本块，包括子循环的
+  set<BB> blocks;
+  // 回边的起点
+  vector<BB> latches;
+  Loop* parent;
+  vector<Loop*> children;
+  // 最外层的循环是1
+  int depth;
+
+  Loop(BB _header);
+  bool Contains(BB bb) const;
+};
+
+// 函数里所有循环的嵌套关系
+// 修改了CFG之后需要和CFG一起重新构造
+class LoopNest {
+ public:
+  LoopNest(const CFG& cfg);
+
+  // 所有循环，内层在外层之前
+  vector<Loop*> loops;
+
+  // 基本块所在的最内层循环，不在循环里时返回nullptr
+  Loop* GetLoop(BB bb) const;
+  // 基本块的循环嵌套深度，不在循环里时是0
+  int GetDepth(BB bb) const;
+
+ private:
+  vector<unique_ptr<Loop>> storage;
+  map<BB, Loop*> block_loop;
+};
+
+// 循环的前置块：循环外唯一的前驱，并且以jump结尾
+// 没有时新建一个，所有循环外的前驱改为跳到它，它再带着参数跳到头
+// 新建的块会加入外层循环，CFG需要重新构造
+BB GetOrInsertPreheader(koopa_raw_function_t func,
+                        Loop& loop,
+                        const CFG& cfg,
+                        ir::RawProgramManager& raw);
+// 把指令插到基本块的最后一条指令之前
+void InsertBeforeTerminator(BB bb,
+                            const vector<koopa_raw_value_t>& insts,
+                            ir::RawProgramManager& raw);
+// 给函数里所有的循环建好前置块，有新建时返回true
+bool InsertPreheaders(koopa_raw_function_t func, ir::RawProgramManager& raw);
+
+// 基本归纳变量：头的参数，从前置块传入init，每次回到头时加上step
+struct InductionVar {
+  koopa_raw_value_t param;
+  koopa_raw_value_t init;
+  int step;
+};
+
+// 从latch跳到target的实参，branch的两个目标都是target时返回nullptr
+koopa_raw_slice_t* GetEdgeArgs(BB latch, BB target);
+// 只有一个latch的循环里的基本归纳变量，前置块要已经建好
+vector<InductionVar> FindInductionVars(const Loop& loop, BB preheader);
+
+}  // namespace opt
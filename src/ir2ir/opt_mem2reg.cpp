@@ -0,0 +1,247 @@
+#include "opt_mem2reg.h"
+
+namespace opt {
+
+Mem2Reg::Mem2Reg(ir::RawProgramManager& _raw) : raw(_raw) {}
+
+bool Mem2Reg::RunOnFunction(koopa_raw_function_t func) {
+  Clear();
+  // 不可达的块没有支配关系，先删掉
+  bool changed = RemoveUnreachableBlocks(func);
+  CFG cfg(func);
+
+  CollectAllocs(func);
+  if (allocs.empty())
+    return changed;
+  InsertParams(cfg);
+  cur_values.assign(allocs.size(), {});
+  Rename(cfg.entry, cfg);
+  Rewrite(func);
+  return true;
+}
+
+void Mem2Reg::Clear() {
+  allocs.clear();
+  alloc_ids.clear();
+  param_allocs.clear();
+  new_params.clear();
+  replace.clear();
+  cur_values.clear();
+  removed.clear();
+}
+
+void Mem2Reg::CollectAllocs(koopa_raw_function_t func) {
+  set<koopa_raw_value_t> candidates;
+  for (size_t i = 0; i < func->bbs.len; ++i) {
+    BB bb = SliceAt<BB>(func->bbs, i);
+    for (size_t j = 0; j < bb->insts.len; ++j) {
+      auto inst = SliceAt<koopa_raw_value_t>(bb->insts, j);
+      if (inst->kind.tag != KOOPA_RVT_ALLOC)
+        continue;
+      auto base_tag = inst->ty->data.pointer.base->tag;
+      if (base_tag == KOOPA_RTT_INT32 || base_tag == KOOPA_RTT_POINTER)
+        candidates.insert(inst);
+    }
+  }
+
+  // 除了load的地址和store的目标，其他任何使用都算取了地址
+  for (size_t i = 0; i < func->bbs.len; ++i) {
+    BB bb = SliceAt<BB>(func->bbs, i);
+    for (size_t j = 0; j < bb->insts.len; ++j) {
+      auto inst = SliceAt<koopa_raw_value_t>(bb->insts, j);
+      if (inst->kind.tag == KOOPA_RVT_LOAD)
+        continue;
+      if (inst->kind.tag == KOOPA_RVT_STORE) {
+        candidates.erase(inst->kind.data.store.value);
+        continue;
+      }
+      for (auto op : GetOperands(inst)) {
+        candidates.erase(op);
+      }
+    }
+  }
+
+  // 按出现的顺序编号，保证输出稳定
+  for (size_t i = 0; i < func->bbs.len; ++i) {
+    BB bb = SliceAt<BB>(func->bbs, i);
+    for (size_t j = 0; j < bb->insts.len; ++j) {
+      auto inst = SliceAt<koopa_raw_value_t>(bb->insts, j);
+      if (candidates.count(inst)) {
+        alloc_ids[inst] = allocs.size();
+        allocs.push_back(inst);
+      }
+    }
+  }
+}
+
+void Mem2Reg::InsertParams(const CFG& cfg) {
+  int n = allocs.size();
+  // 有store的块，和store之前就load的块
+  vector<set<BB>> def_blocks(n), use_blocks(n);
+  for (BB bb : cfg.rpo) {
+    set<int> stored;
+    for (size_t j = 0; j < bb->insts.len; ++j) {
+      auto inst = SliceAt<koopa_raw_value_t>(bb->insts, j);
+      if (inst->kind.tag == KOOPA_RVT_STORE) {
+        auto it = alloc_ids.find(inst->kind.data.store.dest);
+        if (it != alloc_ids.end()) {
+          def_blocks[it->second].insert(bb);
+          stored.insert(it->second);
+        }
+      } else if (inst->kind.tag == KOOPA_RVT_LOAD) {
+        auto it = alloc_ids.find(inst->kind.data.load.src);
+        if (it != alloc_ids.end() && !stored.count(it->second))
+          use_blocks[it->second].insert(bb);
+      }
+    }
+  }
+
+  for (int id = 0; id < n; ++id) {
+    // 入口处活跃的块，只在这些块插参数，避免没用的参数
+    set<BB> live_in;
+    vector<BB> worklist(use_blocks[id].begin(), use_blocks[id].end());
+    while (!worklist.empty()) {
+      BB bb = worklist.back();
+      worklist.pop_back();
+      if (!live_in.insert(bb).second)
+        continue;
+      for (BB pred : cfg.preds.at(bb)) {
+        if (!def_blocks[id].count(pred))
+          worklist.push_back(pred);
+      }
+    }
+
+    // 迭代支配边界
+    set<BB> has_param;
+    worklist.assign(def_blocks[id].begin(), def_blocks[id].end());
+    while (!worklist.empty()) {
+      BB bb = worklist.back();
+      worklist.pop_back();
+      for (BB df : cfg.dom_frontier.at(bb)) {
+        if (has_param.count(df) || !live_in.count(df))
+          continue;
+        has_param.insert(df);
+        param_allocs[df].push_back(id);
+        if (!def_blocks[id].count(df))
+          worklist.push_back(df);
+      }
+    }
+  }
+
+  // 加在原有参数之后
+  for (auto& item : param_allocs) {
+    RawBB bb = Mutable(item.first);
+    vector<const void*> params(bb->params.buffer,
+                               bb->params.buffer + bb->params.len);
+    for (int id : item.second) {
+      koopa_raw_type_t ty = allocs[id]->ty->data.pointer.base;
+      RawValue param = raw.NewBlockArgRef(params.size(), ty);
+      new_params[bb].push_back(param);
+      params.push_back(param);
+    }
+    bb->params = raw.NewSlice(params, KOOPA_RSIK_VALUE);
+  }
+}
+
+void Mem2Reg::Rename(BB bb, const CFG& cfg) {
+  // 离开这个块时要弹出的值
+  vector<int> pushed;
+  auto it = param_allocs.find(bb);
+  if (it != param_allocs.end()) {
+    for (size_t k = 0; k < it->second.size(); ++k) {
+      int id = it->second[k];
+      cur_values[id].push_back(new_params[bb][k]);
+      pushed.push_back(id);
+    }
+  }
+
+  for (size_t j = 0; j < bb->insts.len; ++j) {
+    auto inst = SliceAt<koopa_raw_value_t>(bb->insts, j);
+    const auto& kind = inst->kind;
+    if (kind.tag == KOOPA_RVT_ALLOC && alloc_ids.count(inst)) {
+      removed.insert(inst);
+    } else if (kind.tag == KOOPA_RVT_LOAD &&
+               alloc_ids.count(kind.data.load.src)) {
+      int id = alloc_ids[kind.data.load.src];
+      replace[inst] =
+          cur_values[id].empty() ? GetUndef(id) : cur_values[id].back();
+      removed.insert(inst);
+    } else if (kind.tag == KOOPA_RVT_STORE &&
+               alloc_ids.count(kind.data.store.dest)) {
+      int id = alloc_ids[kind.data.store.dest];
+      cur_values[id].push_back(Resolve(kind.data.store.value));
+      pushed.push_back(id);
+      removed.insert(inst);
+    }
+  }
+
+  // 把当前的值传给后继新增的参数
+  RawValue term = Mutable(GetTerminator(bb));
+  if (term->kind.tag == KOOPA_RVT_JUMP) {
+    auto& jump = term->kind.data.jump;
+    AppendArgs(jump.target, jump.args);
+  } else if (term->kind.tag == KOOPA_RVT_BRANCH) {
+    auto& branch = term->kind.data.branch;
+    AppendArgs(branch.true_bb, branch.true_args);
+    AppendArgs(branch.false_bb, branch.false_args);
+  }
+
+  auto children = cfg.dom_children.find(bb);
+  if (children != cfg.dom_children.end()) {
+    for (BB child : children->second) {
+      Rename(child, cfg);
+    }
+  }
+
+  for (int id : pushed) {
+    cur_values[id].pop_back();
+  }
+}
+
+void Mem2Reg::AppendArgs(BB target, koopa_raw_slice_t& args) {
+  auto it = param_allocs.find(target);
+  if (it == param_allocs.end())
+    return;
+  vector<const void*> items(args.buffer, args.buffer + args.len);
+  for (int id : it->second) {
+    items.push_back(cur_values[id].empty() ? GetUndef(id)
+                                           : cur_values[id].back());
+  }
+  args = raw.NewSlice(items, KOOPA_RSIK_VALUE);
+}
+
+koopa_raw_value_t Mem2Reg::GetUndef(const int& id) {
+  // 未初始化的局部变量按0处理
+  koopa_raw_type_t ty = allocs[id]->ty->data.pointer.base;
+  if (ty->tag == KOOPA_RTT_INT32)
+    return raw.NewInteger(0);
+  return raw.NewUndef(ty);
+}
+
+const koopa_raw_value_t Mem2Reg::Resolve(koopa_raw_value_t value) {
+  auto it = replace.find(value);
+  while (it != replace.end()) {
+    value = it->second;
+    it = replace.find(value);
+  }
+  return value;
+}
+
+void Mem2Reg::Rewrite(koopa_raw_function_t func) {
+  auto resolve = [this](koopa_raw_value_t value) { return Resolve(value); };
+  for (size_t i = 0; i < func->bbs.len; ++i) {
+    RawBB bb = Mutable(SliceAt<BB>(func->bbs, i));
+    // 原地压缩指令
+    size_t len = 0;
+    for (size_t j = 0; j < bb->insts.len; ++j) {
+      auto inst = SliceAt<koopa_raw_value_t>(bb->insts, j);
+      if (removed.count(inst))
+        continue;
+      ReplaceOperands(inst, resolve);
+      bb->insts.buffer[len++] = inst;
+    }
+    bb->insts.len = len;
+  }
+}
+
+}  // namespace opt
@@ -0,0 +1,48 @@
+#pragma once
+
+#include "opt_cfg.h"
+#include "opt_pass.h"
+
+namespace opt {
+
+// 把只被load/store的标量alloc提升成SSA值
+// 在支配边界插入基本块参数（相当于phi），跳转时传入实参
+class Mem2Reg : public FunctionPass {
+ public:
+  Mem2Reg(ir::RawProgramManager& _raw);
+  const string Name() const override { return "mem2reg"; }
+  bool RunOnFunction(koopa_raw_function_t func) override;
+
+ private:
+  ir::RawProgramManager& raw;
+
+  // 可以提升的alloc及其编号
+  vector<koopa_raw_value_t> allocs;
+  map<koopa_raw_value_t, int> alloc_ids;
+  // 每个基本块新增的参数，和参数对应的alloc编号
+  map<BB, vector<int>> param_allocs;
+  map<BB, vector<koopa_raw_value_t>> new_params;
+  // 被删除的load替换成的值
+  map<koopa_raw_value_t, koopa_raw_value_t> replace;
+  // 重命名时每个alloc当前的值
+  vector<vector<koopa_raw_value_t>> cur_values;
+  // 要删除的alloc、load、store
+  set<koopa_raw_value_t> removed;
+
+  void Clear();
+  // 找出没有被取地址的int和指针alloc
+  void CollectAllocs(koopa_raw_function_t func);
+  // 在alloc活跃的迭代支配边界上插入参数
+  void InsertParams(const CFG& cfg);
+  // 沿支配树重命名
+  void Rename(BB bb, const CFG& cfg);
+  // 在跳转指令上追加新参数的实参
+  void AppendArgs(BB target, koopa_raw_slice_t& args);
+  // 从未store过的alloc被load时的值
+  koopa_raw_value_t GetUndef(const int& id);
+  const koopa_raw_value_t Resolve(koopa_raw_value_t value);
+  // 删掉提升掉的指令，替换所有使用
+  void Rewrite(koopa_raw_function_t func);
+};
+
+}  // namespace opt
@@ -0,0 +1,52 @@
+#include "opt_pass.h"
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include "opt_util.h"
+
+namespace opt {
+
+bool FunctionPass::Run(const koopa_raw_program_t& program) {
+  bool changed = false;
+  for (size_t i = 0; i < program.funcs.len; ++i) {
+    auto func = SliceAt<koopa_raw_function_t>(program.funcs, i);
+    if (func->bbs.len != 0)
+      changed |= RunOnFunction(func);
+  }
+  return changed;
+}
+
+PassManager::PassManager() : passes(), costs(), changed() {}
+
+void PassManager::AddPass(unique_ptr<Pass> pass) {
+  passes.push_back(std::move(pass));
+  costs.push_back(0);
+  changed.push_back(false);
+}
+
+void PassManager::Run(const koopa_raw_program_t& program) {
+  using clock = std::chrono::steady_clock;
+  for (size_t i = 0; i < passes.size(); ++i) {
+    auto begin = clock::now();
+    if (passes[i]->Run(program))
+      changed[i] = true;
+    std::chrono::duration<double, std::milli> cost = clock::now() - begin;
+    costs[i] += cost.count();
+  }
+}
+
+void PassManager::Report() const {
+  double total = 0;
+  for (size_t i = 0; i < passes.size(); ++i) {
+    total += costs[i];
+    std::cerr << std::left << std::setw(16) << passes[i]->Name() << std::right
+              << std::fixed << std::setprecision(3) << std::setw(10)
+              << costs[i] << " ms" << (changed[i] ? "" : "  (unchanged)")
+              << std::endl;
+  }
+  std::cerr << std::left << std::setw(16) << "total" << std::right
+            << std::fixed << std::setprecision(3) << std::setw(10) << total
+            << " ms" << std::endl;
+}
+
+}  // namespace opt
@@ -0,0 +1,47 @@
+#pragma once
+
+#include <memory>
+#include <string>
+#include <vector>
+#include "koopa.h"
+
+namespace opt {
+
+using std::string, std::unique_ptr, std::vector;
+
+// IR上的一个优化，原地修改raw program
+class Pass {
+ public:
+  virtual ~Pass() = default;
+  // 打印计时用的名字
+  virtual const string Name() const = 0;
+  // 返回是否修改了IR
+  virtual bool Run(const koopa_raw_program_t& program) = 0;
+};
+
+// 逐个函数运行的pass，跳过只有声明的函数
+class FunctionPass : public Pass {
+ public:
+  bool Run(const koopa_raw_program_t& program) override;
+  virtual bool RunOnFunction(koopa_raw_function_t func) = 0;
+};
+
+// 按加入的顺序运行pass，并统计每个pass的耗时
+// 流式生成时每个函数Run一次，耗时累加
+class PassManager {
+ public:
+  PassManager();
+
+  void AddPass(unique_ptr<Pass> pass);
+  void Run(const koopa_raw_program_t& program);
+  // 把每个pass的累计耗时打印到stderr
+  void Report() const;
+
+ private:
+  vector<unique_ptr<Pass>> passes;
+  // 每个pass的累计耗时(ms)，和是否修改过IR
+  vector<double> costs;
+  vector<bool> changed;
+};
+
+}  // namespace opt
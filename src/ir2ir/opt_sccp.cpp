@@ -0,0 +1,261 @@
+#include "opt_sccp.h"
+#include <climits>
+
+namespace opt {
+
+SCCP::SCCP(ir::RawProgramManager& _raw) : raw(_raw) {}
+
+bool SCCP::RunOnFunction(koopa_raw_function_t func) {
+  Clear();
+  CollectUsers(func);
+
+  BB entry = SliceAt<BB>(func->bbs, 0);
+  exec_blocks.insert(entry);
+  block_worklist.push_back(entry);
+  while (!block_worklist.empty() || !value_worklist.empty()) {
+    if (!block_worklist.empty()) {
+      BB bb = block_worklist.back();
+      block_worklist.pop_back();
+      for (size_t j = 0; j < bb->insts.len; ++j) {
+        VisitInst(SliceAt<koopa_raw_value_t>(bb->insts, j), bb);
+      }
+      continue;
+    }
+    auto value = value_worklist.back();
+    value_worklist.pop_back();
+    auto it = users.find(value);
+    if (it == users.end())
+      continue;
+    for (auto user : it->second) {
+      BB bb = inst_block.at(user);
+      if (exec_blocks.count(bb))
+        VisitInst(user, bb);
+    }
+  }
+  return Rewrite(func);
+}
+
+void SCCP::Clear() {
+  lattice.clear();
+  users.clear();
+  inst_block.clear();
+  exec_blocks.clear();
+  exec_edges.clear();
+  block_worklist.clear();
+  value_worklist.clear();
+}
+
+void SCCP::CollectUsers(koopa_raw_function_t func) {
+  for (size_t i = 0; i < func->bbs.len; ++i) {
+    BB bb = SliceAt<BB>(func->bbs, i);
+    for (size_t j = 0; j < bb->insts.len; ++j) {
+      auto inst = SliceAt<koopa_raw_value_t>(bb->insts, j);
+      inst_block[inst] = bb;
+      for (auto op : GetOperands(inst)) {
+        users[op].push_back(inst);
+      }
+    }
+  }
+}
+
+const SCCP::Lattice SCCP::GetLattice(koopa_raw_value_t value) {
+  if (value->kind.tag == KOOPA_RVT_INTEGER)
+    return {Lattice::e_const, value->kind.data.integer.value};
+  auto it = lattice.find(value);
+  if (it != lattice.end())
+    return it->second;
+  // 只有binary和基本块参数可能是常量，其他的一律不是
+  if (value->kind.tag == KOOPA_RVT_BINARY ||
+      value->kind.tag == KOOPA_RVT_BLOCK_ARG_REF)
+    return {Lattice::e_top, 0};
+  return {Lattice::e_bottom, 0};
+}
+
+void SCCP::LowerLattice(koopa_raw_value_t value, const Lattice& other) {
+  Lattice old = GetLattice(value);
+  Lattice meet = old;
+  if (other.state == Lattice::e_top || old.state == Lattice::e_bottom) {
+    return;
+  } else if (old.state == Lattice::e_top) {
+    meet = other;
+  } else if (other.state == Lattice::e_bottom || other.value != old.value) {
+    meet = {Lattice::e_bottom, 0};
+  }
+  if (meet.state == old.state)
+    return;
+  lattice[value] = meet;
+  value_worklist.push_back(value);
+}
+
+void SCCP::VisitInst(koopa_raw_value_t inst, BB bb) {
+  const auto& kind = inst->kind;
+  switch (kind.tag) {
+    case KOOPA_RVT_BINARY:
+      LowerLattice(inst, EvalBinary(kind.data.binary));
+      break;
+    case KOOPA_RVT_BRANCH: {
+      const auto& branch = kind.data.branch;
+      Lattice cond = GetLattice(branch.cond);
+      if (cond.state == Lattice::e_top)
+        break;
+      if (cond.state == Lattice::e_bottom || cond.value != 0)
+        VisitEdge(bb, branch.true_bb, branch.true_args);
+      if (cond.state == Lattice::e_bottom || cond.value == 0)
+        VisitEdge(bb, branch.false_bb, branch.false_args);
+      break;
+    }
+    case KOOPA_RVT_JUMP:
+      VisitEdge(bb, kind.data.jump.target, kind.data.jump.args);
+      break;
+    default:
+      break;
+  }
+}
+
+void SCCP::VisitEdge(BB from, BB to, const koopa_raw_slice_t& args) {
+  for (size_t i = 0; i < args.len; ++i) {
+    auto param = SliceAt<koopa_raw_value_t>(to->params, i);
+    LowerLattice(param, GetLattice(SliceAt<koopa_raw_value_t>(args, i)));
+  }
+  exec_edges.emplace(from, to);
+  if (exec_blocks.insert(to).second)
+    block_worklist.push_back(to);
+}
+
+const SCCP::Lattice SCCP::EvalBinary(const koopa_raw_binary_t& binary) {
+  Lattice lhs = GetLattice(binary.lhs);
+  Lattice rhs = GetLattice(binary.rhs);
+  if (lhs.state == Lattice::e_bottom || rhs.state == Lattice::e_bottom)
+    return {Lattice::e_bottom, 0};
+  if (lhs.state == Lattice::e_top || rhs.state == Lattice::e_top)
+    return {Lattice::e_top, 0};
+
+  // 按32位补码回绕
+  unsigned l = lhs.value, r = rhs.value;
+  int a = lhs.value, b = rhs.value;
+  int result = 0;
+  switch (binary.op) {
+    case KOOPA_RBO_NOT_EQ:
+      result = a != b;
+      break;
+    case KOOPA_RBO_EQ:
+      result = a == b;
+      break;
+    case KOOPA_RBO_GT:
+      result = a > b;
+      break;
+    case KOOPA_RBO_LT:
+      result = a < b;
+      break;
+    case KOOPA_RBO_GE:
+      result = a >= b;
+      break;
+    case KOOPA_RBO_LE:
+      result = a <= b;
+      break;
+    case KOOPA_RBO_ADD:
+      result = l + r;
+      break;
+    case KOOPA_RBO_SUB:
+      result = l - r;
+      break;
+    case KOOPA_RBO_MUL:
+      result = l * r;
+      break;
+    case KOOPA_RBO_DIV:
+    case KOOPA_RBO_MOD:
+      // 除以0和溢出留到运行时
+      if (b == 0 || (a == INT_MIN && b == -1))
+        return {Lattice::e_bottom, 0};
+      result = binary.op == KOOPA_RBO_DIV ? a / b : a % b;
+      break;
+    case KOOPA_RBO_AND:
+      result = l & r;
+      break;
+    case KOOPA_RBO_OR:
+      result = l | r;
+      break;
+    case KOOPA_RBO_XOR:
+      result = l ^ r;
+      break;
+    case KOOPA_RBO_SHL:
+      result = l << (r & 31);
+      break;
+    case KOOPA_RBO_SHR:
+      result = l >> (r & 31);
+      break;
+    case KOOPA_RBO_SAR:
+      result = a >> (r & 31);
+      break;
+  }
+  return {Lattice::e_const, result};
+}
+
+bool SCCP::Rewrite(koopa_raw_function_t func) {
+  bool changed = false;
+  // 条件是常量的br改成jump
+  for (BB bb : exec_blocks) {
+    RawValue term = Mutable(GetTerminator(bb));
+    if (term->kind.tag != KOOPA_RVT_BRANCH)
+      continue;
+    Lattice cond = GetLattice(term->kind.data.branch.cond);
+    if (cond.state != Lattice::e_const)
+      continue;
+    auto branch = term->kind.data.branch;
+    term->kind.tag = KOOPA_RVT_JUMP;
+    term->kind.data.jump.target = cond.value ? branch.true_bb : branch.false_bb;
+    term->kind.data.jump.args =
+        cond.value ? branch.true_args : branch.false_args;
+    changed = true;
+  }
+  changed |= RemoveUnreachableBlocks(func);
+
+  // 剩下的边都可能执行，参数的值才是准的
+  map<koopa_raw_value_t, koopa_raw_value_t> replace;
+  set<koopa_raw_value_t> const_params;
+  for (size_t i = 0; i < func->bbs.len; ++i) {
+    BB bb = SliceAt<BB>(func->bbs, i);
+    // 条件一直未定的br，后继可达但没执行过，保守起见不改
+    if (!exec_blocks.count(bb))
+      return changed;
+    for (size_t j = 0; j < bb->params.len; ++j) {
+      auto param = SliceAt<koopa_raw_value_t>(bb->params, j);
+      Lattice value = GetLattice(param);
+      if (value.state == Lattice::e_const) {
+        replace[param] = raw.NewInteger(value.value);
+        const_params.insert(param);
+      }
+    }
+    for (size_t j = 0; j < bb->insts.len; ++j) {
+      auto inst = SliceAt<koopa_raw_value_t>(bb->insts, j);
+      if (inst->kind.tag != KOOPA_RVT_BINARY)
+        continue;
+      Lattice value = GetLattice(inst);
+      if (value.state == Lattice::e_const)
+        replace[inst] = raw.NewInteger(value.value);
+    }
+  }
+  if (replace.empty())
+    return changed;
+
+  auto resolve = [&](koopa_raw_value_t value) {
+    auto it = replace.find(value);
+    return it == replace.end() ? value : it->second;
+  };
+  for (size_t i = 0; i < func->bbs.len; ++i) {
+    RawBB bb = Mutable(SliceAt<BB>(func->bbs, i));
+    size_t len = 0;
+    for (size_t j = 0; j < bb->insts.len; ++j) {
+      auto inst = SliceAt<koopa_raw_value_t>(bb->insts, j);
+      if (replace.count(inst))
+        continue;
+      ReplaceOperands(inst, resolve);
+      bb->insts.buffer[len++] = inst;
+    }
+    bb->insts.len = len;
+  }
+  EraseBlockParams(func, const_params);
+  return true;
+}
+
+}  // namespace opt
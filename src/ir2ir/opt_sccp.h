@@ -0,0 +1,49 @@
+#pragma once
+
+#include "opt_cfg.h"
+#include "opt_pass.h"
+
+namespace opt {
+
+// 稀疏条件常量传播（Wegman-Zadeck）
+// 只沿可能执行的边传播，条件是常量的br改成jump，走不到的块删掉
+// 算出常量的binary和基本块参数换成integer
+class SCCP : public FunctionPass {
+ public:
+  SCCP(ir::RawProgramManager& _raw);
+  const string Name() const override { return "sccp"; }
+  bool RunOnFunction(koopa_raw_function_t func) override;
+
+ private:
+  ir::RawProgramManager& raw;
+
+  // 格：未定 > 常量 > 不是常量，只会往下走
+  struct Lattice {
+    enum { e_top, e_const, e_bottom } state;
+    int value;
+  };
+
+  map<koopa_raw_value_t, Lattice> lattice;
+  // 使用每个值的指令，和指令所在的基本块
+  map<koopa_raw_value_t, vector<koopa_raw_value_t>> users;
+  map<koopa_raw_value_t, BB> inst_block;
+  // 可能执行的基本块和边
+  set<BB> exec_blocks;
+  set<pair<BB, BB>> exec_edges;
+  vector<BB> block_worklist;
+  vector<koopa_raw_value_t> value_worklist;
+
+  void Clear();
+  void CollectUsers(koopa_raw_function_t func);
+  const Lattice GetLattice(koopa_raw_value_t value);
+  // 和原来的值取meet，变低了就加入worklist
+  void LowerLattice(koopa_raw_value_t value, const Lattice& other);
+  void VisitInst(koopa_raw_value_t inst, BB bb);
+  // from到to的边可能执行，实参传给参数
+  void VisitEdge(BB from, BB to, const koopa_raw_slice_t& args);
+  const Lattice EvalBinary(const koopa_raw_binary_t& binary);
+  // 按结果改写IR
+  bool Rewrite(koopa_raw_function_t func);
+};
+
+}  // namespace opt
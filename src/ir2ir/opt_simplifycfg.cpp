@@ -0,0 +1,154 @@
+#include "opt_simplifycfg.h"
+
+namespace opt {
+
+static bool SameArgs(const koopa_raw_slice_t& a, const koopa_raw_slice_t& b) {
+  if (a.len != b.len)
+    return false;
+  for (size_t i = 0; i < a.len; ++i) {
+    if (a.buffer[i] != b.buffer[i])
+      return false;
+  }
+  return true;
+}
+
+// 只有一条jump、没有参数的块，返回跳转；否则返回nullptr
+static koopa_raw_value_t GetForwardJump(BB bb) {
+  if (bb->params.len != 0 || bb->insts.len != 1)
+    return nullptr;
+  auto term = GetTerminator(bb);
+  if (term->kind.tag != KOOPA_RVT_JUMP || term->kind.data.jump.target == bb)
+    return nullptr;
+  return term;
+}
+
+SimplifyCFG::SimplifyCFG(ir::RawProgramManager& _raw) : raw(_raw) {}
+
+bool SimplifyCFG::RunOnFunction(koopa_raw_function_t func) {
+  bool changed = false;
+  bool iter_changed = true;
+  while (iter_changed) {
+    iter_changed = FoldBranches(func);
+    iter_changed |= ThreadJumps(func);
+    // 合并时按前驱个数判断，不可达的前驱要先删掉
+    iter_changed |= RemoveUnreachableBlocks(func);
+    iter_changed |= MergeBlocks(func);
+    changed |= iter_changed;
+  }
+  return changed;
+}
+
+bool SimplifyCFG::FoldBranches(koopa_raw_function_t func) {
+  bool changed = false;
+  for (size_t i = 0; i < func->bbs.len; ++i) {
+    RawValue term = Mutable(GetTerminator(SliceAt<BB>(func->bbs, i)));
+    if (term->kind.tag != KOOPA_RVT_BRANCH)
+      continue;
+    auto branch = term->kind.data.branch;
+    if (branch.true_bb != branch.false_bb ||
+        !SameArgs(branch.true_args, branch.false_args))
+      continue;
+    term->kind.tag = KOOPA_RVT_JUMP;
+    term->kind.data.jump.target = branch.true_bb;
+    term->kind.data.jump.args = branch.true_args;
+    changed = true;
+  }
+  return changed;
+}
+
+bool SimplifyCFG::ThreadJumps(koopa_raw_function_t func) {
+  bool changed = false;
+  // 空块跳转的实参支配这个空块，所以也支配它的所有前驱
+  auto thread = [&](koopa_raw_basic_block_t& target, koopa_raw_slice_t& args) {
+    // 连续的空块一次跳过，成环时停下
+    set<BB> visited;
+    auto jump = GetForwardJump(target);
+    while (jump != nullptr && visited.insert(target).second) {
+      target = jump->kind.data.jump.target;
+      // 复制一份，slice会被原地修改，不能和空块共用
+      const auto& src = jump->kind.data.jump.args;
+      args = raw.NewSlice(
+          vector<const void*>(src.buffer, src.buffer + src.len),
+          KOOPA_RSIK_VALUE);
+      changed = true;
+      jump = GetForwardJump(target);
+    }
+  };
+  BB entry = SliceAt<BB>(func->bbs, 0);
+  for (size_t i = 0; i < func->bbs.len; ++i) {
+    BB bb = SliceAt<BB>(func->bbs, i);
+    // 空块自己不改，等它不可达了再删
+    if (bb != entry && GetForwardJump(bb) != nullptr)
+      continue;
+    RawValue term = Mutable(GetTerminator(bb));
+    if (term->kind.tag == KOOPA_RVT_JUMP) {
+      auto& jump = term->kind.data.jump;
+      thread(jump.target, jump.args);
+    } else if (term->kind.tag == KOOPA_RVT_BRANCH) {
+      auto& branch = term->kind.data.branch;
+      thread(branch.true_bb, branch.true_args);
+      thread(branch.false_bb, branch.false_args);
+    }
+  }
+  return changed;
+}
+
+bool SimplifyCFG::MergeBlocks(koopa_raw_function_t func) {
+  CFG cfg(func);
+  set<BB> merged;
+  // 被并掉的块的参数换成实参
+  map<koopa_raw_value_t, koopa_raw_value_t> replace;
+  for (BB bb : cfg.rpo) {
+    if (merged.count(bb))
+      continue;
+    vector<const void*> insts;
+    auto term = GetTerminator(bb);
+    while (term->kind.tag == KOOPA_RVT_JUMP) {
+      BB succ = term->kind.data.jump.target;
+      if (succ == bb || succ == cfg.entry || cfg.preds.at(succ).size() != 1)
+        break;
+      if (insts.empty())
+        insts.assign(bb->insts.buffer, bb->insts.buffer + bb->insts.len);
+      const auto& args = term->kind.data.jump.args;
+      for (size_t i = 0; i < args.len; ++i) {
+        replace[SliceAt<koopa_raw_value_t>(succ->params, i)] =
+            SliceAt<koopa_raw_value_t>(args, i);
+      }
+      insts.pop_back();
+      insts.insert(insts.end(), succ->insts.buffer,
+                   succ->insts.buffer + succ->insts.len);
+      merged.insert(succ);
+      term = GetTerminator(succ);
+    }
+    if (!insts.empty())
+      Mutable(bb)->insts = raw.NewSlice(insts, KOOPA_RSIK_VALUE);
+  }
+  if (merged.empty())
+    return false;
+
+  auto& bbs = Mutable(func)->bbs;
+  size_t len = 0;
+  for (size_t i = 0; i < bbs.len; ++i) {
+    if (!merged.count(SliceAt<BB>(bbs, i)))
+      bbs.buffer[len++] = bbs.buffer[i];
+  }
+  bbs.len = len;
+
+  auto resolve = [&](koopa_raw_value_t value) {
+    auto it = replace.find(value);
+    while (it != replace.end()) {
+      value = it->second;
+      it = replace.find(value);
+    }
+    return value;
+  };
+  for (size_t i = 0; i < bbs.len; ++i) {
+    BB bb = SliceAt<BB>(bbs, i);
+    for (size_t j = 0; j < bb->insts.len; ++j) {
+      ReplaceOperands(SliceAt<koopa_raw_value_t>(bb->insts, j), resolve);
+    }
+  }
+  return true;
+}
+
+}  // namespace opt
@@ -0,0 +1,28 @@
+#pragma once
+
+#include "opt_cfg.h"
+#include "opt_pass.h"
+
+namespace opt {
+
+// 整理控制流图，直到不再变化
+// 删掉不可达的块，两个目标相同的br改成jump
+// 只有一条jump的空块让前驱直接跳过去，只有一个前驱的块并进前驱
+class SimplifyCFG : public FunctionPass {
+ public:
+  SimplifyCFG(ir::RawProgramManager& _raw);
+  const string Name() const override { return "simplifycfg"; }
+  bool RunOnFunction(koopa_raw_function_t func) override;
+
+ private:
+  ir::RawProgramManager& raw;
+
+  // 两个目标和实参都相同的br改成jump
+  bool FoldBranches(koopa_raw_function_t func);
+  // 跳过只有一条jump的块
+  bool ThreadJumps(koopa_raw_function_t func);
+  // 把只有一个前驱的块并进前驱
+  bool MergeBlocks(koopa_raw_function_t func);
+};
+
+}  // namespace opt
@@ -0,0 +1,80 @@
+#include "opt_tailrec.h"
+
+namespace opt {
+
+TailRecursionElim::TailRecursionElim(ir::RawProgramManager& _raw)
+    : raw(_raw) {}
+
+bool TailRecursionElim::RunOnFunction(koopa_raw_function_t func) {
+  vector<RawBB> sites;
+  for (size_t i = 0; i < func->bbs.len; ++i) {
+    RawBB bb = Mutable(SliceAt<BB>(func->bbs, i));
+    for (size_t j = 0; j < bb->insts.len; ++j) {
+      auto inst = SliceAt<koopa_raw_value_t>(bb->insts, j);
+      if (inst->kind.tag == KOOPA_RVT_ALLOC &&
+          inst->ty->data.pointer.base->tag == KOOPA_RTT_ARRAY)
+        return false;
+    }
+    if (bb->insts.len < 2)
+      continue;
+    auto call = SliceAt<koopa_raw_value_t>(bb->insts, bb->insts.len - 2);
+    if (call->kind.tag == KOOPA_RVT_CALL &&
+        call->kind.data.call.callee == func &&
+        IsTailReturn(call, GetTerminator(bb)))
+      sites.push_back(bb);
+  }
+  if (sites.empty())
+    return false;
+
+  // 原来的入口改成循环头，用基本块参数代替函数参数
+  RawBB header = Mutable(SliceAt<BB>(func->bbs, 0));
+  header->name = raw.NewName("%tailrec");
+  map<koopa_raw_value_t, koopa_raw_value_t> params;
+  vector<const void*> items;
+  for (size_t i = 0; i < func->params.len; ++i) {
+    auto param = SliceAt<koopa_raw_value_t>(func->params, i);
+    RawValue new_param = raw.NewBlockArgRef(i, param->ty);
+    params[param] = new_param;
+    items.push_back(new_param);
+  }
+  header->params = raw.NewSlice(items, KOOPA_RSIK_VALUE);
+  auto replace = [&](koopa_raw_value_t value) {
+    auto it = params.find(value);
+    return it == params.end() ? value : it->second;
+  };
+  for (size_t i = 0; i < func->bbs.len; ++i) {
+    BB bb = SliceAt<BB>(func->bbs, i);
+    for (size_t j = 0; j < bb->insts.len; ++j) {
+      ReplaceOperands(SliceAt<koopa_raw_value_t>(bb->insts, j), replace);
+    }
+  }
+
+  // 尾调用改成带着实参跳回循环头
+  for (RawBB bb : sites) {
+    auto call = SliceAt<koopa_raw_value_t>(bb->insts, bb->insts.len - 2);
+    vector<const void*> insts(bb->insts.buffer,
+                              bb->insts.buffer + bb->insts.len - 2);
+    RawValue jump = raw.NewJump(header);
+    const auto& args = call->kind.data.call.args;
+    jump->kind.data.jump.args = raw.NewSlice(
+        vector<const void*>(args.buffer, args.buffer + args.len),
+        KOOPA_RSIK_VALUE);
+    insts.push_back(jump);
+    bb->insts = raw.NewSlice(insts, KOOPA_RSIK_VALUE);
+  }
+
+  // 新的入口把函数参数传给循环头
+  RawBB entry = raw.NewBasicBlock("%entry");
+  RawValue jump = raw.NewJump(header);
+  jump->kind.data.jump.args =
+      raw.NewSlice(vector<const void*>(func->params.buffer,
+                                       func->params.buffer + func->params.len),
+                   KOOPA_RSIK_VALUE);
+  entry->insts = raw.NewSlice({jump}, KOOPA_RSIK_VALUE);
+  vector<const void*> bbs = {entry};
+  bbs.insert(bbs.end(), func->bbs.buffer, func->bbs.buffer + func->bbs.len);
+  Mutable(func)->bbs = raw.NewSlice(bbs, KOOPA_RSIK_BASIC_BLOCK);
+  return true;
+}
+
+}  // namespace opt
@@ -0,0 +1,22 @@
+#pragma once
+
+#include "opt_cfg.h"
+#include "opt_pass.h"
+
+namespace opt {
+
+// 尾递归消除，把调用自己之后直接返回结果的调用改成跳回函数开头
+// 原来的入口变成循环头，函数参数改成它的基本块参数，新建一个入口跳过去
+// 有局部数组的函数不处理，每层递归的数组不能共用一块空间
+// 调用其他函数的尾调用在后端改成跳转
+class TailRecursionElim : public FunctionPass {
+ public:
+  TailRecursionElim(ir::RawProgramManager& _raw);
+  const string Name() const override { return "tailrec"; }
+  bool RunOnFunction(koopa_raw_function_t func) override;
+
+ private:
+  ir::RawProgramManager& raw;
+};
+
+}  // namespace opt
@@ -0,0 +1,169 @@
+#include "opt_util.h"
+#include <cassert>
+
+namespace opt {
+
+RawValue Mutable(koopa_raw_value_t value) {
+  return const_cast<RawValue>(value);
+}
+
+RawBB Mutable(koopa_raw_basic_block_t bb) {
+  return const_cast<RawBB>(bb);
+}
+
+RawFunc Mutable(koopa_raw_function_t func) {
+  return const_cast<RawFunc>(func);
+}
+
+static void PushSlice(const koopa_raw_slice_t& slice,
+                      vector<koopa_raw_value_t>& operands) {
+  for (size_t i = 0; i < slice.len; ++i) {
+    operands.push_back(SliceAt<koopa_raw_value_t>(slice, i));
+  }
+}
+
+vector<koopa_raw_value_t> GetOperands(koopa_raw_value_t inst) {
+  vector<koopa_raw_value_t> operands;
+  const auto& kind = inst->kind;
+  switch (kind.tag) {
+    case KOOPA_RVT_LOAD:
+      operands.push_back(kind.data.load.src);
+      break;
+    case KOOPA_RVT_STORE:
+      operands.push_back(kind.data.store.value);
+      operands.push_back(kind.data.store.dest);
+      break;
+    case KOOPA_RVT_GET_PTR:
+      operands.push_back(kind.data.get_ptr.src);
+      operands.push_back(kind.data.get_ptr.index);
+      break;
+    case KOOPA_RVT_GET_ELEM_PTR:
+      operands.push_back(kind.data.get_elem_ptr.src);
+      operands.push_back(kind.data.get_elem_ptr.index);
+      break;
+    case KOOPA_RVT_BINARY:
+      operands.push_back(kind.data.binary.lhs);
+      operands.push_back(kind.data.binary.rhs);
+      break;
+    case KOOPA_RVT_BRANCH:
+      operands.push_back(kind.data.branch.cond);
+      PushSlice(kind.data.branch.true_args, operands);
+      PushSlice(kind.data.branch.false_args, operands);
+      break;
+    case KOOPA_RVT_JUMP:
+      PushSlice(kind.data.jump.args, operands);
+      break;
+    case KOOPA_RVT_CALL:
+      PushSlice(kind.data.call.args, operands);
+      break;
+    case KOOPA_RVT_RETURN:
+      if (kind.data.ret.value != nullptr)
+        operands.push_back(kind.data.ret.value);
+      break;
+    default:
+      break;
+  }
+  return operands;
+}
+
+static void ReplaceSlice(
+    const koopa_raw_slice_t& slice,
+    const std::function<koopa_raw_value_t(koopa_raw_value_t)>& f) {
+  for (size_t i = 0; i < slice.len; ++i) {
+    slice.buffer[i] = f(SliceAt<koopa_raw_value_t>(slice, i));
+  }
+}
+
+void ReplaceOperands(
+    koopa_raw_value_t inst,
+    const std::function<koopa_raw_value_t(koopa_raw_value_t)>& f) {
+  auto& kind = Mutable(inst)->kind;
+  switch (kind.tag) {
+    case KOOPA_RVT_LOAD:
+      kind.data.load.src = f(kind.data.load.src);
+      break;
+    case KOOPA_RVT_STORE:
+      kind.data.store.value = f(kind.data.store.value);
+      kind.data.store.dest = f(kind.data.store.dest);
+      break;
+    case KOOPA_RVT_GET_PTR:
+      kind.data.get_ptr.src = f(kind.data.get_ptr.src);
+      kind.data.get_ptr.index = f(kind.data.get_ptr.index);
+      break;
+    case KOOPA_RVT_GET_ELEM_PTR:
+      kind.data.get_elem_ptr.src = f(kind.data.get_elem_ptr.src);
+      kind.data.get_elem_ptr.index = f(kind.data.get_elem_ptr.index);
+      break;
+    case KOOPA_RVT_BINARY:
+      kind.data.binary.lhs = f(kind.data.binary.lhs);
+      kind.data.binary.rhs = f(kind.data.binary.rhs);
+      break;
+    case KOOPA_RVT_BRANCH:
+      kind.data.branch.cond = f(kind.data.branch.cond);
+      ReplaceSlice(kind.data.branch.true_args, f);
+      ReplaceSlice(kind.data.branch.false_args, f);
+      break;
+    case KOOPA_RVT_JUMP:
+      ReplaceSlice(kind.data.jump.args, f);
+      break;
+    case KOOPA_RVT_CALL:
+      ReplaceSlice(kind.data.call.args, f);
+      break;
+    case KOOPA_RVT_RETURN:
+      if (kind.data.ret.value != nullptr)
+        kind.data.ret.value = f(kind.data.ret.value);
+      break;
+    default:
+      break;
+  }
+}
+
+bool IsTerminator(koopa_raw_value_t inst) {
+  return inst->kind.tag == KOOPA_RVT_BRANCH ||
+         inst->kind.tag == KOOPA_RVT_JUMP ||
+         inst->kind.tag == KOOPA_RVT_RETURN;
+}
+
+koopa_raw_value_t GetTerminator(koopa_raw_basic_block_t bb) {
+  assert(bb->insts.len > 0);
+  return SliceAt<koopa_raw_value_t>(bb->insts, bb->insts.len - 1);
+}
+
+vector<koopa_raw_basic_block_t> GetSuccessors(koopa_raw_basic_block_t bb) {
+  vector<koopa_raw_basic_block_t> succs;
+  if (bb->insts.len == 0)
+    return succs;
+  koopa_raw_value_t last = GetTerminator(bb);
+  if (last->kind.tag == KOOPA_RVT_BRANCH) {
+    succs.push_back(last->kind.data.branch.true_bb);
+    succs.push_back(last->kind.data.branch.false_bb);
+  } else if (last->kind.tag == KOOPA_RVT_JUMP) {
+    succs.push_back(last->kind.data.jump.target);
+  }
+  return succs;
+}
+
+bool IsTailReturn(koopa_raw_value_t call, koopa_raw_value_t term) {
+  bool has_result = call->ty->tag != KOOPA_RTT_UNIT;
+  if (term->kind.tag == KOOPA_RVT_RETURN) {
+    auto value = term->kind.data.ret.value;
+    return value == nullptr || value == call;
+  }
+  if (term->kind.tag != KOOPA_RVT_JUMP)
+    return false;
+  const auto& jump = term->kind.data.jump;
+  koopa_raw_basic_block_t target = jump.target;
+  if (target->insts.len != 1 ||
+      GetTerminator(target)->kind.tag != KOOPA_RVT_RETURN)
+    return false;
+  auto value = GetTerminator(target)->kind.data.ret.value;
+  if (value == nullptr)
+    return true;
+  // 返回值只能是传过去的call的结果
+  if (!has_result || value->kind.tag != KOOPA_RVT_BLOCK_ARG_REF)
+    return false;
+  size_t index = value->kind.data.block_arg_ref.index;
+  return SliceAt<koopa_raw_value_t>(jump.args, index) == call;
+}
+
+}  // namespace opt
@@ -0,0 +1,53 @@
+#pragma once
+
+#include <functional>
+#include <vector>
+#include "koopa.h"
+#include "sysy2ir/ir_raw.h"
+
+namespace opt {
+
+using std::vector;
+using ir::RawValue, ir::RawBB, ir::RawFunc;
+
+// 取出slice的第i个元素
+template <typename T>
+T SliceAt(const koopa_raw_slice_t& slice, size_t i) {
+  return reinterpret_cast<T>(slice.buffer[i]);
+}
+
+// 把slice转成vector
+template <typename T>
+vector<T> SliceToVector(const koopa_raw_slice_t& slice) {
+  vector<T> ret;
+  ret.reserve(slice.len);
+  for (size_t i = 0; i < slice.len; ++i) {
+    ret.push_back(SliceAt<T>(slice, i));
+  }
+  return ret;
+}
+
+// raw program的内存都归RawProgramManager管，pass可以直接修改
+RawValue Mutable(koopa_raw_value_t value);
+RawBB Mutable(koopa_raw_basic_block_t bb);
+RawFunc Mutable(koopa_raw_function_t func);
+
+// 指令用到的所有值，包括跳转的实参
+vector<koopa_raw_value_t> GetOperands(koopa_raw_value_t inst);
+// 把指令用到的每个值v换成f(v)
+void ReplaceOperands(
+    koopa_raw_value_t inst,
+    const std::function<koopa_raw_value_t(koopa_raw_value_t)>& f);
+
+// 是否是branch、jump、ret
+bool IsTerminator(koopa_raw_value_t inst);
+// 基本块的最后一条指令
+koopa_raw_value_t GetTerminator(koopa_raw_basic_block_t bb);
+// 基本块的后继，branch两个目标相同时会出现两次
+vector<koopa_raw_basic_block_t> GetSuccessors(koopa_raw_basic_block_t bb);
+
+// call之后的term是否直接返回call的结果
+// term是ret，或者跳到一个只有ret、返回参数的块
+bool IsTailReturn(koopa_raw_value_t call, koopa_raw_value_t term);
+
+}  // namespace opt
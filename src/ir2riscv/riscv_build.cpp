@@ -1,112 +1,184 @@
 #include "riscv_build.h"
 namespace riscv {
 
-void ret(ostream& os) {
-  os << "  ret" << endl;
+void ret(AsmEmitter& os) {
+  os.Emit(MachineInst(MOp::e_ret));
 }
 
-void li(ostream& os, const Reg& dest, int imm) {
-  os << "  li " << regstr(dest) << ", " << imm << endl;
+void li(AsmEmitter& os, const Reg& dest, int imm) {
+  os.Emit(MachineInst(MOp::e_li, dest, NONE, NONE, imm));
 }
 
-void lw(ostream& os, const Reg& rd, const Reg& rs, int addr) {
-  os << "  lw " << regstr(rd) << ", " << addr << "(" << regstr(rs) << ")"
-     << endl;
+void lw(AsmEmitter& os, const Reg& rd, const Reg& rs, int addr) {
+  os.Emit(MachineInst(MOp::e_lw, rd, rs, NONE, addr));
 }
 
-void sw(ostream& os, const Reg& rd, const Reg& rs, int addr) {
-  os << "  sw " << regstr(rs) << ", " << addr << "(" << regstr(rd) << ")"
-     << endl;
+void sw(AsmEmitter& os, const Reg& rd, const Reg& rs, int addr) {
+  os.Emit(MachineInst(MOp::e_sw, NONE, rd, rs, addr));
 }
 
-void mv(ostream& os, const Reg& rd, const Reg& rs) {
-  os << "  mv " << regstr(rd) << ", " << regstr(rs) << endl;
+void mv(AsmEmitter& os, const Reg& rd, const Reg& rs) {
+  os.Emit(MachineInst(MOp::e_mv, rd, rs));
 }
 
-void add(ostream& os, const Reg& rd, const Reg& rs1, const Reg& rs2) {
-  os << "  add " << regstr(rd) << ", " << regstr(rs1) << ", " << regstr(rs2)
-     << endl;
+void add(AsmEmitter& os, const Reg& rd, const Reg& rs1, const Reg& rs2) {
+  os.Emit(MachineInst(MOp::e_add, rd, rs1, rs2));
 }
 
-void addi(ostream& os, const Reg& rd, const Reg& rs1, int imm) {
-  os << "  addi " << regstr(rd) << ", " << regstr(rs1) << ", " << imm << endl;
+void addi(AsmEmitter& os, const Reg& rd, const Reg& rs1, int imm) {
+  os.Emit(MachineInst(MOp::e_addi, rd, rs1, NONE, imm));
 }
 
-void sub(ostream& os, const Reg& rd, const Reg& rs1, const Reg& rs2) {
-  os << "  sub " << regstr(rd) << ", " << regstr(rs1) << ", " << regstr(rs2)
-     << endl;
+void sub(AsmEmitter& os, const Reg& rd, const Reg& rs1, const Reg& rs2) {
+  os.Emit(MachineInst(MOp::e_sub, rd, rs1, rs2));
 }
 
-void mul(ostream& os, const Reg& rd, const Reg& rs1, const Reg& rs2) {
-  os << "  mul " << regstr(rd) << ", " << regstr(rs1) << ", " << regstr(rs2)
-     << endl;
+void mul(AsmEmitter& os, const Reg& rd, const Reg& rs1, const Reg& rs2) {
+  os.Emit(MachineInst(MOp::e_mul, rd, rs1, rs2));
 }
 
-void div(ostream& os, const Reg& rd, const Reg& rs1, const Reg& rs2) {
-  os << "  div " << regstr(rd) << ", " << regstr(rs1) << ", " << regstr(rs2)
-     << endl;
+void div(AsmEmitter& os, const Reg& rd, const Reg& rs1, const Reg& rs2) {
+  os.Emit(MachineInst(MOp::e_div, rd, rs1, rs2));
 }
 
-void rem(ostream& os, const Reg& rd, const Reg& rs1, const Reg& rs2) {
-  os << "  rem " << regstr(rd) << ", " << regstr(rs1) << ", " << regstr(rs2)
-     << endl;
+void rem(AsmEmitter& os, const Reg& rd, const Reg& rs1, const Reg& rs2) {
+  os.Emit(MachineInst(MOp::e_rem, rd, rs1, rs2));
 }
 
-void seqz(ostream& os, const Reg& rd, const Reg& rs) {
-  os << "  seqz " << regstr(rd) << ", " << regstr(rs) << endl;
+void seqz(AsmEmitter& os, const Reg& rd, const Reg& rs) {
+  os.Emit(MachineInst(MOp::e_seqz, rd, rs));
 }
 
-void snez(ostream& os, const Reg& rd, const Reg& rs) {
-  os << "  snez " << regstr(rd) << ", " << regstr(rs) << endl;
+void snez(AsmEmitter& os, const Reg& rd, const Reg& rs) {
+  os.Emit(MachineInst(MOp::e_snez, rd, rs));
 }
 
-void slt(ostream& os, const Reg& rd, const Reg& rs1, const Reg& rs2) {
-  os << "  slt " << regstr(rd) << ", " << regstr(rs1) << ", " << regstr(rs2)
-     << endl;
+void slt(AsmEmitter& os, const Reg& rd, const Reg& rs1, const Reg& rs2) {
+  os.Emit(MachineInst(MOp::e_slt, rd, rs1, rs2));
 }
 
-void sgt(ostream& os, const Reg& rd, const Reg& rs1, const Reg& rs2) {
-  os << "  sgt " << regstr(rd) << ", " << regstr(rs1) << ", " << regstr(rs2)
-     << endl;
+void sgt(AsmEmitter& os, const Reg& rd, const Reg& rs1, const Reg& rs2) {
+  os.Emit(MachineInst(MOp::e_sgt, rd, rs1, rs2));
 }
 
-void xorr(ostream& os, const Reg& rd, const Reg& rs1, const Reg& rs2) {
-  os << "  xor " << regstr(rd) << ", " << regstr(rs1) << ", " << regstr(rs2)
-     << endl;
+void xorr(AsmEmitter& os, const Reg& rd, const Reg& rs1, const Reg& rs2) {
+  os.Emit(MachineInst(MOp::e_xor, rd, rs1, rs2));
 }
 
-void xori(ostream& os, const Reg& rd, const Reg& rs1, int imm) {
-  os << "  xori " << regstr(rd) << ", " << regstr(rs1) << ", " << imm << endl;
+void xori(AsmEmitter& os, const Reg& rd, const Reg& rs1, int imm) {
+  os.Emit(MachineInst(MOp::e_xori, rd, rs1, NONE, imm));
 }
 
-void andr(ostream& os, const Reg& rd, const Reg& rs1, const Reg& rs2) {
-  os << "  and " << regstr(rd) << ", " << regstr(rs1) << ", " << regstr(rs2)
-     << endl;
+void andr(AsmEmitter& os, const Reg& rd, const Reg& rs1, const Reg& rs2) {
+  os.Emit(MachineInst(MOp::e_and, rd, rs1, rs2));
 }
 
-void orr(ostream& os, const Reg& rd, const Reg& rs1, const Reg& rs2) {
-  os << "  or " << regstr(rd) << ", " << regstr(rs1) << ", " << regstr(rs2)
-     << endl;
+void orr(AsmEmitter& os, const Reg& rd, const Reg& rs1, const Reg& rs2) {
+  os.Emit(MachineInst(MOp::e_or, rd, rs1, rs2));
 }
 
-void j(ostream& os, const string& label) {
-  os << "  j " << label << endl;
+void andi(AsmEmitter& os, const Reg& rd, const Reg& rs1, int imm) {
+  os.Emit(MachineInst(MOp::e_andi, rd, rs1, NONE, imm));
 }
 
-void bnez(ostream& os, const Reg& reg, const string& label) {
-  os << "  bnez " << regstr(reg) << ", " << label << endl;
+void ori(AsmEmitter& os, const Reg& rd, const Reg& rs1, int imm) {
+  os.Emit(MachineInst(MOp::e_ori, rd, rs1, NONE, imm));
 }
 
-void beqz(ostream& os, const Reg& reg, const string& label) {
-  os << "  beqz " << regstr(reg) << ", " << label << endl;
+void slti(AsmEmitter& os, const Reg& rd, const Reg& rs1, int imm) {
+  os.Emit(MachineInst(MOp::e_slti, rd, rs1, NONE, imm));
 }
 
-void call(ostream& os, const string& name) {
-  os << "  call " << name << endl;
+void sll(AsmEmitter& os, const Reg& rd, const Reg& rs1, const Reg& rs2) {
+  os.Emit(MachineInst(MOp::e_sll, rd, rs1, rs2));
 }
 
-void la(ostream& os, const Reg& reg, const string& name) {
-  os << "  la " << regstr(reg) << ", " << name << endl;
+void slli(AsmEmitter& os, const Reg& rd, const Reg& rs1, int imm) {
+  os.Emit(MachineInst(MOp::e_slli, rd, rs1, NONE, imm));
+}
+
+void srl(AsmEmitter& os, const Reg& rd, const Reg& rs1, const Reg& rs2) {
+  os.Emit(MachineInst(MOp::e_srl, rd, rs1, rs2));
+}
+
+void srli(AsmEmitter& os, const Reg& rd, const Reg& rs1, int imm) {
+  os.Emit(MachineInst(MOp::e_srli, rd, rs1, NONE, imm));
+}
+
+void sra(AsmEmitter& os, const Reg& rd, const Reg& rs1, const Reg& rs2) {
+  os.Emit(MachineInst(MOp::e_sra, rd, rs1, rs2));
+}
+
+void srai(AsmEmitter& os, const Reg& rd, const Reg& rs1, int imm) {
+  os.Emit(MachineInst(MOp::e_srai, rd, rs1, NONE, imm));
+}
+
+void j(AsmEmitter& os, const string& label) {
+  os.Emit(MachineInst(MOp::e_j, NONE, label));
+}
+
+void bnez(AsmEmitter& os, const Reg& reg, const string& label) {
+  MachineInst inst(MOp::e_bnez, NONE, label);
+  inst.rs1 = reg;
+  os.Emit(inst);
+}
+
+void beqz(AsmEmitter& os, const Reg& reg, const string& label) {
+  MachineInst inst(MOp::e_beqz, NONE, label);
+  inst.rs1 = reg;
+  os.Emit(inst);
+}
+
+void beq(AsmEmitter& os,
+         const Reg& rs1,
+         const Reg& rs2,
+         const string& label) {
+  MachineInst inst(MOp::e_beq, NONE, label);
+  inst.rs1 = rs1;
+  inst.rs2 = rs2;
+  os.Emit(inst);
+}
+
+void bne(AsmEmitter& os,
+         const Reg& rs1,
+         const Reg& rs2,
+         const string& label) {
+  MachineInst inst(MOp::e_bne, NONE, label);
+  inst.rs1 = rs1;
+  inst.rs2 = rs2;
+  os.Emit(inst);
+}
+
+void blt(AsmEmitter& os,
+         const Reg& rs1,
+         const Reg& rs2,
+         const string& label) {
+  MachineInst inst(MOp::e_blt, NONE, label);
+  inst.rs1 = rs1;
+  inst.rs2 = rs2;
+  os.Emit(inst);
+}
+
+void bge(AsmEmitter& os,
+         const Reg& rs1,
+         const Reg& rs2,
+         const string& label) {
+  MachineInst inst(MOp::e_bge, NONE, label);
+  inst.rs1 = rs1;
+  inst.rs2 = rs2;
+  os.Emit(inst);
+}
+
+void call(AsmEmitter& os, const string& name) {
+  os.Emit(MachineInst(MOp::e_call, NONE, name));
+}
+
+void tail(AsmEmitter& os, const string& name) {
+  os.Emit(MachineInst(MOp::e_tail, NONE, name));
+}
+
+void la(AsmEmitter& os, const Reg& reg, const string& name) {
+  os.Emit(MachineInst(MOp::e_la, reg, name));
 }
 
 const char* regstr(Reg reg) {
@@ -177,28 +249,28 @@ const char* regstr(Reg reg) {
   }
 }
 
-void sle(ostream& os, const Reg& rd, const Reg& rs1, const Reg& rs2) {
+void sle(AsmEmitter& os, const Reg& rd, const Reg& rs1, const Reg& rs2) {
   sgt(os, rd, rs1, rs2);
   xori(os, rd, rd, 1);
 }
 
-void sge(ostream& os, const Reg& rd, const Reg& rs1, const Reg& rs2) {
+void sge(AsmEmitter& os, const Reg& rd, const Reg& rs1, const Reg& rs2) {
   slt(os, rd, rs1, rs2);
   xori(os, rd, rd, 1);
 }
 
-void eq(ostream& os, const Reg& rd, const Reg& rs1, const Reg& rs2) {
+void eq(AsmEmitter& os, const Reg& rd, const Reg& rs1, const Reg& rs2) {
   xorr(os, rd, rs1, rs2);
   seqz(os, rd, rd);
 }
 
-void neq(ostream& os, const Reg& rd, const Reg& rs1, const Reg& rs2) {
+void neq(AsmEmitter& os, const Reg& rd, const Reg& rs1, const Reg& rs2) {
   xorr(os, rd, rs1, rs2);
   snez(os, rd, rd);
 }
 
-void wlabel(ostream& os, const string& label) {
-  os << label << ":" << endl;
+void wlabel(AsmEmitter& os, const string& label) {
+  os.Emit(MachineInst(MOp::e_label, NONE, label));
 }
 
 }  // namespace riscv
\ No newline at end of file
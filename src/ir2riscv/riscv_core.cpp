@@ -1,41 +1,123 @@
+#include <algorithm>
+#include <atomic>
+#include <thread>
 #include "riscv_ir2riscv.h"
 
 namespace riscv {
 
-void ir2riscv(string ircode, const char* output) {
-  koopa_raw_program_builder_t builder;
-  koopa_raw_program_t program = get_raw_program(ircode, builder);
-  stringstream ss;
-  RiscvGenerator::getInstance().setting.setOs(ss);
-  visit_program(program);
-
-  ofstream outfile(output);
-  if (outfile.is_open()) {
-    outfile << ss.str();
-    outfile.close();
-  } else {
+// BeginStream时设置，工作线程的RiscvGenerator也要用
+static RegAllocStrategy stream_strategy = RegAllocStrategy::e_linear_scan;
+static int stream_jobs = 1;
+
+// 函数的指令数，用来估计翻译的耗时
+static size_t CountInsts(const koopa_raw_function_t& func) {
+  size_t count = 0;
+  for (size_t i = 0; i < func->bbs.len; ++i) {
+    auto bb = reinterpret_cast<koopa_raw_basic_block_t>(func->bbs.buffer[i]);
+    count += bb->insts.len;
+  }
+  return count;
+}
+
+// 多线程翻译函数，结果按原来的顺序放在outs里
+static void VisitFuncsParallel(const vector<koopa_raw_function_t>& funcs,
+                               vector<AsmEmitter>& outs) {
+  // 大的函数先翻译，减少最后只剩一个线程在干活的时间
+  vector<size_t> order(funcs.size());
+  vector<size_t> sizes(funcs.size());
+  for (size_t i = 0; i < funcs.size(); ++i) {
+    order[i] = i;
+    sizes[i] = CountInsts(funcs[i]);
+  }
+  std::stable_sort(order.begin(), order.end(), [&](size_t a, size_t b) {
+    return sizes[a] > sizes[b];
+  });
+
+  // 空闲的线程从队列里领下一个函数
+  std::atomic<size_t> next(0);
+  auto worker = [&]() {
+    auto& gen = RiscvGenerator::getInstance();
+    gen.allocCore.strategy = stream_strategy;
+    for (size_t k = next++; k < order.size(); k = next++) {
+      size_t i = order[k];
+      visit_func(funcs[i]);
+      gen.emitter.Swap(outs[i]);
+    }
+  };
+
+  size_t threads = std::min(funcs.size(), (size_t)stream_jobs);
+  vector<std::thread> pool;
+  for (size_t t = 1; t < threads; ++t) {
+    pool.emplace_back(worker);
+  }
+  // 当前线程也干活
+  worker();
+  for (auto& thread : pool) {
+    thread.join();
+  }
+}
+
+void ir2riscv(const koopa_raw_program_t& program,
+              const char* output,
+              const int& opt_level,
+              const int& jobs) {
+  if (!BeginStream(output, opt_level, jobs))
+    return;
+  StreamUnit(program);
+  EndStream();
+}
+
+bool BeginStream(const char* output, const int& opt_level, const int& jobs) {
+  auto& gen = RiscvGenerator::getInstance();
+  stream_strategy = opt_level >= 2 ? RegAllocStrategy::e_graph_coloring
+                                   : RegAllocStrategy::e_linear_scan;
+  stream_jobs = std::max(jobs, 1);
+  gen.allocCore.strategy = stream_strategy;
+  if (!gen.emitter.Open(output)) {
     cerr << "无法打开文件：" << output << endl;
+    return false;
   }
-  release_builder(builder);
+  return true;
 }
 
-koopa_raw_program_t get_raw_program(string ircode,
-                                    koopa_raw_program_builder_t& builder) {
-  koopa_program_t program;
-  koopa_error_code_t ret = koopa_parse_from_string(ircode.c_str(), &program);
-  // 确保解析时没有出错
-  assert(ret == KOOPA_EC_SUCCESS);
-  // 创建一个 raw program builder, 用来构建 raw program
-  builder = koopa_new_raw_program_builder();
-  // 将 Koopa IR 程序转换为 raw program
-  koopa_raw_program_t raw = koopa_build_raw_program(builder, program);
-  // 释放 Koopa IR 程序占用的内存
-  koopa_delete_program(program);
-  return raw;
+void StreamUnit(const koopa_raw_program_t& unit) {
+  auto& gen = RiscvGenerator::getInstance();
+  bool ok = true;
+  // 全局变量很快，直接在当前线程生成
+  visit_slice(unit.values);
+  ok &= gen.emitter.Flush();
+
+  vector<koopa_raw_function_t> funcs;
+  for (size_t i = 0; i < unit.funcs.len; ++i) {
+    auto func = reinterpret_cast<koopa_raw_function_t>(unit.funcs.buffer[i]);
+    if (func->bbs.len != 0)
+      funcs.push_back(func);
+  }
+
+  if (stream_jobs <= 1 || funcs.size() <= 1) {
+    for (auto func : funcs) {
+      visit_func(func);
+    }
+    ok &= gen.emitter.Flush();
+  } else {
+    vector<AsmEmitter> outs(funcs.size());
+    VisitFuncsParallel(funcs, outs);
+    // 换到当前线程的缓冲区里写入文件
+    for (auto& out : outs) {
+      gen.emitter.Swap(out);
+      ok &= gen.emitter.Flush();
+    }
+  }
+  if (!ok) {
+    cerr << "写入汇编失败" << endl;
+  }
 }
 
-void release_builder(koopa_raw_program_builder_t& builder) {
-  koopa_delete_raw_program_builder(builder);
+void EndStream() {
+  auto& gen = RiscvGenerator::getInstance();
+  if (!gen.emitter.Close()) {
+    cerr << "写入汇编失败" << endl;
+  }
 }
 
-}  // namespace riscv
\ No newline at end of file
+}  // namespace riscv
@@ -0,0 +1,250 @@
+#include "riscv_emit.h"
+#include <cassert>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <utility>
+#include "riscv_peephole.h"
+
+namespace riscv {
+
+// 按Reg的枚举顺序排列，带上长度省去strlen
+static const struct {
+  const char* name;
+  size_t len;
+} reg_names[] = {
+    {"", 0},     {"t0", 2},  {"t1", 2},  {"t2", 2},  {"t3", 2},  {"t4", 2},
+    {"t5", 2},   {"t6", 2},  {"a0", 2},  {"a1", 2},  {"a2", 2},  {"a3", 2},
+    {"a4", 2},   {"a5", 2},  {"a6", 2},  {"a7", 2},  {"s0", 2},  {"s1", 2},
+    {"s2", 2},   {"s3", 2},  {"s4", 2},  {"s5", 2},  {"s6", 2},  {"s7", 2},
+    {"s8", 2},   {"s9", 2},  {"s10", 3}, {"s11", 3}, {"ra", 2},  {"sp", 2},
+    {"x0", 2}};
+
+static const size_t INIT_CAPACITY = 1 << 16;
+
+AsmEmitter::AsmEmitter() : file(nullptr), buf(nullptr), len(0), cap(0) {}
+
+AsmEmitter::~AsmEmitter() {
+  Close();
+  free(buf);
+}
+
+AsmEmitter& AsmEmitter::operator<<(const char* str) {
+  FinishFunction();
+  Append(str, strlen(str));
+  return *this;
+}
+
+AsmEmitter& AsmEmitter::operator<<(const std::string& str) {
+  FinishFunction();
+  Append(str.data(), str.size());
+  return *this;
+}
+
+AsmEmitter& AsmEmitter::operator<<(char ch) {
+  FinishFunction();
+  Reserve(1);
+  buf[len++] = ch;
+  return *this;
+}
+
+AsmEmitter& AsmEmitter::operator<<(int value) {
+  FinishFunction();
+  WriteInt(value);
+  return *this;
+}
+
+AsmEmitter& AsmEmitter::operator<<(const Reg& reg) {
+  FinishFunction();
+  WriteReg(reg);
+  return *this;
+}
+
+void AsmEmitter::Emit(const MachineInst& inst) {
+  insts.push_back(inst);
+}
+
+void AsmEmitter::FinishFunction() {
+  if (insts.empty())
+    return;
+  RunPeephole(insts);
+  for (const auto& inst : insts) {
+    Write(inst);
+  }
+  insts.clear();
+}
+
+size_t AsmEmitter::Size() const {
+  return len;
+}
+
+void AsmEmitter::Clear() {
+  len = 0;
+  insts.clear();
+}
+
+void AsmEmitter::Swap(AsmEmitter& other) {
+  std::swap(buf, other.buf);
+  std::swap(len, other.len);
+  std::swap(cap, other.cap);
+  insts.swap(other.insts);
+}
+
+bool AsmEmitter::Open(const char* path) {
+  Close();
+  Clear();
+  file = fopen(path, "wb");
+  return file != nullptr;
+}
+
+bool AsmEmitter::Flush() {
+  if (file == nullptr)
+    return false;
+  FinishFunction();
+  // 还没写过东西时buf是空指针，不能传给fwrite
+  bool ok = len == 0 ? true : fwrite(buf, 1, len, file) == len;
+  Clear();
+  return ok;
+}
+
+bool AsmEmitter::Close() {
+  if (file == nullptr)
+    return true;
+  bool ok = Flush();
+  ok = fclose(file) == 0 && ok;
+  file = nullptr;
+  return ok;
+}
+
+void AsmEmitter::Write(const MachineInst& inst) {
+  if (inst.op == MOp::e_label) {
+    Append(inst.label.data(), inst.label.size());
+    Append(":\n", 2);
+    return;
+  }
+  Append("  ", 2);
+  const char* name = inst.Name();
+  Append(name, strlen(name));
+  switch (inst.op) {
+    case MOp::e_ret:
+      break;
+    case MOp::e_j:
+    case MOp::e_call:
+    case MOp::e_tail:
+      Append(" ", 1);
+      Append(inst.label.data(), inst.label.size());
+      break;
+    case MOp::e_bnez:
+    case MOp::e_beqz:
+      Append(" ", 1);
+      WriteReg(inst.rs1);
+      Append(", ", 2);
+      Append(inst.label.data(), inst.label.size());
+      break;
+    case MOp::e_beq:
+    case MOp::e_bne:
+    case MOp::e_blt:
+    case MOp::e_bge:
+      Append(" ", 1);
+      WriteReg(inst.rs1);
+      Append(", ", 2);
+      WriteReg(inst.rs2);
+      Append(", ", 2);
+      Append(inst.label.data(), inst.label.size());
+      break;
+    case MOp::e_li:
+      Append(" ", 1);
+      WriteReg(inst.rd);
+      Append(", ", 2);
+      WriteInt(inst.imm);
+      break;
+    case MOp::e_la:
+      Append(" ", 1);
+      WriteReg(inst.rd);
+      Append(", ", 2);
+      Append(inst.label.data(), inst.label.size());
+      break;
+    case MOp::e_lw:
+    case MOp::e_sw:
+      // sw写的是要存的值
+      Append(" ", 1);
+      WriteReg(inst.op == MOp::e_lw ? inst.rd : inst.rs2);
+      Append(", ", 2);
+      WriteInt(inst.imm);
+      Append("(", 1);
+      WriteReg(inst.rs1);
+      Append(")", 1);
+      break;
+    case MOp::e_mv:
+    case MOp::e_seqz:
+    case MOp::e_snez:
+      Append(" ", 1);
+      WriteReg(inst.rd);
+      Append(", ", 2);
+      WriteReg(inst.rs1);
+      break;
+    case MOp::e_addi:
+    case MOp::e_slti:
+    case MOp::e_xori:
+    case MOp::e_andi:
+    case MOp::e_ori:
+    case MOp::e_slli:
+    case MOp::e_srli:
+    case MOp::e_srai:
+      Append(" ", 1);
+      WriteReg(inst.rd);
+      Append(", ", 2);
+      WriteReg(inst.rs1);
+      Append(", ", 2);
+      WriteInt(inst.imm);
+      break;
+    default:
+      Append(" ", 1);
+      WriteReg(inst.rd);
+      Append(", ", 2);
+      WriteReg(inst.rs1);
+      Append(", ", 2);
+      WriteReg(inst.rs2);
+      break;
+  }
+  Append("\n", 1);
+}
+
+void AsmEmitter::WriteInt(int value) {
+  // 从低位往高位写到临时数组里，INT_MIN取反会溢出，用无符号数
+  char digits[12];
+  int pos = sizeof(digits);
+  unsigned int abs_value = value < 0 ? 0u - (unsigned int)value : value;
+  do {
+    digits[--pos] = '0' + abs_value % 10;
+    abs_value /= 10;
+  } while (abs_value != 0);
+  if (value < 0)
+    digits[--pos] = '-';
+  Append(digits + pos, sizeof(digits) - pos);
+}
+
+void AsmEmitter::WriteReg(const Reg& reg) {
+  assert(reg != Reg::NONE);
+  Append(reg_names[reg].name, reg_names[reg].len);
+}
+
+void AsmEmitter::Append(const char* str, size_t n) {
+  Reserve(n);
+  memcpy(buf + len, str, n);
+  len += n;
+}
+
+void AsmEmitter::Reserve(size_t n) {
+  if (len + n <= cap)
+    return;
+  size_t new_cap = cap == 0 ? INIT_CAPACITY : cap;
+  while (new_cap < len + n)
+    new_cap *= 2;
+  char* new_buf = static_cast<char*>(realloc(buf, new_cap));
+  assert(new_buf != nullptr);
+  buf = new_buf;
+  cap = new_cap;
+}
+
+}  // namespace riscv
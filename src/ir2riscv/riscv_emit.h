@@ -0,0 +1,65 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdio>
+#include <string>
+#include <vector>
+#include "riscv_minst.h"
+#include "riscv_util.h"
+
+namespace riscv {
+
+// 汇编输出缓冲区
+// 指令先追加到一整块内存里，Flush时一次性写入文件
+// 流式生成时每个函数Flush一次，缓冲区只保存一个函数的汇编
+// 整数和寄存器名自己格式化，不经过ostream
+// 函数体里的指令先以MachineInst暂存，FinishFunction时做窥孔优化再写成文本
+class AsmEmitter {
+ public:
+  AsmEmitter();
+  ~AsmEmitter();
+  AsmEmitter(const AsmEmitter&) = delete;
+  AsmEmitter& operator=(const AsmEmitter&) = delete;
+
+  AsmEmitter& operator<<(const char* str);
+  AsmEmitter& operator<<(const std::string& str);
+  AsmEmitter& operator<<(char ch);
+  AsmEmitter& operator<<(int value);
+  // 寄存器名
+  AsmEmitter& operator<<(const Reg& reg);
+
+  // 暂存一条指令
+  void Emit(const MachineInst& inst);
+  // 对暂存的指令做窥孔优化，写成文本
+  void FinishFunction();
+
+  // 已写入的字节数
+  size_t Size() const;
+  // 清空内容，保留已分配的内存
+  void Clear();
+  // 交换两个缓冲区的内容，不交换打开的文件
+  void Swap(AsmEmitter& other);
+  // 打开输出文件并清空缓冲区，失败返回false
+  bool Open(const char* path);
+  // 把缓冲区内容写入文件并清空，失败返回false
+  bool Flush();
+  // 写入剩余内容并关闭文件，失败返回false
+  bool Close();
+
+ private:
+  FILE* file;
+  char* buf;
+  size_t len;
+  size_t cap;
+  std::vector<MachineInst> insts;
+
+  // 写入一条指令的文本
+  void Write(const MachineInst& inst);
+  void WriteInt(int value);
+  void WriteReg(const Reg& reg);
+  void Append(const char* str, size_t n);
+  // 保证还能再写入n个字节
+  void Reserve(size_t n);
+};
+
+}  // namespace riscv
@@ -4,37 +4,34 @@ namespace riscv {
 
 #pragma region Arrinit
 
-ArrInfo::ArrInfo() : shape(), init(), init_len(0), stack_addr(0) {}
+ArrInfo::ArrInfo() : shape(), init(), init_len(0) {}
 
 ArrInfo::ArrInfo(const vector<int>& _shape)
-    : shape(_shape), init(), init_len(0), stack_addr(0) {}
+    : shape(_shape), init(), init_len(0) {}
 
 void ArrInfo::PushNum(const int& val) {
   if (val != 0) {
     init.push_back(ArrInit(val));
-  } else if (val == 0) {
-    if (init.size() == 0 || init[init.size() - 1].ty == ArrInit::e_int) {
-      init.push_back(ArrInit(0));
-    } else {
-      init[init.size() - 1].content.zerolen++;
-    }
+    init_len++;
+  } else {
+    PushZeros(1);
   }
-  init_len++;
 }
 
-const int ArrInfo::GetSize() {
-  int size = 4;
-  for (auto i : shape) {
-    size *= i;
+void ArrInfo::PushZeros(const int& len) {
+  if (init.size() == 0 || init[init.size() - 1].ty == ArrInit::e_int) {
+    init.push_back(ArrInit(0));
+    init[init.size() - 1].content.zerolen = len;
+  } else {
+    init[init.size() - 1].content.zerolen += len;
   }
-  return size;
+  init_len += len;
 }
 
-const int ArrInfo::GetSize(int i) {
+const int ArrInfo::GetSize() {
   int size = 4;
-
-  for (int j = shape.size() - i - 1; j > -1; j--) {
-    size *= shape[j];
+  for (auto i : shape) {
+    size *= i;
   }
   return size;
 }
@@ -54,10 +51,7 @@ ArrInit::ArrInit(const int& val) {
 #pragma region Register
 
 RegisterModule::RegisterModule() {
-  available_regs = {};
-  for (Reg reg = Reg::t0; reg != Reg::ra; reg = (Reg)((int)reg + 1)) {
-    available_regs.insert(reg);
-  }
+  available_regs = {Reg::t0, Reg::t1, Reg::t2};
 }
 
 Reg RegisterModule::GetAvailableReg() {
@@ -68,16 +62,13 @@ Reg RegisterModule::GetAvailableReg() {
 }
 
 void RegisterModule::ReleaseReg(Reg reg) {
-  if (reg != Reg::NONE)
+  // 分配给值的寄存器不归这里管
+  if (IsTempReg(reg))
     available_regs.insert(reg);
 }
 
-bool RegisterModule::GetReg(const Reg& reg) {
-  if (available_regs.find(reg) != available_regs.end()) {
-    available_regs.erase(reg);
-    return true;
-  }
-  return false;
+bool RegisterModule::IsTempReg(const Reg& reg) const {
+  return reg == Reg::t0 || reg == Reg::t1 || reg == Reg::t2;
 }
 
 #pragma endregion
@@ -129,12 +120,11 @@ void StackMemoryModule::SetStackMem(const int& mem) {
 void StackMemoryModule::WriteDataTranfer(const InstResultInfo& src,
                                          const InstResultInfo& dest) {
   auto& gen = RiscvGenerator::getInstance();
-  ostream& os = gen.setting.getOs();
+  AsmEmitter& os = gen.emitter;
   switch (src.ty) {
     case ValueType::e_imm:
       if (dest.ty == ValueType::e_reg) {
         // imm -> reg
-        // 现在不会用到，之后优化寄存器策略时可能用？
         li(os, dest.content.reg, src.content.imm);
       } else if (dest.ty == ValueType::e_stack) {
         // imm -> stack
@@ -148,8 +138,8 @@ void StackMemoryModule::WriteDataTranfer(const InstResultInfo& src,
     case ValueType::e_reg:
       if (dest.ty == ValueType::e_reg) {
         // reg1 -> reg2
-        // 啥也不用做，最后会改表
-        assert(false);
+        if (src.content.reg != dest.content.reg)
+          mv(os, dest.content.reg, src.content.reg);
       } else if (dest.ty == ValueType::e_stack) {
         // reg -> stack
         WriteSW(src.content.reg, dest.content.addr);
@@ -174,28 +164,86 @@ void StackMemoryModule::WriteDataTranfer(const InstResultInfo& src,
   return;
 }
 
+// 两个位置是否相同，立即数不算位置
+static bool IsSameLocation(const InstResultInfo& a, const InstResultInfo& b) {
+  if (a.ty != b.ty)
+    return false;
+  if (a.ty == ValueType::e_reg)
+    return a.content.reg == b.content.reg;
+  if (a.ty == ValueType::e_stack)
+    return a.content.addr == b.content.addr;
+  return false;
+}
+
+void StackMemoryModule::WriteParallelMove(
+    vector<pair<InstResultInfo, InstResultInfo>> moves) {
+  auto& gen = RiscvGenerator::getInstance();
+  // 去掉不用动的
+  for (size_t i = 0; i < moves.size();) {
+    if (IsSameLocation(moves[i].first, moves[i].second)) {
+      moves.erase(moves.begin() + i);
+    } else {
+      i++;
+    }
+  }
+
+  // 用来打破环的临时寄存器
+  Reg tmp = Reg::NONE;
+  while (!moves.empty()) {
+    bool moved = false;
+    for (size_t i = 0; i < moves.size(); i++) {
+      // 目标不是其他转移的源，可以直接覆盖
+      bool blocked = false;
+      for (size_t j = 0; j < moves.size(); j++) {
+        if (j != i && IsSameLocation(moves[j].first, moves[i].second)) {
+          blocked = true;
+          break;
+        }
+      }
+      if (!blocked) {
+        WriteDataTranfer(moves[i].first, moves[i].second);
+        moves.erase(moves.begin() + i);
+        moved = true;
+        break;
+      }
+    }
+    if (moved)
+      continue;
+
+    // 剩下的都在环里，先把一个目标的旧值挪到临时寄存器
+    // 上一个环已经转移完了，临时寄存器可以复用
+    if (tmp == Reg::NONE)
+      tmp = gen.regCore.GetAvailableReg();
+    InstResultInfo dest = moves[0].second;
+    WriteDataTranfer(dest, InstResultInfo(tmp));
+    for (auto& move : moves) {
+      if (IsSameLocation(move.first, dest))
+        move.first = InstResultInfo(tmp);
+    }
+  }
+  gen.regCore.ReleaseReg(tmp);
+}
+
 void StackMemoryModule::WriteLI(const Reg& rd, int imm) {
-  ostream& os = RiscvGenerator::getInstance().setting.getOs();
+  AsmEmitter& os = RiscvGenerator::getInstance().emitter;
   li(os, rd, imm);
 }
 
 void StackMemoryModule::WriteLW(const Reg& rd, int addr) {
-  auto& gen = RiscvGenerator::getInstance();
-  ostream& os = gen.setting.getOs();
+  AsmEmitter& os = RiscvGenerator::getInstance().emitter;
   if (IsImmInBound(addr)) {
     lw(os, rd, Reg::sp, addr);
   } else {
-    Reg adr = gen.regCore.GetAvailableReg();
-    li(os, adr, addr);
-    add(os, adr, adr, Reg::sp);
-    lw(os, rd, adr, 0);
-    gen.regCore.ReleaseReg(adr);
+    // 地址直接算在rd里，不再占用临时寄存器
+    li(os, rd, addr);
+    add(os, rd, rd, Reg::sp);
+    lw(os, rd, rd, 0);
   }
 }
 
 void StackMemoryModule::WriteSW(const Reg& rs, int addr) {
   auto& gen = RiscvGenerator::getInstance();
-  ostream& os = gen.setting.getOs();
+  AsmEmitter& os = gen.emitter;
   if (IsImmInBound(addr)) {
     sw(os, Reg::sp, rs, addr);
   } else {
@@ -241,46 +289,92 @@ StackMemoryModule::StackMemoryModule() : stack_memory(0), stack_used(0) {
 
 #pragma region BB
 
-BBModule::BBModule() {}
+BBModule::BBModule() : mid_cnt(0) {}
 
 void BBModule::WriteBBName(const string& label) {
   auto& gen = RiscvGenerator::getInstance();
-  ostream& os = gen.setting.getOs();
+  AsmEmitter& os = gen.emitter;
   wlabel(os, ParseSymbol(label) + "_" + gen.funcCore.func_name);
 }
 
 void BBModule::WriteJumpInst(const string& label) {
   auto& gen = RiscvGenerator::getInstance();
-  ostream& os = gen.setting.getOs();
+  AsmEmitter& os = gen.emitter;
   j(os, ParseSymbol(label) + "_" + gen.funcCore.func_name);
 }
 
 void BBModule::WriteBranch(const Reg& cond,
                            const string& trueLabel,
                            const string& falseLabel) {
-  auto& gen = RiscvGenerator::getInstance();
-  ostream& os = gen.setting.getOs();
-  const string trueMid =
-      ParseSymbol(trueLabel) + "_mid_" + gen.funcCore.func_name;
-  bnez(os, cond, trueMid);
+  int mid = WriteBranchToMid(cond);
   // 否则跳到false
-  j(os, ParseSymbol(falseLabel) + "_" + gen.funcCore.func_name);
-  wlabel(os, trueMid);
-  j(os, ParseSymbol(trueLabel) + "_" + gen.funcCore.func_name);
+  WriteJumpInst(falseLabel);
+  WriteMidLabel(mid);
+  WriteJumpInst(trueLabel);
+}
+
+const string BBModule::GetMidLabel(const int& id) const {
+  auto& gen = RiscvGenerator::getInstance();
+  return "mid_" + std::to_string(id) + "_" + gen.funcCore.func_name;
+}
+
+const int BBModule::WriteBranchToMid(const Reg& cond) {
+  AsmEmitter& os = RiscvGenerator::getInstance().emitter;
+  int id = mid_cnt++;
+  bnez(os, cond, GetMidLabel(id));
+  return id;
+}
+
+const int BBModule::WriteCmpBranchToMid(OpType op,
+                                        const Reg& lhs,
+                                        const Reg& rhs) {
+  AsmEmitter& os = RiscvGenerator::getInstance().emitter;
+  int id = mid_cnt++;
+  const string mid = GetMidLabel(id);
+  switch (op) {
+    case koopa_raw_binary_op::KOOPA_RBO_NOT_EQ:
+      bne(os, lhs, rhs, mid);
+      break;
+    case koopa_raw_binary_op::KOOPA_RBO_EQ:
+      beq(os, lhs, rhs, mid);
+      break;
+    case koopa_raw_binary_op::KOOPA_RBO_GT:
+      blt(os, rhs, lhs, mid);
+      break;
+    case koopa_raw_binary_op::KOOPA_RBO_LT:
+      blt(os, lhs, rhs, mid);
+      break;
+    case koopa_raw_binary_op::KOOPA_RBO_GE:
+      bge(os, lhs, rhs, mid);
+      break;
+    case koopa_raw_binary_op::KOOPA_RBO_LE:
+      bge(os, rhs, lhs, mid);
+      break;
+    default:
+      assert(false);
+  }
+  return id;
+}
+
+void BBModule::WriteMidLabel(const int& id) {
+  AsmEmitter& os = RiscvGenerator::getInstance().emitter;
+  wlabel(os, GetMidLabel(id));
+}
+
+void BBModule::Clear() {
+  mid_cnt = 0;
 }
 
 #pragma endregion
 
 #pragma region Func
 
-FuncModule::FuncModule() : is_leaf_func(false), func_name() {}
+FuncModule::FuncModule() : is_leaf_func(false), func_name(), saved_regs() {}
 
 void FuncModule::WritePrologue() {
   auto& gen = RiscvGenerator::getInstance();
-  auto& os = gen.setting.getOs();
-  os << "\n  .text" << endl;
-  os << "  .globl " << func_name << endl;
-  os << func_name << ":" << endl;
+  auto& os = gen.emitter;
+  os << "\n  .text\n  .globl " << func_name << '\n' << func_name << ":\n";
 
   // 分配栈内存
   int stackMemoryAlloc = gen.stackCore.stack_memory;
@@ -298,22 +392,50 @@ void FuncModule::WritePrologue() {
   // 保存ra
   if (is_leaf_func)
     gen.stackCore.WriteSW(Reg::ra, gen.stackCore.IncreaseStackUsed());
+
+  // 保存用到的callee-saved寄存器
+  for (const Reg& reg : gen.allocCore.GetUsedCalleeSaved()) {
+    int addr = gen.stackCore.IncreaseStackUsed();
+    saved_regs[reg] = addr;
+    gen.stackCore.WriteSW(reg, addr);
+  }
+
+  // 溢出的值
+  gen.allocCore.AssignSpillSlots();
 }
 
 void FuncModule::WriteEpilogue(const InstResultInfo& retValueInfo) {
   auto& gen = RiscvGenerator::getInstance();
-  auto& os = gen.setting.getOs();
+  auto& os = gen.emitter;
 
   if (retValueInfo.ty == ValueType::e_imm) {
     li(os, Reg::a0, retValueInfo.content.imm);
   } else if (retValueInfo.ty == ValueType::e_reg) {
-    mv(os, Reg::a0, retValueInfo.content.reg);
+    if (retValueInfo.content.reg != Reg::a0)
+      mv(os, Reg::a0, retValueInfo.content.reg);
   } else if (retValueInfo.ty == ValueType::e_stack) {
     gen.stackCore.WriteLW(a0, retValueInfo.content.addr);
   } else {
     // 返回void
   }
 
+  WriteRestoreFrame();
+  ret(os);
+}
+
+void FuncModule::WriteTailCall(const string& name) {
+  WriteRestoreFrame();
+  tail(RiscvGenerator::getInstance().emitter, name);
+}
+
+void FuncModule::WriteRestoreFrame() {
+  auto& gen = RiscvGenerator::getInstance();
+  auto& os = gen.emitter;
+  // 恢复callee-saved寄存器
+  for (const auto& saved : saved_regs) {
+    gen.stackCore.WriteLW(saved.first, saved.second);
+  }
+
   int stack_memory_alloc = gen.stackCore.stack_memory;
   // 读取ra
   if (is_leaf_func)
@@ -330,17 +452,20 @@ void FuncModule::WriteEpilogue(const InstResultInfo& retValueInfo) {
       gen.regCore.ReleaseReg(rd);
     }
   }
-  ret(os);
 }
 
 void FuncModule::WriteCallInst(const string& name) {
-  ostream& os = RiscvGenerator::getInstance().setting.getOs();
+  AsmEmitter& os = RiscvGenerator::getInstance().emitter;
   call(os, name);
 }
 
 void FuncModule::Clear() {
   is_leaf_func = false;
   func_name = string();
+  saved_regs.clear();
+  tail_calls.clear();
+  tail_terms.clear();
+  fused_cmps.clear();
 }
 
 #pragma endregion
@@ -352,150 +477,141 @@ GlobalVarModule::GlobalVarModule() {}
 void GlobalVarModule::WriteGlobalVarDecl(const string& name,
                                          const InitInfo& init) {
   auto& gen = RiscvGenerator::getInstance();
-  auto& os = gen.setting.getOs();
+  auto& os = gen.emitter;
 
   os << "\n  .data\n  .globl " << name << "\n" << name << ": \n";
   switch (init.ty) {
     case InitType::e_zeroinit:
-      os << "  .zero " << init.value << endl;
+      os << "  .zero " << init.value << '\n';
       break;
     case InitType::e_int:
-      os << "  .word " << init.value << endl;
+      os << "  .word " << init.value << '\n';
   }
 }
 
-const int GlobalVarModule::WriteLoadGlobalVar(const string& name) {
+void GlobalVarModule::WriteLoadGlobalVar(const Reg& rd, const string& name) {
   auto& gen = RiscvGenerator::getInstance();
-  auto& os = gen.setting.getOs();
-  Reg tmp = gen.regCore.GetAvailableReg();
-  la(os, tmp, name);
-  lw(os, tmp, tmp, 0);
-
-  int addr = gen.stackCore.IncreaseStackUsed();
-  InstResultInfo src(tmp);
-  InstResultInfo dest(ValueType::e_stack, addr);
-  // reg -> stack
-  gen.stackCore.WriteDataTranfer(src, dest);
-
-  // 释放寄存器
-  gen.regCore.ReleaseReg(tmp);
-  return addr;
+  auto& os = gen.emitter;
+  // 地址直接放在rd里
+  la(os, rd, name);
+  lw(os, rd, rd, 0);
 }
 
-void GlobalVarModule::WriteStoreGlobalVar(const string& name,
-                                          const InstResultInfo& src_info) {
+void GlobalVarModule::WriteStoreGlobalVar(const string& name, const Reg& rs) {
   auto& gen = RiscvGenerator::getInstance();
-  auto& os = gen.setting.getOs();
+  auto& os = gen.emitter;
   Reg addr = gen.regCore.GetAvailableReg();
   la(os, addr, name);
-
-  Reg src = gen.regCore.GetAvailableReg();
-  if (src_info.ty == ValueType::e_reg) {
-    src = src_info.content.reg;
-  } else {
-    // stack -> reg, imm -> reg
-    gen.stackCore.WriteDataTranfer(src_info, InstResultInfo(src));
-  }
-  sw(os, addr, src, 0);
-  gen.regCore.ReleaseReg(src);
+  sw(os, addr, rs, 0);
   gen.regCore.ReleaseReg(addr);
-  return;
 }
 
 void GlobalVarModule::WriteGlobalArrDecl(const string& name,
                                          const ArrInfo& init) {
   auto& gen = RiscvGenerator::getInstance();
-  auto& os = gen.setting.getOs();
+  auto& os = gen.emitter;
 
   os << "\n  .data\n  .globl " << name << "\n" << name << ": \n";
   for (const auto& i : init.init) {
     if (i.ty == ArrInit::e_int) {
-      os << "  .word " << i.content.value << endl;
+      os << "  .word " << i.content.value << '\n';
     } else {
-      os << "  .zero " << i.content.zerolen * 4 << endl;
+      os << "  .zero " << i.content.zerolen * 4 << '\n';
     }
   }
 }
 #pragma endregion
 
-#pragma region arr
-
-ArrInfoModule::ArrInfoModule() : arrinfos(), current_arr(), current_dim() {}
-
-const int ArrInfoModule::GetCurArrSize() {
-  return current_arr.GetSize(current_dim);
-}
-
-#pragma endregion
-
 #pragma region RiscvGen
 
 RiscvGenerator::RiscvGenerator()
-    : regCore(), stackCore(), bbCore(), funcCore(), globalCore(), arrCore() {
-  setting.setOs(cout).setIndent(0);
-}
+    : regCore(),
+      allocCore(),
+      stackCore(),
+      bbCore(),
+      funcCore(),
+      globalCore(),
+      emitter() {}
 
 RiscvGenerator& RiscvGenerator::getInstance() {
-  static RiscvGenerator riscgen;
+  // 每个线程一份，翻译函数用到的状态互不干扰，可以并行
+  static thread_local RiscvGenerator riscgen;
   return riscgen;
 }
 
 void RiscvGenerator::WriteBinaInst(OpType op,
+                                   const Reg& rd,
                                    const Reg& left,
                                    const Reg& right) {
-  ostream& os = setting.getOs();
+  AsmEmitter& os = emitter;
 
   switch (op) {
     case koopa_raw_binary_op::KOOPA_RBO_NOT_EQ:
-      neq(os, left, left, right);
+      neq(os, rd, left, right);
       break;
 
     case koopa_raw_binary_op::KOOPA_RBO_EQ:
-      eq(os, left, left, right);
+      eq(os, rd, left, right);
       break;
 
     case koopa_raw_binary_op::KOOPA_RBO_GT:
-      sgt(os, left, left, right);
+      sgt(os, rd, left, right);
       break;
 
     case koopa_raw_binary_op::KOOPA_RBO_LT:
-      slt(os, left, left, right);
+      slt(os, rd, left, right);
       break;
 
     case koopa_raw_binary_op::KOOPA_RBO_GE:
-      sge(os, left, left, right);
+      sge(os, rd, left, right);
       break;
 
     case koopa_raw_binary_op::KOOPA_RBO_LE:
-      sle(os, left, left, right);
+      sle(os, rd, left, right);
       break;
 
     case koopa_raw_binary_op::KOOPA_RBO_ADD:
-      add(os, left, left, right);
+      add(os, rd, left, right);
       break;
 
     case koopa_raw_binary_op::KOOPA_RBO_SUB:
-      sub(os, left, left, right);
+      sub(os, rd, left, right);
       break;
 
     case koopa_raw_binary_op::KOOPA_RBO_MUL:
-      mul(os, left, left, right);
+      mul(os, rd, left, right);
       break;
 
     case koopa_raw_binary_op::KOOPA_RBO_DIV:
-      div(os, left, left, right);
+      div(os, rd, left, right);
       break;
 
     case koopa_raw_binary_op::KOOPA_RBO_MOD:
-      rem(os, left, left, right);
+      rem(os, rd, left, right);
       break;
 
     case koopa_raw_binary_op::KOOPA_RBO_AND:
-      andr(os, left, left, right);
+      andr(os, rd, left, right);
       break;
 
     case koopa_raw_binary_op::KOOPA_RBO_OR:
-      orr(os, left, left, right);
+      orr(os, rd, left, right);
+      break;
+
+    case koopa_raw_binary_op::KOOPA_RBO_XOR:
+      xorr(os, rd, left, right);
+      break;
+
+    case koopa_raw_binary_op::KOOPA_RBO_SHL:
+      sll(os, rd, left, right);
+      break;
+
+    case koopa_raw_binary_op::KOOPA_RBO_SHR:
+      srl(os, rd, left, right);
+      break;
+
+    case koopa_raw_binary_op::KOOPA_RBO_SAR:
+      sra(os, rd, left, right);
       break;
 
     default:
@@ -505,6 +621,132 @@ void RiscvGenerator::WriteBinaInst(OpType op,
   }
 }
 
+// 2的幂返回指数，否则返回-1
+static int GetLog2(int imm) {
+  if (imm <= 0 || (imm & (imm - 1)) != 0)
+    return -1;
+  int shift = 0;
+  while ((1 << shift) != imm)
+    ++shift;
+  return shift;
+}
+
+bool RiscvGenerator::CanUseImm(OpType op, int imm) {
+  // 用long long避免imm+1、-imm溢出
+  long long value = imm;
+  switch (op) {
+    case koopa_raw_binary_op::KOOPA_RBO_NOT_EQ:
+    case koopa_raw_binary_op::KOOPA_RBO_EQ:
+    case koopa_raw_binary_op::KOOPA_RBO_LT:
+    case koopa_raw_binary_op::KOOPA_RBO_GE:
+    case koopa_raw_binary_op::KOOPA_RBO_ADD:
+    case koopa_raw_binary_op::KOOPA_RBO_AND:
+    case koopa_raw_binary_op::KOOPA_RBO_OR:
+    case koopa_raw_binary_op::KOOPA_RBO_XOR:
+      return IsImmInBound(imm);
+    case koopa_raw_binary_op::KOOPA_RBO_GT:
+    case koopa_raw_binary_op::KOOPA_RBO_LE:
+      // 和imm+1比较
+      return value + 1 >= -2048 && value + 1 <= 2047;
+    case koopa_raw_binary_op::KOOPA_RBO_SUB:
+      return -value >= -2048 && -value <= 2047;
+    case koopa_raw_binary_op::KOOPA_RBO_MUL:
+      return GetLog2(imm) >= 0;
+    case koopa_raw_binary_op::KOOPA_RBO_SHL:
+    case koopa_raw_binary_op::KOOPA_RBO_SHR:
+    case koopa_raw_binary_op::KOOPA_RBO_SAR:
+      return imm >= 0 && imm < 32;
+    default:
+      // 除法、取模没有立即数形式
+      return false;
+  }
+}
+
+void RiscvGenerator::WriteBinaImmInst(OpType op,
+                                      const Reg& rd,
+                                      const Reg& left,
+                                      int imm) {
+  AsmEmitter& os = emitter;
+
+  switch (op) {
+    case koopa_raw_binary_op::KOOPA_RBO_NOT_EQ:
+      if (imm == 0) {
+        snez(os, rd, left);
+        break;
+      }
+      xori(os, rd, left, imm);
+      snez(os, rd, rd);
+      break;
+
+    case koopa_raw_binary_op::KOOPA_RBO_EQ:
+      if (imm == 0) {
+        seqz(os, rd, left);
+        break;
+      }
+      xori(os, rd, left, imm);
+      seqz(os, rd, rd);
+      break;
+
+    case koopa_raw_binary_op::KOOPA_RBO_GT:
+      // left > imm即!(left < imm + 1)
+      slti(os, rd, left, imm + 1);
+      xori(os, rd, rd, 1);
+      break;
+
+    case koopa_raw_binary_op::KOOPA_RBO_LT:
+      slti(os, rd, left, imm);
+      break;
+
+    case koopa_raw_binary_op::KOOPA_RBO_GE:
+      slti(os, rd, left, imm);
+      xori(os, rd, rd, 1);
+      break;
+
+    case koopa_raw_binary_op::KOOPA_RBO_LE:
+      slti(os, rd, left, imm + 1);
+      break;
+
+    case koopa_raw_binary_op::KOOPA_RBO_ADD:
+      addi(os, rd, left, imm);
+      break;
+
+    case koopa_raw_binary_op::KOOPA_RBO_SUB:
+      addi(os, rd, left, -imm);
+      break;
+
+    case koopa_raw_binary_op::KOOPA_RBO_MUL:
+      slli(os, rd, left, GetLog2(imm));
+      break;
+
+    case koopa_raw_binary_op::KOOPA_RBO_AND:
+      andi(os, rd, left, imm);
+      break;
+
+    case koopa_raw_binary_op::KOOPA_RBO_OR:
+      ori(os, rd, left, imm);
+      break;
+
+    case koopa_raw_binary_op::KOOPA_RBO_XOR:
+      xori(os, rd, left, imm);
+      break;
+
+    case koopa_raw_binary_op::KOOPA_RBO_SHL:
+      slli(os, rd, left, imm);
+      break;
+
+    case koopa_raw_binary_op::KOOPA_RBO_SHR:
+      srli(os, rd, left, imm);
+      break;
+
+    case koopa_raw_binary_op::KOOPA_RBO_SAR:
+      srai(os, rd, left, imm);
+      break;
+
+    default:
+      assert(false);
+  }
+}
+
 #pragma endregion
 
 }  // namespace riscv
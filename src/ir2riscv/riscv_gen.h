@@ -2,12 +2,12 @@
 
 #include <cassert>
 #include <iostream>
+#include <map>
 #include <queue>
 #include <set>
 #include <sstream>
 #include <string>
 #include "koopa.h"
-#include "output_setting.h"
 #include "riscv_build.h"
 #include "riscv_util.h"
 
@@ -53,21 +53,19 @@ struct ArrInfo {
   vector<ArrInit> init;
   // 当前已经初始化的长度
   int init_len;
-  // 对于临时数组，存储相对于sp的地址
-  int stack_addr;
 
   ArrInfo();
   ArrInfo(const vector<int>& _shape);
   // 初始化时推入一个数
   void PushNum(const int& val);
+  // 初始化时推入len个0，和前面的0合并成一段
+  void PushZeros(const int& len);
   // 获取大小
   const int GetSize();
-  // 给定维度i，获取从i到max的维度的总空间
-  // 如：int a[2][3][5], (i) = 3*5*4, 也就是第一次getelemptr需要的步长
-  const int GetSize(int i);
 };
 
-// 寄存器模块
+// 临时寄存器模块
+// t0-t2不参与寄存器分配，只在一条指令的翻译过程中临时使用
 class RegisterModule {
  private:
   // 当前可用寄存器
@@ -77,10 +75,146 @@ class RegisterModule {
   RegisterModule();
   // 取出一个当前可用的寄存器
   Reg GetAvailableReg();
-  // 释放一个占用寄存器
+  // 释放一个占用寄存器，不是临时寄存器的话什么都不做
   void ReleaseReg(Reg reg);
-  // 取出特定寄存器
-  bool GetReg(const Reg& reg);
+  // 是否是临时寄存器
+  bool IsTempReg(const Reg& reg) const;
+};
+
+// 寄存器分配策略
+// 线性扫描：快，-O1默认
+// 图着色：迭代合并（IRC），消除传参、返回值的mv，-O2使用
+enum class RegAllocStrategy { e_linear_scan, e_graph_coloring };
+
+// 寄存器分配模块
+// 在翻译函数前计算所有值的活跃信息，为其分配寄存器或溢出到栈上
+// 结果写进StackMemoryModule::InstResult，e_reg或e_stack
+class RegAllocModule {
+ public:
+  RegAllocStrategy strategy;
+
+  RegAllocModule();
+  // 为函数中所有的值（参数和有返回值的指令）分配位置
+  void Allocate(const koopa_raw_function_t& func);
+  // 溢出到栈上的值的个数
+  const int GetSpillCount() const;
+  // 分配出去的callee-saved寄存器，需要在函数开头保存
+  const set<Reg>& GetUsedCalleeSaved() const;
+  // 为溢出的值分配栈空间，在函数开头保存完寄存器后调用
+  void AssignSpillSlots();
+  // 清空记录
+  void Clear();
+
+ private:
+  // 活跃区间，位置是指令在函数中的序号
+  struct LiveInterval {
+    int id;
+    int start;
+    int end;
+    // 区间内有函数调用，只能用callee-saved寄存器
+    bool cross_call;
+  };
+
+  // 参与分配的值和编号
+  vector<koopa_raw_value_t> values;
+  map<koopa_raw_value_t, int> value_ids;
+  // 值的定义位置
+  vector<int> def_pos;
+  // 按顺序排列的基本块，和块的开头、结尾位置
+  vector<koopa_raw_basic_block_t> bbs;
+  map<koopa_raw_basic_block_t, int> bb_ids;
+  vector<int> bb_start;
+  vector<int> bb_end;
+  // 基本块的后继
+  vector<vector<int>> bb_succs;
+  // 每个基本块入口和出口活跃的值，按编号排序
+  vector<vector<int>> live_in;
+  vector<vector<int>> live_out;
+  // 函数调用的位置，有序
+  vector<int> call_pos;
+  vector<LiveInterval> intervals;
+  // 希望分到的寄存器，如参数a0-a7，返回值a0
+  map<int, Reg> hints;
+
+  vector<koopa_raw_value_t> spilled;
+  set<Reg> used_callee_saved;
+
+  // 给值和基本块编号，记录位置
+  void NumberValues(const koopa_raw_function_t& func);
+  // 计算基本块的live in/live out
+  void CalcLiveness();
+  // 计算每个值的活跃区间
+  void BuildIntervals();
+  // 线性扫描
+  void LinearScan();
+  // 值被分配到寄存器
+  void AssignReg(const int& id, const Reg& reg);
+
+#pragma region graph coloring
+  // 节点0到K-1是预着色的寄存器，之后是值，节点号 = K + 值编号
+  enum class NodeState {
+    e_unused,
+    e_precolored,
+    e_initial,
+    e_simplify,
+    e_freeze,
+    e_spill,
+    e_spilled,
+    e_coalesced,
+    e_colored,
+    e_selected
+  };
+  enum class MoveState { e_worklist, e_active, e_coalesced, e_constrained };
+
+  // 基本块的循环嵌套深度
+  vector<int> loop_depth;
+  // 冲突图
+  set<pair<int, int>> adj_set;
+  vector<vector<int>> adj_list;
+  vector<int> degree;
+  vector<NodeState> node_state;
+  vector<int> alias;
+  vector<int> color;
+  // 溢出代价，每次定义和使用按10^循环深度加权
+  vector<double> spill_cost;
+  // 传送：参数、返回值和预着色寄存器之间，块参数之间
+  vector<pair<int, int>> moves;
+  vector<MoveState> move_state;
+  vector<vector<int>> move_list;
+  set<int> simplify_worklist;
+  set<int> freeze_worklist;
+  set<int> spill_worklist;
+  set<int> worklist_moves;
+  vector<int> select_stack;
+
+  // 迭代合并图着色
+  void GraphColoring();
+  // 用支配关系找回边，计算循环深度
+  void CalcLoopDepth();
+  // 从活跃信息构建冲突图和传送列表
+  void BuildGraph();
+  void AddEdge(const int& u, const int& v);
+  void AddMove(const int& u, const int& v);
+  void MakeWorklist();
+  const vector<int> Adjacent(const int& n);
+  const vector<int> NodeMoves(const int& n);
+  bool MoveRelated(const int& n);
+  void Simplify();
+  void DecrementDegree(const int& m);
+  void EnableMoves(const vector<int>& nodes);
+  void Coalesce();
+  void AddWorkList(const int& u);
+  // George：t能否并入预着色的r
+  bool OK(const int& t, const int& r);
+  // Briggs：合并后高度数邻居少于K
+  bool Conservative(const vector<int>& nodes);
+  const int GetAlias(int n);
+  void Combine(const int& u, const int& v);
+  void Freeze();
+  void FreezeMoves(const int& u);
+  void SelectSpill();
+  void AssignColors();
+#pragma endregion
 };
 
 // 栈内存管理模块
@@ -101,10 +235,14 @@ class StackMemoryModule {
   // 用于数据转移，需要在外部管理寄存器
   // 支持：
   // imm -> reg, imm -> stack
-  // reg -> stack, stack1 -> stack2
+  // reg1 -> reg2, reg -> stack, stack1 -> stack2
   // stack -> reg
   void WriteDataTranfer(const InstResultInfo& src, const InstResultInfo& dest);
 
+  // 同时进行的一组数据转移，如传参。目标之间互不相同
+  // 源被其他转移覆盖前会先被读出，成环时借用临时寄存器
+  void WriteParallelMove(vector<pair<InstResultInfo, InstResultInfo>> moves);
+
   void WriteLI(const Reg& rs, int imm);
   // 从addr地址读出存入rd，不用imm12
   void WriteLW(const Reg& rd, int addr);
@@ -124,6 +262,11 @@ class StackMemoryModule {
 
 class BBModule {
  private:
+  // 当前函数已经用掉的中转标签数
+  int mid_cnt;
+  // 第id个中转标签的名字
+  const string GetMidLabel(const int& id) const;
+
  public:
   BBModule();
   void WriteBBName(const string& label);
@@ -133,6 +276,15 @@ class BBModule {
   void WriteBranch(const Reg& cond,
                    const string& trueLabel,
                    const string& falseLabel);
+  // bnez的跳转范围有限，先跳到中转标签，再从中转标签j过去
+  // 块参数的传递写在j之前
+  // 每条跳转有自己的中转标签，返回它的编号
+  const int WriteBranchToMid(const Reg& cond);
+  // 比较和跳转合成一条，lhs op rhs成立时跳到中转标签
+  const int WriteCmpBranchToMid(OpType op, const Reg& lhs, const Reg& rhs);
+  void WriteMidLabel(const int& id);
+  // 清空记录
+  void Clear();
 };
 
 class FuncModule {
@@ -141,6 +293,13 @@ class FuncModule {
   bool is_leaf_func;
   // 函数名
   string func_name;
+  // 保存的callee-saved寄存器和保存的位置
+  map<Reg, int> saved_regs;
+  // 复用栈帧的尾调用，和它们之后不用再生成的返回
+  set<koopa_raw_value_t> tail_calls;
+  set<koopa_raw_value_t> tail_terms;
+  // 只被紧跟着的branch使用的比较，不单独生成，和branch合成一条指令
+  set<koopa_raw_value_t> fused_cmps;
 
   FuncModule();
 
@@ -150,8 +309,14 @@ class FuncModule {
   void WriteEpilogue(const InstResultInfo& retValueInfo);
   // 输出call指令
   void WriteCallInst(const string& name);
+  // 恢复栈帧后跳到被调用的函数，参数已经放好
+  void WriteTailCall(const string& name);
   // 清空信息
   void Clear();
+
+ private:
+  // 恢复callee-saved寄存器和ra，回收栈内存
+  void WriteRestoreFrame();
 };
 
 enum class InitType { e_zeroinit, e_int };
@@ -166,32 +331,16 @@ class GlobalVarModule {
   GlobalVarModule();
   // 生成全局变量声明
   void WriteGlobalVarDecl(const string& name, const InitInfo& init);
-  // 从全局变量load，返回最终存储这个load指令结果的地址
-  const int WriteLoadGlobalVar(const string& name);
-  // 存储到全局变量，返回全局变量的地址，info只支持int和reg
-  void WriteStoreGlobalVar(const string& name, const InstResultInfo& src_info);
+  // 从全局变量load到rd
+  void WriteLoadGlobalVar(const Reg& rd, const string& name);
+  // 把rs存储到全局变量
+  void WriteStoreGlobalVar(const string& name, const Reg& rs);
 
   // 生成全局数组声明
   void WriteGlobalArrDecl(const string& name, const ArrInfo& init);
 };
 
-// 记录alloc指令和数组关系的表
-class ArrInfoModule {
- public:
-  map<koopa_raw_value_t, ArrInfo> arrinfos;
-
-  // 当前正在分析的数组，会在第一次调用从alloc中getelemptr时赋值
-  ArrInfo current_arr;
-
-  // 当前解析到的维度数，算指针用
-  int current_dim;
-
-  ArrInfoModule();
-
-  // 用current dim计算current arr的分片size
-  const int GetCurArrSize();
-};
-
+// 后端的全部状态，每个线程一份
 class RiscvGenerator {
  private:
   RiscvGenerator();
@@ -200,16 +349,24 @@ class RiscvGenerator {
   RiscvGenerator& operator=(const RiscvGenerator&) = delete;
 
  public:
-  GenSettings setting;
   RegisterModule regCore;
+  RegAllocModule allocCore;
   StackMemoryModule stackCore;
   BBModule bbCore;
   FuncModule funcCore;
   GlobalVarModule globalCore;
-  ArrInfoModule arrCore;
+  // 汇编输出
+  AsmEmitter emitter;
   static RiscvGenerator& getInstance();
 
-  // 输入运算符，输出指令
-  void WriteBinaInst(OpType op, const Reg& left, const Reg& right);
+  // 输入运算符，输出指令，结果存入rd
+  void WriteBinaInst(OpType op,
+                     const Reg& rd,
+                     const Reg& left,
+                     const Reg& right);
+  // 右操作数是常数imm时能否用立即数形式的指令
+  static bool CanUseImm(OpType op, int imm);
+  // 右操作数是常数imm，结果存入rd，要求CanUseImm
+  void WriteBinaImmInst(OpType op, const Reg& rd, const Reg& left, int imm);
 };
 };  // namespace riscv
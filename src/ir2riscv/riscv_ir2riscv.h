@@ -17,12 +17,20 @@ using namespace std;
 namespace riscv {
 
 /* core.cpp */
-// 主功能
-void ir2riscv(string ircode, const char* output);
-// 生成raw program
-koopa_raw_program_t get_raw_program(string ircode,
-                                    koopa_raw_program_builder_t& builder);
-// 释放raw program builder
-void release_builder(koopa_raw_program_builder_t& builder);
+// 主功能，raw program由前端直接在内存中生成
+// opt_level >= 2时使用图着色寄存器分配
+// jobs个线程并行翻译函数，每个函数写入自己的缓冲区，最后按顺序拼接
+void ir2riscv(const koopa_raw_program_t& program,
+              const char* output,
+              const int& opt_level,
+              const int& jobs);
+
+// 流式生成用，前端每生成一部分就交给后端，写完立刻落盘
+// 打开输出文件，设置寄存器分配策略和线程数，失败返回false
+bool BeginStream(const char* output, const int& opt_level, const int& jobs);
+// 生成一部分全局变量和函数的汇编并写入文件
+void StreamUnit(const koopa_raw_program_t& unit);
+// 关闭输出文件
+void EndStream();
 
 }  // namespace riscv
@@ -0,0 +1,129 @@
+#include "riscv_minst.h"
+
+namespace riscv {
+
+MachineInst::MachineInst(MOp _op, Reg _rd, Reg _rs1, Reg _rs2, int _imm)
+    : op(_op), rd(_rd), rs1(_rs1), rs2(_rs2), imm(_imm), label() {}
+
+MachineInst::MachineInst(MOp _op, Reg _rd, const std::string& _label)
+    : op(_op), rd(_rd), rs1(NONE), rs2(NONE), imm(0), label(_label) {}
+
+const char* MachineInst::Name() const {
+  switch (op) {
+    case MOp::e_label:
+      return "";
+    case MOp::e_li:
+      return "li";
+    case MOp::e_la:
+      return "la";
+    case MOp::e_lw:
+      return "lw";
+    case MOp::e_sw:
+      return "sw";
+    case MOp::e_mv:
+      return "mv";
+    case MOp::e_add:
+      return "add";
+    case MOp::e_addi:
+      return "addi";
+    case MOp::e_sub:
+      return "sub";
+    case MOp::e_mul:
+      return "mul";
+    case MOp::e_div:
+      return "div";
+    case MOp::e_rem:
+      return "rem";
+    case MOp::e_seqz:
+      return "seqz";
+    case MOp::e_snez:
+      return "snez";
+    case MOp::e_slt:
+      return "slt";
+    case MOp::e_slti:
+      return "slti";
+    case MOp::e_sgt:
+      return "sgt";
+    case MOp::e_xor:
+      return "xor";
+    case MOp::e_xori:
+      return "xori";
+    case MOp::e_and:
+      return "and";
+    case MOp::e_andi:
+      return "andi";
+    case MOp::e_or:
+      return "or";
+    case MOp::e_ori:
+      return "ori";
+    case MOp::e_sll:
+      return "sll";
+    case MOp::e_slli:
+      return "slli";
+    case MOp::e_srl:
+      return "srl";
+    case MOp::e_srli:
+      return "srli";
+    case MOp::e_sra:
+      return "sra";
+    case MOp::e_srai:
+      return "srai";
+    case MOp::e_j:
+      return "j";
+    case MOp::e_bnez:
+      return "bnez";
+    case MOp::e_beqz:
+      return "beqz";
+    case MOp::e_beq:
+      return "beq";
+    case MOp::e_bne:
+      return "bne";
+    case MOp::e_blt:
+      return "blt";
+    case MOp::e_bge:
+      return "bge";
+    case MOp::e_call:
+      return "call";
+    case MOp::e_tail:
+      return "tail";
+    case MOp::e_ret:
+      return "ret";
+  }
+  assert(false);
+  return "";
+}
+
+Reg MachineInst::GetDef() const {
+  switch (op) {
+    case MOp::e_label:
+    case MOp::e_sw:
+    case MOp::e_j:
+    case MOp::e_bnez:
+    case MOp::e_beqz:
+    case MOp::e_beq:
+    case MOp::e_bne:
+    case MOp::e_blt:
+    case MOp::e_bge:
+    case MOp::e_call:
+    case MOp::e_tail:
+    case MOp::e_ret:
+      return NONE;
+    default:
+      return rd;
+  }
+}
+
+std::vector<Reg> MachineInst::GetUses() const {
+  std::vector<Reg> uses;
+  if (rs1 != NONE)
+    uses.push_back(rs1);
+  if (rs2 != NONE)
+    uses.push_back(rs2);
+  return uses;
+}
+
+bool MachineInst::Uses(const Reg& reg) const {
+  return rs1 == reg || rs2 == reg;
+}
+
+}  // namespace riscv
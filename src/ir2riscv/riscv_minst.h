@@ -0,0 +1,82 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include "riscv_util.h"
+
+namespace riscv {
+
+// 后端生成的机器指令，函数生成完后做窥孔优化再输出成文本
+enum class MOp {
+  e_label,
+  e_li,
+  e_la,
+  e_lw,
+  e_sw,
+  e_mv,
+  e_add,
+  e_addi,
+  e_sub,
+  e_mul,
+  e_div,
+  e_rem,
+  e_seqz,
+  e_snez,
+  e_slt,
+  e_slti,
+  e_sgt,
+  e_xor,
+  e_xori,
+  e_and,
+  e_andi,
+  e_or,
+  e_ori,
+  e_sll,
+  e_slli,
+  e_srl,
+  e_srli,
+  e_sra,
+  e_srai,
+  e_j,
+  e_bnez,
+  e_beqz,
+  e_beq,
+  e_bne,
+  e_blt,
+  e_bge,
+  e_call,
+  e_tail,
+  e_ret
+};
+
+// lw：rd = imm(rs1)
+// sw：rs2存到imm(rs1)
+// bnez、beqz：判断rs1，跳到label
+// beq、bne、blt、bge：比较rs1和rs2，跳到label
+// li、la：rd = imm、label
+struct MachineInst {
+  MOp op;
+  Reg rd;
+  Reg rs1;
+  Reg rs2;
+  int imm;
+  std::string label;
+
+  MachineInst(MOp _op,
+              Reg _rd = NONE,
+              Reg _rs1 = NONE,
+              Reg _rs2 = NONE,
+              int _imm = 0);
+  MachineInst(MOp _op, Reg _rd, const std::string& _label);
+
+  // 指令名
+  const char* Name() const;
+  // 写的寄存器，没有时返回NONE，call另外处理
+  Reg GetDef() const;
+  // 读的寄存器
+  std::vector<Reg> GetUses() const;
+  // 是否读了reg
+  bool Uses(const Reg& reg) const;
+};
+
+}  // namespace riscv
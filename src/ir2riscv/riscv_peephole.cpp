@@ -0,0 +1,588 @@
+#include "riscv_peephole.h"
+#include <cstdlib>
+#include <map>
+#include <set>
+#include <string>
+
+namespace riscv {
+
+using std::map;
+using std::set;
+using std::string;
+using std::vector;
+
+// 反复执行的轮数上限，正常两三轮就不再变化
+static const int MAX_ROUNDS = 8;
+// 条件跳转的范围是±4KiB，留一些余量
+static const int BRANCH_RANGE = 4000;
+
+// 临时寄存器只在一条IR指令内部使用，不会跨基本块
+static bool IsScratch(const Reg& reg) {
+  return reg == Reg::t0 || reg == Reg::t1 || reg == Reg::t2;
+}
+
+// 会离开当前这段顺序执行的代码
+static bool IsControl(const MOp& op) {
+  switch (op) {
+    case MOp::e_label:
+    case MOp::e_j:
+    case MOp::e_bnez:
+    case MOp::e_beqz:
+    case MOp::e_beq:
+    case MOp::e_bne:
+    case MOp::e_blt:
+    case MOp::e_bge:
+    case MOp::e_call:
+    case MOp::e_tail:
+    case MOp::e_ret:
+      return true;
+    default:
+      return false;
+  }
+}
+
+// 条件跳转
+static bool IsBranch(const MOp& op) {
+  switch (op) {
+    case MOp::e_bnez:
+    case MOp::e_beqz:
+    case MOp::e_beq:
+    case MOp::e_bne:
+    case MOp::e_blt:
+    case MOp::e_bge:
+      return true;
+    default:
+      return false;
+  }
+}
+
+// insts[i]之后reg的值是否不再被使用
+// 遇到控制流就不再往下看，只有临时寄存器可以认为已经死了
+// call、ret、tail会隐式读a0-a7，也按控制流处理
+static bool IsDeadAfter(const vector<MachineInst>& insts,
+                        size_t i,
+                        const Reg& reg) {
+  for (size_t k = i + 1; k < insts.size(); ++k) {
+    const auto& inst = insts[k];
+    if (inst.Uses(reg))
+      return false;
+    if (IsControl(inst.op))
+      return IsScratch(reg);
+    if (inst.GetDef() == reg)
+      return true;
+  }
+  return true;
+}
+
+#pragma region FoldImm
+
+// 寄存器-寄存器运算对应的立即数形式，没有时返回原来的op
+static MOp GetImmOp(const MOp& op) {
+  switch (op) {
+    case MOp::e_add:
+      return MOp::e_addi;
+    case MOp::e_and:
+      return MOp::e_andi;
+    case MOp::e_or:
+      return MOp::e_ori;
+    case MOp::e_xor:
+      return MOp::e_xori;
+    default:
+      return op;
+  }
+}
+
+// 移位对应的立即数形式，没有时返回原来的op
+static MOp GetShiftImmOp(const MOp& op) {
+  switch (op) {
+    case MOp::e_sll:
+      return MOp::e_slli;
+    case MOp::e_srl:
+      return MOp::e_srli;
+    case MOp::e_sra:
+      return MOp::e_srai;
+    default:
+      return op;
+  }
+}
+
+// 用li的结果imm改写下一条指令，改不了返回false
+static bool FoldInto(MachineInst& inst, const Reg& reg, int imm) {
+  // 两个操作数都是它的就不管了
+  if (inst.rs1 == reg && inst.rs2 == reg)
+    return false;
+  Reg other = inst.rs1 == reg ? inst.rs2 : inst.rs1;
+  MOp imm_op = GetImmOp(inst.op);
+
+  if (inst.op == MOp::e_mv) {
+    // mv rd, t => li rd, imm
+    inst = MachineInst(MOp::e_li, inst.rd, NONE, NONE, imm);
+    return true;
+  }
+  if (imm_op != inst.op && IsImmInBound(imm)) {
+    // 满足交换律，哪边都可以
+    inst = MachineInst(imm_op, inst.rd, other, NONE, imm);
+    return true;
+  }
+  if (inst.op == MOp::e_sub && inst.rs2 == reg && IsImmInBound(-imm)) {
+    // sub rd, rs, t => addi rd, rs, -imm
+    inst = MachineInst(MOp::e_addi, inst.rd, other, NONE, -imm);
+    return true;
+  }
+  if (GetShiftImmOp(inst.op) != inst.op && inst.rs2 == reg && imm >= 0 &&
+      imm < 32) {
+    // 移位量是常数
+    inst = MachineInst(GetShiftImmOp(inst.op), inst.rd, other, NONE, imm);
+    return true;
+  }
+  if (inst.op == MOp::e_slt && inst.rs2 == reg && IsImmInBound(imm)) {
+    // rs < imm
+    inst = MachineInst(MOp::e_slti, inst.rd, other, NONE, imm);
+    return true;
+  }
+  if (inst.op == MOp::e_sgt && inst.rs1 == reg && IsImmInBound(imm)) {
+    // imm > rs，即rs < imm
+    inst = MachineInst(MOp::e_slti, inst.rd, other, NONE, imm);
+    return true;
+  }
+  if (imm == 0 && inst.op != MOp::e_lw && inst.op != MOp::e_sw) {
+    // 其他指令读0时直接用x0
+    if (inst.rs1 == reg)
+      inst.rs1 = Reg::x0;
+    if (inst.rs2 == reg)
+      inst.rs2 = Reg::x0;
+    return true;
+  }
+  if (imm == 0 && inst.op == MOp::e_sw && inst.rs2 == reg) {
+    // 存0，地址不用x0
+    inst.rs2 = Reg::x0;
+    return true;
+  }
+  return false;
+}
+
+// li t, imm; op rd, rs, t => opi rd, rs, imm
+// 只在li的结果只被下一条指令使用时改写
+static bool FoldImm(vector<MachineInst>& insts) {
+  bool changed = false;
+  vector<MachineInst> out;
+  out.reserve(insts.size());
+  for (size_t i = 0; i < insts.size(); ++i) {
+    const auto& inst = insts[i];
+    if (inst.op != MOp::e_li || i + 1 >= insts.size()) {
+      out.push_back(inst);
+      continue;
+    }
+    auto& next = insts[i + 1];
+    bool only_use = next.Uses(inst.rd) && (next.GetDef() == inst.rd ||
+                                           IsDeadAfter(insts, i + 1, inst.rd));
+    if (only_use && FoldInto(next, inst.rd, inst.imm)) {
+      changed = true;
+      continue;
+    }
+    out.push_back(inst);
+  }
+  insts.swap(out);
+  return changed;
+}
+
+// 从insts[i]往后找第一条读或写reg的指令，中间遇到控制流就返回-1
+static int FindNextAccess(const vector<MachineInst>& insts,
+                          size_t i,
+                          const Reg& reg,
+                          const Reg& base) {
+  for (size_t k = i + 1; k < insts.size(); ++k) {
+    const auto& inst = insts[k];
+    if (inst.Uses(reg) || inst.GetDef() == reg)
+      return k;
+    // base被改掉了就不能再用
+    if (IsControl(inst.op) || inst.GetDef() == base)
+      return -1;
+  }
+  return -1;
+}
+
+// addi t, base, k; ...; lw/sw x, off(t) => ...; lw/sw x, off+k(base)
+// 同样只在t之后不再被使用时改写
+static bool FoldOffset(vector<MachineInst>& insts) {
+  bool changed = false;
+  vector<bool> removed(insts.size(), false);
+  for (size_t i = 0; i < insts.size(); ++i) {
+    const auto& inst = insts[i];
+    if (inst.op != MOp::e_addi || inst.rd == inst.rs1)
+      continue;
+    int k = FindNextAccess(insts, i, inst.rd, inst.rs1);
+    if (k < 0)
+      continue;
+    auto& next = insts[k];
+    bool is_mem = (next.op == MOp::e_lw && next.rs1 == inst.rd) ||
+                  (next.op == MOp::e_sw && next.rs1 == inst.rd &&
+                   next.rs2 != inst.rd);
+    bool dead = next.GetDef() == inst.rd || IsDeadAfter(insts, k, inst.rd);
+    if (is_mem && dead && IsImmInBound(next.imm + inst.imm)) {
+      next.rs1 = inst.rs1;
+      next.imm += inst.imm;
+      removed[i] = true;
+      changed = true;
+    }
+  }
+  if (!changed)
+    return false;
+  size_t len = 0;
+  for (size_t i = 0; i < insts.size(); ++i) {
+    if (!removed[i])
+      insts[len++] = insts[i];
+  }
+  insts.erase(insts.begin() + len, insts.end());
+  return true;
+}
+
+#pragma endregion
+
+#pragma region ForwardMemory
+
+// 已知内存imm(base)里的值和reg相同
+struct MemEntry {
+  Reg base;
+  int offset;
+  Reg reg;
+};
+
+// 顺序执行的一段代码里，记录已知的内存内容和la加载的符号
+class MemState {
+ public:
+  MemState() : la_syms(Reg::x0 + 1) {}
+
+  void Clear() {
+    entries.clear();
+    for (auto& sym : la_syms) {
+      sym.clear();
+    }
+  }
+
+  // 和imm(base)相同的寄存器，没有时返回NONE
+  Reg Find(const Reg& base, int offset) const {
+    for (const auto& entry : entries) {
+      if (entry.base == base && entry.offset == offset)
+        return entry.reg;
+    }
+    return NONE;
+  }
+
+  bool HasValue(const Reg& base, int offset, const Reg& reg) const {
+    for (const auto& entry : entries) {
+      if (entry.base == base && entry.offset == offset && entry.reg == reg)
+        return true;
+    }
+    return false;
+  }
+
+  // reg被改写，和它有关的记录都失效
+  void Kill(const Reg& reg) {
+    if (reg == NONE)
+      return;
+    size_t len = 0;
+    for (size_t i = 0; i < entries.size(); ++i) {
+      if (entries[i].base != reg && entries[i].reg != reg)
+        entries[len++] = entries[i];
+    }
+    entries.resize(len);
+    la_syms[reg].clear();
+  }
+
+  // 写入imm(base)，除了栈上其他位置的记录，都可能被覆盖
+  void Store(const Reg& base, int offset, const Reg& reg) {
+    size_t len = 0;
+    if (base == Reg::sp) {
+      for (size_t i = 0; i < entries.size(); ++i) {
+        const auto& entry = entries[i];
+        if (entry.base == Reg::sp && entry.offset != offset)
+          entries[len++] = entry;
+      }
+    }
+    entries.resize(len);
+    Record(base, offset, reg);
+  }
+
+  void Record(const Reg& base, int offset, const Reg& reg) {
+    if (base != reg)
+      entries.push_back({base, offset, reg});
+  }
+
+  const string& GetSymbol(const Reg& reg) const { return la_syms[reg]; }
+  void SetSymbol(const Reg& reg, const string& sym) { la_syms[reg] = sym; }
+
+ private:
+  vector<MemEntry> entries;
+  vector<string> la_syms;
+};
+
+// 刚存进内存或刚读出来的值直接转发给后面的lw
+// 重复的sw和la也删掉
+static bool ForwardMemory(vector<MachineInst>& insts) {
+  bool changed = false;
+  MemState state;
+  vector<MachineInst> out;
+  out.reserve(insts.size());
+  for (auto inst : insts) {
+    switch (inst.op) {
+      case MOp::e_lw: {
+        Reg base = inst.rs1;
+        int offset = inst.imm;
+        Reg known = state.Find(base, offset);
+        if (known == inst.rd) {
+          changed = true;
+          continue;
+        }
+        if (known != NONE) {
+          inst = MachineInst(MOp::e_mv, inst.rd, known);
+          changed = true;
+        }
+        state.Kill(inst.rd);
+        state.Record(base, offset, inst.rd);
+        break;
+      }
+      case MOp::e_sw:
+        if (state.HasValue(inst.rs1, inst.imm, inst.rs2)) {
+          changed = true;
+          continue;
+        }
+        state.Store(inst.rs1, inst.imm, inst.rs2);
+        break;
+      case MOp::e_la:
+        if (state.GetSymbol(inst.rd) == inst.label) {
+          changed = true;
+          continue;
+        }
+        state.Kill(inst.rd);
+        state.SetSymbol(inst.rd, inst.label);
+        break;
+      default:
+        if (IsBranch(inst.op)) {
+          // 不跳转时记录仍然有效
+        } else if (IsControl(inst.op)) {
+          // 汇合点和函数调用之后什么都不知道
+          state.Clear();
+        } else if (inst.GetDef() == Reg::sp) {
+          state.Clear();
+        } else {
+          state.Kill(inst.GetDef());
+        }
+        break;
+    }
+    out.push_back(inst);
+  }
+  insts.swap(out);
+  return changed;
+}
+
+#pragma endregion
+
+#pragma region RemoveMoves
+
+// 删掉没有效果的mv，加0的立即数运算改成mv
+static bool RemoveMoves(vector<MachineInst>& insts) {
+  bool changed = false;
+  vector<MachineInst> out;
+  out.reserve(insts.size());
+  for (auto inst : insts) {
+    bool zero_imm = inst.imm == 0 && (inst.op == MOp::e_addi ||
+                                      inst.op == MOp::e_ori ||
+                                      inst.op == MOp::e_xori);
+    if (zero_imm) {
+      inst = MachineInst(MOp::e_mv, inst.rd, inst.rs1);
+      changed = true;
+    }
+    if (inst.op == MOp::e_mv) {
+      // mv a, a
+      if (inst.rd == inst.rs1) {
+        changed = true;
+        continue;
+      }
+      // mv a, b; mv b, a
+      if (!out.empty() && out.back().op == MOp::e_mv &&
+          out.back().rd == inst.rs1 && out.back().rs1 == inst.rd) {
+        changed = true;
+        continue;
+      }
+    }
+    out.push_back(inst);
+  }
+  insts.swap(out);
+  return changed;
+}
+
+#pragma endregion
+
+#pragma region SimplifyBranches
+
+// insts[i]开始的连续label里有没有label
+static bool IsLabelAt(const vector<MachineInst>& insts,
+                      size_t i,
+                      const string& label) {
+  for (; i < insts.size() && insts[i].op == MOp::e_label; ++i) {
+    if (insts[i].label == label)
+      return true;
+  }
+  return false;
+}
+
+// 条件相反的跳转
+static MOp InvertBranch(const MOp& op) {
+  switch (op) {
+    case MOp::e_bnez:
+      return MOp::e_beqz;
+    case MOp::e_beqz:
+      return MOp::e_bnez;
+    case MOp::e_beq:
+      return MOp::e_bne;
+    case MOp::e_bne:
+      return MOp::e_beq;
+    case MOp::e_blt:
+      return MOp::e_bge;
+    case MOp::e_bge:
+      return MOp::e_blt;
+    default:
+      assert(false);
+      return op;
+  }
+}
+
+// 指令的字节数，li、la、call、tail可能展开成两条，按8算
+static int GetInstSize(const MachineInst& inst) {
+  switch (inst.op) {
+    case MOp::e_label:
+      return 0;
+    case MOp::e_li:
+    case MOp::e_la:
+    case MOp::e_call:
+    case MOp::e_tail:
+      return 8;
+    default:
+      return 4;
+  }
+}
+
+// 跳转目标处第一条指令是j时，接着往下找，最多走limit步
+static string GetFinalTarget(const map<string, string>& forwards,
+                             string label,
+                             size_t limit) {
+  for (auto it = forwards.find(label); it != forwards.end() && limit > 0;
+       it = forwards.find(label), --limit) {
+    label = it->second;
+  }
+  return label;
+}
+
+// 跳到一条j的跳转直接跳到最终的目标
+// bnez c, L1; j L2; L1: => beqz c, L2; L1:
+// 条件跳转只在目标够近时改写，远的还是先跳到中转标签再j过去
+// j L; L: => L:
+static bool SimplifyBranches(vector<MachineInst>& insts) {
+  // 每条指令的位置，只会越删越近，估计是保守的
+  vector<int> addrs(insts.size());
+  map<string, int> label_addrs;
+  // 标签后面第一条指令是j时，记录j的目标
+  map<string, string> forwards;
+  int addr = 0;
+  for (size_t i = 0; i < insts.size(); ++i) {
+    addrs[i] = addr;
+    if (insts[i].op == MOp::e_label) {
+      label_addrs[insts[i].label] = addr;
+      size_t k = i + 1;
+      while (k < insts.size() && insts[k].op == MOp::e_label)
+        ++k;
+      if (k < insts.size() && insts[k].op == MOp::e_j)
+        forwards[insts[i].label] = insts[k].label;
+    }
+    addr += GetInstSize(insts[i]);
+  }
+  auto in_range = [&](size_t i, const string& label) {
+    auto it = label_addrs.find(label);
+    return it != label_addrs.end() &&
+           std::abs(it->second - addrs[i]) < BRANCH_RANGE;
+  };
+
+  bool changed = false;
+  vector<MachineInst> out;
+  out.reserve(insts.size());
+  for (size_t i = 0; i < insts.size(); ++i) {
+    auto& inst = insts[i];
+    bool jump = inst.op == MOp::e_j || IsBranch(inst.op);
+    if (jump) {
+      string target = GetFinalTarget(forwards, inst.label, insts.size());
+      if (target != inst.label &&
+          (inst.op == MOp::e_j || in_range(i, target))) {
+        inst.label = target;
+        changed = true;
+      }
+    }
+    if (IsBranch(inst.op) && i + 2 < insts.size() &&
+        insts[i + 1].op == MOp::e_j && IsLabelAt(insts, i + 2, inst.label) &&
+        in_range(i, insts[i + 1].label)) {
+      inst.op = InvertBranch(inst.op);
+      inst.label = insts[i + 1].label;
+      out.push_back(inst);
+      // 跳过j
+      ++i;
+      changed = true;
+      continue;
+    }
+    if (jump && IsLabelAt(insts, i + 1, inst.label)) {
+      changed = true;
+      continue;
+    }
+    out.push_back(inst);
+  }
+  insts.swap(out);
+  return changed;
+}
+
+// 删掉没有跳转用到的标签，和j、ret、tail之后到下一个标签之前的指令
+static bool RemoveDeadCode(vector<MachineInst>& insts) {
+  set<string> targets;
+  for (const auto& inst : insts) {
+    if (inst.op == MOp::e_j || IsBranch(inst.op))
+      targets.insert(inst.label);
+  }
+
+  bool changed = false;
+  bool reachable = true;
+  vector<MachineInst> out;
+  out.reserve(insts.size());
+  for (const auto& inst : insts) {
+    if (inst.op == MOp::e_label) {
+      if (!targets.count(inst.label)) {
+        changed = true;
+        continue;
+      }
+      reachable = true;
+    } else if (!reachable) {
+      changed = true;
+      continue;
+    }
+    out.push_back(inst);
+    if (inst.op == MOp::e_j || inst.op == MOp::e_ret ||
+        inst.op == MOp::e_tail)
+      reachable = false;
+  }
+  insts.swap(out);
+  return changed;
+}
+
+#pragma endregion
+
+void RunPeephole(vector<MachineInst>& insts) {
+  for (int round = 0; round < MAX_ROUNDS; ++round) {
+    bool changed = FoldImm(insts);
+    changed |= FoldOffset(insts);
+    changed |= ForwardMemory(insts);
+    changed |= RemoveMoves(insts);
+    changed |= SimplifyBranches(insts);
+    changed |= RemoveDeadCode(insts);
+    if (!changed)
+      break;
+  }
+}
+
+}  // namespace riscv
@@ -0,0 +1,18 @@
+#pragma once
+
+#include <vector>
+#include "riscv_minst.h"
+
+namespace riscv {
+
+// 对一个函数的指令做窥孔优化，反复执行直到不再变化：
+// 1. li到临时寄存器后马上被使用，改成立即数形式（addi、xori、slti等）
+//    addi算出的地址马上被lw、sw使用，把偏移合进访存指令
+// 2. 把刚存进栈或刚读出来的值直接转发给后面的lw，删掉重复的la
+// 3. 删掉多余的mv
+// 4. 跳到j的跳转直接跳到最终目标，跳过一条j的条件跳转在范围内时改成反向跳转，
+//    删掉跳到下一条的j
+// 5. 删掉没用到的标签和执行不到的指令
+void RunPeephole(std::vector<MachineInst>& insts);
+
+}  // namespace riscv
@@ -45,13 +45,31 @@ void visit_func(const koopa_raw_function_t& func) {
   auto& gen = RiscvGenerator::getInstance();
 
   gen.funcCore.Clear();
+  gen.bbCore.Clear();
   gen.stackCore.Clear();
+  gen.allocCore.Clear();
 
   gen.funcCore.func_name = ParseSymbol(func->name);
+  FindTailCalls(func);
+  FindFusedBranches(func);
+  // 先分配寄存器，溢出的值也要算进栈空间
+  gen.allocCore.Allocate(func);
   CalcMemoryNeeded(func);
   gen.funcCore.WritePrologue();
+  // 局部变量的栈空间在开头统一分配，不依赖基本块的顺序
+  for (size_t i = 0; i < func->bbs.len; ++i) {
+    auto bb = reinterpret_cast<koopa_raw_basic_block_t>(func->bbs.buffer[i]);
+    for (size_t j = 0; j < bb->insts.len; ++j) {
+      auto inst = reinterpret_cast<koopa_raw_value_t>(bb->insts.buffer[j]);
+      if (inst->kind.tag == KOOPA_RVT_ALLOC)
+        visit_inst_alloc(inst);
+    }
+  }
+  WriteParamsMove(func);
 
   visit_slice(func->bbs);
+  // 窥孔优化后写成文本，多线程时也在工作线程里做
+  gen.emitter.FinishFunction();
 }
 
 void visit_basic_block(const koopa_raw_basic_block_t& bb) {
@@ -65,6 +83,9 @@ void visit_basic_block(const koopa_raw_basic_block_t& bb) {
 }
 
 void visit_value(const koopa_raw_value_t& value) {
+  // 尾调用已经返回过了
+  if (RiscvGenerator::getInstance().funcCore.tail_terms.count(value))
+    return;
   //  根据指令类型判断后续需要如何访问
   const auto& kind = value->kind;
   // cout << GetTypeString(value) << ' ';
@@ -91,8 +112,7 @@ void visit_value(const koopa_raw_value_t& value) {
       break;
 
     case KOOPA_RVT_ALLOC:
-      // cout << "  alloc" << endl;
-      visit_inst_alloc(value);
+      // 在函数开头已经分配过了
       break;
 
     case KOOPA_RVT_GLOBAL_ALLOC:
@@ -157,38 +177,22 @@ void visit_inst_int(const koopa_raw_integer_t& inst_int) {
 
 void visit_inst_alloc(const koopa_raw_value_t& value) {
   auto& gen = RiscvGenerator::getInstance();
-  if (value->ty->data.pointer.base->tag == KOOPA_RTT_ARRAY) {
-    ArrInfo info;
-    auto base = value->ty->data.pointer.base;
-    while (base->tag == KOOPA_RTT_ARRAY) {
-      info.shape.insert(info.shape.begin(), base->data.array.len);
-      base = base->data.array.base;
-    }
-    // 保存地址
-    gen.stackCore.stack_used += info.GetSize();
-    // 记录低地址
-    info.stack_addr = gen.stackCore.stack_memory - gen.stackCore.stack_used;
-
-    gen.arrCore.arrinfos.emplace(value, info);
-  } else if (value->ty->data.pointer.base->tag == KOOPA_RTT_POINTER) {
-    // 指针：当成第一维为1的数组，方便计算地址
-    ArrInfo info;
-    info.shape.insert(info.shape.begin(), 1);
-    // 指针指向的指针的解引用，数组或int
-    auto base = value->ty->data.pointer.base->data.pointer.base;
-    while (base->tag == KOOPA_RTT_ARRAY) {
-      info.shape.insert(info.shape.begin(), base->data.array.len);
-      base = base->data.array.base;
-    }
-    info.stack_addr = gen.stackCore.IncreaseStackUsed();
-    gen.arrCore.arrinfos.emplace(value, info);
-    InstResultInfo retinfo(ValueType::e_stack, info.stack_addr);
-    gen.stackCore.InstResult.emplace(value, retinfo);
-  } else if (value->ty->data.pointer.base->tag == KOOPA_RTT_INT32) {
-    InstResultInfo retinfo(ValueType::e_stack,
-                           gen.stackCore.IncreaseStackUsed());
-    gen.stackCore.InstResult.emplace(value, retinfo);
+  auto& stack_core = gen.stackCore;
+  // int、指针、数组都在栈上占一段空间，记录低地址
+  stack_core.stack_used += GetTypeSize(value->ty->data.pointer.base);
+  int addr = stack_core.stack_memory - stack_core.stack_used;
+  stack_core.InstResult.emplace(value,
+                                InstResultInfo(ValueType::e_stack, addr));
+}
+
+// 数组类型的shape
+static ArrInfo GetArrInfo(koopa_raw_type_t ty) {
+  ArrInfo info;
+  while (ty->tag == KOOPA_RTT_ARRAY) {
+    info.shape.push_back(ty->data.array.len);
+    ty = ty->data.array.base;
   }
+  return info;
 }
 
 void visit_inst_globalalloc(const koopa_raw_value_t& inst) {
@@ -210,449 +214,190 @@ void visit_inst_globalalloc(const koopa_raw_value_t& inst) {
     if (inst->ty->data.pointer.base->tag == KOOPA_RTT_INT32) {
       info.value = 4;
     } else {
-      ArrInfo ainfo;
-      auto base = inst->ty->data.pointer.base;
-      while (base->tag == KOOPA_RTT_ARRAY) {
-        ainfo.shape.insert(ainfo.shape.begin(), base->data.array.len);
-        base = base->data.array.base;
-      }
-      info.value = ainfo.GetSize();
-
-      // 将相关信息存进全局数组表
-      // 新建一个arrinfo以消除初始化数据
-      gen.arrCore.arrinfos.emplace(inst, ainfo);
+      info.value = GetArrInfo(inst->ty->data.pointer.base).GetSize();
     }
     gen.globalCore.WriteGlobalVarDecl(ParseSymbol(inst->name), info);
   } else if (inst_init->kind.tag == KOOPA_RVT_AGGREGATE) {
     // 是一个一个数组
-    ArrInfo info;
+    ArrInfo info = GetArrInfo(inst->ty->data.pointer.base);
     // 递归解析
-    SolveArrAggInit(inst_init, info, true);
+    SolveArrAggInit(inst_init, info);
     gen.globalCore.WriteGlobalArrDecl(ParseSymbol(inst->name), info);
-
-    // 将相关信息存进全局数组表
-    // 新建一个arrinfo以消除初始化数据
-    ArrInfo new_info(info.shape);
-    gen.arrCore.arrinfos.emplace(inst, new_info);
   }
 }
 
 void visit_inst_load(const koopa_raw_value_t& inst) {
   auto& gen = RiscvGenerator::getInstance();
-  auto& stack_core = gen.stackCore;
-  auto& arr_core = gen.arrCore;
-
-  if (inst->kind.data.load.src->kind.tag == KOOPA_RVT_GLOBAL_ALLOC) {
-    // 加载全局变量
-    int addr = gen.globalCore.WriteLoadGlobalVar(
-        ParseSymbol(inst->kind.data.load.src->name));
-    // 存储其位置
-    stack_core.InstResult.emplace(inst,
-                                  InstResultInfo(ValueType::e_stack, addr));
-
-    return;
-  }
-
-  else if (inst->kind.data.load.src->kind.tag == KOOPA_RVT_GET_ELEM_PTR ||
-           inst->kind.data.load.src->kind.tag == KOOPA_RVT_GET_PTR) {
-    // 手动读出来，再存到栈里
-    auto& value = inst->kind.data.load.src;
-    auto& os = gen.setting.getOs();
-
-    Reg val = gen.regCore.GetAvailableReg();
-    Reg realaddr = gen.regCore.GetAvailableReg();
-
-    const auto& info = gen.stackCore.InstResult.at(value);
-
-    gen.stackCore.WriteLW(realaddr, info.content.addr);
-    // 将值load进val中
-    lw(os, val, realaddr, 0);
-
-    // 将val存到这个指令的输出中
-    InstResultInfo destinfo(ValueType::e_stack, stack_core.IncreaseStackUsed());
-    InstResultInfo srcinfo(val);
-    stack_core.WriteDataTranfer(srcinfo, destinfo);
-    stack_core.InstResult.emplace(inst, destinfo);
-
-    gen.regCore.ReleaseReg(realaddr);
-    gen.regCore.ReleaseReg(val);
-    return;
-  }
-
-  else if (arr_core.arrinfos.find(inst->kind.data.load.src) !=
-           arr_core.arrinfos.end()) {
-    arr_core.arrinfos.emplace(inst,
-                              arr_core.arrinfos.at(inst->kind.data.load.src));
+  auto& os = gen.emitter;
+  const auto& src = inst->kind.data.load.src;
+  if (IsResultUnused(inst))
     return;
-  }
-
-  else if (stack_core.InstResult.find(inst->kind.data.load.src) !=
-           stack_core.InstResult.end()) {
-    // 从普通的值里load
 
-    stack_core.InstResult[inst] =
-        stack_core.InstResult[inst->kind.data.load.src];
-    return;
+  Reg rd = GetInstResultReg(inst);
+  if (src->kind.tag == KOOPA_RVT_GLOBAL_ALLOC) {
+    // 加载全局变量
+    gen.globalCore.WriteLoadGlobalVar(rd, ParseSymbol(src->name));
+  } else if (src->kind.tag == KOOPA_RVT_ALLOC) {
+    // 加载局部变量
+    gen.stackCore.WriteLW(rd, gen.stackCore.InstResult.at(src).content.addr);
+  } else {
+    // 从指针load
+    Reg addr = GetValueResult(src);
+    lw(os, rd, addr, 0);
+    gen.regCore.ReleaseReg(addr);
   }
-  gen.setting.getOs() << "src type: " << inst->kind.data.load.src->kind.tag
-                      << endl;
-  assert(false);
+  SaveInstResult(inst, rd);
 }
 
 void visit_inst_store(const koopa_raw_value_t& inst) {
   const auto& inst_store = inst->kind.data.store;
   auto& gen = RiscvGenerator::getInstance();
-  auto& stack_core = gen.stackCore;
-
-  InstResultInfo src, dest;
-
-  // 选择源
-  if (inst_store.value->kind.tag == KOOPA_RVT_INTEGER) {
-    // 加载立即数
-    src.ty = ValueType::e_imm;
-    src.content.imm = inst_store.value->kind.data.integer.value;
-
-  } else if (inst_store.value->kind.tag == KOOPA_RVT_FUNC_ARG_REF) {
-    // 加载函数参数
-    int argid = inst_store.value->kind.data.func_arg_ref.index;
-    src = GetParamPosition(argid);
-    if (argid >= 8) {
-      // 到上一个函数的栈帧里找，也就是将地址加上自己分配的空间
-      src.content.addr += stack_core.stack_memory;
-    }
-
-  } else {
-    auto srcResult = stack_core.InstResult.at(inst_store.value);
-    src.ty = srcResult.ty;
-    if (src.ty == ValueType::e_reg) {
-      src.content.reg = srcResult.content.reg;
-    } else {
-      src.content.addr = srcResult.content.addr;
-    }
-  }
+  auto& os = gen.emitter;
+  const auto& dest = inst_store.dest;
 
-  // 选择目标
-  if (inst_store.dest->kind.tag == KOOPA_RVT_GLOBAL_ALLOC) {
+  Reg src = GetValueResult(inst_store.value);
+  if (dest->kind.tag == KOOPA_RVT_GLOBAL_ALLOC) {
     // 存储进全局变量
-    // 截胡
-    gen.globalCore.WriteStoreGlobalVar(ParseSymbol(inst_store.dest->name), src);
-    return;
-  }
-
-  else if (stack_core.InstResult.find(inst_store.dest) !=
-           stack_core.InstResult.end()) {
-    dest = stack_core.InstResult.at(inst_store.dest);
-    if (inst_store.dest->kind.tag == KOOPA_RVT_GET_ELEM_PTR ||
-        inst_store.dest->kind.tag == KOOPA_RVT_GET_PTR) {
-      // 截胡
-      // 先处理src
-      auto& os = gen.setting.getOs();
-      Reg srcreg = gen.regCore.GetAvailableReg();
-      switch (src.ty) {
-        case ValueType::e_imm:
-          li(os, srcreg, src.content.imm);
-          break;
-        case ValueType::e_reg:
-          addi(os, srcreg, src.content.reg, 0);
-          break;
-        case ValueType::e_stack:
-          gen.stackCore.WriteLW(srcreg, src.content.addr);
-          break;
-        default:
-          break;
-      }
-      // srcreg内存储要加载进去的值
-      // 加载
-
-      Reg realaddr = gen.regCore.GetAvailableReg();
-      gen.stackCore.WriteLW(realaddr, dest.content.addr);
-      sw(os, realaddr, srcreg, 0);
-
-      gen.regCore.ReleaseReg(realaddr);
-      gen.regCore.ReleaseReg(srcreg);
-      return;
-    }
+    gen.globalCore.WriteStoreGlobalVar(ParseSymbol(dest->name), src);
+  } else if (dest->kind.tag == KOOPA_RVT_ALLOC) {
+    // 存进局部变量
+    gen.stackCore.WriteSW(src, gen.stackCore.InstResult.at(dest).content.addr);
   } else {
-    // 存进栈里
-    dest.ty = ValueType::e_stack;
-    dest.content.addr = stack_core.IncreaseStackUsed();
-    stack_core.InstResult[inst_store.dest] = dest;
-  }
-
-  // 复杂
-  stack_core.WriteDataTranfer(src, dest);
-
-  // 如果源是寄存器，此处目标只会是栈，将源释放
-  if (src.ty == ValueType::e_reg) {
-    gen.regCore.ReleaseReg(src.content.reg);
+    // 存到指针指向的位置
+    Reg addr = GetValueResult(dest);
+    sw(os, addr, src, 0);
+    gen.regCore.ReleaseReg(addr);
   }
+  gen.regCore.ReleaseReg(src);
 }
 
 void visit_inst_getptr(const koopa_raw_value_t& inst) {
-  const auto& inst_gep = inst->kind.data.get_elem_ptr;
-
-  auto& gen = RiscvGenerator::getInstance();
-  auto& arr_core = gen.arrCore;
-  auto& stack_core = gen.stackCore;
-  auto& reg_core = gen.regCore;
-  auto& os = gen.setting.getOs();
-
-  Reg regsrc = reg_core.GetAvailableReg();
-  Reg addr = reg_core.GetAvailableReg();
-  int sizejump = 0;
-
-  ArrInfo& info = arr_core.arrinfos[inst_gep.src];
-  arr_core.current_arr = info;
-  arr_core.current_dim = 1;
-  sizejump = arr_core.GetCurArrSize();
-
-  // src加载到reg src中
-  Reg tmp = reg_core.GetAvailableReg();
-  assert(info.stack_addr != -1);
-  if (IsImmInBound(info.stack_addr)) {
-    addi(os, tmp, Reg::sp, info.stack_addr);
-  } else {
-    li(os, tmp, info.stack_addr);
-    add(os, tmp, Reg::sp, tmp);
-  }
-  // getptr要多进行一次lw
-  lw(os, regsrc, tmp, 0);
-  reg_core.ReleaseReg(tmp);
-
-  // index加载到addr中
-  if (inst_gep.index->kind.tag == KOOPA_RVT_INTEGER) {
-    li(os, addr, inst_gep.index->kind.data.integer.value);
-  } else {
-    stack_core.WriteDataTranfer(stack_core.InstResult.at(inst_gep.index),
-                                InstResultInfo(addr));
-  }
-
-  // 计算地址偏移
-  Reg tmp1 = reg_core.GetAvailableReg();
-  li(os, tmp1, sizejump);
-  mul(os, addr, addr, tmp1);
-  reg_core.ReleaseReg(tmp1);
-
-  // 计算地址
-  // 最后存在src中
-  add(os, regsrc, regsrc, addr);
-
-  // 存回内存，返回值应该是地址
-  InstResultInfo destinfo(ValueType::e_stack, stack_core.IncreaseStackUsed());
-  InstResultInfo srcinfo(regsrc);
-  // 走reg -> stack
-  stack_core.WriteDataTranfer(srcinfo, destinfo);
-  // 保存指令返回值
-  stack_core.InstResult.emplace(inst, destinfo);
-
-  reg_core.ReleaseReg(addr);
-  reg_core.ReleaseReg(regsrc);
+  const auto& inst_gp = inst->kind.data.get_ptr;
+  // *T -> *T，步长是T的大小
+  int stride = GetTypeSize(inst_gp.src->ty->data.pointer.base);
+  WritePtrOffset(inst, inst_gp.src, inst_gp.index, stride);
 }
 
 void visit_inst_getelemptr(const koopa_raw_value_t& inst) {
   const auto& inst_gep = inst->kind.data.get_elem_ptr;
-
-  auto& gen = RiscvGenerator::getInstance();
-  auto& arr_core = gen.arrCore;
-  auto& stack_core = gen.stackCore;
-  auto& reg_core = gen.regCore;
-  auto& os = gen.setting.getOs();
-
-  Reg src = reg_core.GetAvailableReg();
-  Reg addr = reg_core.GetAvailableReg();
-  int sizejump = 0;
-
-  if (inst_gep.src->kind.tag == KOOPA_RVT_GLOBAL_ALLOC) {
-    ArrInfo& info = arr_core.arrinfos[inst_gep.src];
-    arr_core.current_arr = info;
-    arr_core.current_dim = 1;
-    sizejump = arr_core.GetCurArrSize();
-
-    // src加载到reg src中
-    la(os, src, ParseSymbol(inst_gep.src->name));
-
-    // index加载到addr中
-    if (inst_gep.index->kind.tag == KOOPA_RVT_INTEGER) {
-      li(os, addr, inst_gep.index->kind.data.integer.value);
-    } else {
-      stack_core.WriteDataTranfer(stack_core.InstResult.at(inst_gep.index),
-                                  InstResultInfo(addr));
-    }
-
-  } else if (inst_gep.src->kind.tag == KOOPA_RVT_ALLOC) {
-    ArrInfo& info = arr_core.arrinfos[inst_gep.src];
-    arr_core.current_arr = info;
-    arr_core.current_dim = 1;
-    sizejump = arr_core.GetCurArrSize();
-
-    // src加载到reg src中
-    assert(info.stack_addr != -1);
-    if (IsImmInBound(info.stack_addr)) {
-      addi(os, src, Reg::sp, info.stack_addr);
-    } else {
-      Reg tmp = reg_core.GetAvailableReg();
-      li(os, tmp, info.stack_addr);
-      add(os, src, Reg::sp, tmp);
-      reg_core.ReleaseReg(tmp);
-    }
-
-    // index加载到addr中
-    if (inst_gep.index->kind.tag == KOOPA_RVT_INTEGER) {
-      li(os, addr, inst_gep.index->kind.data.integer.value);
-    } else {
-      stack_core.WriteDataTranfer(stack_core.InstResult.at(inst_gep.index),
-                                  InstResultInfo(addr));
-    }
-
-  } else if (inst_gep.src->kind.tag == KOOPA_RVT_GET_ELEM_PTR ||
-             inst_gep.src->kind.tag == KOOPA_RVT_GET_PTR) {
-    // 直接利用arr_core中的信息
-    // 因为生成koopaIR中，对一个数组的下标解算是连续的gep / gp指令
-
-    // 累加current_dim
-    arr_core.current_dim++;
-    sizejump = arr_core.GetCurArrSize();
-
-    // src: 从栈中获取
-    stack_core.WriteDataTranfer(stack_core.InstResult.at(inst_gep.src),
-                                InstResultInfo(src));
-
-    // index加载到addr中
-    if (inst_gep.index->kind.tag == KOOPA_RVT_INTEGER) {
-      li(os, addr, inst_gep.index->kind.data.integer.value);
-    } else {
-      stack_core.WriteDataTranfer(stack_core.InstResult.at(inst_gep.index),
-                                  InstResultInfo(addr));
-    }
-  }
-
-  // 计算地址偏移
-  Reg tmp1 = reg_core.GetAvailableReg();
-  li(os, tmp1, sizejump);
-  mul(os, addr, addr, tmp1);
-  reg_core.ReleaseReg(tmp1);
-
-  // 计算地址
-  // 最后存在src中
-  add(os, src, src, addr);
-
-  // 存回内存，返回值应该是地址
-  InstResultInfo destinfo(ValueType::e_stack, stack_core.IncreaseStackUsed());
-  InstResultInfo srcinfo(src);
-  // 走reg -> stack
-  stack_core.WriteDataTranfer(srcinfo, destinfo);
-  // 保存指令返回值
-  stack_core.InstResult.emplace(inst, destinfo);
-
-  reg_core.ReleaseReg(addr);
-  reg_core.ReleaseReg(src);
+  // *[T, n] -> *T，步长是T的大小
+  auto arr = inst_gep.src->ty->data.pointer.base;
+  int stride = GetTypeSize(arr->data.array.base);
+  WritePtrOffset(inst, inst_gep.src, inst_gep.index, stride);
 }
 
 void visit_inst_binary(const koopa_raw_value_t& inst) {
   const koopa_raw_binary_t& inst_bina = inst->kind.data.binary;
   auto& gen = RiscvGenerator::getInstance();
-  auto& stack_core = gen.stackCore;
-  Reg r1 = GetValueResult(inst_bina.lhs);
-  Reg r2 = GetValueResult(inst_bina.rhs);
-  RiscvGenerator::getInstance().WriteBinaInst(inst_bina.op, r1, r2);
+  // 和branch合成的比较在branch里生成
+  if (IsResultUnused(inst) || gen.funcCore.fused_cmps.count(inst))
+    return;
+
+  OpType op = inst_bina.op;
+  koopa_raw_value_t lhs = inst_bina.lhs;
+  koopa_raw_value_t rhs = inst_bina.rhs;
+  // 常数放到右边
+  OpType swapped;
+  if (lhs->kind.tag == KOOPA_RVT_INTEGER &&
+      rhs->kind.tag != KOOPA_RVT_INTEGER && GetSwappedOp(op, swapped)) {
+    std::swap(lhs, rhs);
+    op = swapped;
+  }
+  if (rhs->kind.tag == KOOPA_RVT_INTEGER &&
+      RiscvGenerator::CanUseImm(op, rhs->kind.data.integer.value)) {
+    // 用立即数形式，常数不用加载到寄存器
+    Reg r1 = GetValueResult(lhs);
+    Reg rd = GetInstResultReg(inst);
+    gen.WriteBinaImmInst(op, rd, r1, rhs->kind.data.integer.value);
+    gen.regCore.ReleaseReg(r1);
+    SaveInstResult(inst, rd);
+    return;
+  }
 
-  // 把r1的内容存回内存，返回地址?
-  InstResultInfo dest(ValueType::e_stack, stack_core.IncreaseStackUsed()),
-      src(r1);
-  // 走reg -> stack
-  stack_core.WriteDataTranfer(src, dest);
+  Reg r1 = GetValueResult(lhs);
+  Reg r2 = GetValueResult(rhs);
+  Reg rd = GetInstResultReg(inst);
+  gen.WriteBinaInst(op, rd, r1, r2);
 
   gen.regCore.ReleaseReg(r1);
   gen.regCore.ReleaseReg(r2);
-  stack_core.InstResult.emplace(inst, dest);
+  SaveInstResult(inst, rd);
 }
 
 void visit_inst_branch(const koopa_raw_value_t& inst) {
   auto& gen = RiscvGenerator::getInstance();
-  auto& stack_core = gen.stackCore;
   auto& branch = inst->kind.data.branch;
-  Reg cond = GetValueResult(branch.cond);
-  gen.bbCore.WriteBranch(cond, string(branch.true_bb->name),
-                         string(branch.false_bb->name));
-
-  if (stack_core.InstResult.find(branch.cond) != stack_core.InstResult.end() ||
-      branch.cond->kind.tag == KOOPA_RVT_INTEGER) {  // 保存过或是立即数
-    // cond是临时分配的
+  const string true_label(branch.true_bb->name);
+  const string false_label(branch.false_bb->name);
+  int mid;
+  if (gen.funcCore.fused_cmps.count(branch.cond)) {
+    // 比较和跳转合成一条
+    const auto& cmp = branch.cond->kind.data.binary;
+    Reg lhs = GetValueResult(cmp.lhs);
+    Reg rhs = GetValueResult(cmp.rhs);
+    mid = gen.bbCore.WriteCmpBranchToMid(cmp.op, lhs, rhs);
+    gen.regCore.ReleaseReg(lhs);
+    gen.regCore.ReleaseReg(rhs);
+  } else {
+    Reg cond = GetValueResult(branch.cond);
+    if (branch.true_args.len == 0 && branch.false_args.len == 0) {
+      gen.bbCore.WriteBranch(cond, true_label, false_label);
+      gen.regCore.ReleaseReg(cond);
+      return;
+    }
+    mid = gen.bbCore.WriteBranchToMid(cond);
     gen.regCore.ReleaseReg(cond);
   }
+
+  // 两条边分别传参
+  WriteBlockArgsMove(branch.false_bb, branch.false_args);
+  gen.bbCore.WriteJumpInst(false_label);
+  gen.bbCore.WriteMidLabel(mid);
+  WriteBlockArgsMove(branch.true_bb, branch.true_args);
+  gen.bbCore.WriteJumpInst(true_label);
 }
 
 void visit_inst_jump(const koopa_raw_value_t& inst) {
   auto& gen = RiscvGenerator::getInstance();
-  gen.bbCore.WriteJumpInst(inst->kind.data.jump.target->name);
+  auto& jump = inst->kind.data.jump;
+  WriteBlockArgsMove(jump.target, jump.args);
+  gen.bbCore.WriteJumpInst(jump.target->name);
 }
 
 void visit_inst_call(const koopa_raw_value_t& inst) {
   auto& gen = RiscvGenerator::getInstance();
   auto& stack_core = gen.stackCore;
   const auto& inst_call = inst->kind.data.call;
-  int len = inst_call.args.len;
-  set<Reg> reg_used;
 
-  for (int i = 0; i < len; i++) {
+  // 参数同时放到a0-a7和栈上，源可能就是别的参数寄存器
+  vector<pair<InstResultInfo, InstResultInfo>> moves;
+  for (size_t i = 0; i < inst_call.args.len; i++) {
     auto value = reinterpret_cast<koopa_raw_value_t>(inst_call.args.buffer[i]);
-
-    InstResultInfo src;
-
-    // 参数没有保存：立即数传参
-    if (value->kind.tag == KOOPA_RVT_INTEGER) {
-      src = InstResultInfo(ValueType::e_imm, value->kind.data.integer.value);
-    } else if (stack_core.InstResult.find(value) !=
-               stack_core.InstResult.end()) {
-      src = stack_core.InstResult.at(value);
-    } else {
-      // 还是没有存在栈里？
-      assert(false);
-    }
-
-    auto dest = GetParamPosition(i);
-    if (dest.ty == ValueType::e_reg) {
-      gen.regCore.GetReg(dest.content.reg);
-      reg_used.insert(dest.content.reg);
-    }
-    // imm -> reg 或 stack -> reg
-    stack_core.WriteDataTranfer(src, dest);
-  }
-  gen.funcCore.WriteCallInst(ParseSymbol(inst_call.callee->name));
-  for (auto r : reg_used) {
-    gen.regCore.ReleaseReg(r);
+    moves.emplace_back(GetValueLocation(value), GetParamPosition(i));
   }
-
-  // 处理函数返回值，计入栈
-  if (inst_call.callee->ty->data.function.ret->tag == KOOPA_RTT_UNIT) {
-    // 函数返回void
+  stack_core.WriteParallelMove(moves);
+  if (gen.funcCore.tail_calls.count(inst)) {
+    gen.funcCore.WriteTailCall(ParseSymbol(inst_call.callee->name));
     return;
   }
-  gen.regCore.GetReg(Reg::a0);
-  InstResultInfo src(Reg::a0),
-      dest(ValueType::e_stack, stack_core.IncreaseStackUsed());
+  gen.funcCore.WriteCallInst(ParseSymbol(inst_call.callee->name));
 
-  // reg -> stack
-  stack_core.WriteDataTranfer(src, dest);
-  gen.regCore.ReleaseReg(Reg::a0);
-  stack_core.InstResult.emplace(inst, dest);
+  // 处理函数返回值，函数返回void或者没人用就不管
+  if (IsResultUnused(inst))
+    return;
+  stack_core.WriteDataTranfer(InstResultInfo(Reg::a0),
+                              stack_core.InstResult.at(inst));
 }
 
 void visit_inst_ret(const koopa_raw_return_t& inst_ret) {
   auto& gen = RiscvGenerator::getInstance();
-  auto& instResult = gen.stackCore.InstResult;
   InstResultInfo info;
 
   if (inst_ret.value == nullptr) {
     // 返回值为void
     info.ty = ValueType::e_unused;
-  } else if (instResult.find(inst_ret.value) != instResult.end()) {
-    // 返回值在变量中
-    info = instResult[inst_ret.value];
-  } else if (inst_ret.value->kind.tag == KOOPA_RVT_INTEGER) {
-    // 返回值为立即数
-    info.ty = ValueType::e_imm;
-    info.content.imm = inst_ret.value->kind.data.integer.value;
+  } else {
+    info = GetValueLocation(inst_ret.value);
   }
   gen.funcCore.WriteEpilogue(info);
 }
@@ -680,22 +425,10 @@ void CalcMemoryNeeded(const koopa_raw_function_t& func) {
       const koopa_raw_value_t& value =
           reinterpret_cast<koopa_raw_value_t>(bb->insts.buffer[j]);
 
-      // 非void语句
-      // 根据返回值计算
-
-      auto base = value->ty;
       // alloc，计算指向的数据大小
+      // 其他值在寄存器里，溢出的单独算
       if (value->kind.tag == KOOPA_RVT_ALLOC) {
-        base = base->data.pointer.base;
-        int arr_len = 1;
-        // 递归计算数组
-        while (base->tag == KOOPA_RTT_ARRAY) {
-          arr_len *= base->data.array.len;
-          base = base->data.array.base;
-        }
-        alloc_size += 4 * arr_len;
-      } else if (base->tag != KOOPA_RTT_UNIT) {
-        alloc_size += 4;
+        alloc_size += GetTypeSize(value->ty->data.pointer.base);
       }
 
       if (value->kind.tag == KOOPA_RVT_CALL) {
@@ -706,6 +439,11 @@ void CalcMemoryNeeded(const koopa_raw_function_t& func) {
     }
   }
 
+  auto& gen = RiscvGenerator::getInstance();
+  // 溢出的值和要保存的callee-saved寄存器
+  alloc_size += 4 * gen.allocCore.GetSpillCount();
+  alloc_size += 4 * gen.allocCore.GetUsedCalleeSaved().size();
+
   if (has_call_inst) {
     alloc_size += 4;
   }
@@ -718,36 +456,292 @@ void CalcMemoryNeeded(const koopa_raw_function_t& func) {
   std::cerr << "alloc size: " << alloc_size << std::endl;
   alloc_size = (alloc_size + 15) / 16 * 16;
 
-  auto& gen = RiscvGenerator::getInstance();
   gen.stackCore.SetStackMem(alloc_size);
   gen.funcCore.is_leaf_func = has_call_inst;
   return;
 }
 
+void FindTailCalls(const koopa_raw_function_t& func) {
+  auto& func_core = RiscvGenerator::getInstance().funcCore;
+  for (size_t i = 0; i < func->bbs.len; ++i) {
+    auto bb = reinterpret_cast<koopa_raw_basic_block_t>(func->bbs.buffer[i]);
+    for (size_t j = 0; j < bb->insts.len; ++j) {
+      auto inst = reinterpret_cast<koopa_raw_value_t>(bb->insts.buffer[j]);
+      if (inst->kind.tag == KOOPA_RVT_ALLOC)
+        return;
+    }
+  }
+
+  for (size_t i = 0; i < func->bbs.len; ++i) {
+    auto bb = reinterpret_cast<koopa_raw_basic_block_t>(func->bbs.buffer[i]);
+    const auto& insts = bb->insts;
+    if (insts.len < 2)
+      continue;
+    auto call =
+        reinterpret_cast<koopa_raw_value_t>(insts.buffer[insts.len - 2]);
+    auto term =
+        reinterpret_cast<koopa_raw_value_t>(insts.buffer[insts.len - 1]);
+    if (call->kind.tag != KOOPA_RVT_CALL ||
+        call->kind.data.call.args.len > 8 || !opt::IsTailReturn(call, term))
+      continue;
+    func_core.tail_calls.insert(call);
+    func_core.tail_terms.insert(term);
+  }
+}
+
+void FindFusedBranches(const koopa_raw_function_t& func) {
+  auto& func_core = RiscvGenerator::getInstance().funcCore;
+  vector<koopa_raw_value_t> candidates;
+  for (size_t i = 0; i < func->bbs.len; ++i) {
+    auto bb = reinterpret_cast<koopa_raw_basic_block_t>(func->bbs.buffer[i]);
+    const auto& insts = bb->insts;
+    if (insts.len < 2)
+      continue;
+    auto cmp = reinterpret_cast<koopa_raw_value_t>(insts.buffer[insts.len - 2]);
+    auto term =
+        reinterpret_cast<koopa_raw_value_t>(insts.buffer[insts.len - 1]);
+    if (term->kind.tag != KOOPA_RVT_BRANCH ||
+        term->kind.data.branch.cond != cmp ||
+        cmp->kind.tag != KOOPA_RVT_BINARY)
+      continue;
+    switch (cmp->kind.data.binary.op) {
+      case KOOPA_RBO_NOT_EQ:
+      case KOOPA_RBO_EQ:
+      case KOOPA_RBO_GT:
+      case KOOPA_RBO_LT:
+      case KOOPA_RBO_GE:
+      case KOOPA_RBO_LE:
+        candidates.push_back(cmp);
+        break;
+      default:
+        break;
+    }
+  }
+  if (candidates.empty())
+    return;
+
+  // 只能被当作条件用一次，不能再传给基本块参数或者别的指令
+  map<koopa_raw_value_t, int> use_count;
+  vector<koopa_raw_value_t> operands;
+  for (size_t i = 0; i < func->bbs.len; ++i) {
+    auto bb = reinterpret_cast<koopa_raw_basic_block_t>(func->bbs.buffer[i]);
+    for (size_t j = 0; j < bb->insts.len; ++j) {
+      operands.clear();
+      GetOperands(reinterpret_cast<koopa_raw_value_t>(bb->insts.buffer[j]),
+                  operands);
+      for (const auto& op : operands) {
+        ++use_count[op];
+      }
+    }
+  }
+  for (const auto& cmp : candidates) {
+    if (use_count[cmp] == 1)
+      func_core.fused_cmps.insert(cmp);
+  }
+}
+
 const Reg GetValueResult(const koopa_raw_value_t& value) {
   auto& gen = RiscvGenerator::getInstance();
   auto& stack_core = gen.stackCore;
+  auto& os = gen.emitter;
   if (value->kind.tag == KOOPA_RVT_INTEGER) {
-    // 处理常数
+    // 处理常数，0直接用x0
+    if (value->kind.data.integer.value == 0)
+      return zeroReg();
     Reg rs = gen.regCore.GetAvailableReg();
     stack_core.WriteLI(rs, value->kind.data.integer.value);
     return rs;
   }
+  if (value->kind.tag == KOOPA_RVT_UNDEF) {
+    // 未定义的值随便取，用0
+    return zeroReg();
+  }
+  if (value->kind.tag == KOOPA_RVT_GLOBAL_ALLOC) {
+    // 全局变量的地址
+    Reg rs = gen.regCore.GetAvailableReg();
+    la(os, rs, ParseSymbol(value->name));
+    return rs;
+  }
   assert(stack_core.InstResult.find(value) != stack_core.InstResult.end());
 
-  InstResultInfo info;
-  info = stack_core.InstResult.at(value);
+  const InstResultInfo& info = stack_core.InstResult.at(value);
+  if (value->kind.tag == KOOPA_RVT_ALLOC) {
+    // 局部变量的地址
+    Reg rs = gen.regCore.GetAvailableReg();
+    WriteAddImm(rs, Reg::sp, info.content.addr);
+    return rs;
+  }
   if (info.ty == ValueType::e_reg) {
-    cout << "will this actually run?" << endl;
-    // 还没做分配策略的
+    // 分配到了寄存器
     return info.content.reg;
   } else if (info.ty == ValueType::e_stack) {
-    // 先读出
+    // 溢出了，先读出
     Reg rs = gen.regCore.GetAvailableReg();
     stack_core.WriteLW(rs, info.content.addr);
     return rs;
   }
   assert(false);
+  return Reg::NONE;
+}
+
+const InstResultInfo GetValueLocation(const koopa_raw_value_t& value) {
+  if (value->kind.tag == KOOPA_RVT_INTEGER) {
+    return InstResultInfo(ValueType::e_imm, value->kind.data.integer.value);
+  }
+  if (value->kind.tag == KOOPA_RVT_UNDEF) {
+    return InstResultInfo(ValueType::e_imm, 0);
+  }
+  // 地址不会直接当作参数或返回值
+  assert(value->kind.tag != KOOPA_RVT_ALLOC &&
+         value->kind.tag != KOOPA_RVT_GLOBAL_ALLOC);
+  return RiscvGenerator::getInstance().stackCore.InstResult.at(value);
+}
+
+bool IsResultUnused(const koopa_raw_value_t& inst) {
+  const auto& inst_result = RiscvGenerator::getInstance().stackCore.InstResult;
+  return inst_result.find(inst) == inst_result.end();
+}
+
+const Reg GetInstResultReg(const koopa_raw_value_t& inst) {
+  auto& gen = RiscvGenerator::getInstance();
+  const auto& info = gen.stackCore.InstResult.at(inst);
+  if (info.ty == ValueType::e_reg) {
+    return info.content.reg;
+  }
+  // 溢出的值先算在临时寄存器里
+  return gen.regCore.GetAvailableReg();
+}
+
+void SaveInstResult(const koopa_raw_value_t& inst, const Reg& rd) {
+  auto& gen = RiscvGenerator::getInstance();
+  const auto& info = gen.stackCore.InstResult.at(inst);
+  if (info.ty == ValueType::e_stack) {
+    gen.stackCore.WriteSW(rd, info.content.addr);
+  }
+  gen.regCore.ReleaseReg(rd);
+}
+
+bool GetSwappedOp(const OpType& op, OpType& swapped) {
+  switch (op) {
+    case koopa_raw_binary_op::KOOPA_RBO_NOT_EQ:
+    case koopa_raw_binary_op::KOOPA_RBO_EQ:
+    case koopa_raw_binary_op::KOOPA_RBO_ADD:
+    case koopa_raw_binary_op::KOOPA_RBO_MUL:
+    case koopa_raw_binary_op::KOOPA_RBO_AND:
+    case koopa_raw_binary_op::KOOPA_RBO_OR:
+    case koopa_raw_binary_op::KOOPA_RBO_XOR:
+      swapped = op;
+      return true;
+    case koopa_raw_binary_op::KOOPA_RBO_GT:
+      swapped = koopa_raw_binary_op::KOOPA_RBO_LT;
+      return true;
+    case koopa_raw_binary_op::KOOPA_RBO_LT:
+      swapped = koopa_raw_binary_op::KOOPA_RBO_GT;
+      return true;
+    case koopa_raw_binary_op::KOOPA_RBO_GE:
+      swapped = koopa_raw_binary_op::KOOPA_RBO_LE;
+      return true;
+    case koopa_raw_binary_op::KOOPA_RBO_LE:
+      swapped = koopa_raw_binary_op::KOOPA_RBO_GE;
+      return true;
+    default:
+      return false;
+  }
+}
+
+void WriteAddImm(const Reg& rd, const Reg& rs, int imm) {
+  auto& gen = RiscvGenerator::getInstance();
+  auto& os = gen.emitter;
+  if (imm == 0) {
+    if (rd != rs)
+      mv(os, rd, rs);
+  } else if (IsImmInBound(imm)) {
+    addi(os, rd, rs, imm);
+  } else if (rd != rs) {
+    // 常数先放在rd里，不再占用临时寄存器
+    li(os, rd, imm);
+    add(os, rd, rs, rd);
+  } else {
+    Reg tmp = gen.regCore.GetAvailableReg();
+    li(os, tmp, imm);
+    add(os, rd, rs, tmp);
+    gen.regCore.ReleaseReg(tmp);
+  }
+}
+
+void WritePtrOffset(const koopa_raw_value_t& inst,
+                    const koopa_raw_value_t& src,
+                    const koopa_raw_value_t& index,
+                    const int& stride) {
+  auto& gen = RiscvGenerator::getInstance();
+  auto& os = gen.emitter;
+  auto& reg_core = gen.regCore;
+  if (IsResultUnused(inst))
+    return;
+
+  Reg rd = GetInstResultReg(inst);
+  if (index->kind.tag == KOOPA_RVT_INTEGER) {
+    // 偏移在编译期就能算出来
+    int offset = index->kind.data.integer.value * stride;
+    if (src->kind.tag == KOOPA_RVT_ALLOC) {
+      // 局部数组，直接从sp算
+      int addr = gen.stackCore.InstResult.at(src).content.addr;
+      WriteAddImm(rd, Reg::sp, addr + offset);
+    } else {
+      Reg base = GetValueResult(src);
+      WriteAddImm(rd, base, offset);
+      reg_core.ReleaseReg(base);
+    }
+  } else {
+    // 偏移 = index * stride
+    Reg idx = GetValueResult(index);
+    Reg tmp = reg_core.GetAvailableReg();
+    if (RiscvGenerator::CanUseImm(KOOPA_RBO_MUL, stride)) {
+      // 步长是2的幂，用移位
+      gen.WriteBinaImmInst(KOOPA_RBO_MUL, tmp, idx, stride);
+    } else {
+      li(os, tmp, stride);
+      mul(os, tmp, idx, tmp);
+    }
+    reg_core.ReleaseReg(idx);
+
+    Reg base = GetValueResult(src);
+    add(os, rd, base, tmp);
+    reg_core.ReleaseReg(base);
+    reg_core.ReleaseReg(tmp);
+  }
+  SaveInstResult(inst, rd);
+}
+
+void WriteParamsMove(const koopa_raw_function_t& func) {
+  auto& stack_core = RiscvGenerator::getInstance().stackCore;
+  vector<pair<InstResultInfo, InstResultInfo>> moves;
+  for (size_t i = 0; i < func->params.len; ++i) {
+    auto param = reinterpret_cast<koopa_raw_value_t>(func->params.buffer[i]);
+    if (IsResultUnused(param))
+      continue;
+    InstResultInfo src = GetParamPosition(i);
+    if (src.ty == ValueType::e_stack) {
+      // 到上一个函数的栈帧里找，也就是将地址加上自己分配的空间
+      src.content.addr += stack_core.stack_memory;
+    }
+    moves.emplace_back(src, stack_core.InstResult.at(param));
+  }
+  stack_core.WriteParallelMove(moves);
+}
+
+void WriteBlockArgsMove(const koopa_raw_basic_block_t& target,
+                        const koopa_raw_slice_t& args) {
+  auto& stack_core = RiscvGenerator::getInstance().stackCore;
+  vector<pair<InstResultInfo, InstResultInfo>> moves;
+  for (size_t i = 0; i < args.len; ++i) {
+    auto param = reinterpret_cast<koopa_raw_value_t>(target->params.buffer[i]);
+    if (IsResultUnused(param))
+      continue;
+    auto arg = reinterpret_cast<koopa_raw_value_t>(args.buffer[i]);
+    moves.emplace_back(GetValueLocation(arg), stack_core.InstResult.at(param));
+  }
+  stack_core.WriteParallelMove(moves);
 }
 
 const InstResultInfo GetParamPosition(const int& param_cnt) {
@@ -773,24 +767,16 @@ const InstResultInfo GetParamPosition(const int& param_cnt) {
   }
 }
 
-void SolveArrAggInit(const koopa_raw_value_t& value,
-                     ArrInfo& info,
-                     const bool& should_push_dim) {
+void SolveArrAggInit(const koopa_raw_value_t& value, ArrInfo& info) {
   if (value->kind.tag == KOOPA_RVT_INTEGER) {
     info.PushNum(value->kind.data.integer.value);
+  } else if (value->kind.tag == KOOPA_RVT_ZERO_INIT) {
+    info.PushZeros(GetTypeSize(value->ty) / 4);
   } else if (value->kind.tag == KOOPA_RVT_AGGREGATE) {
-    int len = value->kind.data.aggregate.elems.len;
-    if (should_push_dim) {
-      info.shape.insert(info.shape.begin(), len);
-    }
-
-    // 只有每个维度的第一个才改变维度
-    bool spd = true;
-    for (int i = 0; i < len; i++) {
-      auto val = reinterpret_cast<koopa_raw_value_t>(
-          value->kind.data.aggregate.elems.buffer[i]);
-      SolveArrAggInit(val, info, spd && should_push_dim);
-      spd = false;
+    const auto& elems = value->kind.data.aggregate.elems;
+    for (size_t i = 0; i < elems.len; i++) {
+      SolveArrAggInit(reinterpret_cast<koopa_raw_value_t>(elems.buffer[i]),
+                      info);
     }
   }
 }
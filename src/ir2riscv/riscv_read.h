@@ -7,6 +7,7 @@
 #include <queue>
 #include <sstream>
 #include <string>
+#include "ir2ir/opt_util.h"
 #include "koopa.h"
 #include "riscv_gen.h"
 #include "riscv_util.h"
@@ -71,15 +72,54 @@ void visit_inst_ret(const koopa_raw_return_t& inst_ret);
 // 顺序遍历，计算函数分配所需的内存
 void CalcMemoryNeeded(const koopa_raw_function_t& func);
 
+// 找出可以复用栈帧的尾调用：调用后直接返回结果，参数都能放进寄存器
+// 有局部变量时地址可能传给被调用者，不做
+void FindTailCalls(const koopa_raw_function_t& func);
+
+// 找出可以和branch合成一条指令的比较：
+// 是基本块倒数第二条指令，结果只被最后的branch当作条件使用
+void FindFusedBranches(const koopa_raw_function_t& func);
+
 // 获取某条指令返回值的放置位置，如果在栈上，则将其拉回寄存器内
+// 常数、地址和溢出的值会占用临时寄存器，用完需要ReleaseReg
 const Reg GetValueResult(const koopa_raw_value_t& value);
 
+// 获取值的位置：立即数、寄存器或栈，不生成指令
+const InstResultInfo GetValueLocation(const koopa_raw_value_t& value);
+
+// 指令的结果没有分配位置，即没有被使用
+bool IsResultUnused(const koopa_raw_value_t& inst);
+
+// 获取存放指令结果的寄存器，溢出的值返回临时寄存器
+const Reg GetInstResultReg(const koopa_raw_value_t& inst);
+
+// 把rd中的结果存到指令结果的位置，并释放临时寄存器
+void SaveInstResult(const koopa_raw_value_t& inst, const Reg& rd);
+
+// 交换左右操作数后等价的运算符，不能交换时返回false
+bool GetSwappedOp(const OpType& op, OpType& swapped);
+
+// rd = rs + imm，imm超出范围时借用临时寄存器
+void WriteAddImm(const Reg& rd, const Reg& rs, int imm);
+
+// getptr和getelemptr：inst = src + index * stride
+void WritePtrOffset(const koopa_raw_value_t& inst,
+                    const koopa_raw_value_t& src,
+                    const koopa_raw_value_t& index,
+                    const int& stride);
+
+// 在函数开头把参数从a0-a7和栈上移动到分配的位置
+void WriteParamsMove(const koopa_raw_function_t& func);
+
+// 跳转前把实参并行移动到目标基本块参数的位置
+void WriteBlockArgsMove(const koopa_raw_basic_block_t& target,
+                        const koopa_raw_slice_t& args);
+
 // 给定参数号，输出应该存储这个参数的位置
 const InstResultInfo GetParamPosition(const int& param_cnt);
 
 // 解析聚合初始化的全局数组，将初始化值加入info
-void SolveArrAggInit(const koopa_raw_value_t& value,
-                     ArrInfo& info,
-                     const bool& should_push_dim);
+// 聚合里的zeroinit整段推入0
+void SolveArrAggInit(const koopa_raw_value_t& value, ArrInfo& info);
 
 }  // namespace riscv
\ No newline at end of file
@@ -0,0 +1,960 @@
+#include <algorithm>
+#include <cmath>
+#include "riscv_gen.h"
+
+namespace riscv {
+
+// 参与分配的寄存器，t0-t2留给RegisterModule做临时寄存器
+static const Reg caller_saved_regs[] = {
+    Reg::t3, Reg::t4, Reg::t5, Reg::t6, Reg::a0, Reg::a1,
+    Reg::a2, Reg::a3, Reg::a4, Reg::a5, Reg::a6, Reg::a7};
+static const Reg callee_saved_regs[] = {
+    Reg::s1, Reg::s2, Reg::s3, Reg::s4,  Reg::s5, Reg::s6,
+    Reg::s7, Reg::s8, Reg::s9, Reg::s10, Reg::s11};
+static const Reg param_regs[] = {Reg::a0, Reg::a1, Reg::a2, Reg::a3,
+                                 Reg::a4, Reg::a5, Reg::a6, Reg::a7};
+
+// 有结果、需要放在寄存器里的值
+// alloc和global alloc是地址，由栈和la处理
+// 和branch合成的比较没有结果
+static bool IsAllocatable(const koopa_raw_value_t& value) {
+  if (value->ty->tag == KOOPA_RTT_UNIT)
+    return false;
+  if (RiscvGenerator::getInstance().funcCore.fused_cmps.count(value))
+    return false;
+  switch (value->kind.tag) {
+    case KOOPA_RVT_FUNC_ARG_REF:
+    case KOOPA_RVT_BLOCK_ARG_REF:
+    case KOOPA_RVT_LOAD:
+    case KOOPA_RVT_GET_PTR:
+    case KOOPA_RVT_GET_ELEM_PTR:
+    case KOOPA_RVT_BINARY:
+    case KOOPA_RVT_CALL:
+      return true;
+    default:
+      return false;
+  }
+}
+
+// 基本块的后继，由最后一条指令决定
+static void GetSuccessors(const koopa_raw_basic_block_t& bb,
+                          vector<koopa_raw_basic_block_t>& succs) {
+  if (bb->insts.len == 0)
+    return;
+  auto last =
+      reinterpret_cast<koopa_raw_value_t>(bb->insts.buffer[bb->insts.len - 1]);
+  if (last->kind.tag == KOOPA_RVT_BRANCH) {
+    succs.push_back(last->kind.data.branch.true_bb);
+    succs.push_back(last->kind.data.branch.false_bb);
+  } else if (last->kind.tag == KOOPA_RVT_JUMP) {
+    succs.push_back(last->kind.data.jump.target);
+  }
+}
+
+RegAllocModule::RegAllocModule()
+    : strategy(RegAllocStrategy::e_linear_scan) {}
+
+void RegAllocModule::Allocate(const koopa_raw_function_t& func) {
+  NumberValues(func);
+  CalcLiveness();
+  if (strategy == RegAllocStrategy::e_graph_coloring) {
+    GraphColoring();
+    return;
+  }
+  BuildIntervals();
+  LinearScan();
+}
+
+const int RegAllocModule::GetSpillCount() const {
+  return spilled.size();
+}
+
+const set<Reg>& RegAllocModule::GetUsedCalleeSaved() const {
+  return used_callee_saved;
+}
+
+void RegAllocModule::AssignSpillSlots() {
+  auto& stack_core = RiscvGenerator::getInstance().stackCore;
+  for (const auto& value : spilled) {
+    int addr = stack_core.IncreaseStackUsed();
+    stack_core.InstResult[value] = InstResultInfo(ValueType::e_stack, addr);
+  }
+}
+
+void RegAllocModule::Clear() {
+  values.clear();
+  value_ids.clear();
+  def_pos.clear();
+  bbs.clear();
+  bb_ids.clear();
+  bb_start.clear();
+  bb_end.clear();
+  bb_succs.clear();
+  live_in.clear();
+  live_out.clear();
+  call_pos.clear();
+  intervals.clear();
+  hints.clear();
+  spilled.clear();
+  used_callee_saved.clear();
+
+  loop_depth.clear();
+  adj_set.clear();
+  adj_list.clear();
+  degree.clear();
+  node_state.clear();
+  alias.clear();
+  color.clear();
+  spill_cost.clear();
+  moves.clear();
+  move_state.clear();
+  move_list.clear();
+  simplify_worklist.clear();
+  freeze_worklist.clear();
+  spill_worklist.clear();
+  worklist_moves.clear();
+  select_stack.clear();
+}
+
+#pragma region liveness
+
+void RegAllocModule::NumberValues(const koopa_raw_function_t& func) {
+  // 参数在位置0定义，每个基本块开头占一个位置给块参数，每条指令占一个位置
+  int pos = 0;
+  for (size_t i = 0; i < func->params.len; ++i) {
+    auto param = reinterpret_cast<koopa_raw_value_t>(func->params.buffer[i]);
+    value_ids[param] = values.size();
+    values.push_back(param);
+    def_pos.push_back(pos);
+    if (i < 8)
+      hints[value_ids[param]] = param_regs[i];
+  }
+
+  for (size_t i = 0; i < func->bbs.len; ++i) {
+    auto bb = reinterpret_cast<koopa_raw_basic_block_t>(func->bbs.buffer[i]);
+    bb_ids[bb] = bbs.size();
+    bbs.push_back(bb);
+    bb_start.push_back(++pos);
+    for (size_t j = 0; j < bb->params.len; ++j) {
+      auto param = reinterpret_cast<koopa_raw_value_t>(bb->params.buffer[j]);
+      value_ids[param] = values.size();
+      values.push_back(param);
+      def_pos.push_back(pos);
+    }
+    for (size_t j = 0; j < bb->insts.len; ++j) {
+      auto inst = reinterpret_cast<koopa_raw_value_t>(bb->insts.buffer[j]);
+      ++pos;
+      if (inst->kind.tag == KOOPA_RVT_CALL) {
+        call_pos.push_back(pos);
+      }
+      if (IsAllocatable(inst)) {
+        value_ids[inst] = values.size();
+        values.push_back(inst);
+        def_pos.push_back(pos);
+        // 返回值在a0里
+        if (inst->kind.tag == KOOPA_RVT_CALL)
+          hints[value_ids[inst]] = Reg::a0;
+      }
+    }
+    bb_end.push_back(pos);
+  }
+}
+
+void RegAllocModule::CalcLiveness() {
+  int n = bbs.size();
+  // 每个基本块内先定义后使用的值不算use
+  // SSA中块内的定义一定在使用之前，看定义位置是否在块内即可
+  vector<vector<int>> uses(n), defs(n);
+  bb_succs.assign(n, {});
+  vector<koopa_raw_value_t> operands;
+  vector<koopa_raw_basic_block_t> succ_bbs;
+  for (int b = 0; b < n; ++b) {
+    auto bb = bbs[b];
+    for (size_t j = 0; j < bb->params.len; ++j) {
+      auto param = reinterpret_cast<koopa_raw_value_t>(bb->params.buffer[j]);
+      defs[b].push_back(value_ids.at(param));
+    }
+    for (size_t j = 0; j < bb->insts.len; ++j) {
+      auto inst = reinterpret_cast<koopa_raw_value_t>(bb->insts.buffer[j]);
+      operands.clear();
+      GetOperands(inst, operands);
+      for (const auto& op : operands) {
+        auto it = value_ids.find(op);
+        if (it == value_ids.end())
+          continue;
+        int pos = def_pos[it->second];
+        if (pos < bb_start[b] || pos > bb_end[b])
+          uses[b].push_back(it->second);
+      }
+      if (IsAllocatable(inst))
+        defs[b].push_back(value_ids.at(inst));
+    }
+    std::sort(uses[b].begin(), uses[b].end());
+    uses[b].erase(std::unique(uses[b].begin(), uses[b].end()), uses[b].end());
+    std::sort(defs[b].begin(), defs[b].end());
+
+    succ_bbs.clear();
+    GetSuccessors(bb, succ_bbs);
+    for (const auto& succ : succ_bbs) {
+      bb_succs[b].push_back(bb_ids.at(succ));
+    }
+  }
+
+  // 迭代到不动点，倒序访问收敛更快
+  // live_out = U live_in[succ]
+  // live_in = use U (live_out - def)
+  live_in.assign(n, {});
+  live_out.assign(n, {});
+  bool changed = true;
+  vector<int> tmp, out;
+  while (changed) {
+    changed = false;
+    for (int b = n - 1; b >= 0; --b) {
+      out.clear();
+      for (int s : bb_succs[b]) {
+        tmp.clear();
+        std::set_union(out.begin(), out.end(), live_in[s].begin(),
+                       live_in[s].end(), std::back_inserter(tmp));
+        out.swap(tmp);
+      }
+      tmp.clear();
+      std::set_difference(out.begin(), out.end(), defs[b].begin(),
+                          defs[b].end(), std::back_inserter(tmp));
+      vector<int> in;
+      std::set_union(uses[b].begin(), uses[b].end(), tmp.begin(), tmp.end(),
+                     std::back_inserter(in));
+      if (in != live_in[b] || out != live_out[b]) {
+        changed = true;
+        live_in[b].swap(in);
+        live_out[b].swap(out);
+      }
+    }
+  }
+}
+
+void RegAllocModule::BuildIntervals() {
+  int n = values.size();
+  vector<int> start(def_pos), end(n, -1);
+
+  // 每个值的区间覆盖：定义、所有使用、所有活跃的基本块
+  vector<koopa_raw_value_t> operands;
+  for (size_t b = 0; b < bbs.size(); ++b) {
+    int pos = bb_start[b];
+    auto bb = bbs[b];
+    for (size_t j = 0; j < bb->insts.len; ++j) {
+      auto inst = reinterpret_cast<koopa_raw_value_t>(bb->insts.buffer[j]);
+      ++pos;
+      operands.clear();
+      GetOperands(inst, operands);
+      for (size_t k = 0; k < operands.size(); ++k) {
+        auto it = value_ids.find(operands[k]);
+        if (it == value_ids.end())
+          continue;
+        end[it->second] = std::max(end[it->second], pos);
+        // 传参的值最好就放在参数寄存器里
+        if (inst->kind.tag == KOOPA_RVT_CALL && k < 8 &&
+            hints.find(it->second) == hints.end())
+          hints[it->second] = param_regs[k];
+        if (inst->kind.tag == KOOPA_RVT_RETURN &&
+            hints.find(it->second) == hints.end())
+          hints[it->second] = Reg::a0;
+      }
+    }
+    for (int id : live_in[b]) {
+      start[id] = std::min(start[id], bb_start[b]);
+    }
+    for (int id : live_out[b]) {
+      end[id] = std::max(end[id], bb_end[b]);
+    }
+  }
+
+  for (int id = 0; id < n; ++id) {
+    // 没人用的值不分配，访问时直接跳过
+    if (end[id] < 0)
+      continue;
+    LiveInterval interval;
+    interval.id = id;
+    interval.start = start[id];
+    interval.end = end[id];
+    // (start, end)之间有call，caller-saved寄存器会被破坏
+    auto it = std::upper_bound(call_pos.begin(), call_pos.end(), start[id]);
+    interval.cross_call = it != call_pos.end() && *it < end[id];
+    intervals.push_back(interval);
+  }
+}
+
+#pragma endregion
+
+#pragma region linear scan
+
+void RegAllocModule::AssignReg(const int& id, const Reg& reg) {
+  auto& stack_core = RiscvGenerator::getInstance().stackCore;
+  stack_core.InstResult[values[id]] = InstResultInfo(reg);
+  if (IsCalleeSaved(reg))
+    used_callee_saved.insert(reg);
+}
+
+void RegAllocModule::LinearScan() {
+  std::sort(intervals.begin(), intervals.end(),
+            [](const LiveInterval& a, const LiveInterval& b) {
+              return a.start != b.start ? a.start < b.start : a.id < b.id;
+            });
+
+  set<Reg> free_caller(std::begin(caller_saved_regs),
+                       std::end(caller_saved_regs));
+  set<Reg> free_callee(std::begin(callee_saved_regs),
+                       std::end(callee_saved_regs));
+  // 正在占用寄存器的区间和寄存器
+  vector<pair<LiveInterval, Reg>> active;
+
+  auto release = [&](const Reg& reg) {
+    if (IsCalleeSaved(reg))
+      free_callee.insert(reg);
+    else
+      free_caller.insert(reg);
+  };
+
+  for (const auto& cur : intervals) {
+    // 回收已经结束的区间，结束位置等于cur.start的还要被cur的指令读
+    for (size_t i = 0; i < active.size();) {
+      if (active[i].first.end < cur.start) {
+        release(active[i].second);
+        active.erase(active.begin() + i);
+      } else {
+        i++;
+      }
+    }
+
+    // 优先用hint，其次不跨调用的用caller-saved，最后callee-saved
+    Reg reg = Reg::NONE;
+    auto hint = hints.find(cur.id);
+    if (!cur.cross_call && hint != hints.end() &&
+        free_caller.count(hint->second)) {
+      reg = hint->second;
+      free_caller.erase(reg);
+    } else if (!cur.cross_call && !free_caller.empty()) {
+      reg = *free_caller.begin();
+      free_caller.erase(reg);
+    } else if (!free_callee.empty()) {
+      reg = *free_callee.begin();
+      free_callee.erase(reg);
+    }
+
+    if (reg != Reg::NONE) {
+      AssignReg(cur.id, reg);
+      active.emplace_back(cur, reg);
+      continue;
+    }
+
+    // 没有空闲寄存器，溢出结束最晚的那个
+    int victim = -1;
+    for (size_t i = 0; i < active.size(); ++i) {
+      if (cur.cross_call && !IsCalleeSaved(active[i].second))
+        continue;
+      if (victim == -1 || active[i].first.end > active[victim].first.end)
+        victim = i;
+    }
+    if (victim != -1 && active[victim].first.end > cur.end) {
+      reg = active[victim].second;
+      spilled.push_back(values[active[victim].first.id]);
+      AssignReg(cur.id, reg);
+      active[victim] = std::make_pair(cur, reg);
+    } else {
+      spilled.push_back(values[cur.id]);
+    }
+  }
+}
+
+#pragma endregion
+
+#pragma region graph coloring
+
+// 可用的颜色数，颜色i对应color_regs[i]，caller-saved在前，优先使用
+static const int K = 23;
+static const Reg color_regs[K] = {
+    Reg::t3, Reg::t4, Reg::t5, Reg::t6, Reg::a0,  Reg::a1,
+    Reg::a2, Reg::a3, Reg::a4, Reg::a5, Reg::a6,  Reg::a7,
+    Reg::s1, Reg::s2, Reg::s3, Reg::s4, Reg::s5,  Reg::s6,
+    Reg::s7, Reg::s8, Reg::s9, Reg::s10, Reg::s11};
+// 前12个颜色是caller-saved，调用时会被破坏
+static const int caller_saved_count = 12;
+// 预着色节点的度数视为无穷大
+static const int infinite_degree = 0x3f3f3f3f;
+
+static int GetColor(const Reg& reg) {
+  for (int i = 0; i < K; ++i) {
+    if (color_regs[i] == reg)
+      return i;
+  }
+  assert(false);
+  return -1;
+}
+
+void RegAllocModule::GraphColoring() {
+  CalcLoopDepth();
+  BuildGraph();
+  MakeWorklist();
+  while (true) {
+    if (!simplify_worklist.empty()) {
+      Simplify();
+    } else if (!worklist_moves.empty()) {
+      Coalesce();
+    } else if (!freeze_worklist.empty()) {
+      Freeze();
+    } else if (!spill_worklist.empty()) {
+      SelectSpill();
+    } else {
+      break;
+    }
+  }
+  // 溢出的值在栈上，使用时借用t0-t2，不需要重写程序再来一轮
+  AssignColors();
+}
+
+void RegAllocModule::CalcLoopDepth() {
+  int n = bbs.size();
+  vector<vector<int>> preds(n);
+  for (int b = 0; b < n; ++b) {
+    for (int s : bb_succs[b]) {
+      preds[s].push_back(b);
+    }
+  }
+
+  // 逆后序
+  vector<int> rpo, order(n, -1);
+  vector<bool> visited(n, false);
+  vector<pair<int, size_t>> stack = {{0, 0}};
+  visited[0] = true;
+  while (!stack.empty()) {
+    auto& top = stack.back();
+    if (top.second < bb_succs[top.first].size()) {
+      int s = bb_succs[top.first][top.second++];
+      if (!visited[s]) {
+        visited[s] = true;
+        stack.emplace_back(s, 0);
+      }
+    } else {
+      rpo.push_back(top.first);
+      stack.pop_back();
+    }
+  }
+  std::reverse(rpo.begin(), rpo.end());
+  for (size_t i = 0; i < rpo.size(); ++i) {
+    order[rpo[i]] = i;
+  }
+
+  // Cooper-Harvey-Kennedy求直接支配者
+  vector<int> idom(n, -1);
+  idom[0] = 0;
+  auto intersect = [&](int a, int b) {
+    while (a != b) {
+      while (order[a] > order[b])
+        a = idom[a];
+      while (order[b] > order[a])
+        b = idom[b];
+    }
+    return a;
+  };
+  bool changed = true;
+  while (changed) {
+    changed = false;
+    for (size_t i = 1; i < rpo.size(); ++i) {
+      int b = rpo[i];
+      int new_idom = -1;
+      for (int p : preds[b]) {
+        if (idom[p] == -1)
+          continue;
+        new_idom = new_idom == -1 ? p : intersect(p, new_idom);
+      }
+      if (new_idom != idom[b]) {
+        idom[b] = new_idom;
+        changed = true;
+      }
+    }
+  }
+  auto dominates = [&](int h, int b) {
+    while (true) {
+      if (b == h)
+        return true;
+      if (b == 0 || idom[b] == -1)
+        return false;
+      b = idom[b];
+    }
+  };
+
+  // 回边b->h确定的自然循环，同一个头的合并成一个循环
+  map<int, set<int>> loops;
+  for (int b : rpo) {
+    for (int h : bb_succs[b]) {
+      if (!dominates(h, b))
+        continue;
+      auto& body = loops[h];
+      body.insert(h);
+      vector<int> worklist = {b};
+      while (!worklist.empty()) {
+        int x = worklist.back();
+        worklist.pop_back();
+        if (!body.insert(x).second)
+          continue;
+        for (int p : preds[x]) {
+          worklist.push_back(p);
+        }
+      }
+    }
+  }
+  loop_depth.assign(n, 0);
+  for (const auto& loop : loops) {
+    for (int b : loop.second) {
+      loop_depth[b]++;
+    }
+  }
+}
+
+void RegAllocModule::BuildGraph() {
+  int n = K + values.size();
+  adj_list.assign(n, {});
+  degree.assign(n, 0);
+  node_state.assign(n, NodeState::e_unused);
+  alias.assign(n, 0);
+  color.assign(n, -1);
+  spill_cost.assign(n, 0);
+  move_list.assign(n, {});
+  for (int i = 0; i < n; ++i) {
+    alias[i] = i;
+  }
+  for (int i = 0; i < K; ++i) {
+    node_state[i] = NodeState::e_precolored;
+    color[i] = i;
+    degree[i] = infinite_degree;
+  }
+
+  // 只给用到的值着色，没人用的值不分配
+  vector<koopa_raw_value_t> operands;
+  for (auto bb : bbs) {
+    for (size_t j = 0; j < bb->insts.len; ++j) {
+      operands.clear();
+      GetOperands(reinterpret_cast<koopa_raw_value_t>(bb->insts.buffer[j]),
+                  operands);
+      for (const auto& op : operands) {
+        auto it = value_ids.find(op);
+        if (it != value_ids.end())
+          node_state[K + it->second] = NodeState::e_initial;
+      }
+    }
+  }
+  auto node = [&](const koopa_raw_value_t& value) {
+    auto it = value_ids.find(value);
+    if (it == value_ids.end() ||
+        node_state[K + it->second] == NodeState::e_unused)
+      return -1;
+    return K + it->second;
+  };
+
+  // 每个基本块从出口往回走，定义的值和此时活跃的值冲突
+  for (size_t b = 0; b < bbs.size(); ++b) {
+    auto bb = bbs[b];
+    double weight = std::pow(10.0, std::min(loop_depth[b], 6));
+    set<int> live;
+    for (int id : live_out[b]) {
+      live.insert(K + id);
+    }
+
+    for (int j = bb->insts.len - 1; j >= 0; --j) {
+      auto inst = reinterpret_cast<koopa_raw_value_t>(bb->insts.buffer[j]);
+      const auto& kind = inst->kind;
+      int d = node(inst);
+      if (d != -1) {
+        for (int l : live) {
+          AddEdge(d, l);
+        }
+        live.erase(d);
+        spill_cost[d] += weight;
+      }
+
+      if (kind.tag == KOOPA_RVT_CALL) {
+        // 跨过调用的值不能放在caller-saved寄存器里
+        for (int l : live) {
+          for (int c = 0; c < caller_saved_count; ++c) {
+            AddEdge(l, c);
+          }
+        }
+        // 返回值从a0来，参数到a0-a7去
+        if (d != -1)
+          AddMove(d, GetColor(Reg::a0));
+        for (size_t i = 0; i < kind.data.call.args.len && i < 8; ++i) {
+          int arg = node(reinterpret_cast<koopa_raw_value_t>(
+              kind.data.call.args.buffer[i]));
+          if (arg != -1)
+            AddMove(arg, GetColor(param_regs[i]));
+        }
+      } else if (kind.tag == KOOPA_RVT_RETURN) {
+        if (kind.data.ret.value != nullptr && node(kind.data.ret.value) != -1)
+          AddMove(node(kind.data.ret.value), GetColor(Reg::a0));
+      }
+
+      // 块参数：实参和形参之间是一次传送
+      auto add_arg_moves = [&](const koopa_raw_basic_block_t& target,
+                               const koopa_raw_slice_t& args) {
+        for (size_t i = 0; i < args.len; ++i) {
+          int arg = node(reinterpret_cast<koopa_raw_value_t>(args.buffer[i]));
+          int param = node(
+              reinterpret_cast<koopa_raw_value_t>(target->params.buffer[i]));
+          if (arg != -1 && param != -1)
+            AddMove(arg, param);
+        }
+      };
+      if (kind.tag == KOOPA_RVT_JUMP) {
+        add_arg_moves(kind.data.jump.target, kind.data.jump.args);
+      } else if (kind.tag == KOOPA_RVT_BRANCH) {
+        add_arg_moves(kind.data.branch.true_bb, kind.data.branch.true_args);
+        add_arg_moves(kind.data.branch.false_bb, kind.data.branch.false_args);
+      }
+
+      operands.clear();
+      GetOperands(inst, operands);
+      for (const auto& op : operands) {
+        int u = node(op);
+        if (u == -1)
+          continue;
+        live.insert(u);
+        spill_cost[u] += weight;
+      }
+    }
+
+    // 块参数在块开头同时定义
+    for (size_t j = 0; j < bb->params.len; ++j) {
+      int p = node(reinterpret_cast<koopa_raw_value_t>(bb->params.buffer[j]));
+      if (p == -1)
+        continue;
+      for (int l : live) {
+        AddEdge(p, l);
+      }
+      spill_cost[p] += weight;
+    }
+  }
+
+  // 函数参数在入口同时定义，和入口活跃的值两两冲突
+  if (!bbs.empty()) {
+    for (int u : live_in[0]) {
+      for (int v : live_in[0]) {
+        AddEdge(K + u, K + v);
+      }
+    }
+  }
+  for (int i = 0; i < 8 && i < (int)values.size(); ++i) {
+    if (values[i]->kind.tag != KOOPA_RVT_FUNC_ARG_REF)
+      break;
+    if (node(values[i]) != -1)
+      AddMove(K + i, GetColor(param_regs[i]));
+  }
+}
+
+void RegAllocModule::AddEdge(const int& u, const int& v) {
+  if (u == v || adj_set.count({u, v}))
+    return;
+  adj_set.insert({u, v});
+  adj_set.insert({v, u});
+  if (node_state[u] != NodeState::e_precolored) {
+    adj_list[u].push_back(v);
+    degree[u]++;
+  }
+  if (node_state[v] != NodeState::e_precolored) {
+    adj_list[v].push_back(u);
+    degree[v]++;
+  }
+}
+
+void RegAllocModule::AddMove(const int& u, const int& v) {
+  if (u == v)
+    return;
+  int m = moves.size();
+  moves.emplace_back(u, v);
+  move_state.push_back(MoveState::e_worklist);
+  move_list[u].push_back(m);
+  move_list[v].push_back(m);
+  worklist_moves.insert(m);
+}
+
+void RegAllocModule::MakeWorklist() {
+  for (size_t n = K; n < node_state.size(); ++n) {
+    if (node_state[n] != NodeState::e_initial)
+      continue;
+    if (degree[n] >= K) {
+      node_state[n] = NodeState::e_spill;
+      spill_worklist.insert(n);
+    } else if (MoveRelated(n)) {
+      node_state[n] = NodeState::e_freeze;
+      freeze_worklist.insert(n);
+    } else {
+      node_state[n] = NodeState::e_simplify;
+      simplify_worklist.insert(n);
+    }
+  }
+}
+
+const vector<int> RegAllocModule::Adjacent(const int& n) {
+  vector<int> ret;
+  for (int m : adj_list[n]) {
+    if (node_state[m] != NodeState::e_selected &&
+        node_state[m] != NodeState::e_coalesced)
+      ret.push_back(m);
+  }
+  return ret;
+}
+
+const vector<int> RegAllocModule::NodeMoves(const int& n) {
+  vector<int> ret;
+  for (int m : move_list[n]) {
+    if (move_state[m] == MoveState::e_active ||
+        move_state[m] == MoveState::e_worklist)
+      ret.push_back(m);
+  }
+  return ret;
+}
+
+bool RegAllocModule::MoveRelated(const int& n) {
+  for (int m : move_list[n]) {
+    if (move_state[m] == MoveState::e_active ||
+        move_state[m] == MoveState::e_worklist)
+      return true;
+  }
+  return false;
+}
+
+void RegAllocModule::Simplify() {
+  int n = *simplify_worklist.begin();
+  simplify_worklist.erase(n);
+  node_state[n] = NodeState::e_selected;
+  select_stack.push_back(n);
+  for (int m : Adjacent(n)) {
+    DecrementDegree(m);
+  }
+}
+
+void RegAllocModule::DecrementDegree(const int& m) {
+  if (node_state[m] == NodeState::e_precolored)
+    return;
+  int d = degree[m]--;
+  if (d != K)
+    return;
+  // 从高度数变成低度数，相关的传送可以再试试合并
+  vector<int> nodes = Adjacent(m);
+  nodes.push_back(m);
+  EnableMoves(nodes);
+  spill_worklist.erase(m);
+  if (MoveRelated(m)) {
+    node_state[m] = NodeState::e_freeze;
+    freeze_worklist.insert(m);
+  } else {
+    node_state[m] = NodeState::e_simplify;
+    simplify_worklist.insert(m);
+  }
+}
+
+void RegAllocModule::EnableMoves(const vector<int>& nodes) {
+  for (int n : nodes) {
+    for (int m : NodeMoves(n)) {
+      if (move_state[m] == MoveState::e_active) {
+        move_state[m] = MoveState::e_worklist;
+        worklist_moves.insert(m);
+      }
+    }
+  }
+}
+
+void RegAllocModule::Coalesce() {
+  int m = *worklist_moves.begin();
+  worklist_moves.erase(m);
+  int x = GetAlias(moves[m].first);
+  int y = GetAlias(moves[m].second);
+  // 预着色的放在u
+  int u = x, v = y;
+  if (node_state[y] == NodeState::e_precolored) {
+    u = y;
+    v = x;
+  }
+
+  if (u == v) {
+    move_state[m] = MoveState::e_coalesced;
+    AddWorkList(u);
+  } else if (node_state[v] == NodeState::e_precolored ||
+             adj_set.count({u, v})) {
+    // 冲突，不能合并
+    move_state[m] = MoveState::e_constrained;
+    AddWorkList(u);
+    AddWorkList(v);
+  } else {
+    bool can_combine;
+    if (node_state[u] == NodeState::e_precolored) {
+      can_combine = true;
+      for (int t : Adjacent(v)) {
+        if (!OK(t, u)) {
+          can_combine = false;
+          break;
+        }
+      }
+    } else {
+      vector<int> nodes = Adjacent(u);
+      for (int t : Adjacent(v)) {
+        nodes.push_back(t);
+      }
+      std::sort(nodes.begin(), nodes.end());
+      nodes.erase(std::unique(nodes.begin(), nodes.end()), nodes.end());
+      can_combine = Conservative(nodes);
+    }
+    if (can_combine) {
+      move_state[m] = MoveState::e_coalesced;
+      Combine(u, v);
+      AddWorkList(u);
+    } else {
+      move_state[m] = MoveState::e_active;
+    }
+  }
+}
+
+void RegAllocModule::AddWorkList(const int& u) {
+  if (node_state[u] != NodeState::e_precolored && !MoveRelated(u) &&
+      degree[u] < K && node_state[u] == NodeState::e_freeze) {
+    freeze_worklist.erase(u);
+    node_state[u] = NodeState::e_simplify;
+    simplify_worklist.insert(u);
+  }
+}
+
+bool RegAllocModule::OK(const int& t, const int& r) {
+  return degree[t] < K || node_state[t] == NodeState::e_precolored ||
+         adj_set.count({t, r});
+}
+
+bool RegAllocModule::Conservative(const vector<int>& nodes) {
+  int k = 0;
+  for (int n : nodes) {
+    if (degree[n] >= K)
+      k++;
+  }
+  return k < K;
+}
+
+const int RegAllocModule::GetAlias(int n) {
+  while (node_state[n] == NodeState::e_coalesced) {
+    n = alias[n];
+  }
+  return n;
+}
+
+void RegAllocModule::Combine(const int& u, const int& v) {
+  if (node_state[v] == NodeState::e_freeze) {
+    freeze_worklist.erase(v);
+  } else {
+    spill_worklist.erase(v);
+  }
+  node_state[v] = NodeState::e_coalesced;
+  alias[v] = u;
+  for (int m : move_list[v]) {
+    move_list[u].push_back(m);
+  }
+  spill_cost[u] += spill_cost[v];
+  EnableMoves({v});
+  for (int t : Adjacent(v)) {
+    AddEdge(t, u);
+    DecrementDegree(t);
+  }
+  if (degree[u] >= K && node_state[u] == NodeState::e_freeze) {
+    freeze_worklist.erase(u);
+    node_state[u] = NodeState::e_spill;
+    spill_worklist.insert(u);
+  }
+}
+
+void RegAllocModule::Freeze() {
+  int u = *freeze_worklist.begin();
+  freeze_worklist.erase(u);
+  node_state[u] = NodeState::e_simplify;
+  simplify_worklist.insert(u);
+  FreezeMoves(u);
+}
+
+void RegAllocModule::FreezeMoves(const int& u) {
+  for (int m : NodeMoves(u)) {
+    int x = moves[m].first, y = moves[m].second;
+    int v = GetAlias(y) == GetAlias(u) ? GetAlias(x) : GetAlias(y);
+    worklist_moves.erase(m);
+    // 放弃合并
+    move_state[m] = MoveState::e_constrained;
+    if (node_state[v] == NodeState::e_freeze && !MoveRelated(v) &&
+        degree[v] < K) {
+      freeze_worklist.erase(v);
+      node_state[v] = NodeState::e_simplify;
+      simplify_worklist.insert(v);
+    }
+  }
+}
+
+void RegAllocModule::SelectSpill() {
+  // 代价/度数最小的最先考虑溢出，循环里的值代价高
+  int m = -1;
+  for (int n : spill_worklist) {
+    if (m == -1 || spill_cost[n] / degree[n] < spill_cost[m] / degree[m])
+      m = n;
+  }
+  spill_worklist.erase(m);
+  node_state[m] = NodeState::e_simplify;
+  simplify_worklist.insert(m);
+  FreezeMoves(m);
+}
+
+void RegAllocModule::AssignColors() {
+  while (!select_stack.empty()) {
+    int n = select_stack.back();
+    select_stack.pop_back();
+    vector<bool> ok_colors(K, true);
+    for (int w : adj_list[n]) {
+      int a = GetAlias(w);
+      if (node_state[a] == NodeState::e_colored ||
+          node_state[a] == NodeState::e_precolored)
+        ok_colors[color[a]] = false;
+    }
+
+    // 优先选和传送另一端相同的颜色，能省一条mv
+    int c = -1;
+    for (int m : move_list[n]) {
+      int other = GetAlias(moves[m].first) == n ? GetAlias(moves[m].second)
+                                                 : GetAlias(moves[m].first);
+      if (color[other] != -1 && ok_colors[color[other]] &&
+          (node_state[other] == NodeState::e_colored ||
+           node_state[other] == NodeState::e_precolored)) {
+        c = color[other];
+        break;
+      }
+    }
+    for (int i = 0; i < K && c == -1; ++i) {
+      if (ok_colors[i])
+        c = i;
+    }
+
+    if (c == -1) {
+      node_state[n] = NodeState::e_spilled;
+    } else {
+      node_state[n] = NodeState::e_colored;
+      color[n] = c;
+    }
+  }
+
+  // 写回结果，合并掉的值和代表用同一个位置
+  for (size_t id = 0; id < values.size(); ++id) {
+    int n = K + id;
+    if (node_state[n] == NodeState::e_unused)
+      continue;
+    int a = GetAlias(n);
+    if (node_state[a] == NodeState::e_colored ||
+        node_state[a] == NodeState::e_precolored) {
+      AssignReg(id, color_regs[color[a]]);
+    } else {
+      spilled.push_back(values[id]);
+    }
+  }
+}
+
+#pragma endregion
+
+}  // namespace riscv
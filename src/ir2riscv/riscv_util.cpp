@@ -71,4 +71,71 @@ const char* GetTypeString(const koopa_raw_value_t& value) {
 Reg zeroReg() {
   return Reg::x0;
 }
+
+int GetTypeSize(koopa_raw_type_t ty) {
+  switch (ty->tag) {
+    case KOOPA_RTT_INT32:
+    case KOOPA_RTT_POINTER:
+      return 4;
+    case KOOPA_RTT_ARRAY:
+      return ty->data.array.len * GetTypeSize(ty->data.array.base);
+    default:
+      return 0;
+  }
+}
+
+bool IsCalleeSaved(const Reg& reg) {
+  return reg >= Reg::s1 && reg <= Reg::s11;
+}
+
+static void PushSlice(const koopa_raw_slice_t& slice,
+                      std::vector<koopa_raw_value_t>& operands) {
+  for (size_t i = 0; i < slice.len; ++i) {
+    operands.push_back(reinterpret_cast<koopa_raw_value_t>(slice.buffer[i]));
+  }
+}
+
+void GetOperands(const koopa_raw_value_t& inst,
+                 std::vector<koopa_raw_value_t>& operands) {
+  const auto& kind = inst->kind;
+  switch (kind.tag) {
+    case KOOPA_RVT_LOAD:
+      operands.push_back(kind.data.load.src);
+      break;
+    case KOOPA_RVT_STORE:
+      operands.push_back(kind.data.store.value);
+      operands.push_back(kind.data.store.dest);
+      break;
+    case KOOPA_RVT_GET_PTR:
+      operands.push_back(kind.data.get_ptr.src);
+      operands.push_back(kind.data.get_ptr.index);
+      break;
+    case KOOPA_RVT_GET_ELEM_PTR:
+      operands.push_back(kind.data.get_elem_ptr.src);
+      operands.push_back(kind.data.get_elem_ptr.index);
+      break;
+    case KOOPA_RVT_BINARY:
+      operands.push_back(kind.data.binary.lhs);
+      operands.push_back(kind.data.binary.rhs);
+      break;
+    case KOOPA_RVT_BRANCH:
+      operands.push_back(kind.data.branch.cond);
+      PushSlice(kind.data.branch.true_args, operands);
+      PushSlice(kind.data.branch.false_args, operands);
+      break;
+    case KOOPA_RVT_JUMP:
+      PushSlice(kind.data.jump.args, operands);
+      break;
+    case KOOPA_RVT_CALL:
+      PushSlice(kind.data.call.args, operands);
+      break;
+    case KOOPA_RVT_RETURN:
+      if (kind.data.ret.value != nullptr)
+        operands.push_back(kind.data.ret.value);
+      break;
+    default:
+      break;
+  }
+}
+
 }  // namespace riscv
\ No newline at end of file
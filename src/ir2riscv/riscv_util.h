@@ -7,6 +7,7 @@
 #include <queue>
 #include <sstream>
 #include <string>
+#include <vector>
 #include "koopa.h"
 
 namespace riscv {
@@ -60,4 +61,14 @@ const char* GetTypeString(const koopa_raw_value_t& value);
 
 Reg zeroReg();
 
+// 类型占用的字节数
+int GetTypeSize(koopa_raw_type_t ty);
+
+// 是否是callee-saved寄存器，s1-s11
+bool IsCalleeSaved(const Reg& reg);
+
+// 指令用到的所有值，追加到operands
+void GetOperands(const koopa_raw_value_t& inst,
+                 std::vector<koopa_raw_value_t>& operands);
+
 }  // namespace riscv
\ No newline at end of file
@@ -1,9 +1,13 @@
+#include <algorithm>
 #include <cassert>
+#include <cstdlib>
 #include <cstring>
 #include <fstream>
 #include <iostream>
 #include <memory>
 #include <string>
+#include <thread>
+#include "ir2ir/opt_ir2ir.h"
 #include "ir2riscv/riscv_ir2riscv.h"
 #include "sysy2ir/ir_sysy2ir.h"
 
@@ -18,24 +22,65 @@ int main(int argc, const char* argv[]) {
 
 void supreme_compile(int argc, const char* argv[]) {
   // 解析命令行参数. 测试脚本/评测平台要求你的编译器能接收如下参数:
-  // compiler 模式 输入文件 -o 输出文件
-  assert(argc == 5);
+  // compiler 模式 输入文件 -o 输出文件 [-O0 | -O1 | -O2] [-time-passes]
+  //          [-stream] [-jN]
+  assert(argc >= 5);
   auto input = argv[2];
   auto output = argv[4];
   CompilerMode mode;
+  // 优化等级，-O1提升局部变量，-O2使用图着色寄存器分配
+  // -koopa默认不优化，便于对照前端的输出
+  int opt_level = 1;
+  // 打印每个优化pass的耗时
+  bool time_passes = false;
+  // 逐个函数生成IR、优化、输出汇编，生成完就释放，限制内存峰值
+  bool stream = false;
+  // 前端生成函数和后端翻译函数的线程数，默认用上所有核
+  int jobs = std::max(1, (int)std::thread::hardware_concurrency());
   if (strcmp(argv[1], "-koopa") == 0) {
     mode = CompilerMode::KOOPA;
+    opt_level = 0;
   } else if (strcmp(argv[1], "-riscv") == 0) {
     mode = CompilerMode::RISCV;
   } else if (strcmp(argv[1], "-perf") == 0) {
     mode = CompilerMode::PERF;
+    opt_level = 2;
   } else {
     assert(false);
   }
+  for (int i = 5; i < argc; i++) {
+    if (strncmp(argv[i], "-O", 2) == 0) {
+      opt_level = atoi(argv[i] + 2);
+    } else if (strcmp(argv[i], "-time-passes") == 0) {
+      time_passes = true;
+    } else if (strcmp(argv[i], "-stream") == 0) {
+      stream = true;
+    } else if (strncmp(argv[i], "-j", 2) == 0) {
+      jobs = atoi(argv[i] + 2);
+    }
+  }
+
+  if (stream && mode != CompilerMode::KOOPA) {
+    opt::PassManager manager;
+    opt::BuildPipeline(manager, opt_level);
+    if (!riscv::BeginStream(output, opt_level, jobs))
+      return;
+    ir::sysy2ir(input, [&](const koopa_raw_program_t& unit) {
+      manager.Run(unit);
+      riscv::StreamUnit(unit);
+    });
+    riscv::EndStream();
+    if (time_passes)
+      manager.Report();
+    return;
+  }
 
-  string ir = ir::sysy2ir(input, output, mode == CompilerMode::KOOPA);
+  const koopa_raw_program_t program = ir::sysy2ir(input, jobs);
+  opt::ir2ir(program, opt_level, time_passes);
   if (mode == CompilerMode::KOOPA) {
+    // 只有-koopa需要文本形式的IR
+    ir::ir2file(program, output);
     return;
   }
-  riscv::ir2riscv(ir, output);
+  riscv::ir2riscv(program, output, opt_level, jobs);
 }
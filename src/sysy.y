@@ -13,7 +13,7 @@
 
 // 声明 lexer 函数和错误处理函数
 int yylex();
-void yyerror(std::unique_ptr<BaseAST> &ast, const char *s);
+void yyerror(BaseAST *&ast, ir::ASTArena &arena, const char *s);
 extern int yylineno;
 
 using namespace std;
@@ -23,27 +23,27 @@ using namespace std;
 // 定义 parser 函数和错误处理函数的附加参数
 // 我们需要返回一个字符串作为 AST, 所以我们把附加参数定义成字符串的智能指针
 // 解析完成后, 我们要手动修改这个参数, 把它设置成解析得到的字符串
-%parse-param { std::unique_ptr<BaseAST> &ast }
+// 所有节点都在 arena 中分配, 由 arena 统一释放
+%parse-param { BaseAST *&ast } { ir::ASTArena &arena }
 
 // yylval 的定义, 我们把它定义成了一个联合体 (union)
-// 因为 token 的值有的是字符串指针, 有的是整数
-// 之前我们在 lexer 中用到的 str_val 和 int_val 就是在这里被定义的
-// 至于为什么要用字符串指针而不直接用 string 或者 unique_ptr<string>?
-// 请自行 STFW 在 union 里写一个带析构函数的类会出现什么情况
+// 因为 token 的值有的是标识符编号, 有的是整数
+// 之前我们在 lexer 中用到的 sym_val 和 int_val 就是在这里被定义的
+// 标识符在 lexer 中就驻留成编号, 不再为每个标识符 new 一个 string
 %union {
-  std::string *str_val;
+  ir::SymbolId sym_val;
   int int_val;
   BaseAST *ast_val;
 }
 
 // lexer 返回的所有 token 种类的声明
-// 注意 IDENT 和 INT_CONST 会返回 token 的值, 分别对应 str_val 和 int_val
+// 注意 IDENT 和 INT_CONST 会返回 token 的值, 分别对应 sym_val 和 int_val
 %token INT RETURN
 %token OPLE OPLT OPGE OPGT OPEQ OPNE OPAND OPOR
 %token CONST
 %token IF ELSE WHILE CONTINUE BREAK
 %token VOID
-%token <str_val> IDENT
+%token <sym_val> IDENT
 %token <int_val> INT_CONST
 
 // 非终结符的类型定义
@@ -67,12 +67,12 @@ using namespace std;
 // CompRoot        ::= CompUnitList
 CompRoot
   : CompUnitList {
-    auto comp_root = make_unique<CompRootAST>();
-    auto list = unique_ptr<CompUnitListUnit>(dynamic_cast<CompUnitListUnit*>($1));
+    auto comp_root = arena.New<CompRootAST>();
+    auto list = dynamic_cast<CompUnitListUnit*>($1);
     for (auto it = list->comp_units.rbegin(); it != list->comp_units.rend(); ++it) {
-      comp_root->comp_units.push_back(unique_ptr<CompUnitAST>(*it));
+      comp_root->comp_units.push_back(*it);
     }
-    ast = move(comp_root);
+    ast = comp_root;
   }
   ;
 
@@ -83,7 +83,7 @@ CompUnitList
     $$ = $2;
   }
   | {
-    auto ast = new CompUnitListUnit();
+    auto ast = arena.New<CompUnitListUnit>();
     $$ = ast;
   }
   ;
@@ -91,15 +91,15 @@ CompUnitList
 // CompUnit        ::= FuncDef | Decl
 CompUnit
   : FuncDef {
-    auto ast = new CompUnitAST();
+    auto ast = arena.New<CompUnitAST>();
     ast->ty = CompUnitAST::comp_unit_ty::e_func_def;
-    ast->content = unique_ptr<BaseAST>($1);
+    ast->content = $1;
     $$ = ast;
   }
   | Decl {
-    auto ast = new CompUnitAST();
+    auto ast = arena.New<CompUnitAST>();
     ast->ty = CompUnitAST::comp_unit_ty::e_decl;
-    ast->content = unique_ptr<BaseAST>($1);
+    ast->content = $1;
     $$ = ast;
   }
   ;
@@ -107,15 +107,15 @@ CompUnit
 // Decl          ::= ConstDecl | VarDecl
 Decl
   : ConstDecl {
-    auto ast = new DeclAST();
+    auto ast = arena.New<DeclAST>();
     ast->de = DeclAST::de_t::e_const;
-    ast->decl = unique_ptr<BaseAST>($1);
+    ast->decl = $1;
     $$ = ast;
   }
   | VarDecl {
-    auto ast = new DeclAST();
+    auto ast = arena.New<DeclAST>();
     ast->de = DeclAST::de_t::e_var;
-    ast->decl = unique_ptr<BaseAST>($1);
+    ast->decl = $1;
     $$ = ast;
   }
   ;
@@ -124,14 +124,14 @@ Decl
 // ConstDecl     ::= "const" BType ConstDef ConstDeclList ";"
 ConstDecl
   : CONST BType ConstDef ConstDeclList ';' {
-    auto ast = new ConstDeclAST();
-    ast->btype = unique_ptr<BaseAST>($2);
+    auto ast = arena.New<ConstDeclAST>();
+    ast->btype = $2;
     // 插入开头def
-    ast->const_defs.push_back(unique_ptr<ConstDefAST>(dynamic_cast<ConstDefAST*>($3)));
-    auto list = unique_ptr<ConstDeclListUnit>(dynamic_cast<ConstDeclListUnit*>($4));
+    ast->const_defs.push_back(dynamic_cast<ConstDefAST*>($3));
+    auto list = dynamic_cast<ConstDeclListUnit*>($4);
     // 插入剩余def
     for (auto it = list->const_defs.rbegin(); it != list->const_defs.rend(); ++it) {
-      ast->const_defs.push_back(unique_ptr<ConstDefAST>(*it));
+      ast->const_defs.push_back(*it);
     }
     $$ = ast;
   }
@@ -144,7 +144,7 @@ ConstDeclList
     $$ = $3;
   }
   | {
-    auto ast = new ConstDeclListUnit();
+    auto ast = arena.New<ConstDeclListUnit>();
     $$ = ast;
   }
   ;
@@ -152,12 +152,12 @@ ConstDeclList
 // BType         ::= "int" | "void"
 BType
   : INT {
-    auto ast = new BTypeAST();
+    auto ast = arena.New<BTypeAST>();
     ast->ty = BTypeAST::btype_t::e_int;
     $$ = ast;
   }
   | VOID {
-    auto ast = new BTypeAST();
+    auto ast = arena.New<BTypeAST>();
     ast->ty = BTypeAST::btype_t::e_void;
     $$ = ast;
   }
@@ -169,18 +169,18 @@ ConstDef        ::= IDENT "=" ConstInitVal
 */
 ConstDef
   : IDENT '=' ConstInitVal {
-    auto ast = new ConstDefAST();
+    auto ast = arena.New<ConstDefAST>();
     ast->ty = ConstDefAST::def_t::e_int;
-    ast->var_name = *unique_ptr<string>($1);
-    ast->const_init_val = unique_ptr<BaseAST>($3);
+    ast->var_name = $1;
+    ast->const_init_val = $3;
     $$ = ast;
   }
   | IDENT ArrSize '=' ConstArrVal {
-    auto ast = new ConstDefAST();
+    auto ast = arena.New<ConstDefAST>();
     ast->ty = ConstDefAST::def_t::e_arr;
-    ast->var_name = *unique_ptr<string>($1);
-    ast->arr_size = unique_ptr<BaseAST>($2);
-    ast->const_init_val = unique_ptr<BaseAST>($4);
+    ast->var_name = $1;
+    ast->arr_size = $2;
+    ast->const_init_val = $4;
     $$ = ast;
   }
   ;
@@ -188,8 +188,8 @@ ConstDef
 // ConstInitVal  ::= ConstExp
 ConstInitVal
   : ConstExp {
-    auto ast = new ConstInitValAST();
-    ast->const_exp = unique_ptr<BaseAST>($1);
+    auto ast = arena.New<ConstInitValAST>();
+    ast->const_exp = $1;
     $$ = ast;
   }
   ;
@@ -198,14 +198,14 @@ ConstInitVal
 // VarDecl     ::= BType VarDef VarDeclList ";"
 VarDecl
   : BType VarDef VarDeclList ';' {
-    auto ast = new VarDeclAST();
-    ast->btype = unique_ptr<BaseAST>($1);
+    auto ast = arena.New<VarDeclAST>();
+    ast->btype = $1;
     // 插入开头def
-    ast->var_defs.push_back(unique_ptr<VarDefAST>(dynamic_cast<VarDefAST*>($2)));
-    auto list = unique_ptr<VarDeclListUnit>(dynamic_cast<VarDeclListUnit*>($3));
+    ast->var_defs.push_back(dynamic_cast<VarDefAST*>($2));
+    auto list = dynamic_cast<VarDeclListUnit*>($3);
     // 插入剩余def
     for (auto it = list->var_defs.rbegin(); it != list->var_defs.rend(); ++it) {
-      ast->var_defs.push_back(unique_ptr<VarDefAST>(*it));
+      ast->var_defs.push_back(*it);
     }
     $$ = ast;
   }
@@ -218,7 +218,7 @@ VarDeclList
     $$ = $3;
   }
   | {
-    auto ast = new VarDeclListUnit();
+    auto ast = arena.New<VarDeclListUnit>();
     $$ = ast;
   }
   ;
@@ -231,35 +231,35 @@ VarDef          ::= IDENT
 */
 VarDef
   : IDENT {
-    auto ast = new VarDefAST();
+    auto ast = arena.New<VarDefAST>();
     ast->init_with_val = false;
     ast->ty = VarDefAST::def_t::e_int;
-    ast->var_name = *unique_ptr<string>($1);
+    ast->var_name = $1;
     $$ = ast;
   }
   | IDENT '=' InitVal {
-    auto ast = new VarDefAST();
+    auto ast = arena.New<VarDefAST>();
     ast->init_with_val = true;
     ast->ty = VarDefAST::def_t::e_int;
-    ast->var_name = *unique_ptr<string>($1);
-    ast->init_val = unique_ptr<BaseAST>($3);
+    ast->var_name = $1;
+    ast->init_val = $3;
     $$ = ast;
   }
   | IDENT ArrSize {
-    auto ast = new VarDefAST();
+    auto ast = arena.New<VarDefAST>();
     ast->init_with_val = false;
     ast->ty = VarDefAST::def_t::e_arr;
-    ast->var_name = *unique_ptr<string>($1);
-    ast->arr_size = unique_ptr<BaseAST>($2);
+    ast->var_name = $1;
+    ast->arr_size = $2;
     $$ = ast;
   }
   | IDENT ArrSize '=' ArrInitVal {
-    auto ast = new VarDefAST();
+    auto ast = arena.New<VarDefAST>();
     ast->init_with_val = true;
     ast->ty = VarDefAST::def_t::e_arr;
-    ast->var_name = *unique_ptr<string>($1);
-    ast->arr_size = unique_ptr<BaseAST>($2);
-    ast->init_val = unique_ptr<BaseAST>($4);
+    ast->var_name = $1;
+    ast->arr_size = $2;
+    ast->init_val = $4;
     $$ = ast;
   }
   ;
@@ -267,8 +267,8 @@ VarDef
 // InitVal       ::= Exp
 InitVal
   : Exp {
-    auto ast = new InitValAST();
-    ast->exp = unique_ptr<BaseAST>($1);
+    auto ast = arena.New<InitValAST>();
+    ast->exp = $1;
     $$ = ast;
   }
   ;
@@ -276,12 +276,12 @@ InitVal
 // ArrSize         ::= "[" ConstExp "]" ArrSizeList
 ArrSize
   : '[' ConstExp ']' ArrSizeList {
-    auto ast = new ArrSizeAST();
-    ast->arr_size.push_back(unique_ptr<ConstExpAST>(dynamic_cast<ConstExpAST*>($2)));
-    auto list = unique_ptr<ArrSizeListUnit>(dynamic_cast<ArrSizeListUnit*>($4));
+    auto ast = arena.New<ArrSizeAST>();
+    ast->arr_size.push_back(dynamic_cast<ConstExpAST*>($2));
+    auto list = dynamic_cast<ArrSizeListUnit*>($4);
     // 插入剩余
     for (auto it = list->values.rbegin(); it != list->values.rend(); ++it) {
-      ast->arr_size.push_back(unique_ptr<ConstExpAST>(*it));
+      ast->arr_size.push_back(*it);
     }
     $$ = ast;
   }
@@ -294,7 +294,7 @@ ArrSizeList
     $$ = $4;
   }
   | {
-    auto ast = new ArrSizeListUnit();
+    auto ast = arena.New<ArrSizeListUnit>();
     $$ = ast;
   }
   ;
@@ -302,15 +302,15 @@ ArrSizeList
 // CAElement       ::= ConstExp | ConstArrVal
 CAElement
   : ConstExp {
-    auto ast = new CAElementAST();
+    auto ast = arena.New<CAElementAST>();
     ast->ty = CAElementAST::caty_t::e_cexp;
-    ast->content = unique_ptr<BaseAST>($1);
+    ast->content = $1;
     $$ = ast;
   }
   | ConstArrVal {
-    auto ast = new CAElementAST();
+    auto ast = arena.New<CAElementAST>();
     ast->ty = CAElementAST::caty_t::e_carr;
-    ast->content = unique_ptr<BaseAST>($1);
+    ast->content = $1;
     $$ = ast;
   }
   ;
@@ -318,17 +318,17 @@ CAElement
 // ConstArrVal     ::= "{" "}" | "{" CAElement CAElementList "}"
 ConstArrVal
   : '{' '}' {
-    auto ast = new ConstArrValAST();
+    auto ast = arena.New<ConstArrValAST>();
     $$ = ast;
   }
   | '{' CAElement CAElementList '}' {
-    auto ast = new ConstArrValAST();
+    auto ast = arena.New<ConstArrValAST>();
     // 插入开头
-    ast->values.push_back(unique_ptr<CAElementAST>(dynamic_cast<CAElementAST*>($2)));
-    auto list = unique_ptr<CAElementListUnit>(dynamic_cast<CAElementListUnit*>($3));
+    ast->values.push_back(dynamic_cast<CAElementAST*>($2));
+    auto list = dynamic_cast<CAElementListUnit*>($3);
     // 插入剩余
     for (auto it = list->values.rbegin(); it != list->values.rend(); ++it) {
-      ast->values.push_back(unique_ptr<CAElementAST>(*it));
+      ast->values.push_back(*it);
     }
     $$ = ast;
   }
@@ -341,7 +341,7 @@ CAElementList
     $$ = $3;
   }
   | {
-    auto ast = new CAElementListUnit();
+    auto ast = arena.New<CAElementListUnit>();
     $$ = ast;
   }
   ;
@@ -349,32 +349,32 @@ CAElementList
 // AIElement       ::= Exp | ArrInitVal
 AIElement
   : Exp {
-    auto ast = new AIElementAST();
+    auto ast = arena.New<AIElementAST>();
     ast->ty = AIElementAST::aity_t::e_exp;
-    ast->content = unique_ptr<BaseAST>($1);
+    ast->content = $1;
     $$ = ast;
   }
   | ArrInitVal {
-    auto ast = new AIElementAST();
+    auto ast = arena.New<AIElementAST>();
     ast->ty = AIElementAST::aity_t::e_arr;
-    ast->content = unique_ptr<BaseAST>($1);
+    ast->content = $1;
     $$ = ast;
   }
 
 // ArrInitVal      ::= "{" "}" | "{" AIElement AIElementList "}"
 ArrInitVal
   : '{' '}' {
-    auto ast = new ArrInitValAST();
+    auto ast = arena.New<ArrInitValAST>();
     $$ = ast;
   }
   | '{' AIElement AIElementList '}' {
-    auto ast = new ArrInitValAST();
+    auto ast = arena.New<ArrInitValAST>();
     // 插入开头
-    ast->values.push_back(unique_ptr<AIElementAST>(dynamic_cast<AIElementAST*>($2)));
-    auto list = unique_ptr<AIElementListUnit>(dynamic_cast<AIElementListUnit*>($3));
+    ast->values.push_back(dynamic_cast<AIElementAST*>($2));
+    auto list = dynamic_cast<AIElementListUnit*>($3);
     // 插入剩余
     for (auto it = list->values.rbegin(); it != list->values.rend(); ++it) {
-      ast->values.push_back(unique_ptr<AIElementAST>(*it));
+      ast->values.push_back(*it);
     }
     $$ = ast;
   }
@@ -387,7 +387,7 @@ AIElementList
     $$ = $3;
   }
   | {
-    auto ast = new AIElementListUnit();
+    auto ast = arena.New<AIElementListUnit>();
     $$ = ast;
   }
   ;
@@ -395,11 +395,11 @@ AIElementList
 // FuncDef         ::= FuncType IDENT "(" FuncFParams ")" Block
 FuncDef
   : BType IDENT '(' FuncFParams ')' Block {
-    auto ast = new FuncDefAST();
-    ast->func_type = unique_ptr<BaseAST>($1);
-    ast->func_name = *unique_ptr<string>($2);
-    ast->params = unique_ptr<BaseAST>($4);
-    ast->block = unique_ptr<BaseAST>($6);
+    auto ast = arena.New<FuncDefAST>();
+    ast->func_type = $1;
+    ast->func_name = $2;
+    ast->params = $4;
+    ast->block = $6;
     $$ = ast;
   }
   ;
@@ -407,16 +407,16 @@ FuncDef
 // FuncFParams     ::= FuncFParam FuncFParamsList | epsilon
 FuncFParams
   : FuncFParam FuncFParamsList {
-    auto ast = new FuncFParamsAST();
-    ast->params.push_back(unique_ptr<FuncFParamAST>(dynamic_cast<FuncFParamAST*>($1)));
-    auto list = unique_ptr<FuncFParamsListUnit>(dynamic_cast<FuncFParamsListUnit*>($2));
+    auto ast = arena.New<FuncFParamsAST>();
+    ast->params.push_back(dynamic_cast<FuncFParamAST*>($1));
+    auto list = dynamic_cast<FuncFParamsListUnit*>($2);
     for (auto it = list->params.rbegin(); it != list->params.rend(); ++it) {
-      ast->params.push_back(unique_ptr<FuncFParamAST>(*it));
+      ast->params.push_back(*it);
     }
     $$ = ast;
   }
   | {
-    auto ast = new FuncFParamsAST();
+    auto ast = arena.New<FuncFParamsAST>();
     $$ = ast;
   }
   ;
@@ -428,7 +428,7 @@ FuncFParamsList
     $$ = $3;
   }
   | {
-    auto ast = new FuncFParamsListUnit();
+    auto ast = arena.New<FuncFParamsListUnit>();
     $$ = ast;
   }
   ;
@@ -440,22 +440,22 @@ FuncFParam      ::= INT IDENT
 */
 FuncFParam
   : INT IDENT {
-    auto ast = new FuncFParamAST();
+    auto ast = arena.New<FuncFParamAST>();
     ast->is_ptr = false;
-    ast->param_name = *unique_ptr<string>($2);
+    ast->param_name = $2;
     $$ = ast;
   }
   | INT IDENT '[' ']' {
-    auto ast = new FuncFParamAST();
-    ast->param_name = *unique_ptr<string>($2);
-    ast->ptr_size = unique_ptr<BaseAST>(new ArrSizeAST());
+    auto ast = arena.New<FuncFParamAST>();
+    ast->param_name = $2;
+    ast->ptr_size = arena.New<ArrSizeAST>();
     ast->is_ptr = true;
     $$ = ast;
   }
   | INT IDENT '[' ']' ArrSize {
-    auto ast = new FuncFParamAST();
-    ast->param_name = *unique_ptr<string>($2);
-    ast->ptr_size = unique_ptr<BaseAST>($5);
+    auto ast = arena.New<FuncFParamAST>();
+    ast->param_name = $2;
+    ast->ptr_size = $5;
     ast->is_ptr = true;
     $$ = ast;
   }
@@ -464,13 +464,12 @@ FuncFParam
 // Block     ::= "{" BlockList "}"
 Block
   : '{' BlockList '}' {
-    auto ast = new BlockAST();
+    auto ast = arena.New<BlockAST>();
 
     // 插入item
-    auto list = unique_ptr<BlockListUnit>(dynamic_cast<BlockListUnit*>($2));
+    auto list = dynamic_cast<BlockListUnit*>($2);
     for (auto it = list->block_items.rbegin(); it != list->block_items.rend(); ++it) {
-      auto ptr = *it;
-      ast->block_items.push_back(unique_ptr<BlockItemAST>(ptr));
+      ast->block_items.push_back(*it);
     }
     $$ = ast;
   }
@@ -483,7 +482,7 @@ BlockList
     $$ = $2;
   }
   | {
-    auto ast = new BlockListUnit();
+    auto ast = arena.New<BlockListUnit>();
     $$ = ast;
   }
   ;
@@ -491,15 +490,15 @@ BlockList
 // BlockItem     ::= Decl | Stmt
 BlockItem
   : Decl {
-    auto ast = new BlockItemAST();
+    auto ast = arena.New<BlockItemAST>();
     ast->bt = BlockItemAST::blocktype_t::decl;
-    ast->content = unique_ptr<BaseAST>($1);
+    ast->content = $1;
     $$ = ast;
   }
   | Stmt {
-    auto ast = new BlockItemAST();
+    auto ast = arena.New<BlockItemAST>();
     ast->bt = BlockItemAST::blocktype_t::stmt;
-    ast->content = unique_ptr<BaseAST>($1);
+    ast->content = $1;
     $$ = ast;
   }
   ;
@@ -507,15 +506,15 @@ BlockItem
 // Stmt            ::= OpenStmt | ClosedStmt
 Stmt
   : OpenStmt {
-    auto ast = new StmtAST();
+    auto ast = arena.New<StmtAST>();
     ast->type = StmtAST::stmty_t::open;
-    ast->stmt = unique_ptr<BaseAST>($1);
+    ast->stmt = $1;
     $$ = ast;
   }
   | ClosedStmt {
-    auto ast = new StmtAST();
+    auto ast = arena.New<StmtAST>();
     ast->type = StmtAST::stmty_t::closed;
-    ast->stmt = unique_ptr<BaseAST>($1);
+    ast->stmt = $1;
     $$ = ast;
   }
   ;
@@ -528,32 +527,32 @@ OpenStmt        ::= "if" "(" Exp ")" OpenStmt
 */
 OpenStmt
   : IF '(' Exp ')' OpenStmt {
-    auto ast = new OpenStmtAST();
+    auto ast = arena.New<OpenStmtAST>();
     ast->type = OpenStmtAST::opty_t::io;
-    ast->exp = unique_ptr<BaseAST>($3);
-    ast->open = unique_ptr<BaseAST>($5);
+    ast->exp = $3;
+    ast->open = $5;
     $$ = ast;
   }
   | IF '(' Exp ')' ClosedStmt {
-    auto ast = new OpenStmtAST();
+    auto ast = arena.New<OpenStmtAST>();
     ast->type = OpenStmtAST::opty_t::ic;
-    ast->exp = unique_ptr<BaseAST>($3);
-    ast->closed = unique_ptr<BaseAST>($5);
+    ast->exp = $3;
+    ast->closed = $5;
     $$ = ast;
   }
   | IF '(' Exp ')' ClosedStmt ELSE OpenStmt {
-    auto ast = new OpenStmtAST();
+    auto ast = arena.New<OpenStmtAST>();
     ast->type = OpenStmtAST::opty_t::iceo;
-    ast->exp = unique_ptr<BaseAST>($3);
-    ast->closed = unique_ptr<BaseAST>($5);
-    ast->open = unique_ptr<BaseAST>($7);
+    ast->exp = $3;
+    ast->closed = $5;
+    ast->open = $7;
     $$ = ast;
   }
   | WHILE '(' Exp ')' OpenStmt {
-    auto ast = new OpenStmtAST();
+    auto ast = arena.New<OpenStmtAST>();
     ast->type = OpenStmtAST::opty_t::loop;
-    ast->exp = unique_ptr<BaseAST>($3);
-    ast->open = unique_ptr<BaseAST>($5);
+    ast->exp = $3;
+    ast->open = $5;
     $$ = ast;
   }
   ;
@@ -565,24 +564,24 @@ ClosedStmt      ::= SimpleStmt
 */
 ClosedStmt
   : SimpleStmt {
-    auto ast = new ClosedStmtAST();
+    auto ast = arena.New<ClosedStmtAST>();
     ast->type = ClosedStmtAST::csty_t::simp;
-    ast->simple = unique_ptr<BaseAST>($1);
+    ast->simple = $1;
     $$ = ast;
   }
   | IF '(' Exp ')' ClosedStmt ELSE ClosedStmt {
-    auto ast = new ClosedStmtAST();
+    auto ast = arena.New<ClosedStmtAST>();
     ast->type = ClosedStmtAST::csty_t::icec;
-    ast->exp = unique_ptr<BaseAST>($3);
-    ast->tclosed = unique_ptr<BaseAST>($5);
-    ast->fclosed = unique_ptr<BaseAST>($7);
+    ast->exp = $3;
+    ast->tclosed = $5;
+    ast->fclosed = $7;
     $$ = ast;
   }
   | WHILE '(' Exp ')' ClosedStmt {
-    auto ast = new ClosedStmtAST();
+    auto ast = arena.New<ClosedStmtAST>();
     ast->type = ClosedStmtAST::csty_t::loop;
-    ast->exp = unique_ptr<BaseAST>($3);
-    ast->tclosed = unique_ptr<BaseAST>($5);
+    ast->exp = $3;
+    ast->tclosed = $5;
     $$ = ast;
   }
   ;
@@ -599,47 +598,47 @@ SimpleStmt      ::= LVal "=" Exp ";"
 */
 SimpleStmt
   : LVal '=' Exp ';' {
-    auto ast = new SimpleStmtAST();
+    auto ast = arena.New<SimpleStmtAST>();
     ast->st = SimpleStmtAST::sstmt_t::storelval;
-    ast->lval = unique_ptr<BaseAST>($1);
-    ast->exp = unique_ptr<BaseAST>($3);
+    ast->lval = $1;
+    ast->exp = $3;
     $$ = ast;
   }
   | Exp ';' {
-    auto ast = new SimpleStmtAST();
+    auto ast = arena.New<SimpleStmtAST>();
     ast->st = SimpleStmtAST::sstmt_t::expr;
-    ast->exp = unique_ptr<BaseAST>($1);
+    ast->exp = $1;
     $$ = ast;
   }
   | ';' {
-    auto ast = new SimpleStmtAST();
+    auto ast = arena.New<SimpleStmtAST>();
     ast->st = SimpleStmtAST::sstmt_t::nullexp;
     $$ = ast;
   }
   | Block {
-    auto ast = new SimpleStmtAST();
+    auto ast = arena.New<SimpleStmtAST>();
     ast->st = SimpleStmtAST::sstmt_t::block;
-    ast->blk = unique_ptr<BaseAST>($1);
+    ast->blk = $1;
     $$ = ast;
   } 
   | RETURN Exp ';' {
-    auto ast = new SimpleStmtAST();
+    auto ast = arena.New<SimpleStmtAST>();
     ast->st = SimpleStmtAST::sstmt_t::ret;
-    ast->exp = unique_ptr<BaseAST>($2);
+    ast->exp = $2;
     $$ = ast;
   }
   | RETURN ';' {
-    auto ast = new SimpleStmtAST();
+    auto ast = arena.New<SimpleStmtAST>();
     ast->st = SimpleStmtAST::sstmt_t::nullret;
     $$ = ast;
   }
   | CONTINUE ';' {
-    auto ast = new SimpleStmtAST();
+    auto ast = arena.New<SimpleStmtAST>();
     ast->st = SimpleStmtAST::sstmt_t::cont;
     $$ = ast;
   }
   | BREAK ';' {
-    auto ast = new SimpleStmtAST();
+    auto ast = arena.New<SimpleStmtAST>();
     ast->st = SimpleStmtAST::sstmt_t::brk;
     $$ = ast;
   }
@@ -648,8 +647,8 @@ SimpleStmt
 // Exp         ::= LOrExp;
 Exp
   : LOrExp {
-    auto ast = new ExpAST();
-    ast->loexp = unique_ptr<BaseAST>($1);
+    auto ast = arena.New<ExpAST>();
+    ast->loexp = $1;
     $$ = ast;
   }
   ;
@@ -658,12 +657,12 @@ Exp
 // ArrAddr         ::= "[" Exp "]" ArrAddrList
 ArrAddr
   : '[' Exp ']' ArrAddrList {
-    auto ast = new ArrAddrAST();
-    ast->arr_addr.push_back(unique_ptr<ExpAST>(dynamic_cast<ExpAST*>($2)));
-    auto list = unique_ptr<ArrAddrListUnit>(dynamic_cast<ArrAddrListUnit*>($4));
+    auto ast = arena.New<ArrAddrAST>();
+    ast->arr_addr.push_back(dynamic_cast<ExpAST*>($2));
+    auto list = dynamic_cast<ArrAddrListUnit*>($4);
     // 插入剩余
     for (auto it = list->addrs.rbegin(); it != list->addrs.rend(); ++it) {
-      ast->arr_addr.push_back(unique_ptr<ExpAST>(*it));
+      ast->arr_addr.push_back(*it);
     }
     $$ = ast;
   }
@@ -676,7 +675,7 @@ ArrAddrList
     $$ = $4;
   }
   | {
-    auto ast = new ArrAddrListUnit();
+    auto ast = arena.New<ArrAddrListUnit>();
     $$ = ast;
   }
   ;
@@ -684,16 +683,16 @@ ArrAddrList
 // LVal            ::= IDENT | IDENT ArrAddr
 LVal
   : IDENT {
-    auto ast = new LValAST();
+    auto ast = arena.New<LValAST>();
     ast->ty = LValAST::lval_t::e_noaddr;
-    ast->var_name = *unique_ptr<string>($1);
+    ast->var_name = $1;
     $$ = ast;
   }
   | IDENT ArrAddr {
-    auto ast = new LValAST();
+    auto ast = arena.New<LValAST>();
     ast->ty = LValAST::lval_t::e_withaddr;
-    ast->var_name = *unique_ptr<string>($1);
-    ast->arr_param = unique_ptr<BaseAST>($2);
+    ast->var_name = $1;
+    ast->arr_param = $2;
     $$ = ast;
   }
   ;
@@ -701,22 +700,22 @@ LVal
 // PrimaryExp    ::= "(" Exp ")" | LVal | Number
 PrimaryExp
   : '(' Exp ')' {
-    auto ast = new PrimaryExpAST();
+    auto ast = arena.New<PrimaryExpAST>();
     ast->pt = PrimaryExpAST::primary_exp_type_t::Brackets;
-    ast->content = unique_ptr<BaseAST>($2);
+    ast->content = $2;
     $$ = ast;
   }
   | LVal {
-    auto ast = new PrimaryExpAST();
+    auto ast = arena.New<PrimaryExpAST>();
     ast->pt = PrimaryExpAST::primary_exp_type_t::LVal;
-    ast->content = unique_ptr<BaseAST>($1);
+    ast->content = $1;
     $$ = ast;
   }
 
   | Number {
-    auto ast = new PrimaryExpAST();
+    auto ast = arena.New<PrimaryExpAST>();
     ast->pt = PrimaryExpAST::primary_exp_type_t::Number;
-    ast->content = unique_ptr<BaseAST>($1);
+    ast->content = $1;
     $$ = ast;
   }
   ;
@@ -724,7 +723,7 @@ PrimaryExp
 // Number      ::= INT_CONST
 Number
   : INT_CONST {
-    auto ast = new NumberAST();
+    auto ast = arena.New<NumberAST>();
     ast->int_const = $1;
     $$ = ast;
   }
@@ -740,43 +739,43 @@ UnaryExp        ::= PrimaryExp
 */
 UnaryExp
   : PrimaryExp {
-    auto ast = new UnaryExpAST();
+    auto ast = arena.New<UnaryExpAST>();
     ast->uex = UnaryExpAST::uex_t::Primary;
-    ast->exp = unique_ptr<BaseAST>($1);
+    ast->exp = $1;
     $$ = ast;
   }
   | '+' UnaryExp {
-    auto ast = new UnaryExpAST();
+    auto ast = arena.New<UnaryExpAST>();
     ast->uex = UnaryExpAST::uex_t::OPUnary;
     ast->uop = UnaryExpAST::uop_t::Pos;
-    ast->exp = unique_ptr<BaseAST>($2);
+    ast->exp = $2;
     $$ = ast;
   }
   | '-' UnaryExp {
-    auto ast = new UnaryExpAST();
+    auto ast = arena.New<UnaryExpAST>();
     ast->uex = UnaryExpAST::uex_t::OPUnary;
     ast->uop = UnaryExpAST::uop_t::Neg;
-    ast->exp = unique_ptr<BaseAST>($2);
+    ast->exp = $2;
     $$ = ast;
   }
   | '!' UnaryExp {
-    auto ast = new UnaryExpAST();
+    auto ast = arena.New<UnaryExpAST>();
     ast->uex = UnaryExpAST::uex_t::OPUnary;
     ast->uop = UnaryExpAST::uop_t::Not;
-    ast->exp = unique_ptr<BaseAST>($2);
+    ast->exp = $2;
     $$ = ast;
   }
   | IDENT '(' FuncRParams ')' {
-    auto ast = new UnaryExpAST();
+    auto ast = arena.New<UnaryExpAST>();
     ast->uex = UnaryExpAST::uex_t::FuncWithParam;
-    ast->func_name = *unique_ptr<string>($1);
-    ast->params = unique_ptr<BaseAST>($3);
+    ast->func_name = $1;
+    ast->params = $3;
     $$ = ast;
   }
   | IDENT '(' ')' {
-    auto ast = new UnaryExpAST();
+    auto ast = arena.New<UnaryExpAST>();
     ast->uex = UnaryExpAST::uex_t::FuncNoParam;
-    ast->func_name = *unique_ptr<string>($1);
+    ast->func_name = $1;
     $$ = ast;
   }
   ;
@@ -784,11 +783,11 @@ UnaryExp
 // FuncRParams     ::= Exp FuncRParamsList
 FuncRParams
   : Exp FuncRParamsList {
-    auto ast = new FuncRParamsAST();
-    ast->params.push_back(unique_ptr<ExpAST>(dynamic_cast<ExpAST*>($1)));
-    auto list = unique_ptr<FuncRParamsListUnit>(dynamic_cast<FuncRParamsListUnit*>($2));
+    auto ast = arena.New<FuncRParamsAST>();
+    ast->params.push_back(dynamic_cast<ExpAST*>($1));
+    auto list = dynamic_cast<FuncRParamsListUnit*>($2);
     for (auto it = list->params.rbegin(); it != list->params.rend(); ++it) {
-      ast->params.push_back(unique_ptr<ExpAST>(*it));
+      ast->params.push_back(*it);
     }
     $$ = ast;
   }
@@ -801,7 +800,7 @@ FuncRParamsList
     $$ = $3;
   }
   | {
-    auto ast = new FuncRParamsListUnit();
+    auto ast = arena.New<FuncRParamsListUnit>();
     $$ = ast;
   }
   ;
@@ -809,33 +808,33 @@ FuncRParamsList
 // MulExp      ::= UnaryExp | MulExp ("*" | "/" | "%") UnaryExp;
 MulExp
   : UnaryExp {
-    auto ast = new MulExpAST();
+    auto ast = arena.New<MulExpAST>();
     ast->mex = MulExpAST::mex_t::Unary;
-    ast->uexp = unique_ptr<BaseAST>($1);
+    ast->uexp = $1;
     $$ = ast;
   }
   | MulExp '*' UnaryExp {
-    auto ast = new MulExpAST();
+    auto ast = arena.New<MulExpAST>();
     ast->mex = MulExpAST::mex_t::MulOPUnary;
     ast->mop = MulExpAST::mop_t::Mul;
-    ast->mexp = unique_ptr<BaseAST>($1);
-    ast->uexp = unique_ptr<BaseAST>($3);
+    ast->mexp = $1;
+    ast->uexp = $3;
     $$ = ast;
   }
   | MulExp '/' UnaryExp {
-    auto ast = new MulExpAST();
+    auto ast = arena.New<MulExpAST>();
     ast->mex = MulExpAST::mex_t::MulOPUnary;
     ast->mop = MulExpAST::mop_t::Div;
-    ast->mexp = unique_ptr<BaseAST>($1);
-    ast->uexp = unique_ptr<BaseAST>($3);
+    ast->mexp = $1;
+    ast->uexp = $3;
     $$ = ast;
   }
   | MulExp '%' UnaryExp {
-    auto ast = new MulExpAST();
+    auto ast = arena.New<MulExpAST>();
     ast->mex = MulExpAST::mex_t::MulOPUnary;
     ast->mop = MulExpAST::mop_t::Mod;
-    ast->mexp = unique_ptr<BaseAST>($1);
-    ast->uexp = unique_ptr<BaseAST>($3);
+    ast->mexp = $1;
+    ast->uexp = $3;
     $$ = ast;
   }
   ;
@@ -843,25 +842,25 @@ MulExp
 // AddExp      ::= MulExp | AddExp ("+" | "-") MulExp;
 AddExp
   : MulExp {
-    auto ast = new AddExpAST();
+    auto ast = arena.New<AddExpAST>();
     ast->aex = AddExpAST::aex_t::MulExp;
-    ast->mexp = unique_ptr<BaseAST>($1);
+    ast->mexp = $1;
     $$ = ast;
   }
   | AddExp '+' MulExp {
-    auto ast = new AddExpAST();
+    auto ast = arena.New<AddExpAST>();
     ast->aex = AddExpAST::aex_t::AddOPMul;
     ast->aop = AddExpAST::aop_t::Add;
-    ast->aexp = unique_ptr<BaseAST>($1);
-    ast->mexp = unique_ptr<BaseAST>($3);
+    ast->aexp = $1;
+    ast->mexp = $3;
     $$ = ast;
   }
   | AddExp '-' MulExp {
-    auto ast = new AddExpAST();
+    auto ast = arena.New<AddExpAST>();
     ast->aex = AddExpAST::aex_t::AddOPMul;
     ast->aop = AddExpAST::aop_t::Sub;
-    ast->aexp = unique_ptr<BaseAST>($1);
-    ast->mexp = unique_ptr<BaseAST>($3);
+    ast->aexp = $1;
+    ast->mexp = $3;
     $$ = ast;
   }
   ;
@@ -869,41 +868,41 @@ AddExp
 // RelExp      ::= AddExp | RelExp ("<" | ">" | "<=" | ">=") AddExp;
 RelExp
   : AddExp {
-    auto ast = new RelExpAST();
+    auto ast = arena.New<RelExpAST>();
     ast->rex = RelExpAST::rex_t::AddExp;
-    ast->aexp = unique_ptr<BaseAST>($1);
+    ast->aexp = $1;
     $$ = ast;
   }
   | RelExp OPLT AddExp {
-    auto ast = new RelExpAST();
+    auto ast = arena.New<RelExpAST>();
     ast->rex = RelExpAST::rex_t::RelOPAdd;
     ast->rop = RelExpAST::rop_t::LessThan;
-    ast->rexp = unique_ptr<BaseAST>($1);
-    ast->aexp = unique_ptr<BaseAST>($3);
+    ast->rexp = $1;
+    ast->aexp = $3;
     $$ = ast;
   }
   | RelExp OPLE AddExp {
-    auto ast = new RelExpAST();
+    auto ast = arena.New<RelExpAST>();
     ast->rex = RelExpAST::rex_t::RelOPAdd;
     ast->rop = RelExpAST::rop_t::LessEqual;
-    ast->rexp = unique_ptr<BaseAST>($1);
-    ast->aexp = unique_ptr<BaseAST>($3);
+    ast->rexp = $1;
+    ast->aexp = $3;
     $$ = ast;
   }
   | RelExp OPGT AddExp {
-    auto ast = new RelExpAST();
+    auto ast = arena.New<RelExpAST>();
     ast->rex = RelExpAST::rex_t::RelOPAdd;
     ast->rop = RelExpAST::rop_t::GreaterThan;
-    ast->rexp = unique_ptr<BaseAST>($1);
-    ast->aexp = unique_ptr<BaseAST>($3);
+    ast->rexp = $1;
+    ast->aexp = $3;
     $$ = ast;
   }
   | RelExp OPGE AddExp {
-    auto ast = new RelExpAST();
+    auto ast = arena.New<RelExpAST>();
     ast->rex = RelExpAST::rex_t::RelOPAdd;
     ast->rop = RelExpAST::rop_t::GreaterEqual;
-    ast->rexp = unique_ptr<BaseAST>($1);
-    ast->aexp = unique_ptr<BaseAST>($3);
+    ast->rexp = $1;
+    ast->aexp = $3;
     $$ = ast;
   }
   ;
@@ -911,25 +910,25 @@ RelExp
 // EqExp       ::= RelExp | EqExp ("==" | "!=") RelExp;
 EqExp
   : RelExp {
-    auto ast = new EqExpAST();
+    auto ast = arena.New<EqExpAST>();
     ast->eex = EqExpAST::eex_t::RelExp;
-    ast->rexp = unique_ptr<BaseAST>($1);
+    ast->rexp = $1;
     $$ = ast;
   }
   | EqExp OPEQ RelExp {
-    auto ast = new EqExpAST();
+    auto ast = arena.New<EqExpAST>();
     ast->eex = EqExpAST::eex_t::EqOPRel;
     ast->eop = EqExpAST::eop_t::Equal;
-    ast->eexp = unique_ptr<BaseAST>($1);
-    ast->rexp = unique_ptr<BaseAST>($3);
+    ast->eexp = $1;
+    ast->rexp = $3;
     $$ = ast;
   }
   | EqExp OPNE RelExp {
-    auto ast = new EqExpAST();
+    auto ast = arena.New<EqExpAST>();
     ast->eex = EqExpAST::eex_t::EqOPRel;
     ast->eop = EqExpAST::eop_t::NotEqual;
-    ast->eexp = unique_ptr<BaseAST>($1);
-    ast->rexp = unique_ptr<BaseAST>($3);
+    ast->eexp = $1;
+    ast->rexp = $3;
     $$ = ast;
   }
   ;
@@ -937,16 +936,16 @@ EqExp
 // LAndExp     ::= EqExp | LAndExp "&&" EqExp;
 LAndExp
   : EqExp {
-    auto ast = new LAndExpAST();
+    auto ast = arena.New<LAndExpAST>();
     ast->laex = LAndExpAST::laex_t::EqExp;
-    ast->eexp = unique_ptr<BaseAST>($1);
+    ast->eexp = $1;
     $$ = ast;
   }
   | LAndExp OPAND EqExp {
-    auto ast = new LAndExpAST();
+    auto ast = arena.New<LAndExpAST>();
     ast->laex = LAndExpAST::laex_t::LAOPEq;
-    ast->laexp = unique_ptr<BaseAST>($1);
-    ast->eexp = unique_ptr<BaseAST>($3);
+    ast->laexp = $1;
+    ast->eexp = $3;
     $$ = ast;
   }
   ;
@@ -954,16 +953,16 @@ LAndExp
 // LOrExp      ::= LAndExp | LOrExp "||" LAndExp;
 LOrExp
   : LAndExp {
-    auto ast = new LOrExpAST();
+    auto ast = arena.New<LOrExpAST>();
     ast->loex = LOrExpAST::loex_t::LAndExp;
-    ast->laexp = unique_ptr<BaseAST>($1);
+    ast->laexp = $1;
     $$ = ast;
   }
   | LOrExp OPOR LAndExp {
-    auto ast = new LOrExpAST();
+    auto ast = arena.New<LOrExpAST>();
     ast->loex = LOrExpAST::loex_t::LOOPLA;
-    ast->loexp = unique_ptr<BaseAST>($1);
-    ast->laexp = unique_ptr<BaseAST>($3);
+    ast->loexp = $1;
+    ast->laexp = $3;
     $$ = ast;
   }
   ;
@@ -971,8 +970,8 @@ LOrExp
 // ConstExp      ::= Exp;
 ConstExp
   : Exp {
-    auto ast = new ConstExpAST();
-    ast->exp = unique_ptr<BaseAST>($1);
+    auto ast = arena.New<ConstExpAST>();
+    ast->exp = $1;
     $$ = ast;
   }
   ;
@@ -981,6 +980,6 @@ ConstExp
 
 // 定义错误处理函数, 其中第二个参数是错误信息
 // parser 如果发生错误 (例如输入的程序出现了语法错误), 就会调用这个函数
-void yyerror(unique_ptr<BaseAST> &ast, const char *s) {
+void yyerror(BaseAST *&ast, ir::ASTArena &arena, const char *s) {
   cerr << "error: " << s << " at line " << yylineno << endl;
 }
@@ -0,0 +1,41 @@
+#include "ir_arena.h"
+
+namespace ir {
+
+ASTArena::ASTArena() : chunks(), cur(nullptr), left(0), dtors() {}
+
+ASTArena::~ASTArena() {
+  Clear();
+}
+
+void ASTArena::Clear() {
+  // 后构造的先析构
+  for (auto it = dtors.rbegin(); it != dtors.rend(); ++it) {
+    it->second(it->first);
+  }
+  dtors.clear();
+  for (char* chunk : chunks) {
+    ::operator delete(chunk);
+  }
+  chunks.clear();
+  cur = nullptr;
+  left = 0;
+}
+
+void* ASTArena::Allocate(size_t size, size_t align) {
+  size_t pad = (align - reinterpret_cast<size_t>(cur) % align) % align;
+  if (cur == nullptr || pad + size > left) {
+    // 放不下就开新块，特别大的节点单独占一块
+    size_t chunk_size = size + align > CHUNK_SIZE ? size + align : CHUNK_SIZE;
+    cur = static_cast<char*>(::operator new(chunk_size));
+    chunks.push_back(cur);
+    left = chunk_size;
+    pad = (align - reinterpret_cast<size_t>(cur) % align) % align;
+  }
+  void* ret = cur + pad;
+  cur += pad + size;
+  left -= pad + size;
+  return ret;
+}
+
+}  // namespace ir
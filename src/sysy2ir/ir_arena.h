@@ -0,0 +1,47 @@
+#pragma once
+
+#include <cstddef>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace ir {
+
+// 语法树节点的内存池
+// 节点从大块内存中顺序切出，析构时一次性释放，节点之间用裸指针相连
+class ASTArena {
+ public:
+  ASTArena();
+  ~ASTArena();
+  ASTArena(const ASTArena&) = delete;
+  ASTArena& operator=(const ASTArena&) = delete;
+
+  // 在池中构造一个节点
+  template <typename T, typename... Args>
+  T* New(Args&&... args) {
+    void* mem = Allocate(sizeof(T), alignof(T));
+    T* node = new (mem) T(std::forward<Args>(args)...);
+    // 节点里的string、vector还需要析构
+    if constexpr (!std::is_trivially_destructible_v<T>) {
+      dtors.emplace_back(node, [](void* p) { static_cast<T*>(p)->~T(); });
+    }
+    return node;
+  }
+
+  // 析构所有节点并归还内存
+  void Clear();
+
+ private:
+  static const size_t CHUNK_SIZE = 64 * 1024;
+
+  std::vector<char*> chunks;
+  // 当前块中下一个可用的位置和剩余大小
+  char* cur;
+  size_t left;
+  std::vector<std::pair<void*, void (*)(void*)>> dtors;
+
+  void* Allocate(size_t size, size_t align);
+};
+
+}  // namespace ir
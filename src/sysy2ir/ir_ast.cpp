@@ -1,4 +1,8 @@
 #include "ir_ast.h"
+#include <algorithm>
+#include <atomic>
+#include <mutex>
+#include <thread>
 #include "ir_util.h"
 using namespace ir;
 
@@ -14,6 +18,37 @@ void CompRootAST::Print(ostream& os, int indent) const {
   os << "}," << endl;
 }
 
+// 多线程生成函数体，函数都已经声明过
+// 每个线程从主线程的生成器复制全局符号表和函数表，生成完把内存交给主线程
+static void DefineFuncsParallel(const vector<FuncDefAST*>& funcs,
+                                const int& jobs) {
+  auto& main_gen = IRGenerator::getInstance();
+  std::atomic<size_t> next(0);
+  std::mutex adopt_lock;
+  auto worker = [&]() {
+    auto& gen = IRGenerator::getInstance();
+    gen.ForkFrom(main_gen);
+    for (size_t i = next++; i < funcs.size(); i = next++) {
+      funcs[i]->Define();
+      gen.funcCore.Reset();
+      gen.branchCore.Reset();
+    }
+    // 线程退出时生成器会被析构
+    std::lock_guard<std::mutex> guard(adopt_lock);
+    main_gen.rawCore.Adopt(gen.rawCore);
+  };
+
+  // 主线程的生成器在此期间只读，所以主线程不参与
+  size_t threads = std::min(funcs.size(), (size_t)jobs);
+  vector<std::thread> pool;
+  for (size_t t = 0; t < threads; ++t) {
+    pool.emplace_back(worker);
+  }
+  for (auto& thread : pool) {
+    thread.join();
+  }
+}
+
 void CompRootAST::Dump() {
   auto& gen = IRGenerator::getInstance();
   gen.WriteLibFuncDecl();
@@ -26,15 +61,33 @@ void CompRootAST::Dump() {
     }
   }
   gen.symbolCore.dproc.global = false;
-  gen.setting.getOs() << endl;
+  gen.symbolCore.dproc.MarkLocalBase();
+  gen.FlushUnit();
 
+  vector<FuncDefAST*> funcs;
   for (auto it = comp_units.begin(); it != comp_units.end(); it++) {
     if ((*it)->ty == CompUnitAST::e_func_def) {
-      (*it)->Dump();
+      funcs.push_back(static_cast<FuncDefAST*>((*it)->content));
+    }
+  }
+
+  // 流式生成要逐个函数交给后端
+  if (gen.unit_handler || gen.jobs <= 1 || funcs.size() <= 1) {
+    for (auto func : funcs) {
+      func->Dump();
       gen.funcCore.Reset();
       gen.branchCore.Reset();
+      gen.FlushUnit();
     }
+    return;
+  }
+
+  // 合法的程序只会调用前面定义的函数，先全部声明不影响结果
+  for (auto func : funcs) {
+    func->Declare();
+    gen.funcCore.Reset();
   }
+  DefineFuncsParallel(funcs, gen.jobs);
 }
 
 #pragma endregion
@@ -149,7 +202,7 @@ void ConstDefAST::Print(ostream& os, int indent) const {
   make_indent(os, indent);
   os << "ConstDefAST: {" << endl;
   make_indent(os, indent + 1);
-  os << "var_name: " << var_name << endl;
+  os << "var_name: " << SymbolName(var_name) << endl;
   make_indent(os, indent + 1);
   os << "ty: " << (ty == e_int ? "int" : "array") << endl;
   if (ty == e_arr) {
@@ -167,7 +220,7 @@ void ConstDefAST::Dump() {
   if (ty == e_int) {
     // 计算常数表达式
     const_init_val->Dump();
-    auto ptr = dynamic_cast<ConstInitValAST*>(const_init_val.get());
+    auto ptr = dynamic_cast<ConstInitValAST*>(const_init_val);
 
     // 取值加入符号表
     auto entry = pcs.GenerateConstEntry(var_name, ptr->thisRet.GetValue());
@@ -177,7 +230,7 @@ void ConstDefAST::Dump() {
   else if (ty == e_arr) {
     // arr
     arr_size->Dump();
-    auto& size = dynamic_cast<ArrSizeAST*>(arr_size.get())->size_value;
+    auto& size = dynamic_cast<ArrSizeAST*>(arr_size)->size_value;
 
     ArrInfo info(size);
 
@@ -212,7 +265,7 @@ void ConstInitValAST::Print(ostream& os, int indent) const {
 
 void ConstInitValAST::Dump() {
   const_exp->Dump();
-  auto ce = dynamic_cast<ConstExpAST*>(const_exp.get());
+  auto ce = dynamic_cast<ConstExpAST*>(const_exp);
   thisRet = ce->thisRet;
 }
 
@@ -261,7 +314,7 @@ void VarDefAST::Print(ostream& os, int indent) const {
   make_indent(os, indent);
   os << "VarDefAST: {" << endl;
   make_indent(os, indent + 1);
-  os << "var_name: " << var_name << endl;
+  os << "var_name: " << SymbolName(var_name) << endl;
   make_indent(os, indent + 1);
   os << "ty: " << (ty == e_int ? "int" : "array") << endl;
   if (ty == e_arr) {
@@ -288,7 +341,7 @@ void VarDefAST::Dump() {
     RetInfo init;
     if (init_with_val) {
       init_val->Dump();
-      auto iv = dynamic_cast<InitValAST*>(init_val.get());
+      auto iv = dynamic_cast<InitValAST*>(init_val);
       init = iv->thisRet;
     }
     if (pcs.global) {
@@ -305,7 +358,7 @@ void VarDefAST::Dump() {
   } else if (ty == e_arr) {
     // arr
     arr_size->Dump();
-    auto& size = dynamic_cast<ArrSizeAST*>(arr_size.get())->size_value;
+    auto& size = dynamic_cast<ArrSizeAST*>(arr_size)->size_value;
     ArrInfo info(size);
 
     // 取值加入符号表
@@ -347,7 +400,7 @@ void InitValAST::Print(ostream& os, int indent) const {
 
 void InitValAST::Dump() {
   exp->Dump();
-  auto ae = dynamic_cast<ExpAST*>(exp.get());
+  auto ae = dynamic_cast<ExpAST*>(exp);
   thisRet = ae->thisRet;
 }
 
@@ -368,9 +421,11 @@ void ArrSizeAST::Print(ostream& os, int indent) const {
 }
 
 void ArrSizeAST::Dump() {
+  // 函数参数的维度在声明和定义时各算一次
+  size_value.clear();
   for (int i = 0; i < arr_size.size(); i++) {
     arr_size[i]->Dump();
-    auto ptr = dynamic_cast<ConstExpAST*>(arr_size[i].get());
+    auto ptr = dynamic_cast<ConstExpAST*>(arr_size[i]);
     size_value.push_back(ptr->thisRet.GetValue());
   }
 }
@@ -406,7 +461,7 @@ void CAElementAST::Dump() {
   auto& arrinit = gen.arrinitCore;
   if (ty == e_cexp) {
     content->Dump();
-    auto ptr = dynamic_cast<ConstExpAST*>(content.get());
+    auto ptr = dynamic_cast<ConstExpAST*>(content);
     arrinit.PushInfo(ptr->thisRet);
   } else if (ty == e_carr) {
     content->Dump();
@@ -489,7 +544,7 @@ void AIElementAST::Dump() {
   auto& arrinit = gen.arrinitCore;
   if (ty == e_exp) {
     content->Dump();
-    auto ptr = dynamic_cast<ExpAST*>(content.get());
+    auto ptr = dynamic_cast<ExpAST*>(content);
     arrinit.PushInfo(ptr->thisRet);
   } else if (ty == e_arr) {
     content->Dump();
@@ -562,7 +617,7 @@ void FuncDefAST::Print(ostream& os, int indent) const {
   os << "FuncDefAST {" << endl;
   func_type->Print(os, indent + 1);
   make_indent(os, indent + 1);
-  os << "func name: \"" << func_name << "\"," << endl;
+  os << "func name: \"" << SymbolName(func_name) << "\"," << endl;
   params->Print(os, indent + 1);
   block->Print(os, indent + 1);
   make_indent(os, indent);
@@ -570,15 +625,21 @@ void FuncDefAST::Print(ostream& os, int indent) const {
 }
 
 void FuncDefAST::Dump() {
-  IRGenerator& gen = IRGenerator::getInstance();
-  // 记录函数类型和参数
-  gen.symbolCore.dproc.Enable();
-  func_type->Dump();
-  gen.funcCore.ret_ty = gen.symbolCore.dproc.getCurVarType();
-  params->Dump();
-  gen.symbolCore.dproc.Disable();
+  Declare();
+  IRGenerator::getInstance().funcCore.Reset();
+  Define();
+}
 
-  gen.funcCore.func_name = func_name;
+void FuncDefAST::Declare() {
+  DumpSignature();
+  IRGenerator::getInstance().WriteFuncDecl();
+}
+
+void FuncDefAST::Define() {
+  IRGenerator& gen = IRGenerator::getInstance();
+  // 参数也是局部变量，重新按本函数的起点编号
+  gen.symbolCore.dproc.ResetVarPool();
+  DumpSignature();
 
   gen.symbolCore.PushScope();
   gen.WriteFuncPrologue();
@@ -592,6 +653,17 @@ void FuncDefAST::Dump() {
   gen.WriteFuncEpilogue();
 }
 
+void FuncDefAST::DumpSignature() {
+  IRGenerator& gen = IRGenerator::getInstance();
+  gen.symbolCore.dproc.Enable();
+  func_type->Dump();
+  gen.funcCore.ret_ty = gen.symbolCore.dproc.getCurVarType();
+  params->Dump();
+  gen.symbolCore.dproc.Disable();
+
+  gen.funcCore.func_name = SymbolName(func_name);
+}
+
 #pragma endregion
 
 #pragma region FuncFParams
@@ -632,7 +704,7 @@ void FuncFParamAST::Print(ostream& os, int indent) const {
   make_indent(os, indent);
   os << "FuncFParamAST {" << endl;
   make_indent(os, indent + 1);
-  os << "param name: " << param_name << endl;
+  os << "param name: " << SymbolName(param_name) << endl;
   make_indent(os, indent + 1);
   os << "is pointer: " << (is_ptr ? "true" : "false") << endl;
   if (is_ptr) {
@@ -649,7 +721,7 @@ void FuncFParamAST::Dump() {
   auto& pcs = gen.symbolCore.dproc;
   if (is_ptr) {
     ptr_size->Dump();
-    auto size(dynamic_cast<ArrSizeAST*>(ptr_size.get())->size_value);
+    auto size(dynamic_cast<ArrSizeAST*>(ptr_size)->size_value);
 
     // 数组开头先拍一个1
     size.insert(size.begin(), 0);
@@ -781,16 +853,15 @@ void OpenStmtAST::Print(ostream& os, int indent) const {
 void OpenStmtAST::Dump() {
   IRGenerator& gen = IRGenerator::getInstance();
 
-  exp->Dump();
-  auto cond = dynamic_cast<ExpAST*>(exp.get());
-  RetInfo ret = cond->thisRet;
+  auto cond = dynamic_cast<ExpAST*>(exp);
   IfInfo ifin;
 
   switch (type) {
     case io:
     case ic:
       ifin = IfInfo(IfInfo::ifty_t::i);
-      gen.WriteBrInst(ret, ifin);
+      gen.InitIfInfo(ifin);
+      cond->DumpCond(ifin.then_label, ifin.next_label);
       gen.WriteLabel(ifin.then_label);
       if (type == io) {
         open->Dump();
@@ -805,7 +876,8 @@ void OpenStmtAST::Dump() {
 
     case iceo: {
       ifin = IfInfo(IfInfo::ifty_t::ie);
-      gen.WriteBrInst(ret, ifin);
+      gen.InitIfInfo(ifin);
+      cond->DumpCond(ifin.then_label, ifin.else_label);
 
       gen.WriteLabel(ifin.then_label);
       closed->Dump();
@@ -833,10 +905,7 @@ void OpenStmtAST::Dump() {
       gen.WriteJumpInst(loopInfo.cond_label);
 
       gen.WriteLabel(loopInfo.cond_label);
-      exp->Dump();
-      auto cond = dynamic_cast<ExpAST*>(exp.get());
-      RetInfo ret = cond->thisRet;
-      gen.WriteBrInst(ret, loopInfo);
+      cond->DumpCond(loopInfo.body_label, loopInfo.next_label);
       gen.branchCore.PushInfo(loopInfo);
 
       gen.WriteLabel(loopInfo.body_label);
@@ -896,11 +965,10 @@ void ClosedStmtAST::Dump() {
       break;
 
     case icec: {
-      exp->Dump();
-      auto cond = dynamic_cast<ExpAST*>(exp.get());
-      RetInfo ret = cond->thisRet;
+      auto cond = dynamic_cast<ExpAST*>(exp);
       IfInfo ifin(IfInfo::ifty_t::ie);
-      gen.WriteBrInst(ret, ifin);
+      gen.InitIfInfo(ifin);
+      cond->DumpCond(ifin.then_label, ifin.else_label);
 
       gen.WriteLabel(ifin.then_label);
       tclosed->Dump();
@@ -928,10 +996,8 @@ void ClosedStmtAST::Dump() {
       gen.WriteJumpInst(loopInfo.cond_label);
 
       gen.WriteLabel(loopInfo.cond_label);
-      exp->Dump();
-      auto cond = dynamic_cast<ExpAST*>(exp.get());
-      RetInfo ret = cond->thisRet;
-      gen.WriteBrInst(ret, loopInfo);
+      auto cond = dynamic_cast<ExpAST*>(exp);
+      cond->DumpCond(loopInfo.body_label, loopInfo.next_label);
       gen.branchCore.PushInfo(loopInfo);
 
       gen.WriteLabel(loopInfo.body_label);
@@ -1003,7 +1069,7 @@ void SimpleStmtAST::Dump() {
 
       // 计算表达式
       exp->Dump();
-      auto ee = dynamic_cast<ExpAST*>(exp.get());
+      auto ee = dynamic_cast<ExpAST*>(exp);
 
       // 赋值
       aproc.WriteAssign(ee->thisRet);
@@ -1011,7 +1077,7 @@ void SimpleStmtAST::Dump() {
 
     case sstmt_t::ret: {
       exp->Dump();
-      auto ee = dynamic_cast<ExpAST*>(exp.get());
+      auto ee = dynamic_cast<ExpAST*>(exp);
       // 设置返回值
       gen.funcCore.ret_info = ee->thisRet;
       gen.WriteRetInst();
@@ -1072,10 +1138,14 @@ void ExpAST::Print(ostream& os, int indent) const {
 
 void ExpAST::Dump() {
   loexp->Dump();
-  auto le = dynamic_cast<LOrExpAST*>(loexp.get());
+  auto le = dynamic_cast<LOrExpAST*>(loexp);
   thisRet = le->thisRet;
 }
 
+void ExpAST::DumpCond(const int& trueLabel, const int& falseLabel) {
+  dynamic_cast<LOrExpAST*>(loexp)->DumpCond(trueLabel, falseLabel);
+}
+
 #pragma endregion
 
 #pragma region ArrAddr
@@ -1095,8 +1165,8 @@ void ArrAddrAST::Print(ostream& os, int indent) const {
 void ArrAddrAST::Dump() {
   for (int i = 0; i < arr_addr.size(); i++) {
     arr_addr[i]->Dump();
-    auto ptr = dynamic_cast<ExpAST*>(arr_addr[i].get());
-    addr_value.push_back(ptr->thisRet.GetInfo());
+    auto ptr = dynamic_cast<ExpAST*>(arr_addr[i]);
+    addr_value.push_back(ptr->thisRet);
   }
 }
 
@@ -1120,7 +1190,7 @@ void LValAST::Print(ostream& os, int indent) const {
   make_indent(os, indent);
   os << "LValAST {" << endl;
   make_indent(os, indent + 1);
-  os << "var name: " << var_name << endl;
+  os << "var name: " << SymbolName(var_name) << endl;
   make_indent(os, indent + 1);
   os << "ty: " << (ty == e_noaddr ? "no addr" : "with addr") << endl;
   if (ty == e_withaddr) {
@@ -1135,7 +1205,7 @@ void LValAST::Print(ostream& os, int indent) const {
 void LValAST::Dump() {
   auto& gen = IRGenerator::getInstance();
   auto& aproc = gen.symbolCore.aproc;
-  SymbolTableEntry entry = gen.symbolCore.getEntry(var_name);
+  const SymbolTableEntry& entry = gen.symbolCore.getEntry(var_name);
   // 判断变量类型
 
   // 是否将被赋值，是否是左值。
@@ -1151,7 +1221,7 @@ void LValAST::Dump() {
       // var int
       if (is_assigning) {
         // 左值，设置aproc处理当前符号
-        aproc.current_var = entry;
+        aproc.current_var = &entry;
         aproc.Disable();
       } else {
         // 右值，获取其临时符号
@@ -1169,12 +1239,12 @@ void LValAST::Dump() {
     if (is_assigning) {
       // 左值，设置aproc处理当前符号
       // 地址一定够长
-      aproc.current_var = entry;
+      aproc.current_var = &entry;
       aproc.Disable();
 
       // 解析数组参数
       arr_param->Dump();
-      auto ptr = dynamic_cast<ArrAddrAST*>(arr_param.get());
+      auto ptr = dynamic_cast<ArrAddrAST*>(arr_param);
       const auto addr = ptr->addr_value;
       aproc.arr_addr = addr;
     } else {
@@ -1185,7 +1255,7 @@ void LValAST::Dump() {
       vector<RetInfo> addr;
       if (ty == e_withaddr) {
         arr_param->Dump();
-        auto ptr = dynamic_cast<ArrAddrAST*>(arr_param.get());
+        auto ptr = dynamic_cast<ArrAddrAST*>(arr_param);
         addr = ptr->addr_value;
 
         // 数组，地址足够长，就从数组中load值作为thisRet
@@ -1195,21 +1265,21 @@ void LValAST::Dump() {
         }
         // 不够长，退化成指针
         addr.push_back(RetInfo(0));
-        thisRet = gen.WriteGetPtrFromArr(entry.GetAllocName(), addr);
+        thisRet = gen.WriteGetPtrFromArr(entry.GetAllocValue(), addr);
       } else
         // 没有地址，退化成指针
         addr.push_back(RetInfo(0));
-      thisRet = gen.WriteGetPtrFromArr(entry.GetAllocName(), addr);
+      thisRet = gen.WriteGetPtrFromArr(entry.GetAllocValue(), addr);
     }
 
   } else if (entry.var_type == VarType::e_ptr) {
     // ptr
 
-    auto ptr = dynamic_cast<ArrAddrAST*>(arr_param.get());
+    auto ptr = dynamic_cast<ArrAddrAST*>(arr_param);
 
     if (is_assigning) {
       // 左值，设置aproc处理当前符号
-      aproc.current_var = entry;
+      aproc.current_var = &entry;
       aproc.Disable();
 
       // 解析指针参数
@@ -1223,7 +1293,7 @@ void LValAST::Dump() {
       vector<RetInfo> addr;
       if (ty == e_withaddr) {
         arr_param->Dump();
-        auto ptr = dynamic_cast<ArrAddrAST*>(arr_param.get());
+        auto ptr = dynamic_cast<ArrAddrAST*>(arr_param);
         addr = ptr->addr_value;
 
         // 数组，地址足够长，就从数组中load值作为thisRet
@@ -1233,11 +1303,11 @@ void LValAST::Dump() {
         }
         // 不够长，退化成指针
         addr.push_back(RetInfo(0));
-        thisRet = gen.WriteGetPtrFromPtr(entry.GetAllocName(), addr);
+        thisRet = gen.WriteGetPtrFromPtr(entry.GetAllocValue(), addr);
       } else
         // 没有地址，退化成指针
         addr.push_back(RetInfo(0));
-      thisRet = gen.WriteGetPtrFromPtr(entry.GetAllocName(), addr);
+      thisRet = gen.WriteGetPtrFromPtr(entry.GetAllocValue(), addr);
     }
   }
 }
@@ -1261,16 +1331,16 @@ void PrimaryExpAST::Dump() {
 
   switch (pt) {
     case primary_exp_type_t::Brackets: {
-      auto ee = dynamic_cast<ExpAST*>(content.get());
+      auto ee = dynamic_cast<ExpAST*>(content);
       thisRet = ee->thisRet;
     } break;
     case primary_exp_type_t::LVal: {
       // 右值
-      auto lv = dynamic_cast<LValAST*>(content.get());
+      auto lv = dynamic_cast<LValAST*>(content);
       thisRet = lv->thisRet;
     } break;
     case primary_exp_type_t::Number: {
-      auto nb = dynamic_cast<NumberAST*>(content.get());
+      auto nb = dynamic_cast<NumberAST*>(content);
       thisRet = RetInfo(nb->int_const);
     } break;
 
@@ -1327,12 +1397,12 @@ void UnaryExpAST::Print(ostream& os, int indent) const {
   } else if (uex == uex_t::FuncWithParam) {
     os << "Func" << endl;
     make_indent(os, indent + 1);
-    os << "Func name: " << func_name << endl;
+    os << "Func name: " << SymbolName(func_name) << endl;
     params->Print(os, indent + 1);
   } else if (uex == uex_t::FuncNoParam) {
     os << "Func" << endl;
     make_indent(os, indent + 1);
-    os << "Func name: " << func_name << endl;
+    os << "Func name: " << SymbolName(func_name) << endl;
   }
 
   make_indent(os, indent);
@@ -1345,12 +1415,12 @@ void UnaryExpAST::Dump() {
   switch (uex) {
     case uex_t::Primary: {
       exp->Dump();
-      auto pr = dynamic_cast<PrimaryExpAST*>(exp.get());
+      auto pr = dynamic_cast<PrimaryExpAST*>(exp);
       thisRet = pr->thisRet;
     } break;
     case uex_t::OPUnary: {
       exp->Dump();
-      auto ex = dynamic_cast<UnaryExpAST*>(exp.get());
+      auto ex = dynamic_cast<UnaryExpAST*>(exp);
       switch (uop) {
         case uop_t::Pos:
           thisRet = ex->thisRet;
@@ -1365,12 +1435,12 @@ void UnaryExpAST::Dump() {
     } break;
     case uex_t::FuncWithParam: {
       params->Dump();
-      auto ptr = dynamic_cast<FuncRParamsAST*>(params.get());
-      thisRet = gen.WriteCallInst(func_name, ptr->GetParams());
+      auto ptr = dynamic_cast<FuncRParamsAST*>(params);
+      thisRet = gen.WriteCallInst(SymbolName(func_name), ptr->GetParams());
     } break;
     case uex_t::FuncNoParam:
     default:
-      thisRet = gen.WriteCallInst(func_name, vector<RetInfo>());
+      thisRet = gen.WriteCallInst(SymbolName(func_name), vector<RetInfo>());
       break;
       ;
   }
@@ -1442,8 +1512,8 @@ void MulExpAST::Dump() {
     mexp->Dump();
     uexp->Dump();
 
-    auto me = dynamic_cast<MulExpAST*>(mexp.get());
-    auto ue = dynamic_cast<UnaryExpAST*>(uexp.get());
+    auto me = dynamic_cast<MulExpAST*>(mexp);
+    auto ue = dynamic_cast<UnaryExpAST*>(uexp);
 
     IRGenerator& gen = IRGenerator::getInstance();
     switch (mop) {
@@ -1461,7 +1531,7 @@ void MulExpAST::Dump() {
     }
   } else {
     uexp->Dump();
-    auto ue = dynamic_cast<UnaryExpAST*>(uexp.get());
+    auto ue = dynamic_cast<UnaryExpAST*>(uexp);
     thisRet = ue->thisRet;
   }
 }
@@ -1516,8 +1586,8 @@ void AddExpAST::Dump() {
   if (aex == aex_t::AddOPMul) {
     aexp->Dump();
     mexp->Dump();
-    auto ae = dynamic_cast<AddExpAST*>(aexp.get());
-    auto me = dynamic_cast<MulExpAST*>(mexp.get());
+    auto ae = dynamic_cast<AddExpAST*>(aexp);
+    auto me = dynamic_cast<MulExpAST*>(mexp);
 
     IRGenerator& gen = IRGenerator::getInstance();
     switch (aop) {
@@ -1532,7 +1602,7 @@ void AddExpAST::Dump() {
     }
   } else {
     mexp->Dump();
-    auto me = dynamic_cast<MulExpAST*>(mexp.get());
+    auto me = dynamic_cast<MulExpAST*>(mexp);
     thisRet = me->thisRet;
   }
 }
@@ -1586,8 +1656,8 @@ void RelExpAST::Dump() {
 
     IRGenerator& gen = IRGenerator::getInstance();
 
-    auto rel = dynamic_cast<RelExpAST*>(rexp.get());
-    auto ae = dynamic_cast<AddExpAST*>(aexp.get());
+    auto rel = dynamic_cast<RelExpAST*>(rexp);
+    auto ae = dynamic_cast<AddExpAST*>(aexp);
 
     switch (rop) {
       case rop_t::LessThan:
@@ -1607,7 +1677,7 @@ void RelExpAST::Dump() {
     }
   } else {
     aexp->Dump();
-    auto ae = dynamic_cast<AddExpAST*>(aexp.get());
+    auto ae = dynamic_cast<AddExpAST*>(aexp);
     thisRet = ae->thisRet;
   }
 }
@@ -1664,8 +1734,8 @@ void EqExpAST::Dump() {
   if (eex == eex_t::EqOPRel) {
     eexp->Dump();
     rexp->Dump();
-    auto eq = dynamic_cast<EqExpAST*>(eexp.get());
-    auto rel = dynamic_cast<RelExpAST*>(rexp.get());
+    auto eq = dynamic_cast<EqExpAST*>(eexp);
+    auto rel = dynamic_cast<RelExpAST*>(rexp);
 
     IRGenerator& gen = IRGenerator::getInstance();
 
@@ -1679,7 +1749,7 @@ void EqExpAST::Dump() {
     }
   } else {
     rexp->Dump();
-    auto rel = dynamic_cast<RelExpAST*>(rexp.get());
+    auto rel = dynamic_cast<RelExpAST*>(rexp);
     thisRet = rel->thisRet;
   }
 }
@@ -1732,8 +1802,8 @@ void LAndExpAST::Dump() {
   auto& gen = IRGenerator::getInstance();
   auto& pcs = gen.symbolCore.dproc;
   if (laex == laex_t::LAOPEq) {
-    auto la = dynamic_cast<LAndExpAST*>(laexp.get());
-    auto eq = dynamic_cast<EqExpAST*>(eexp.get());
+    auto la = dynamic_cast<LAndExpAST*>(laexp);
+    auto eq = dynamic_cast<EqExpAST*>(eexp);
 
     if (pcs.IsEnabled() && pcs.getCurSymType() == SymbolType::e_const) {
       laexp->Dump();
@@ -1744,44 +1814,42 @@ void LAndExpAST::Dump() {
     }
 
     /*
-      int result = lhs != 0;
-      if (lhs != 0) {
-        result = rhs != 0;
-      }
+      lhs != 0 ? (rhs != 0) : 0
+      结果作为next块的参数传过去
     */
-
-    // int result = lhs != 0;
     laexp->Dump();
-    auto entry = pcs.QuickGenEntry(SymbolType::e_var, VarType::e_int,
-                                   gen.registerShortCircuitVar());
-    gen.WriteAllocInst(entry);
-    RetInfo lhsNeZero =
-        gen.WriteBinaryInst(la->thisRet, RetInfo(0), OpID::LG_NEQ);
-    gen.WriteStoreInst(lhsNeZero, entry);
+    int rhs_label = gen.branchCore.registerNewBB();
+    int next_label = gen.branchCore.registerNewBB();
+    gen.WriteShortCircuitBr(la->thisRet, rhs_label, next_label, 0);
 
-    // if (lhs != 0) {
-    IfInfo ifinfo(IfInfo::i);
-    gen.WriteBrInst(lhsNeZero, ifinfo);
-
-    // result = rhs != 0;
-    gen.WriteLabel(ifinfo.then_label);
+    gen.WriteLabel(rhs_label);
     eexp->Dump();
     RetInfo rhsNeZero =
         gen.WriteBinaryInst(eq->thisRet, RetInfo(0), OpID::LG_NEQ);
-    gen.WriteStoreInst(rhsNeZero, entry);
-    gen.WriteJumpInst(ifinfo.next_label);
+    gen.WriteJumpInst(next_label, rhsNeZero);
 
-    // load return
-    gen.WriteLabel(ifinfo.next_label);
-    thisRet = gen.WriteLoadInst(entry);
+    thisRet = gen.WriteParamLabel(next_label);
 
   } else {
     eexp->Dump();
-    auto ee = dynamic_cast<EqExpAST*>(eexp.get());
+    auto ee = dynamic_cast<EqExpAST*>(eexp);
     thisRet = ee->thisRet;
   }
 }
 
+void LAndExpAST::DumpCond(const int& trueLabel, const int& falseLabel) {
+  auto& gen = IRGenerator::getInstance();
+  if (laex == laex_t::LAOPEq) {
+    // lhs为假时直接跳到false，否则再看rhs
+    int rhs_label = gen.branchCore.registerNewBB();
+    dynamic_cast<LAndExpAST*>(laexp)->DumpCond(rhs_label, falseLabel);
+    gen.WriteLabel(rhs_label);
+  }
+  eexp->Dump();
+  gen.WriteBrInst(dynamic_cast<EqExpAST*>(eexp)->thisRet, trueLabel,
+                  falseLabel);
+}
+
 string LAndExpAST::type() const {
   switch (laex) {
     case laex_t::EqExp:
@@ -1821,8 +1889,8 @@ void LOrExpAST::Dump() {
   auto& gen = IRGenerator::getInstance();
   auto& pcs = gen.symbolCore.dproc;
   if (loex == loex_t::LOOPLA) {
-    auto la = dynamic_cast<LAndExpAST*>(laexp.get());
-    auto lo = dynamic_cast<LOrExpAST*>(loexp.get());
+    auto la = dynamic_cast<LAndExpAST*>(laexp);
+    auto lo = dynamic_cast<LOrExpAST*>(loexp);
 
     if (pcs.IsEnabled() && pcs.getCurSymType() == SymbolType::e_const) {
       loexp->Dump();
@@ -1832,45 +1900,41 @@ void LOrExpAST::Dump() {
     }
 
     /*
-      int result = lhs != 0;
-      if (lhs == 0) {
-        result = rhs != 0;
-      }
+      lhs != 0 ? 1 : (rhs != 0)
+      结果作为next块的参数传过去
     */
-
-    // int result = lhs;
     loexp->Dump();
-    auto entry = pcs.QuickGenEntry(SymbolType::e_var, VarType::e_int,
-                                   gen.registerShortCircuitVar());
-    gen.WriteAllocInst(entry);
-    RetInfo lhsNeZero =
-        gen.WriteBinaryInst(lo->thisRet, RetInfo(0), OpID::LG_NEQ);
-    gen.WriteStoreInst(lhsNeZero, entry);
-
-    // if (lhs == 0) {
-    IfInfo ifinfo(IfInfo::i);
-    RetInfo lhsEqZero = gen.WriteUnaryInst(lhsNeZero, OpID::UNARY_NOT);
-    gen.WriteBrInst(lhsEqZero, ifinfo);
-
-    // result = rhs != 0;
-    gen.WriteLabel(ifinfo.then_label);
+    int rhs_label = gen.branchCore.registerNewBB();
+    int next_label = gen.branchCore.registerNewBB();
+    gen.WriteShortCircuitBr(lo->thisRet, rhs_label, next_label, 1);
+
+    gen.WriteLabel(rhs_label);
     laexp->Dump();
     RetInfo rhsNeZero =
         gen.WriteBinaryInst(la->thisRet, RetInfo(0), OpID::LG_NEQ);
-    gen.WriteStoreInst(rhsNeZero, entry);
-    gen.WriteJumpInst(ifinfo.next_label);
+    gen.WriteJumpInst(next_label, rhsNeZero);
 
-    // load return
-    gen.WriteLabel(ifinfo.next_label);
-    thisRet = gen.WriteLoadInst(entry);
+    thisRet = gen.WriteParamLabel(next_label);
 
   } else {
     laexp->Dump();
-    auto la = dynamic_cast<LAndExpAST*>(laexp.get());
+    auto la = dynamic_cast<LAndExpAST*>(laexp);
     thisRet = la->thisRet;
   }
 }
 
+void LOrExpAST::DumpCond(const int& trueLabel, const int& falseLabel) {
+  auto& gen = IRGenerator::getInstance();
+  auto la = dynamic_cast<LAndExpAST*>(laexp);
+  if (loex == loex_t::LOOPLA) {
+    // lhs为真时直接跳到true，否则再看rhs
+    int rhs_label = gen.branchCore.registerNewBB();
+    dynamic_cast<LOrExpAST*>(loexp)->DumpCond(trueLabel, rhs_label);
+    gen.WriteLabel(rhs_label);
+  }
+  la->DumpCond(trueLabel, falseLabel);
+}
+
 string LOrExpAST::type() const {
   switch (loex) {
     case loex_t::LAndExp:
@@ -1896,7 +1960,7 @@ void ConstExpAST::Print(ostream& os, int indent) const {
 
 void ConstExpAST::Dump() {
   exp->Dump();
-  auto ptr = dynamic_cast<ExpAST*>(exp.get());
+  auto ptr = dynamic_cast<ExpAST*>(exp);
   thisRet = ptr->thisRet;
   assert(thisRet.ty == RetInfo::ty_int);
 }
@@ -6,13 +6,14 @@
 #include <iostream>
 #include <memory>
 #include <string>
+#include "ir_arena.h"
 #include "ir_gen.h"
 #include "ir_sysy2ir.h"
 
 #define INDENT_LEN 4
 
 using namespace std;
-using ir::RetInfo;
+using ir::RetInfo, ir::ASTArena, ir::SymbolId, ir::SymbolName;
 
 /*
 CompRoot        ::= CompUnitList
@@ -129,7 +130,7 @@ class CompUnitAST;
 // CompRoot        ::= CompUnitList
 class CompRootAST : public BaseAST {
  public:
-  vector<unique_ptr<CompUnitAST>> comp_units;
+  vector<CompUnitAST*> comp_units;
 
   void Print(ostream& os, int indent) const override;
   void Dump() override;
@@ -154,7 +155,7 @@ class CompUnitListUnit : public BaseAST {
 class CompUnitAST : public BaseAST {
  public:
   enum comp_unit_ty { e_func_def, e_decl } ty;
-  unique_ptr<BaseAST> content;
+  BaseAST* content;
 
   void Print(ostream& os, int indent) const override;
   void Dump() override;
@@ -167,7 +168,7 @@ class DeclAST : public BaseAST {
  public:
   enum de_t { e_const, e_var };
   de_t de;
-  unique_ptr<BaseAST> decl;
+  BaseAST* decl;
 
   void Print(ostream& os, int indent) const override;
   void Dump() override;
@@ -179,8 +180,8 @@ class ConstDefAST;
 // ConstDecl     ::= "const" BType ConstDef ConstDeclList ";";
 class ConstDeclAST : public BaseAST {
  public:
-  unique_ptr<BaseAST> btype;
-  vector<unique_ptr<ConstDefAST>> const_defs;
+  BaseAST* btype;
+  vector<ConstDefAST*> const_defs;
 
   void Print(ostream& os, int indent) const override;
   void Dump() override;
@@ -218,9 +219,9 @@ ConstDef        ::= IDENT "=" ConstInitVal
 class ConstDefAST : public BaseAST {
  public:
   enum def_t { e_int, e_arr } ty;
-  string var_name;
-  unique_ptr<BaseAST> arr_size;
-  unique_ptr<BaseAST> const_init_val;
+  SymbolId var_name;
+  BaseAST* arr_size;
+  BaseAST* const_init_val;
 
   void Print(ostream& os, int indent) const override;
   void Dump() override;
@@ -231,7 +232,7 @@ class ConstDefAST : public BaseAST {
 // ConstInitVal  ::= ConstExp;
 class ConstInitValAST : public BaseAST {
  public:
-  unique_ptr<BaseAST> const_exp;
+  BaseAST* const_exp;
   RetInfo thisRet;
 
   void Print(ostream& os, int indent) const override;
@@ -244,8 +245,8 @@ class VarDefAST;
 // VarDecl     ::= BType VarDef VarDeclList ";";
 class VarDeclAST : public BaseAST {
  public:
-  unique_ptr<BaseAST> btype;
-  vector<unique_ptr<VarDefAST>> var_defs;
+  BaseAST* btype;
+  vector<VarDefAST*> var_defs;
 
   void Print(ostream& os, int indent) const override;
   void Dump() override;
@@ -276,9 +277,9 @@ class VarDefAST : public BaseAST {
  public:
   bool init_with_val;
   enum def_t { e_int, e_arr } ty;
-  string var_name;
-  unique_ptr<BaseAST> arr_size;
-  unique_ptr<BaseAST> init_val;
+  SymbolId var_name;
+  BaseAST* arr_size;
+  BaseAST* init_val;
 
   void Print(ostream& os, int indent) const override;
   void Dump() override;
@@ -289,7 +290,7 @@ class VarDefAST : public BaseAST {
 // InitVal       ::= Exp;
 class InitValAST : public BaseAST {
  public:
-  unique_ptr<BaseAST> exp;
+  BaseAST* exp;
   RetInfo thisRet;
 
   void Print(ostream& os, int indent) const override;
@@ -302,7 +303,7 @@ class ConstExpAST;
 // ArrSize         ::= "[" ConstExp "]" ArrSizeList
 class ArrSizeAST : public BaseAST {
  public:
-  vector<unique_ptr<ConstExpAST>> arr_size;
+  vector<ConstExpAST*> arr_size;
   vector<int> size_value;
 
   void Print(ostream& os, int indent) const override;
@@ -326,7 +327,7 @@ class ArrSizeListUnit : public BaseAST {
 class CAElementAST : public BaseAST {
  public:
   enum caty_t { e_cexp, e_carr } ty;
-  unique_ptr<BaseAST> content;
+  BaseAST* content;
 
   void Print(ostream& os, int indent) const override;
   void Dump() override;
@@ -337,7 +338,7 @@ class CAElementAST : public BaseAST {
 // ConstArrVal     ::= "{" "}" | "{" CAElement CAElementList "}"
 class ConstArrValAST : public BaseAST {
  public:
-  vector<unique_ptr<CAElementAST>> values;
+  vector<CAElementAST*> values;
 
   void Print(ostream& os, int indent) const override;
   void Dump() override;
@@ -362,7 +363,7 @@ class ExpAST;
 class AIElementAST : public BaseAST {
  public:
   enum aity_t { e_exp, e_arr } ty;
-  unique_ptr<BaseAST> content;
+  BaseAST* content;
 
   void Print(ostream& os, int indent) const override;
   void Dump() override;
@@ -373,7 +374,7 @@ class AIElementAST : public BaseAST {
 // ArrInitVal      ::= "{" "}" | "{" AIElement AIElementList "}"
 class ArrInitValAST : public BaseAST {
  public:
-  vector<unique_ptr<AIElementAST>> values;
+  vector<AIElementAST*> values;
   vector<RetInfo> init_values;
 
   void Print(ostream& os, int indent) const override;
@@ -397,13 +398,21 @@ class AIElementListUnit : public BaseAST {
 // FuncDef         ::= BType IDENT "(" FuncFParams ")" Block
 class FuncDefAST : public BaseAST {
  public:
-  unique_ptr<BaseAST> func_type;
-  unique_ptr<BaseAST> params;
-  unique_ptr<BaseAST> block;
-  string func_name;
+  BaseAST* func_type;
+  BaseAST* params;
+  BaseAST* block;
+  SymbolId func_name;
 
   void Print(ostream& os, int indent) const override;
   void Dump() override;
+  // 生成函数声明，加入函数表
+  void Declare();
+  // 生成函数体，函数必须已经声明过，可以在任意线程调用
+  void Define();
+
+ private:
+  // 记录函数类型和参数
+  void DumpSignature();
 };
 #pragma endregion
 
@@ -412,7 +421,7 @@ class FuncDefAST : public BaseAST {
 class FuncFParamAST;
 class FuncFParamsAST : public BaseAST {
  public:
-  vector<unique_ptr<FuncFParamAST>> params;
+  vector<FuncFParamAST*> params;
 
   void Print(ostream& os, int indent) const override;
   void Dump() override;
@@ -439,9 +448,9 @@ FuncFParam      ::= INT IDENT
 */
 class FuncFParamAST : public BaseAST {
  public:
-  unique_ptr<BaseAST> ptr_size;
+  BaseAST* ptr_size;
   bool is_ptr;
-  string param_name;
+  SymbolId param_name;
 
   void Print(ostream& os, int indent) const override;
   void Dump() override;
@@ -453,7 +462,7 @@ class BlockItemAST;
 // Block           ::= "{" BlockItem BlockList "}"
 class BlockAST : public BaseAST {
  public:
-  vector<unique_ptr<BlockItemAST>> block_items;
+  vector<BlockItemAST*> block_items;
 
   void Print(ostream& os, int indent) const override;
   void Dump() override;
@@ -479,7 +488,7 @@ class BlockItemAST : public BaseAST {
  public:
   enum blocktype_t { decl, stmt };
   blocktype_t bt;
-  unique_ptr<BaseAST> content;
+  BaseAST* content;
 
   void Print(ostream& os, int indent) const override;
   void Dump() override;
@@ -491,7 +500,7 @@ class BlockItemAST : public BaseAST {
 class StmtAST : public BaseAST {
  public:
   enum stmty_t { open, closed } type;
-  unique_ptr<BaseAST> stmt;
+  BaseAST* stmt;
 
   void Print(ostream& os, int indent) const override;
   void Dump() override;
@@ -508,7 +517,7 @@ OpenStmt        ::= "if" "(" Exp ")" OpenStmt
 class OpenStmtAST : public BaseAST {
  public:
   enum opty_t { io, ic, iceo, loop } type;
-  unique_ptr<BaseAST> open, closed, exp;
+  BaseAST *open, *closed, *exp;
 
   void Print(ostream& os, int indent) const override;
   void Dump() override;
@@ -524,7 +533,7 @@ ClosedStmt      ::= SimpleStmt
 class ClosedStmtAST : public BaseAST {
  public:
   enum csty_t { simp, icec, loop } type;
-  unique_ptr<BaseAST> simple, tclosed, fclosed, exp;
+  BaseAST *simple, *tclosed, *fclosed, *exp;
 
   void Print(ostream& os, int indent) const override;
   void Dump() override;
@@ -546,9 +555,9 @@ class SimpleStmtAST : public BaseAST {
  public:
   enum sstmt_t { storelval, ret, expr, block, nullexp, nullret, cont, brk };
   sstmt_t st;
-  unique_ptr<BaseAST> lval;
-  unique_ptr<BaseAST> exp;
-  unique_ptr<BaseAST> blk;
+  BaseAST* lval;
+  BaseAST* exp;
+  BaseAST* blk;
 
   void Print(ostream& os, int indent) const override;
   void Dump() override;
@@ -559,11 +568,13 @@ class SimpleStmtAST : public BaseAST {
 // Exp         ::= LOrExp
 class ExpAST : public BaseAST {
  public:
-  unique_ptr<BaseAST> loexp;
+  BaseAST* loexp;
   RetInfo thisRet;
 
   void Print(ostream& os, int indent) const override;
   void Dump() override;
+  // 作为if、while的条件，不求出值，直接跳到trueLabel或falseLabel
+  void DumpCond(const int& trueLabel, const int& falseLabel);
 };
 #pragma endregion
 
@@ -572,7 +583,7 @@ class ConstExpAST;
 // ArrAddr         ::= "[" Exp "]" ArrAddrList
 class ArrAddrAST : public BaseAST {
  public:
-  vector<unique_ptr<ExpAST>> arr_addr;
+  vector<ExpAST*> arr_addr;
   vector<RetInfo> addr_value;
 
   void Print(ostream& os, int indent) const override;
@@ -596,8 +607,8 @@ class ArrAddrListUnit : public BaseAST {
 class LValAST : public BaseAST {
  public:
   enum lval_t { e_noaddr, e_withaddr } ty;
-  unique_ptr<BaseAST> arr_param;
-  string var_name;
+  BaseAST* arr_param;
+  SymbolId var_name;
   RetInfo thisRet;
 
   void Print(ostream& os, int indent) const override;
@@ -611,7 +622,7 @@ class PrimaryExpAST : public BaseAST {
  public:
   enum primary_exp_type_t { Brackets, LVal, Number };
   primary_exp_type_t pt;
-  unique_ptr<BaseAST> content;
+  BaseAST* content;
   RetInfo thisRet;
 
   void Print(ostream& os, int indent) const override;
@@ -647,10 +658,10 @@ class UnaryExpAST : public BaseAST {
   enum uex_t { Primary, OPUnary, FuncWithParam, FuncNoParam } uex;
   enum uop_t { Pos, Neg, Not } uop;
 
-  unique_ptr<BaseAST> exp;
+  BaseAST* exp;
 
-  string func_name;
-  unique_ptr<BaseAST> params;
+  SymbolId func_name;
+  BaseAST* params;
 
   RetInfo thisRet;
 
@@ -663,7 +674,7 @@ class UnaryExpAST : public BaseAST {
 // FuncRParams     ::= Exp FuncRParamsList;
 class FuncRParamsAST : public BaseAST {
  public:
-  vector<unique_ptr<ExpAST>> params;
+  vector<ExpAST*> params;
   vector<RetInfo> parsed_params;
 
   void Print(ostream& os, int indent) const override;
@@ -692,8 +703,8 @@ class MulExpAST : public BaseAST {
   mex_t mex;
   enum mop_t { Mul, Div, Mod };
   mop_t mop;
-  unique_ptr<BaseAST> mexp;
-  unique_ptr<BaseAST> uexp;
+  BaseAST* mexp;
+  BaseAST* uexp;
   RetInfo thisRet;
 
   void Print(ostream& os, int indent) const override;
@@ -713,8 +724,8 @@ class AddExpAST : public BaseAST {
   aex_t aex;
   enum aop_t { Add, Sub };
   aop_t aop;
-  unique_ptr<BaseAST> mexp;
-  unique_ptr<BaseAST> aexp;
+  BaseAST* mexp;
+  BaseAST* aexp;
   RetInfo thisRet;
 
   void Print(ostream& os, int indent) const override;
@@ -734,8 +745,8 @@ class RelExpAST : public BaseAST {
   rex_t rex;
   enum rop_t { LessThan, LessEqual, GreaterThan, GreaterEqual };
   rop_t rop;
-  unique_ptr<BaseAST> rexp;
-  unique_ptr<BaseAST> aexp;
+  BaseAST* rexp;
+  BaseAST* aexp;
   RetInfo thisRet;
 
   void Print(ostream& os, int indent) const override;
@@ -755,8 +766,8 @@ class EqExpAST : public BaseAST {
   eex_t eex;
   enum eop_t { Equal, NotEqual };
   eop_t eop;
-  unique_ptr<BaseAST> eexp;
-  unique_ptr<BaseAST> rexp;
+  BaseAST* eexp;
+  BaseAST* rexp;
   RetInfo thisRet;
 
   void Print(ostream& os, int indent) const override;
@@ -774,12 +785,13 @@ class LAndExpAST : public BaseAST {
  public:
   enum laex_t { EqExp, LAOPEq };
   laex_t laex;
-  unique_ptr<BaseAST> laexp;
-  unique_ptr<BaseAST> eexp;
+  BaseAST* laexp;
+  BaseAST* eexp;
   RetInfo thisRet;
 
   void Print(ostream& os, int indent) const override;
   void Dump() override;
+  void DumpCond(const int& trueLabel, const int& falseLabel);
 
  private:
   string type() const;
@@ -792,12 +804,13 @@ class LOrExpAST : public BaseAST {
  public:
   enum loex_t { LAndExp, LOOPLA };
   loex_t loex;
-  unique_ptr<BaseAST> laexp;
-  unique_ptr<BaseAST> loexp;
+  BaseAST* laexp;
+  BaseAST* loexp;
   RetInfo thisRet;
 
   void Print(ostream& os, int indent) const override;
   void Dump() override;
+  void DumpCond(const int& trueLabel, const int& falseLabel);
 
  private:
   string type() const;
@@ -808,7 +821,7 @@ class LOrExpAST : public BaseAST {
 // ConstExp      ::= Exp;
 class ConstExpAST : public BaseAST {
  public:
-  unique_ptr<BaseAST> exp;
+  BaseAST* exp;
   RetInfo thisRet;
 
   void Print(ostream& os, int indent) const override;
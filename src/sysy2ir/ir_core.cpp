@@ -1,40 +1,51 @@
 #include "ir_sysy2ir.h"
 
 extern FILE* yyin;
-extern int yyparse(unique_ptr<BaseAST>& ast);
+extern int yyparse(BaseAST*& ast, ASTArena& arena);
 
 namespace ir {
 
-string sysy2ir(const char* input, const char* output, bool output2file) {
+static const koopa_raw_program_t Generate(const char* input) {
   yyin = fopen(input, "r");
   assert(yyin);
 
   // 调用 parser 函数, parser 函数会进一步调用 lexer 解析输入文件的
-  unique_ptr<BaseAST> ast;
-  auto ret = yyparse(ast);
+  // 语法树只在生成IR时使用，函数返回时整棵树一起释放
+  ASTArena arena;
+  BaseAST* ast = nullptr;
+  auto ret = yyparse(ast, arena);
   assert(!ret);
 
-  stringstream out, cou;
+  // ast->Print(cout, 0);
+  // 直接在内存中生成raw program
+  ast->Dump();
 
-  IRGenerator::getInstance().setting.setIndent(0).setOs(cou);
+  return IRGenerator::getInstance().rawCore.GetProgram();
+}
 
-  // ast->Print(out, 0);
-  ast->Dump();
+const koopa_raw_program_t sysy2ir(const char* input, const int& jobs) {
+  auto& gen = IRGenerator::getInstance();
+  gen.unit_handler = nullptr;
+  gen.jobs = jobs;
+  return Generate(input);
+}
+
+void sysy2ir(const char* input, const UnitHandler& handler) {
+  auto& gen = IRGenerator::getInstance();
+  gen.unit_handler = handler;
+  Generate(input);
+  gen.unit_handler = nullptr;
+}
 
-  if (false) {
-    cout << "Structure: \n" << out.str() << endl;
-    cout << "IR code:\n" << cou.str() << endl;
+void ir2file(const koopa_raw_program_t& program, const char* output) {
+  ofstream outfile(output);
+  if (outfile.is_open()) {
+    RawPrinter printer(outfile);
+    printer.PrintProgram(program);
+    outfile.close();
   } else {
-    // 输出到文件
-    ofstream outfile(output);
-    if (outfile.is_open()) {
-      outfile << cou.str();
-      outfile.close();
-    } else {
-      cerr << "无法打开文件：" << output << endl;
-    }
+    cerr << "无法打开文件：" << output << endl;
   }
-  return cou.str();
 }
 
-}  // namespace ir
\ No newline at end of file
+}  // namespace ir
@@ -8,27 +8,16 @@ RetInfo::RetInfo() : ty(ty_void) {}
 
 RetInfo::RetInfo(int _value) : ty(ty_int), value(_value) {}
 
-RetInfo::RetInfo(string _symbol) : ty(ty_sbl), name(_symbol) {}
+RetInfo::RetInfo(koopa_raw_value_t _symbol) : ty(ty_sbl), sym(_symbol) {}
 
 const int& RetInfo::GetValue() const {
   assert(ty == ty_int);
   return value;
 }
 
-const string& RetInfo::GetSym() const {
+const koopa_raw_value_t& RetInfo::GetSym() const {
   assert(ty == ty_sbl);
-  return name;
-}
-
-const string RetInfo::GetInfo() const {
-  switch (ty) {
-    case retty_t::ty_int:
-      return to_string(GetValue());
-    case retty_t::ty_sbl:
-      return GetSym();
-    default:
-      return "";
-  }
+  return sym;
 }
 
 #pragma endregion
@@ -65,34 +54,25 @@ ArrInfo::ArrInfo(const vector<int>& _shape) : shape(_shape) {
   }
 }
 
-const string ArrInfo::GetType() const {
+koopa_raw_type_t ArrInfo::GetType() const {
   // int a[4][3]: [[i32, 3], 4]
-  stringstream ss;
-  int dim = Dim();
-  for (int i = 0; i < dim; i++) {
-    ss << "[";
-  }
-  ss << "i32, " << shape[dim - 1] << "]";
-  for (int i = dim - 2; i > -1; i--) {
-    ss << ", " << shape[i] << "]";
+  auto& raw = IRGenerator::getInstance().rawCore;
+  koopa_raw_type_t ty = raw.GetInt32Type();
+  for (int i = Dim() - 1; i > -1; i--) {
+    ty = raw.GetArrayType(ty, shape[i]);
   }
-  return ss.str();
+  return ty;
 }
 
-const string ArrInfo::GetPtrType() const {
+koopa_raw_type_t ArrInfo::GetPtrType() const {
   assert(shape[0] == 0);
-  stringstream ss;
-  int dim = Dim();
-  ss << '*';
+  auto& raw = IRGenerator::getInstance().rawCore;
+  koopa_raw_type_t ty = raw.GetInt32Type();
   // 第0维是0，不要
-  for (int i = 1; i < dim; i++) {
-    ss << "[";
+  for (int i = Dim() - 1; i > 0; i--) {
+    ty = raw.GetArrayType(ty, shape[i]);
   }
-  ss << "i32";
-  for (int i = dim - 1; i > 0; i--) {
-    ss << ", " << shape[i] << "]";
-  }
-  return ss.str();
+  return raw.GetPointerType(ty);
 }
 
 const int ArrInfo::Dim() const {
@@ -109,10 +89,23 @@ ArrInfo ArrInfo::GetFrag(const int& begin, const int& end) const {
   return ArrInfo(frag);
 }
 
+const vector<int> ArrInfo::GetAddr(int index) const {
+  vector<int> addr(shape.size());
+  for (int i = shape.size() - 1; i >= 0; i--) {
+    addr[i] = index % shape[i];
+    index /= shape[i];
+  }
+  return addr;
+}
+
 #pragma endregion
 
 #pragma region arr init
 
+static bool IsZeroInit(const RetInfo& info) {
+  return info.ty == RetInfo::ty_int && info.GetValue() == 0;
+}
+
 ArrInitNode::ArrInitNode() : ty(e_value), value(), nodes(), parent(nullptr) {}
 
 ArrInitNode::ArrInitNode(const RetInfo& val)
@@ -128,69 +121,16 @@ ArrInitNode::ArrInitNode(const node_t& type)
 SymbolTableEntry::SymbolTableEntry()
     : symbol_type(SymbolType::e_unused), var_type(VarType::e_unused), id(-1) {}
 
-const string SymbolTableEntry::GetAllocName() const {
-  return "@" + var_name + '_' + std::to_string(id);
-}
-
-const string SymbolTableEntry::GetAllocInst() const {
-  assert(symbol_type == SymbolType::e_var);
-  if (var_type == VarType::e_int) {
-    // int
-    // @x = alloc i32
-    stringstream ss;
-    ss << GetAllocName() << " = alloc i32";
-    return ss.str();
-  } else {
-    cerr << "[NOT SUPPORTED]" << endl;
-    assert(false);
-    return "";
-  }
+const string& SymbolTableEntry::GetName() const {
+  return SymbolName(symbol);
 }
 
-const string SymbolTableEntry::GetLoadInst(
-    const string& loadToSymbolName) const {
-  assert(symbol_type == SymbolType::e_var);
-  if (var_type == VarType::e_int) {
-    // int
-    // %0 = load @x
-    stringstream ss;
-    ss << loadToSymbolName << " = load " << GetAllocName();
-    return ss.str();
-  } else {
-    cerr << "[NOT SUPPORTED]" << endl;
-    assert(false);
-    return "";
-  }
-}
-
-const string SymbolTableEntry::GetStoreInst(
-    const string& storeFromSymbolName) const {
-  if (var_type == VarType::e_int || var_type == VarType::e_ptr) {
-    // int
-    // store %0, @x
-    stringstream ss;
-    ss << "store " << storeFromSymbolName << ", " << GetAllocName();
-    return ss.str();
-  } else {
-    cerr << "[NOT SUPPORTED]" << endl;
-    assert(false);
-    return "";
-  }
+const string SymbolTableEntry::GetAllocName() const {
+  return "@" + GetName() + '_' + std::to_string(id);
 }
 
-const string SymbolTableEntry::GetStoreInst(const int& imm) const {
-  // (symbolType == SymbolType::VAR);
-  if (var_type == VarType::e_int) {
-    // int
-    // store 0, @x
-    stringstream ss;
-    ss << "store " << imm << ", " << GetAllocName();
-    return ss.str();
-  } else {
-    cerr << "[NOT SUPPORTED]" << endl;
-    assert(false);
-    return "";
-  }
+koopa_raw_value_t SymbolTableEntry::GetAllocValue() const {
+  return IRGenerator::getInstance().symbolCore.GetAllocValue(*this);
 }
 
 #pragma endregion
@@ -199,25 +139,22 @@ const string SymbolTableEntry::GetStoreInst(const int& imm) const {
 
 SymbolTable::SymbolTable() : table(), parent(nullptr) {}
 
-bool SymbolTable::TryGetEntry(string symbol_name, SymbolTableEntry& out) const {
-  if (table.find(symbol_name) != table.end()) {
-    out = table.at(symbol_name);
-    return true;
-  }
-  return false;
+const SymbolTableEntry* SymbolTable::FindEntry(const SymbolId& symbol) const {
+  auto it = table.find(symbol);
+  return it == table.end() ? nullptr : &it->second;
 }
 
 void SymbolTable::InsertEntry(const SymbolTableEntry& entry) {
-  if (table.find(entry.var_name) != table.end()) {
-    cerr << "Symbol Table insert error: symbol with name \"" << entry.var_name
+  if (table.find(entry.symbol) != table.end()) {
+    cerr << "Symbol Table insert error: symbol with name \"" << entry.GetName()
          << "\" has already inserted in the table. It will be overwritten by "
             "default"
          << endl;
-    table[entry.var_name] = entry;
+    table[entry.symbol] = entry;
     return;
   }
   // do actual insert
-  table.emplace(entry.var_name, entry);
+  table.emplace(entry.symbol, entry);
 }
 
 void SymbolTable::ClearTable() {
@@ -249,7 +186,10 @@ const bool& BaseProcessor::IsEnabled() {
 DeclaimProcessor::DeclaimProcessor()
     : BaseProcessor(),
       current_symbol_type(SymbolType::e_unused),
-      current_var_type(VarType::e_unused) {}
+      current_var_type(VarType::e_unused),
+      var_pool(0),
+      global(false),
+      local_base(0) {}
 
 void DeclaimProcessor::SetSymbolType(const SymbolType& type) {
   assert(IsEnabled());
@@ -266,60 +206,68 @@ void DeclaimProcessor::Reset() {
   current_var_type = VarType::e_unused;
 }
 
-SymbolTableEntry DeclaimProcessor::GenerateConstEntry(const string& var_name,
+void DeclaimProcessor::MarkLocalBase() {
+  local_base = var_pool;
+}
+
+void DeclaimProcessor::ResetVarPool() {
+  var_pool = local_base;
+}
+
+SymbolTableEntry DeclaimProcessor::GenerateConstEntry(const SymbolId& symbol,
                                                       const int& value) {
   assert(IsEnabled() && current_symbol_type == SymbolType::e_const &&
          current_var_type != VarType::e_unused);
   SymbolTableEntry ste;
   ste.symbol_type = SymbolType::e_const;
   ste.var_type = VarType::e_int;
-  ste.var_name = var_name;
+  ste.symbol = symbol;
   ste.const_value = value;
   ste.id = RegisterVar();
   return ste;
 }
 
-SymbolTableEntry DeclaimProcessor::GenerateArrEntry(const string& var_name,
+SymbolTableEntry DeclaimProcessor::GenerateArrEntry(const SymbolId& symbol,
                                                     const ArrInfo& info) {
   SymbolTableEntry ste;
   ste.symbol_type = SymbolType::e_var;
   ste.var_type = VarType::e_arr;
-  ste.var_name = var_name;
+  ste.symbol = symbol;
   ste.arr_info = info;
   ste.id = RegisterVar();
   return ste;
 }
 
-SymbolTableEntry DeclaimProcessor::GeneratePtrEntry(const string& var_name,
+SymbolTableEntry DeclaimProcessor::GeneratePtrEntry(const SymbolId& symbol,
                                                     const ArrInfo& ptr_info) {
   SymbolTableEntry ste;
   ste.symbol_type = SymbolType::e_var;
   ste.var_type = VarType::e_ptr;
-  ste.var_name = var_name;
+  ste.symbol = symbol;
   ste.arr_info = ptr_info;
   ste.id = RegisterVar();
   return ste;
 }
 
-SymbolTableEntry DeclaimProcessor::GenerateVarEntry(const string& var_name,
+SymbolTableEntry DeclaimProcessor::GenerateVarEntry(const SymbolId& symbol,
                                                     const VarType& var_ty) {
   assert(IsEnabled() && current_symbol_type != SymbolType::e_unused &&
          current_var_type != VarType::e_unused);
   SymbolTableEntry ste;
   ste.symbol_type = SymbolType::e_var;
   ste.var_type = VarType::e_int;
-  ste.var_name = var_name;
+  ste.symbol = symbol;
   ste.id = RegisterVar();
   return ste;
 }
 
 SymbolTableEntry DeclaimProcessor::QuickGenEntry(const SymbolType& st,
                                                  const VarType& vt,
-                                                 string name) {
+                                                 const string& name) {
   SymbolTableEntry ste;
   ste.symbol_type = st;
   ste.var_type = vt;
-  ste.var_name = name;
+  ste.symbol = SymbolInterner::getInstance().Intern(name);
   ste.id = RegisterVar();
   return ste;
 }
@@ -340,36 +288,52 @@ const int DeclaimProcessor::RegisterVar() {
 
 #pragma region Assignment
 
-AssignmentProcessor::AssignmentProcessor() : BaseProcessor() {}
+AssignmentProcessor::AssignmentProcessor()
+    : BaseProcessor(), current_var(nullptr) {}
 
 void AssignmentProcessor::WriteAssign(const RetInfo& value) const {
   auto& gen = IRGenerator::getInstance();
-  if (current_var.var_type == VarType::e_int) {
-    gen.WriteStoreInst(value, current_var);
-  } else if (current_var.var_type == VarType::e_arr) {
-    gen.WriteStoreArrInst(current_var, value, arr_addr);
-  } else if (current_var.var_type == VarType::e_ptr) {
-    gen.WriteStorePtrInst(current_var, value, arr_addr);
+  assert(current_var != nullptr);
+  if (current_var->var_type == VarType::e_int) {
+    gen.WriteStoreInst(value, *current_var);
+  } else if (current_var->var_type == VarType::e_arr) {
+    gen.WriteStoreArrInst(*current_var, value, arr_addr);
+  } else if (current_var->var_type == VarType::e_ptr) {
+    gen.WriteStorePtrInst(*current_var, value, arr_addr);
   }
 }
 
 #pragma endregion
 
-SymbolManager::SymbolManager() : dproc(), aproc(), RootTable() {
+SymbolManager::SymbolManager()
+    : dproc(), aproc(), RootTable(), alloc_values() {
   currentTable = &RootTable;
 }
 
-const SymbolTableEntry SymbolManager::getEntry(string symbol_name) {
-  SymbolTableEntry entry;
-  SymbolTable* search = currentTable;
+void SymbolManager::SetAllocValue(const SymbolTableEntry& entry,
+                                  koopa_raw_value_t value) {
+  alloc_values[entry.id] = value;
+}
+
+koopa_raw_value_t SymbolManager::GetAllocValue(
+    const SymbolTableEntry& entry) const {
+  auto it = alloc_values.find(entry.id);
+  assert(it != alloc_values.end());
+  return it->second;
+}
+
+const SymbolTableEntry& SymbolManager::getEntry(const SymbolId& symbol) const {
+  const SymbolTable* search = currentTable;
   while (search != nullptr) {
-    if (search->TryGetEntry(symbol_name, entry))
-      return entry;
+    const SymbolTableEntry* entry = search->FindEntry(symbol);
+    if (entry != nullptr)
+      return *entry;
     search = search->parent;
   }
-  cerr << "SymbolManager: don't find symbol with name " << symbol_name << endl;
+  cerr << "SymbolManager: don't find symbol with name " << SymbolName(symbol)
+       << endl;
   assert(false);
-  return SymbolTableEntry();
+  abort();
 }
 
 void SymbolManager::InsertEntry(SymbolTableEntry entry) {
@@ -388,6 +352,14 @@ void SymbolManager::PopScope() {
   delete tmp;
 }
 
+void SymbolManager::CopyGlobals(const SymbolManager& other) {
+  assert(currentTable == &RootTable);
+  RootTable.table = other.RootTable.table;
+  alloc_values = other.alloc_values;
+  // 变量池和局部变量编号的起点也要一样
+  dproc = other.dproc;
+}
+
 #pragma region Branch
 
 BranchManager::BranchManager() : hasRetThisBB(false), bbPool(0), loopStack() {}
@@ -427,93 +399,98 @@ void BranchManager::Reset() {
 #pragma region func
 
 FuncManager::FuncManager()
-    : func_name(), ret_ty(), ret_info(), symbolPool(0), func_table() {}
+    : func_name(), ret_ty(), ret_info(), func_table(), param_refs() {}
+
+void FuncManager::WriteFuncDecl() {
+  auto& raw = IRGenerator::getInstance().rawCore;
+
+  vector<koopa_raw_type_t> param_types;
+  WriteParamsDefine(param_types);
+  koopa_raw_type_t ret = ret_ty == VarType::e_void ? raw.GetUnitType()
+                                                   : raw.GetInt32Type();
+  RawFunc func = raw.NewFunction(
+      "@" + func_name, raw.GetFuncType(param_types, ret), param_refs);
 
-void FuncManager::WriteFuncPrologue() {
   // 记入函数表
-  func_table.emplace(func_name, ret_ty);
-
-  auto& setting = IRGenerator::getInstance().setting;
-  auto& os = setting.getOs();
-
-  os << "fun @" << func_name << "(";
-  WriteParamsDefine();
-  os << ")" << (ret_ty == VarType::e_void ? "" : ": ")  // 格式
-     << GetVarType(ret_ty) << " "                       // 格式
-     << "{\n"
-     << setting.getIndentStr()
-     << "%"
-        "entry:"
-     << endl;
-  setting.getIndent() += 2;
+  func_table.emplace(func_name, func);
+  raw.AddFunction(func);
+}
+
+void FuncManager::WriteFuncPrologue() {
+  auto& raw = IRGenerator::getInstance().rawCore;
+  // 声明时已经生成了func_arg_ref
+  RawFunc func = const_cast<RawFunc>(func_table.at(func_name));
+  param_refs.clear();
+  for (size_t i = 0; i < func->params.len; i++) {
+    param_refs.push_back(
+        reinterpret_cast<koopa_raw_value_t>(func->params.buffer[i]));
+  }
+
+  raw.BeginFunction(func);
+  raw.InsertBasicBlock(raw.GetBasicBlock("%entry"));
   WriteAllocParams();
   return;
 }
 
 void FuncManager::WriteFuncEpilogue() {
-  auto& setting = IRGenerator::getInstance().setting;
-  auto& os = setting.getOs();
-  os << "}\n" << endl;
-  setting.getIndent() -= 2;
+  IRGenerator::getInstance().rawCore.EndFunction();
   return;
 }
 
 void FuncManager::WriteRetInst() {
-  auto& setting = IRGenerator::getInstance().setting;
-  auto& os = setting.getOs();
-  os << setting.getIndentStr() << "ret " << ret_info.GetInfo() << endl;
-  IRGenerator::getInstance().branchCore.hasRetThisBB = true;
-}
-
-const int FuncManager::registerNewSymbol() {
-  return symbolPool++;
+  auto& gen = IRGenerator::getInstance();
+  koopa_raw_value_t value = nullptr;
+  if (ret_info.ty != RetInfo::ty_void) {
+    value = gen.GetRawValue(ret_info);
+  }
+  gen.rawCore.InsertInst(gen.rawCore.NewReturn(value));
+  gen.branchCore.hasRetThisBB = true;
 }
 
-void FuncManager::InsertParam(VarType ty, string name) {
+void FuncManager::InsertParam(VarType ty, const SymbolId& symbol) {
   auto& gen = IRGenerator::getInstance();
   assert(ty == VarType::e_int);
-  params.push_back(
-      gen.symbolCore.dproc.QuickGenEntry(SymbolType::e_var, ty, name));
+  params.push_back(gen.symbolCore.dproc.QuickGenEntry(SymbolType::e_var, ty,
+                                                      SymbolName(symbol)));
 }
 
 void FuncManager::InsertParam(const SymbolTableEntry& entry) {
   params.push_back(entry);
 }
 
-void FuncManager::WriteParamsDefine() {
-  auto& os = IRGenerator::getInstance().setting.getOs();
+void FuncManager::WriteParamsDefine(vector<koopa_raw_type_t>& types) {
+  auto& raw = IRGenerator::getInstance().rawCore;
   int len = params.size();
 
+  param_refs.clear();
   for (int i = 0; i < len; i++) {
-    if (i != 0)
-      os << ", ";
+    koopa_raw_type_t ty;
     if (params[i].var_type == VarType::e_int) {
-      os << getParamVarName(params[i].var_name) << ": "
-         << GetVarType(params[i].var_type);
-    } else if (params[i].var_type == VarType::e_ptr) {
-      os << getParamVarName(params[i].var_name) << ": "
-         << params[i].arr_info.GetPtrType();
+      ty = raw.GetInt32Type();
+    } else {
+      assert(params[i].var_type == VarType::e_ptr);
+      ty = params[i].arr_info.GetPtrType();
     }
+    types.push_back(ty);
+    param_refs.push_back(
+        raw.NewFuncArgRef(i, ty, getParamVarName(params[i].GetName())));
   }
 }
 
 void FuncManager::WriteAllocParams() {
   auto& gen = IRGenerator::getInstance();
-  for (auto it = params.begin(); it != params.end(); it++) {
-    SymbolTableEntry entry(*it);
+  int len = params.size();
+  for (int i = 0; i < len; i++) {
+    SymbolTableEntry entry(params[i]);
     if (entry.var_type == VarType::e_int) {
       gen.WriteAllocInst(entry);
-      gen.symbolCore.InsertEntry(entry);
-      RetInfo tmp(getParamVarName(it->var_name));
-      gen.WriteStoreInst(tmp, entry);
     } else if (entry.var_type == VarType::e_ptr) {
       gen.WriteAllocPtrInst(entry);
-      gen.symbolCore.InsertEntry(entry);
-      RetInfo tmp(getParamVarName(it->var_name));
-      gen.WriteStoreInst(tmp, entry);
     } else {
       assert(false);
     }
+    gen.symbolCore.InsertEntry(entry);
+    gen.WriteStoreInst(RetInfo(param_refs[i]), entry);
   }
 }
 
@@ -521,8 +498,8 @@ void FuncManager::Reset() {
   func_name = string();
   ret_ty = VarType::e_int;
   ret_info = RetInfo();
-  symbolPool = 0;
   params.clear();
+  param_refs.clear();
 }
 
 void FuncManager::SetDefaultRetInfo() {
@@ -536,19 +513,38 @@ void FuncManager::SetDefaultRetInfo() {
   }
 }
 
-const map<string, VarType>& FuncManager::GetFuncTable() const {
+const map<string, koopa_raw_function_t>& FuncManager::GetFuncTable() const {
   return func_table;
 }
 
 void FuncManager::AddLibFuncs() {
-  func_table.emplace(string("getint"), VarType::e_int);
-  func_table.emplace(string("getch"), VarType::e_int);
-  func_table.emplace(string("getarray"), VarType::e_int);
-  func_table.emplace(string("putint"), VarType::e_void);
-  func_table.emplace(string("putch"), VarType::e_void);
-  func_table.emplace(string("putarray"), VarType::e_void);
-  func_table.emplace(string("starttime"), VarType::e_void);
-  func_table.emplace(string("stoptime"), VarType::e_void);
+  auto& raw = IRGenerator::getInstance().rawCore;
+  koopa_raw_type_t i32 = raw.GetInt32Type();
+  koopa_raw_type_t ptr = raw.GetPointerType(i32);
+  koopa_raw_type_t unit = raw.GetUnitType();
+  AddLibFunc("getint", {}, i32);
+  AddLibFunc("getch", {}, i32);
+  AddLibFunc("getarray", {ptr}, i32);
+  AddLibFunc("putint", {i32}, unit);
+  AddLibFunc("putch", {i32}, unit);
+  AddLibFunc("putarray", {i32, ptr}, unit);
+  AddLibFunc("starttime", {}, unit);
+  AddLibFunc("stoptime", {}, unit);
+}
+
+void FuncManager::AddLibFunc(const string& name,
+                             const vector<koopa_raw_type_t>& params,
+                             koopa_raw_type_t ret) {
+  auto& raw = IRGenerator::getInstance().rawCore;
+  // 没有基本块，是函数声明
+  RawFunc func =
+      raw.NewFunction("@" + name, raw.GetFuncType(params, ret), {});
+  func_table.emplace(name, func);
+  raw.AddFunction(func);
+}
+
+void FuncManager::CopyFuncTable(const FuncManager& other) {
+  func_table = other.func_table;
 }
 
 const string FuncManager::getParamVarName(const string& name) const {
@@ -591,57 +587,76 @@ void ArrInitManager::Clear() {
   global = false;
 }
 
-const vector<RetInfo> ArrInitManager::GetInits(const ArrInfo& shape) {
-  vector<RetInfo> ret;
-  RecursionGetInits(root, shape, ret, true);
+const ArrInits ArrInitManager::GetInits(const ArrInfo& shape) {
+  ArrInits ret;
+  RecursionGetInits(root, shape, 0, ret, true);
   return ret;
 }
 
-void ArrInitManager::GetInitString(const ArrInfo& arr,
-                                   const vector<RetInfo>& inits,
-                                   stringstream& output) {
-  int dim = arr.Dim();
-  if (dim == 1) {
-    // 1d
-    // int a[3] = {1,2,3}
-    output << '{';
-    for (int i = 0; i < arr.shape[0]; i++) {
-      if (i != 0)
-        output << ", ";
-      output << inits[i].GetInfo();
-    }
-    output << '}';
-  } else {
-    // nd
-    // int a[3][2][2] = {{{0,0},{0,0}},{{0,0},{0,0}},{{0,0},{0,0}}}
-    output << '{';
-
-    ArrInfo new_info = arr.GetFrag(1, dim);
-    vector<RetInfo> new_inits;
-    for (int i = 0; i < arr.shape[0]; i++) {
-      if (i != 0)
-        output << ", ";
-      // 截取数据
-      auto begin = inits.begin() + i * new_info.GetSize();
-      auto end = begin + new_info.GetSize();
-      new_inits.assign(begin, end);
-      GetInitString(new_info, new_inits, output);
+// len个连续的0元素，多于一个时用一个[ty, len]类型的zeroinit表示
+static koopa_raw_value_t NewZeroRun(koopa_raw_type_t ty, const int& len) {
+  auto& raw = IRGenerator::getInstance().rawCore;
+  if (len > 1)
+    return raw.NewZeroInit(raw.GetArrayType(ty, len));
+  if (ty->tag == KOOPA_RTT_INT32)
+    return raw.NewInteger(0);
+  return raw.NewZeroInit(ty);
+}
+
+koopa_raw_value_t ArrInitManager::GetInitAggregate(const ArrInfo& arr,
+                                                   const ArrInits& inits,
+                                                   const int& begin,
+                                                   const int& end,
+                                                   const int& offset) {
+  auto& raw = IRGenerator::getInstance().rawCore;
+  if (begin == end) {
+    // 全是0
+    return raw.NewZeroInit(arr.GetType());
+  }
+
+  // int a[4][2] = {{1}}: {{1, 0}, [[i32, 2], 3]类型的zeroinit}
+  // 一维时子数组就是单个i32
+  ArrInfo new_info = arr.GetFrag(1, arr.Dim());
+  koopa_raw_type_t sub_ty = new_info.GetType();
+  int sub_size = new_info.GetSize();
+  vector<koopa_raw_value_t> elems;
+  // 下一个要生成的元素
+  int next = 0;
+  int cur = begin;
+  while (cur < end) {
+    // 找出落在第i个子数组里的初始化值
+    int i = (inits[cur].first - offset) / sub_size;
+    int sub_offset = offset + i * sub_size;
+    int sub_end = cur;
+    while (sub_end < end && inits[sub_end].first < sub_offset + sub_size)
+      sub_end++;
+
+    if (i > next)
+      elems.push_back(NewZeroRun(sub_ty, i - next));
+    if (arr.Dim() == 1) {
+      elems.push_back(raw.NewInteger(inits[cur].second.GetValue()));
+    } else {
+      elems.push_back(
+          GetInitAggregate(new_info, inits, cur, sub_end, sub_offset));
     }
-    output << '}';
+    next = i + 1;
+    cur = sub_end;
   }
+  if (next < arr.shape[0])
+    elems.push_back(NewZeroRun(sub_ty, arr.shape[0] - next));
+  return raw.NewAggregate(elems, arr.GetType());
 }
 
 void ArrInitManager::RecursionGetInits(const ArrInitNode& node,
                                        const ArrInfo& arr,
-                                       vector<RetInfo>& appendto,
+                                       const int& offset,
+                                       ArrInits& appendto,
                                        bool first_layer) {
   // 记录这个shape中已经初始化的元素个数
   int has_inited = 0;
   // 记录数组dim
   // shape = (len 1, len 2, len 3, ..., len n)
   int dim = arr.Dim();
-  // 这个数组应该初始化的元素数
-  int should_init = arr.GetSize();
 
   // 处理零初始化
   if (global && first_layer && node.nodes.size() == 0) {
@@ -650,10 +665,11 @@ void ArrInitManager::RecursionGetInits(const ArrInitNode& node,
   }
 
   // 初始化这个子数组中的所有元素
-  for (auto n : node.nodes) {
+  for (const auto& n : node.nodes) {
     if (n.ty == ArrInitNode::e_value) {
-      // 元素：视为最底层
-      appendto.push_back(RetInfo(n.value));
+      // 元素：视为最底层，常数0不用记录
+      if (!IsZeroInit(n.value))
+        appendto.push_back({offset + has_inited, n.value});
       has_inited++;
 
     } else if (n.ty == ArrInitNode::e_arr) {
@@ -681,17 +697,14 @@ void ArrInitManager::RecursionGetInits(const ArrInitNode& node,
       ArrInfo fragment = arr.GetFrag(i, dim);
 
       // 处理这个数组
-      RecursionGetInits(n, fragment, appendto, false);
+      RecursionGetInits(n, fragment, offset + has_inited, appendto, false);
       // 已处理元素个数累加上数组元素个数
       has_inited += fragment.GetSize();
     }
   }
 
-  // 给数组补零
-  while (has_inited < should_init) {
-    appendto.push_back(RetInfo(0));
-    has_inited++;
-  }
+  // 剩下的元素都是0，不用记录
+  assert(has_inited <= arr.GetSize());
 
   // 能运行到这里那肯定不是零初始化
   zero_init = false;
@@ -700,17 +713,45 @@ void ArrInitManager::RecursionGetInits(const ArrInitNode& node,
 #pragma endregion
 
 IRGenerator::IRGenerator()
-    : symbolCore(), branchCore(), funcCore(), arrinitCore() {
-  setting.setOs(cout).setIndent(0);
-}
+    : rawCore(),
+      symbolCore(),
+      branchCore(),
+      funcCore(),
+      arrinitCore(),
+      unit_handler(),
+      jobs(1) {}
 
 IRGenerator& IRGenerator::getInstance() {
-  static IRGenerator gen;
+  // 每个线程一份，函数可以并行生成
+  static thread_local IRGenerator gen;
   return gen;
 }
 
+void IRGenerator::ForkFrom(const IRGenerator& other) {
+  symbolCore.CopyGlobals(other.symbolCore);
+  funcCore.CopyFuncTable(other.funcCore);
+}
+
+void IRGenerator::FlushUnit() {
+  if (!unit_handler)
+    return;
+  unit_handler(rawCore.TakePendingUnit());
+  rawCore.ReleaseFunction();
+}
+
+koopa_raw_value_t IRGenerator::GetRawValue(const RetInfo& info) {
+  if (info.ty == RetInfo::ty_int) {
+    return rawCore.NewInteger(info.GetValue());
+  }
+  return info.GetSym();
+}
+
 #pragma region lv3
 
+void IRGenerator::WriteFuncDecl() {
+  funcCore.WriteFuncDecl();
+}
+
 void IRGenerator::WriteFuncPrologue() {
   funcCore.WriteFuncPrologue();
 }
@@ -740,18 +781,16 @@ const RetInfo IRGenerator::WriteUnaryInst(const RetInfo& left, OpID op) {
 const RetInfo IRGenerator::WriteBinaryInst(const RetInfo& left,
                                            const RetInfo& right,
                                            OpID op) {
-  ostream& os = setting.getOs();
-
   // const expr
   if (left.ty == RetInfo::retty_t::ty_int &&
       right.ty == RetInfo::retty_t::ty_int) {
     return RetInfo(calcConstExpr(left.GetValue(), right.GetValue(), op));
   }
 
-  const string newSymbolName = getSymbolName(funcCore.registerNewSymbol());
-  os << setting.getIndentStr() << newSymbolName << " = " << BiOp2koopa(op)
-     << ' ' << left.GetInfo() << ", " << right.GetInfo() << endl;
-  return RetInfo(newSymbolName);
+  koopa_raw_value_t lhs = GetRawValue(left);
+  koopa_raw_value_t rhs = GetRawValue(right);
+  RawValue inst = rawCore.NewBinary(BiOp2koopa(op), lhs, rhs);
+  return RetInfo(rawCore.InsertInst(inst));
 }
 
 const RetInfo IRGenerator::WriteLogicInst(const RetInfo& left,
@@ -768,61 +807,80 @@ const RetInfo IRGenerator::WriteLogicInst(const RetInfo& left,
 #pragma region lv4
 
 void IRGenerator::WriteAllocInst(const SymbolTableEntry& entry) {
-  ostream& os = setting.getOs();
-  os << setting.getIndentStr() << entry.GetAllocInst() << endl;
+  assert(entry.symbol_type == SymbolType::e_var &&
+         entry.var_type == VarType::e_int);
+  // @x = alloc i32
+  koopa_raw_value_t alloc = rawCore.InsertInst(
+      rawCore.NewAlloc(entry.GetAllocName(), rawCore.GetInt32Type()));
+  symbolCore.SetAllocValue(entry, alloc);
 }
 
 const RetInfo IRGenerator::WriteLoadInst(const SymbolTableEntry& entry) {
-  ostream& os = setting.getOs();
-  const string newSymbolName = getSymbolName(funcCore.registerNewSymbol());
-  os << setting.getIndentStr() << entry.GetLoadInst(newSymbolName) << endl;
-  return RetInfo(newSymbolName);
+  assert(entry.symbol_type == SymbolType::e_var);
+  // %0 = load @x
+  koopa_raw_value_t src = entry.GetAllocValue();
+  return RetInfo(rawCore.InsertInst(rawCore.NewLoad(src)));
 }
 
 void IRGenerator::WriteStoreInst(const RetInfo& value,
                                  const SymbolTableEntry& entry) {
-  ostream& os = setting.getOs();
-
-  os << setting.getIndentStr();
-  if (value.ty == RetInfo::ty_int) {
-    // 常量赋值
-    os << entry.GetStoreInst(value.GetValue()) << endl;
-  } else if (value.ty == RetInfo::ty_sbl) {
-    // 符号赋值
-    os << entry.GetStoreInst(value.GetSym()) << endl;
+  if (value.ty == RetInfo::ty_void) {
+    return;
   }
+  // store %0, @x
+  koopa_raw_value_t dest = entry.GetAllocValue();
+  koopa_raw_value_t src = GetRawValue(value);
+  rawCore.InsertInst(rawCore.NewStore(src, dest));
 }
 
 #pragma endregion
 
 #pragma region lv6
 
-void IRGenerator::WriteBasicBlockPrologue(const int& bb_id) {
-  ostream& os = getInstance().setting.getOs();
-  os << "\n%" << getLabelName(bb_id) << ":" << endl;
+void IRGenerator::InitIfInfo(IfInfo& info) {
+  info.then_label = branchCore.registerNewBB();
+  if (info.ty == IfInfo::ifty_t::ie)
+    info.else_label = branchCore.registerNewBB();
+  info.next_label = branchCore.registerNewBB();
 }
 
-void IRGenerator::WriteBrInst(const RetInfo& cond, IfInfo& info) {
-  ostream& os = getInstance().setting.getOs();
-  switch (info.ty) {
-    case IfInfo::ifty_t::i:
-      info.then_label = branchCore.registerNewBB();
-      info.next_label = branchCore.registerNewBB();
-      os << setting.getIndentStr() << "br " << cond.GetInfo() << ", "
-         << getLabelName(info.then_label) << ", "
-         << getLabelName(info.next_label) << endl;
-      break;
-    case IfInfo::ifty_t::ie:
-    default:
-      info.then_label = branchCore.registerNewBB();
-      info.else_label = branchCore.registerNewBB();
-      info.next_label = branchCore.registerNewBB();
-      os << setting.getIndentStr() << "br " << cond.GetInfo() << ", "
-         << getLabelName(info.then_label) << ", "
-         << getLabelName(info.else_label) << endl;
-      break;
+void IRGenerator::WriteBrInst(const RetInfo& cond,
+                              const int& trueLabel,
+                              const int& falseLabel) {
+  if (cond.ty == RetInfo::ty_int) {
+    WriteJumpInst(cond.GetValue() != 0 ? trueLabel : falseLabel);
+    return;
   }
-  return;
+  rawCore.InsertInst(rawCore.NewBranch(
+      GetRawValue(cond), getLabelBB(trueLabel), getLabelBB(falseLabel)));
+}
+
+void IRGenerator::WriteShortCircuitBr(const RetInfo& cond,
+                                      const int& rhsLabel,
+                                      const int& nextLabel,
+                                      const int& shortValue) {
+  if (cond.ty == RetInfo::ty_int) {
+    if ((cond.GetValue() != 0) == (shortValue != 0))
+      WriteJumpInst(nextLabel, RetInfo(shortValue));
+    else
+      WriteJumpInst(rhsLabel);
+    return;
+  }
+  // 短路的一边带上实参
+  vector<const void*> args = {rawCore.NewInteger(shortValue)};
+  RawValue br;
+  if (shortValue != 0) {
+    br = rawCore.NewBranch(GetRawValue(cond), getLabelBB(nextLabel),
+                           getLabelBB(rhsLabel));
+    br->kind.data.branch.true_args =
+        rawCore.NewSlice(args, KOOPA_RSIK_VALUE);
+  } else {
+    br = rawCore.NewBranch(GetRawValue(cond), getLabelBB(rhsLabel),
+                           getLabelBB(nextLabel));
+    br->kind.data.branch.false_args =
+        rawCore.NewSlice(args, KOOPA_RSIK_VALUE);
+  }
+  rawCore.InsertInst(br);
 }
 
 void IRGenerator::WriteJumpInst(const int& labelID) {
@@ -830,8 +888,14 @@ void IRGenerator::WriteJumpInst(const int& labelID) {
 }
 
 void IRGenerator::WriteJumpInst(const string& labelName) {
-  ostream& os = getInstance().setting.getOs();
-  os << setting.getIndentStr() << "jump " << labelName << endl;
+  rawCore.InsertInst(rawCore.NewJump(rawCore.GetBasicBlock(labelName)));
+}
+
+void IRGenerator::WriteJumpInst(const int& labelID, const RetInfo& arg) {
+  RawValue jump = rawCore.NewJump(getLabelBB(labelID));
+  vector<const void*> args = {GetRawValue(arg)};
+  jump->kind.data.jump.args = rawCore.NewSlice(args, KOOPA_RSIK_VALUE);
+  rawCore.InsertInst(jump);
 }
 
 void IRGenerator::WriteLabel(const int& BBId) {
@@ -839,14 +903,18 @@ void IRGenerator::WriteLabel(const int& BBId) {
 }
 
 void IRGenerator::WriteLabel(const string& labelName) {
-  ostream& os = getInstance().setting.getOs();
-  os << "\n" << labelName << ":" << endl;
+  rawCore.InsertBasicBlock(rawCore.GetBasicBlock(labelName));
   // 新块的开始
   branchCore.hasRetThisBB = false;
 }
 
-const string IRGenerator::registerShortCircuitVar() {
-  return string("if_") + to_string(registerNewVar());
+const RetInfo IRGenerator::WriteParamLabel(const int& labelID) {
+  RawBB bb = getLabelBB(labelID);
+  RawValue param = rawCore.NewBlockArgRef(0, rawCore.GetInt32Type());
+  vector<const void*> params = {param};
+  bb->params = rawCore.NewSlice(params, KOOPA_RSIK_VALUE);
+  WriteLabel(labelID);
+  return RetInfo(param);
 }
 
 #pragma endregion
@@ -855,15 +923,8 @@ const string IRGenerator::registerShortCircuitVar() {
 
 void IRGenerator::InitLoopInfo(LoopInfo& info) {
   info.cond_label = branchCore.registerNewBB();
-}
-
-void IRGenerator::WriteBrInst(const RetInfo& cond, LoopInfo& loopInfo) {
-  ostream& os = getInstance().setting.getOs();
-  loopInfo.body_label = branchCore.registerNewBB();
-  loopInfo.next_label = branchCore.registerNewBB();
-  os << setting.getIndentStr() << "br " << cond.GetInfo() << ", "
-     << getLabelName(loopInfo.body_label) << ", "
-     << getLabelName(loopInfo.next_label) << endl;
+  info.body_label = branchCore.registerNewBB();
+  info.next_label = branchCore.registerNewBB();
 }
 
 #pragma endregion
@@ -874,62 +935,37 @@ void IRGenerator::WriteBrInst(const RetInfo& cond, LoopInfo& loopInfo) {
 
 const RetInfo IRGenerator::WriteCallInst(const string& func_name,
                                          const vector<RetInfo>& params) {
-  auto& os = setting.getOs();
-  os << setting.getIndentStr();
-
   // 查函数表，保存值
-  bool hasRetValue = false;
-  string newSymbolName;
-  auto& funcTbl = funcCore.GetFuncTable();
-  if (funcTbl.at(func_name) == VarType::e_int) {
-    newSymbolName = getSymbolName(funcCore.registerNewSymbol());
-    os << newSymbolName << " = ";
-    hasRetValue = true;
-  }
-
-  int len = params.size();
-  os << "call @" << func_name << "(";
+  koopa_raw_function_t callee = funcCore.GetFuncTable().at(func_name);
 
-  for (int i = 0; i < len; i++) {
-    if (i != 0)
-      os << ", ";
-    os << params[i].GetInfo();
+  vector<koopa_raw_value_t> args;
+  for (auto& param : params) {
+    args.push_back(GetRawValue(param));
   }
+  koopa_raw_value_t call = rawCore.InsertInst(rawCore.NewCall(callee, args));
 
-  os << ")" << endl;
-
-  if (hasRetValue) {
-    return RetInfo(newSymbolName);
+  if (callee->ty->data.function.ret->tag == KOOPA_RTT_INT32) {
+    return RetInfo(call);
   } else {
     return RetInfo();
   }
 }
 
 void IRGenerator::WriteLibFuncDecl() {
-  auto& os = setting.getOs();
-  os <<
-      R"EOF(decl @getint(): i32
-decl @getch(): i32
-decl @getarray(*i32): i32
-decl @putint(i32)
-decl @putch(i32)
-decl @putarray(i32, *i32)
-decl @starttime()
-decl @stoptime())EOF"
-     << endl;
   funcCore.AddLibFuncs();
 }
 
 void IRGenerator::WriteGlobalVar(const SymbolTableEntry& entry,
                                  const RetInfo& init) {
-  auto& os = setting.getOs();
-  os << "global " << entry.GetAllocName() << " = alloc "
-     << GetVarType(entry.var_type) << ", ";
+  koopa_raw_value_t value;
   if (init.ty == RetInfo::ty_void) {
-    os << "zeroinit" << endl;
+    value = rawCore.NewZeroInit(rawCore.GetInt32Type());
   } else {
-    os << init.GetValue() << endl;
+    value = rawCore.NewInteger(init.GetValue());
   }
+  koopa_raw_value_t alloc = rawCore.NewGlobalAlloc(entry.GetAllocName(), value);
+  rawCore.AddGlobalValue(alloc);
+  symbolCore.SetAllocValue(entry, alloc);
 }
 
 #pragma endregion
@@ -939,65 +975,123 @@ void IRGenerator::WriteGlobalVar(const SymbolTableEntry& entry,
 void IRGenerator::WriteGlobalArrVar(const SymbolTableEntry& entry) {
   assert(entry.var_type == VarType::e_arr);
 
-  auto& os = setting.getOs();
   arrinitCore.global = true;
   auto init = arrinitCore.GetInits(entry.arr_info);
 
-  // 定义
-  os << "global " << entry.GetAllocName() << " = alloc "
-     << entry.arr_info.GetType() << ", ";
-
   // 初始化
+  koopa_raw_value_t value;
   if (arrinitCore.zero_init) {
     // 使用zeroinit
-    os << "zeroinit" << endl;
+    value = rawCore.NewZeroInit(entry.arr_info.GetType());
   } else {
-    stringstream ss;
-    arrinitCore.GetInitString(entry.arr_info, init, ss);
-    os << ss.str() << endl;
+    value = arrinitCore.GetInitAggregate(entry.arr_info, init, 0, init.size(),
+                                         0);
   }
 
+  // 定义
+  koopa_raw_value_t alloc = rawCore.NewGlobalAlloc(entry.GetAllocName(), value);
+  rawCore.AddGlobalValue(alloc);
+  symbolCore.SetAllocValue(entry, alloc);
+
   arrinitCore.Clear();
 }
 
+// 局部数组中0的个数超过这个值时，用循环清零
+static const int ZERO_FILL_THRESHOLD = 64;
+// 清零循环每轮store的个数
+static const int FILL_UNROLL = 4;
+
+void IRGenerator::WriteZeroFillLoop(koopa_raw_value_t first, const int& size) {
+  koopa_raw_value_t zero = rawCore.NewInteger(0);
+  // 凑不满一轮的放在最前面，直接store
+  int rest = size % FILL_UNROLL;
+  for (int i = 0; i < rest; i++) {
+    koopa_raw_value_t ptr = first;
+    if (i != 0)
+      ptr = rawCore.InsertInst(
+          rawCore.NewGetPtr(first, rawCore.NewInteger(i)));
+    rawCore.InsertInst(rawCore.NewStore(zero, ptr));
+  }
+  if (size == rest)
+    return;
+  koopa_raw_value_t base = first;
+  if (rest != 0)
+    base = rawCore.InsertInst(
+        rawCore.NewGetPtr(first, rawCore.NewInteger(rest)));
+
+  /*
+    倒着清零，循环条件就是下标本身
+    jump %fill(size - rest)
+  %fill(%i: i32):
+    %n = sub %i, 4
+    %p = getptr base, %n
+    store 0, %p
+    %p1 = getptr %p, 1
+    store 0, %p1
+    ...
+    br %n, %fill(%n), %next
+  %next:
+  */
+  int fill_label = branchCore.registerNewBB();
+  int next_label = branchCore.registerNewBB();
+  WriteJumpInst(fill_label, RetInfo(size - rest));
+
+  RetInfo index = WriteParamLabel(fill_label);
+  RetInfo next = WriteBinaryInst(index, RetInfo(FILL_UNROLL), OpID::BI_SUB);
+  koopa_raw_value_t ptr =
+      rawCore.InsertInst(rawCore.NewGetPtr(base, GetRawValue(next)));
+  rawCore.InsertInst(rawCore.NewStore(zero, ptr));
+  for (int i = 1; i < FILL_UNROLL; i++) {
+    koopa_raw_value_t ptr_i = rawCore.InsertInst(
+        rawCore.NewGetPtr(ptr, rawCore.NewInteger(i)));
+    rawCore.InsertInst(rawCore.NewStore(zero, ptr_i));
+  }
+
+  RawValue br = rawCore.NewBranch(GetRawValue(next), getLabelBB(fill_label),
+                                  getLabelBB(next_label));
+  vector<const void*> args = {GetRawValue(next)};
+  br->kind.data.branch.true_args = rawCore.NewSlice(args, KOOPA_RSIK_VALUE);
+  rawCore.InsertInst(br);
+  WriteLabel(next_label);
+}
+
 void IRGenerator::WriteAllocArrInst(const SymbolTableEntry& entry,
                                     const bool& has_init) {
   assert(entry.var_type == VarType::e_arr);
 
-  const string indent = setting.getIndentStr();
-  auto& os = setting.getOs();
   auto init = arrinitCore.GetInits(entry.arr_info);
   int size = entry.arr_info.GetSize();
 
   // 定义
-  os << indent << entry.GetAllocName() << " = alloc "
-     << entry.arr_info.GetType() << endl;
+  koopa_raw_value_t alloc = rawCore.InsertInst(
+      rawCore.NewAlloc(entry.GetAllocName(), entry.arr_info.GetType()));
+  symbolCore.SetAllocValue(entry, alloc);
 
   if (!has_init) {
     // 不初始化
   } else {
-    // 动态地址
     int dim = entry.arr_info.Dim();
-    vector<int> cur_addr(dim);
-
-    for (int i = 0; i < size; i++) {
-      const string addr_1 =
-          WriteGetPtrFromArrInt(entry.GetAllocName(), cur_addr);
-
-      os << indent << "store " << init[i].GetInfo() << ", " << addr_1 << endl;
-
-      // 更新地址
-      int j = dim - 1;
-      cur_addr[j]++;
-      // 不用检查第一维
-      for (; j > 0; j--) {
-        if (cur_addr[j] >= entry.arr_info.shape[j]) {
-          cur_addr[j - 1]++;
-          cur_addr[j] -= entry.arr_info.shape[j];
-        } else {
-          // 一次不满足就直接跳出
-          break;
-        }
+    // 0多时先整体清零，之后只store非0的元素
+    bool fill = size - (int)init.size() > ZERO_FILL_THRESHOLD;
+    if (fill) {
+      koopa_raw_value_t first =
+          WriteGetPtrFromArrInt(alloc, vector<int>(dim));
+      WriteZeroFillLoop(first, size);
+      for (const auto& [index, value] : init) {
+        koopa_raw_value_t addr_1 =
+            WriteGetPtrFromArrInt(alloc, entry.arr_info.GetAddr(index));
+        rawCore.InsertInst(rawCore.NewStore(GetRawValue(value), addr_1));
+      }
+    } else {
+      // 所有元素都store，没记录的是0
+      size_t cur = 0;
+      for (int i = 0; i < size; i++) {
+        RetInfo value(0);
+        if (cur < init.size() && init[cur].first == i)
+          value = init[cur++].second;
+        koopa_raw_value_t addr_1 =
+            WriteGetPtrFromArrInt(alloc, entry.arr_info.GetAddr(i));
+        rawCore.InsertInst(rawCore.NewStore(GetRawValue(value), addr_1));
       }
     }
   }
@@ -1005,133 +1099,98 @@ void IRGenerator::WriteAllocArrInst(const SymbolTableEntry& entry,
   arrinitCore.Clear();
 }
 
-void IRGenerator::WriteGetelemptrInst(const string& symbol,
-                                      const string& arr_var,
-                                      const string& addr) const {
-  auto& os = setting.getOs();
-  const string indent = setting.getIndentStr();
-  os << indent << symbol << " = getelemptr " << arr_var << ", " << addr << endl;
+koopa_raw_value_t IRGenerator::WriteGetelemptrInst(koopa_raw_value_t arr_var,
+                                                   const RetInfo& addr) {
+  koopa_raw_value_t src = arr_var;
+  koopa_raw_value_t index = GetRawValue(addr);
+  return rawCore.InsertInst(rawCore.NewGetElemPtr(src, index));
 }
 
-const string IRGenerator::WriteGetPtrFromArr(const string& arr_var,
-                                             const vector<RetInfo>& addr) {
-  string addr_1 = getSymbolName(funcCore.registerNewSymbol());
-  string addr_2 = arr_var;
-
-  int len = addr.size();
-  for (int i = 0; i < len; i++) {
-    WriteGetelemptrInst(addr_1, addr_2, addr[i].GetInfo());
-    addr_2 = addr_1;
-    if (i != len - 1)
-      addr_1 = getSymbolName(funcCore.registerNewSymbol());
+koopa_raw_value_t IRGenerator::WriteGetPtrFromArr(koopa_raw_value_t arr_var,
+                                                  const vector<RetInfo>& addr) {
+  koopa_raw_value_t ptr = arr_var;
+  for (auto& index : addr) {
+    ptr = WriteGetelemptrInst(ptr, index);
   }
-  return addr_1;
+  return ptr;
 }
 
-const string IRGenerator::WriteGetPtrFromArrInt(const string& arr_var,
-                                                const vector<int>& addr) {
-  string addr_1 = getSymbolName(funcCore.registerNewSymbol());
-  string addr_2 = arr_var;
-  int len = addr.size();
-  for (int i = 0; i < len; i++) {
-    WriteGetelemptrInst(addr_1, addr_2, to_string(addr[i]));
-    addr_2 = addr_1;
-    if (i != len - 1)
-      addr_1 = getSymbolName(funcCore.registerNewSymbol());
+koopa_raw_value_t IRGenerator::WriteGetPtrFromArrInt(
+    koopa_raw_value_t arr_var,
+    const vector<int>& addr) {
+  koopa_raw_value_t ptr = arr_var;
+  for (auto& index : addr) {
+    ptr = WriteGetelemptrInst(ptr, RetInfo(index));
   }
-  return addr_1;
+  return ptr;
 }
 
 const RetInfo IRGenerator::WriteLoadArrInst(const SymbolTableEntry& entry,
                                             const vector<RetInfo>& addr) {
-  auto& os = setting.getOs();
-
-  const string addr_1 = WriteGetPtrFromArr(entry.GetAllocName(), addr);
-
-  const string ret = getSymbolName(funcCore.registerNewSymbol());
-  os << setting.getIndentStr() << ret << " = load " << addr_1 << endl;
-  return RetInfo(ret);
+  koopa_raw_value_t addr_1 =
+      WriteGetPtrFromArr(entry.GetAllocValue(), addr);
+  return RetInfo(rawCore.InsertInst(rawCore.NewLoad(addr_1)));
 }
 
 void IRGenerator::WriteStoreArrInst(const SymbolTableEntry& entry,
                                     const RetInfo& value,
                                     const vector<RetInfo>& addr) {
-  auto& os = setting.getOs();
-
-  const string addr_1 = WriteGetPtrFromArr(entry.GetAllocName(), addr);
-
-  const string ret = getSymbolName(funcCore.registerNewSymbol());
-  os << setting.getIndentStr() << "store " << value.GetInfo() << ", " << addr_1
-     << endl;
+  koopa_raw_value_t addr_1 =
+      WriteGetPtrFromArr(entry.GetAllocValue(), addr);
+  koopa_raw_value_t src = GetRawValue(value);
+  rawCore.InsertInst(rawCore.NewStore(src, addr_1));
   return;
 }
 
-void IRGenerator::WriteGetPtrInst(const string& symbol,
-                                  const string& arr_var,
-                                  const string& addr) const {
-  auto& os = setting.getOs();
-  const string indent = setting.getIndentStr();
-  os << indent << symbol << " = getptr " << arr_var << ", " << addr << endl;
+koopa_raw_value_t IRGenerator::WriteGetPtrInst(koopa_raw_value_t arr_var,
+                                               const RetInfo& addr) {
+  koopa_raw_value_t src = arr_var;
+  koopa_raw_value_t index = GetRawValue(addr);
+  return rawCore.InsertInst(rawCore.NewGetPtr(src, index));
 }
 
 void IRGenerator::WriteAllocPtrInst(const SymbolTableEntry& entry) {
   assert(entry.var_type == VarType::e_ptr);
-  auto& os = setting.getOs();
 
   // 定义
-  os << setting.getIndentStr() << entry.GetAllocName() << " = alloc "
-     << entry.arr_info.GetPtrType() << endl;
+  koopa_raw_value_t alloc = rawCore.InsertInst(
+      rawCore.NewAlloc(entry.GetAllocName(), entry.arr_info.GetPtrType()));
+  symbolCore.SetAllocValue(entry, alloc);
 }
 
-const string IRGenerator::WriteGetPtrFromPtr(const string& arr_var,
-                                             const vector<RetInfo>& addr) {
+koopa_raw_value_t IRGenerator::WriteGetPtrFromPtr(koopa_raw_value_t arr_var,
+                                                  const vector<RetInfo>& addr) {
   // 必须有坐标
   assert(addr.size() >= 1);
 
-  string addr_1 = getSymbolName(funcCore.registerNewSymbol());
-  string addr_2 = arr_var;
-
   // 先load
-  auto& os = setting.getOs();
-  const string indent = setting.getIndentStr();
-  os << indent << addr_1 << " = load " << addr_2 << endl;
-  addr_2 = addr_1;
-  addr_1 = getSymbolName(funcCore.registerNewSymbol());
+  koopa_raw_value_t ptr =
+      rawCore.InsertInst(rawCore.NewLoad(arr_var));
 
   int len = addr.size();
   for (int i = 0; i < len; i++) {
     if (i == 0)
-      WriteGetPtrInst(addr_1, addr_2, addr[0].GetInfo());
+      ptr = WriteGetPtrInst(ptr, addr[0]);
     else
-      WriteGetelemptrInst(addr_1, addr_2, addr[i].GetInfo());
-    addr_2 = addr_1;
-    if (i != len - 1)
-      addr_1 = getSymbolName(funcCore.registerNewSymbol());
+      ptr = WriteGetelemptrInst(ptr, addr[i]);
   }
-  return addr_1;
+  return ptr;
 }
 
 const RetInfo IRGenerator::WriteLoadPtrInst(const SymbolTableEntry& entry,
                                             const vector<RetInfo>& addr) {
-  auto& os = setting.getOs();
-
-  const string addr_1 = WriteGetPtrFromPtr(entry.GetAllocName(), addr);
-
-  const string ret = getSymbolName(funcCore.registerNewSymbol());
-  os << setting.getIndentStr() << ret << " = load " << addr_1 << endl;
-  return RetInfo(ret);
+  koopa_raw_value_t addr_1 =
+      WriteGetPtrFromPtr(entry.GetAllocValue(), addr);
+  return RetInfo(rawCore.InsertInst(rawCore.NewLoad(addr_1)));
 }
 
 void IRGenerator::WriteStorePtrInst(const SymbolTableEntry& entry,
                                     const RetInfo& value,
                                     const vector<RetInfo>& addr) {
-  auto& os = setting.getOs();
-
-  const string addr_1 = WriteGetPtrFromPtr(entry.GetAllocName(), addr);
-
-  const string ret = getSymbolName(funcCore.registerNewSymbol());
-  os << setting.getIndentStr() << "store " << value.GetInfo() << ", " << addr_1
-     << endl;
+  koopa_raw_value_t addr_1 =
+      WriteGetPtrFromPtr(entry.GetAllocValue(), addr);
+  koopa_raw_value_t src = GetRawValue(value);
+  rawCore.InsertInst(rawCore.NewStore(src, addr_1));
   return;
 }
 
@@ -1143,14 +1202,14 @@ const int IRGenerator::registerNewVar() {
 
 #pragma region private
 
-const string IRGenerator::getSymbolName(const int& symbol) const {
-  return string("%") + to_string(symbol);
-}
-
 const string IRGenerator::getLabelName(const int& bb_id) const {
   return string("%") + string("label_") + to_string(bb_id);
 }
 
+RawBB IRGenerator::getLabelBB(const int& bb_id) {
+  return rawCore.GetBasicBlock(getLabelName(bb_id));
+}
+
 int IRGenerator::calcConstExpr(const int& l, const int& r, OpID op) {
   switch (op) {
     case BI_ADD:
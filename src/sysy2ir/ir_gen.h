@@ -1,32 +1,39 @@
 #pragma once
 
+#include <algorithm>
 #include <cassert>
 #include <cstring>
 #include <deque>
+#include <functional>
 #include <iostream>
 #include <map>
 #include <sstream>
 #include <string>
+#include <unordered_map>
 #include <vector>
+#include "ir_intern.h"
+#include "ir_raw.h"
 #include "ir_util.h"
 #include "output_setting.h"
 
-using std::vector, std::map;
+using std::vector, std::map, std::pair;
 
 namespace ir {
+// 流式生成时接收一部分program的回调
+typedef std::function<void(const koopa_raw_program_t&)> UnitHandler;
+
 // 栈内元素类型
 
 // Tagged Enums
 struct RetInfo {
   enum retty_t { ty_void, ty_int, ty_sbl } ty;
   int value;
-  string name;
+  koopa_raw_value_t sym;
   RetInfo();
   RetInfo(int value);
-  RetInfo(string symbol);
+  RetInfo(koopa_raw_value_t symbol);
   const int& GetValue() const;
-  const string& GetSym() const;
-  const string GetInfo() const;
+  const koopa_raw_value_t& GetSym() const;
 };
 
 // if可能的类型：单if或if-else
@@ -55,16 +62,18 @@ struct ArrInfo {
   int size;
   ArrInfo();
   ArrInfo(const vector<int>& _shape);
-  // 获取koopa变量类型名称，如[i32, 2]
-  const string GetType() const;
-  // lv9-3 获取koopa指针变量类型名，如*i32, *[i32, 3]
-  const string GetPtrType() const;
+  // 获取koopa变量类型，如[i32, 2]
+  koopa_raw_type_t GetType() const;
+  // lv9-3 获取koopa指针变量类型，如*i32, *[i32, 3]
+  koopa_raw_type_t GetPtrType() const;
   // shape.len()
   const int Dim() const;
   // 获取大小，shape累乘
   const int GetSize() const;
   // 截取一个新的shape
   ArrInfo GetFrag(const int& begin, const int& end) const;
+  // 展平后的下标转成每一维的下标
+  const vector<int> GetAddr(int index) const;
 };
 
 // 数组初始化多叉树节点
@@ -79,6 +88,10 @@ struct ArrInitNode {
   ArrInitNode(const node_t& type);
 };
 
+// 稀疏的数组初始化值：(展平后的下标, 值)，下标递增
+// 常数0不记录，没出现的下标都是0
+typedef vector<pair<int, RetInfo>> ArrInits;
+
 #pragma region symbol
 
 class SymbolManager;
@@ -88,21 +101,18 @@ struct SymbolTableEntry {
   // 变量类型
   VarType var_type;
   // 懒得union
-  string var_name;
+  SymbolId symbol;
   int const_value;
   ArrInfo arr_info;
   int id;
 
   SymbolTableEntry();
+  // 变量名
+  const string& GetName() const;
   // @ + name
   const string GetAllocName() const;
-  // 声明的指令
-  const string GetAllocInst() const;
-  // 加载的指令
-  const string GetLoadInst(const string& loadToSymbolName) const;
-  // 赋值的指令
-  const string GetStoreInst(const string& storeFromSymbolName) const;
-  const string GetStoreInst(const int& imm) const;
+  // 声明时生成的alloc值，load和store都用它
+  koopa_raw_value_t GetAllocValue() const;
 };
 
 class BaseProcessor {
@@ -133,27 +143,32 @@ class DeclaimProcessor : public BaseProcessor {
   void SetVarType(const VarType& type);
   // 重置，在函数调用完后（重置变量池）
   void Reset();
+  // 全局变量声明完后调用，记下局部变量编号的起点
+  void MarkLocalBase();
+  // 开始生成函数时调用，每个函数的局部变量都从同一个起点编号
+  // 编号只和函数本身有关，函数并行生成时输出也不变
+  void ResetVarPool();
 
   // 生成常数变量表项
-  SymbolTableEntry GenerateConstEntry(const string& varName, const int& value);
+  SymbolTableEntry GenerateConstEntry(const SymbolId& symbol, const int& value);
 
   // 生成数组变量表项
   // 常数数组也调用：表项中不存储常数数组初始化信息，因为没必要
-  SymbolTableEntry GenerateArrEntry(const string& var_name,
+  SymbolTableEntry GenerateArrEntry(const SymbolId& symbol,
                                     const ArrInfo& info);
 
   // 生成指针变量表项
-  SymbolTableEntry GeneratePtrEntry(const string& var_name,
+  SymbolTableEntry GeneratePtrEntry(const SymbolId& symbol,
                                     const ArrInfo& ptr_info);
 
   // 生成无初始化的变量表项
-  SymbolTableEntry GenerateVarEntry(const string& varName,
+  SymbolTableEntry GenerateVarEntry(const SymbolId& symbol,
                                     const VarType& var_ty);
 
   // 即时生成表项，用于短路运算临时变量，不插入符号表
   SymbolTableEntry QuickGenEntry(const SymbolType& st,
                                  const VarType& vt,
-                                 string name);
+                                 const string& name);
 
   // 获取当前正在初始化的变量的类型（逻辑运算的编译时常数用）
   const SymbolType getCurSymType() const;
@@ -161,14 +176,17 @@ class DeclaimProcessor : public BaseProcessor {
   // 获取当前正在初始化的变量的类型（逻辑运算的编译时常数用）
   const VarType getCurVarType() const;
   const int RegisterVar();
+
+ private:
+  int local_base;
 };
 
 // 变量赋值处理器
 class AssignmentProcessor : public BaseProcessor {
  public:
   AssignmentProcessor();
-  // 保证在有值的时候才会用到
-  SymbolTableEntry current_var;
+  // 保证在有值的时候才会用到，指向符号表中的表项
+  const SymbolTableEntry* current_var;
   // 对数组变量赋值时的地址信息
   vector<RetInfo> arr_addr;
 
@@ -178,11 +196,12 @@ class AssignmentProcessor : public BaseProcessor {
 
 class SymbolTable {
  public:
-  // 表
-  map<string, SymbolTableEntry> table;
+  // 表，按标识符编号哈希，插入不会使已有表项失效
+  std::unordered_map<SymbolId, SymbolTableEntry> table;
   SymbolTable();
   // utility
-  bool TryGetEntry(string _symbol_name, SymbolTableEntry& out) const;
+  // 找不到返回nullptr
+  const SymbolTableEntry* FindEntry(const SymbolId& symbol) const;
   void InsertEntry(const SymbolTableEntry& entry);
   void ClearTable();
 
@@ -206,14 +225,25 @@ class SymbolManager {
   SymbolTable* currentTable;
 
   SymbolManager();
-  // 递归从当前的表向根表查询
-  const SymbolTableEntry getEntry(string symbolName);
+  // 记录变量声明时生成的alloc值
+  void SetAllocValue(const SymbolTableEntry& entry, koopa_raw_value_t value);
+  // 获取变量的alloc值
+  koopa_raw_value_t GetAllocValue(const SymbolTableEntry& entry) const;
+  // 递归从当前的表向根表查询，返回的引用在所在作用域弹出前有效
+  const SymbolTableEntry& getEntry(const SymbolId& symbol) const;
   // 向当前的表插入
   void InsertEntry(SymbolTableEntry entry);
   // 推入一个新表
   void PushScope();
   // 弹出一个表
   void PopScope();
+  // 复制other的根表和全局变量的alloc值
+  void CopyGlobals(const SymbolManager& other);
+
+ private:
+  // 变量ID到alloc值
+  // 表项在alloc之前就插入符号表了，所以alloc值单独存
+  map<int, koopa_raw_value_t> alloc_values;
 };
 
 #pragma endregion
@@ -260,21 +290,21 @@ class FuncManager {
   // 函数参数
   vector<SymbolTableEntry> params;
 
-  // 生成函数开头
+  // 生成函数声明，加入函数表
+  void WriteFuncDecl();
+  // 生成函数开头，函数必须已经声明过
   void WriteFuncPrologue();
   // 生成函数屁股
   void WriteFuncEpilogue();
   // 生成返回指令
   void WriteRetInst();
-  // 获取临时变量ID
-  const int registerNewSymbol();
   // 插入参数信息
-  void InsertParam(VarType ty, string name);
+  void InsertParam(VarType ty, const SymbolId& symbol);
   // 插入参数信息，数组用
   // 蛤蛤，大屎山来喽
   void InsertParam(const SymbolTableEntry& entry);
-  // 打印参数信息，在函数定义处
-  void WriteParamsDefine();
+  // 生成参数定义，在函数定义处
+  void WriteParamsDefine(vector<koopa_raw_type_t>& types);
   // 为参数分配新的变量，函数定义完后
   void WriteAllocParams();
   // 刷新状态
@@ -282,17 +312,23 @@ class FuncManager {
   // 设置返回值为函数对应返回值的默认retinfo
   void SetDefaultRetInfo();
   // 返回函数表
-  const map<string, VarType>& GetFuncTable() const;
+  const map<string, koopa_raw_function_t>& GetFuncTable() const;
   // 将库函数加入函数表
   void AddLibFuncs();
+  // 复制other的函数表
+  void CopyFuncTable(const FuncManager& other);
 
  private:
-  // 临时符号ID
-  int symbolPool;
-  // 函数表，包含函数名和返回值类型
-  // 返回值类型决定是否用符号存储其返回值
+  // 函数表，包含函数名和函数
+  // 函数返回值类型决定是否用符号存储其返回值
   // 不考虑参数，因为给定的程序语法一定正确
-  map<string, VarType> func_table;
+  map<string, koopa_raw_function_t> func_table;
+  // 函数参数对应的func_arg_ref
+  vector<koopa_raw_value_t> param_refs;
+  // 声明一个库函数
+  void AddLibFunc(const string& name,
+                  const vector<koopa_raw_type_t>& params,
+                  koopa_raw_type_t ret);
   // 参数特有名称name_p
   const string getParamVarName(const string& name) const;
 };
@@ -323,22 +359,29 @@ class ArrInitManager {
   // 初始化
   void Clear();
   // 给定目标arrsize，输出初始化信息
-  const vector<RetInfo> GetInits(const ArrInfo& shape);
-  // 给定初始化信息和数组shape，输出格式化的大括号表达式
-  void GetInitString(const ArrInfo& shape,
-                     const vector<RetInfo>& inits,
-                     stringstream& output);
+  const ArrInits GetInits(const ArrInfo& shape);
+  // 给定初始化信息和数组shape，输出对应的aggregate
+  // 只用到inits中[begin, end)的部分，offset是这个子数组的起始下标
+  // 全0的子数组用zeroinit，连续多个0元素合成一个[T, len]类型的zeroinit，
+  // 所以aggregate的元素个数可能比数组长度少
+  koopa_raw_value_t GetInitAggregate(const ArrInfo& shape,
+                                     const ArrInits& inits,
+                                     const int& begin,
+                                     const int& end,
+                                     const int& offset);
 
  private:
-  // 递归处理：给定arr node和数组的size
+  // 递归处理：给定arr node和数组的size，offset是这个子数组的起始下标
   void RecursionGetInits(const ArrInitNode& node,
                          const ArrInfo& shape,
-                         vector<RetInfo>& appendto,
+                         const int& offset,
+                         ArrInits& appendto,
                          bool first_layer);
 };
 
 #pragma endregion
 
+// 前端的全部状态，每个线程一份
 class IRGenerator {
  private:
   IRGenerator();
@@ -348,15 +391,29 @@ class IRGenerator {
 
  public:
   static IRGenerator& getInstance();
-  GenSettings setting;
 
+  RawProgramManager rawCore;
   SymbolManager symbolCore;
   BranchManager branchCore;
   FuncManager funcCore;
   ArrInitManager arrinitCore;
 
+  // 获取RetInfo对应的koopa值，立即数会生成integer
+  koopa_raw_value_t GetRawValue(const RetInfo& info);
+
+  // 流式生成时接收每一部分program，为空时生成完整的program
+  UnitHandler unit_handler;
+  // 并行生成函数的线程数，流式生成时不并行
+  int jobs;
+  // 从主线程的生成器复制全局符号表和函数表，之后可以独立生成函数
+  void ForkFrom(const IRGenerator& other);
+  // 把上次之后生成的全局变量和函数交给unit_handler，然后释放函数体
+  void FlushUnit();
+
 #pragma region lv3
 
+  // 生成函数声明
+  void WriteFuncDecl();
   // 生成函数开头
   void WriteFuncPrologue();
   // 生成函数屁股
@@ -388,27 +445,35 @@ class IRGenerator {
 
 #pragma region lv6
 
-  // 生成块开头（仅标签）
-  void WriteBasicBlockPrologue(const int& bb_id);
-  // 生成if判断指令（br），label存在Ifinfo中
-  void WriteBrInst(const RetInfo& cond, IfInfo& info);
+  // 初始化IfInfo，按类型分配then、else、next的label
+  void InitIfInfo(IfInfo& info);
+  // 生成条件跳转（br），cond是常数时直接跳到对应的块
+  void WriteBrInst(const RetInfo& cond,
+                   const int& trueLabel,
+                   const int& falseLabel);
+  // 短路求值：cond的真假等于shortValue（0或1）时带着shortValue跳到next，
+  // 否则跳到rhs继续求值
+  void WriteShortCircuitBr(const RetInfo& cond,
+                           const int& rhsLabel,
+                           const int& nextLabel,
+                           const int& shortValue);
   // 生成无条件跳转
   void WriteJumpInst(const int& labelID);
   void WriteJumpInst(const string& labelName);
+  // 带一个实参的无条件跳转
+  void WriteJumpInst(const int& labelID, const RetInfo& arg);
   // 生成标签（%label_n: ）并刷新块返回状态，进入新块
   void WriteLabel(const int& labelID);
   void WriteLabel(const string& labelName);
-  // 生成一个用于短路的变量名
-  const string registerShortCircuitVar();
+  // 生成带一个i32参数的标签，返回这个参数
+  const RetInfo WriteParamLabel(const int& labelID);
 
 #pragma endregion
 
 #pragma region lv7
 
-  // 初始化LoopInfo（设置cond label）
+  // 初始化LoopInfo（分配cond、body、next的label）
   void InitLoopInfo(LoopInfo& info);
-  // 生成while相关跳转指令（br），label存在loopInfo中
-  void WriteBrInst(const RetInfo& cond, LoopInfo& loopInfo);
 
 #pragma endregion
 
@@ -430,22 +495,23 @@ class IRGenerator {
 
   // 生成局部数组变量定义
   void WriteAllocArrInst(const SymbolTableEntry& entry, const bool& has_init);
+  // 把从first开始的size个i32清零，整轮的部分展开成循环
+  void WriteZeroFillLoop(koopa_raw_value_t first, const int& size);
 
   // 生成getelemptr语句
   // 语法：{symbol} = getelemptr {arr_var}, {addr}
-  // 行为：取出arr_var[addr]的地址存入symbol
-  void WriteGetelemptrInst(const string& symbol,
-                           const string& arr_var,
-                           const string& addr) const;
+  // 行为：取出arr_var[addr]的地址，返回symbol
+  koopa_raw_value_t WriteGetelemptrInst(koopa_raw_value_t arr_var,
+                                        const RetInfo& addr);
 
   // 获取指向数组给定地址处的指针，并写下相关指令
-  const string WriteGetPtrFromArr(const string& arr_var,
-                                  const vector<RetInfo>& addr);
+  koopa_raw_value_t WriteGetPtrFromArr(koopa_raw_value_t arr_var,
+                                       const vector<RetInfo>& addr);
 
-  // 获取存放指向数组给定地址处的指针的变量名，并写下相关一连串指令
+  // 获取指向数组给定地址处的指针，并写下相关一连串指令
   // int版
-  const string WriteGetPtrFromArrInt(const string& arr_var,
-                                     const vector<int>& addr);
+  koopa_raw_value_t WriteGetPtrFromArrInt(koopa_raw_value_t arr_var,
+                                          const vector<int>& addr);
 
   // 生成从数组中load值的语句
   const RetInfo WriteLoadArrInst(const SymbolTableEntry& entry,
@@ -457,18 +523,17 @@ class IRGenerator {
                          const vector<RetInfo>& addr);
 
   // 生成getptr语句
-  // 语法：{symbol} = getelemptr {ptr_var}, {addr}
-  // 行为：取出ptr_var[addr]的地址存入symbol
-  void WriteGetPtrInst(const string& symbol,
-                       const string& arr_var,
-                       const string& addr) const;
+  // 语法：{symbol} = getptr {ptr_var}, {addr}
+  // 行为：取出ptr_var[addr]的地址，返回symbol
+  koopa_raw_value_t WriteGetPtrInst(koopa_raw_value_t arr_var,
+                                    const RetInfo& addr);
 
   // 生成指针变量函数参数定义
   void WriteAllocPtrInst(const SymbolTableEntry& entry);
 
   // 获取指向指针+index给定地址处的指针，并写下相关一连串指令
-  const string WriteGetPtrFromPtr(const string& arr_var,
-                                  const vector<RetInfo>& addr);
+  koopa_raw_value_t WriteGetPtrFromPtr(koopa_raw_value_t arr_var,
+                                       const vector<RetInfo>& addr);
 
   // 生成从指针中load值的语句
   const RetInfo WriteLoadPtrInst(const SymbolTableEntry& entry,
@@ -481,8 +546,9 @@ class IRGenerator {
 
  private:
   const int registerNewVar();
-  const string getSymbolName(const int& symbol) const;
   const string getLabelName(const int& bb_id) const;
+  // 获取标签对应的基本块
+  RawBB getLabelBB(const int& bb_id);
   // 计算常数表达式
   int calcConstExpr(const int& left, const int& right, OpID op);
 };
@@ -0,0 +1,42 @@
+#include "ir_intern.h"
+#include <cassert>
+#include <mutex>
+
+namespace ir {
+
+SymbolInterner::SymbolInterner() : ids(), names(), lock() {}
+
+SymbolInterner& SymbolInterner::getInstance() {
+  static SymbolInterner interner;
+  return interner;
+}
+
+SymbolId SymbolInterner::Intern(std::string_view name) {
+  {
+    std::shared_lock<std::shared_mutex> reader(lock);
+    auto it = ids.find(name);
+    if (it != ids.end())
+      return it->second;
+  }
+  std::unique_lock<std::shared_mutex> writer(lock);
+  // 加写锁之前可能已经被别的线程插入了
+  auto it = ids.find(name);
+  if (it != ids.end())
+    return it->second;
+  SymbolId id = names.size();
+  names.emplace_back(name);
+  ids.emplace(names.back(), id);
+  return id;
+}
+
+const std::string& SymbolInterner::GetName(const SymbolId& id) const {
+  std::shared_lock<std::shared_mutex> reader(lock);
+  assert(id >= 0 && id < (SymbolId)names.size());
+  return names[id];
+}
+
+const std::string& SymbolName(const SymbolId& id) {
+  return SymbolInterner::getInstance().GetName(id);
+}
+
+}  // namespace ir
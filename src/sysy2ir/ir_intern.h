@@ -0,0 +1,40 @@
+#pragma once
+
+#include <deque>
+#include <shared_mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+namespace ir {
+
+// 标识符的编号，同名标识符编号相同
+typedef int SymbolId;
+
+// 标识符驻留表，词法分析时把标识符换成编号，之后都按编号比较
+// 并行生成IR时还会插入临时变量名，读写都要加锁
+class SymbolInterner {
+ private:
+  SymbolInterner();
+  SymbolInterner(const SymbolInterner&) = delete;
+  SymbolInterner(const SymbolInterner&&) = delete;
+  SymbolInterner& operator=(const SymbolInterner&) = delete;
+
+  // 名字到编号，string_view指向names中的字符串
+  std::unordered_map<std::string_view, SymbolId> ids;
+  // 编号到名字，deque扩容不移动已有元素
+  std::deque<std::string> names;
+  mutable std::shared_mutex lock;
+
+ public:
+  static SymbolInterner& getInstance();
+
+  // 获取名字对应的编号，第一次出现时分配新编号
+  SymbolId Intern(std::string_view name);
+  const std::string& GetName(const SymbolId& id) const;
+};
+
+// 编号对应的名字
+const std::string& SymbolName(const SymbolId& id);
+
+}  // namespace ir
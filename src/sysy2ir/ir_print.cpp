@@ -0,0 +1,282 @@
+#include "ir_print.h"
+#include <cassert>
+#include <sstream>
+
+namespace ir {
+
+using std::stringstream;
+
+// 类型里i32的个数
+static size_t GetCellCount(koopa_raw_type_t ty) {
+  if (ty->tag == KOOPA_RTT_ARRAY)
+    return ty->data.array.len * GetCellCount(ty->data.array.base);
+  return 1;
+}
+
+// 运算符的koopa名称，顺序和koopa_raw_binary_op一致
+static const char* binary_op_names[] = {
+    "ne", "eq", "gt", "lt",  "ge",  "le",  "add", "sub", "mul",
+    "div", "mod", "and", "or", "xor", "shl", "shr", "sar"};
+
+RawPrinter::RawPrinter(ostream& os) : symbols() {
+  setting.setOs(os).setIndent(2);
+}
+
+void RawPrinter::PrintProgram(const koopa_raw_program_t& program) {
+  auto& os = setting.getOs();
+
+  // 库函数声明
+  for (size_t i = 0; i < program.funcs.len; ++i) {
+    auto func = reinterpret_cast<koopa_raw_function_t>(program.funcs.buffer[i]);
+    if (func->bbs.len != 0) {
+      continue;
+    }
+    os << "decl " << func->name << "(";
+    auto& params = func->ty->data.function.params;
+    for (size_t j = 0; j < params.len; ++j) {
+      if (j != 0)
+        os << ", ";
+      os << GetType(reinterpret_cast<koopa_raw_type_t>(params.buffer[j]));
+    }
+    os << ")";
+    koopa_raw_type_t ret = func->ty->data.function.ret;
+    if (ret->tag != KOOPA_RTT_UNIT) {
+      os << ": " << GetType(ret);
+    }
+    os << endl;
+  }
+  os << endl;
+
+  // 全局变量
+  for (size_t i = 0; i < program.values.len; ++i) {
+    PrintGlobalAlloc(
+        reinterpret_cast<koopa_raw_value_t>(program.values.buffer[i]));
+  }
+  os << endl;
+
+  // 函数定义
+  for (size_t i = 0; i < program.funcs.len; ++i) {
+    auto func = reinterpret_cast<koopa_raw_function_t>(program.funcs.buffer[i]);
+    if (func->bbs.len != 0) {
+      PrintFunc(func);
+    }
+  }
+}
+
+void RawPrinter::PrintGlobalAlloc(koopa_raw_value_t value) {
+  assert(value->kind.tag == KOOPA_RVT_GLOBAL_ALLOC);
+  koopa_raw_value_t init = value->kind.data.global_alloc.init;
+  setting.getOs() << "global " << value->name << " = alloc "
+                  << GetType(value->ty->data.pointer.base) << ", "
+                  << GetValue(init) << endl;
+}
+
+void RawPrinter::PrintFunc(koopa_raw_function_t func) {
+  auto& os = setting.getOs();
+  RegisterSymbols(func);
+
+  os << "fun " << func->name << "(";
+  for (size_t i = 0; i < func->params.len; ++i) {
+    auto param = reinterpret_cast<koopa_raw_value_t>(func->params.buffer[i]);
+    if (i != 0)
+      os << ", ";
+    os << GetValue(param) << ": " << GetType(param->ty);
+  }
+  os << ")";
+  koopa_raw_type_t ret = func->ty->data.function.ret;
+  if (ret->tag != KOOPA_RTT_UNIT) {
+    os << ": " << GetType(ret);
+  }
+  os << " {" << endl;
+
+  for (size_t i = 0; i < func->bbs.len; ++i) {
+    if (i != 0)
+      os << endl;
+    PrintBasicBlock(
+        reinterpret_cast<koopa_raw_basic_block_t>(func->bbs.buffer[i]));
+  }
+  os << "}\n" << endl;
+}
+
+void RawPrinter::PrintBasicBlock(koopa_raw_basic_block_t bb) {
+  auto& os = setting.getOs();
+  os << bb->name;
+  if (bb->params.len != 0) {
+    // 基本块参数
+    os << "(";
+    for (size_t i = 0; i < bb->params.len; ++i) {
+      auto param = reinterpret_cast<koopa_raw_value_t>(bb->params.buffer[i]);
+      if (i != 0)
+        os << ", ";
+      os << GetValue(param) << ": " << GetType(param->ty);
+    }
+    os << ")";
+  }
+  os << ":" << endl;
+
+  for (size_t i = 0; i < bb->insts.len; ++i) {
+    PrintInst(reinterpret_cast<koopa_raw_value_t>(bb->insts.buffer[i]));
+  }
+}
+
+void RawPrinter::PrintInst(koopa_raw_value_t inst) {
+  auto& os = setting.getOs();
+  const auto& kind = inst->kind;
+  os << setting.getIndentStr();
+  if (inst->ty->tag != KOOPA_RTT_UNIT) {
+    os << GetValue(inst) << " = ";
+  }
+
+  switch (kind.tag) {
+    case KOOPA_RVT_ALLOC:
+      os << "alloc " << GetType(inst->ty->data.pointer.base);
+      break;
+    case KOOPA_RVT_LOAD:
+      os << "load " << GetValue(kind.data.load.src);
+      break;
+    case KOOPA_RVT_STORE:
+      os << "store " << GetValue(kind.data.store.value) << ", "
+         << GetValue(kind.data.store.dest);
+      break;
+    case KOOPA_RVT_GET_PTR:
+      os << "getptr " << GetValue(kind.data.get_ptr.src) << ", "
+         << GetValue(kind.data.get_ptr.index);
+      break;
+    case KOOPA_RVT_GET_ELEM_PTR:
+      os << "getelemptr " << GetValue(kind.data.get_elem_ptr.src) << ", "
+         << GetValue(kind.data.get_elem_ptr.index);
+      break;
+    case KOOPA_RVT_BINARY:
+      os << binary_op_names[kind.data.binary.op] << " "
+         << GetValue(kind.data.binary.lhs) << ", "
+         << GetValue(kind.data.binary.rhs);
+      break;
+    case KOOPA_RVT_BRANCH:
+      os << "br " << GetValue(kind.data.branch.cond) << ", "
+         << GetTarget(kind.data.branch.true_bb, kind.data.branch.true_args)
+         << ", "
+         << GetTarget(kind.data.branch.false_bb, kind.data.branch.false_args);
+      break;
+    case KOOPA_RVT_JUMP:
+      os << "jump " << GetTarget(kind.data.jump.target, kind.data.jump.args);
+      break;
+    case KOOPA_RVT_CALL: {
+      os << "call " << kind.data.call.callee->name << "(";
+      auto& args = kind.data.call.args;
+      for (size_t i = 0; i < args.len; ++i) {
+        if (i != 0)
+          os << ", ";
+        os << GetValue(reinterpret_cast<koopa_raw_value_t>(args.buffer[i]));
+      }
+      os << ")";
+      break;
+    }
+    case KOOPA_RVT_RETURN:
+      os << "ret";
+      if (kind.data.ret.value != nullptr) {
+        os << " " << GetValue(kind.data.ret.value);
+      }
+      break;
+    default:
+      assert(false);
+  }
+  os << endl;
+}
+
+void RawPrinter::RegisterSymbols(koopa_raw_function_t func) {
+  symbols.clear();
+  int symbol_pool = 0;
+  for (size_t i = 0; i < func->bbs.len; ++i) {
+    auto bb = reinterpret_cast<koopa_raw_basic_block_t>(func->bbs.buffer[i]);
+    for (size_t j = 0; j < bb->params.len; ++j) {
+      auto param = reinterpret_cast<koopa_raw_value_t>(bb->params.buffer[j]);
+      if (param->name == nullptr) {
+        symbols.emplace(param, symbol_pool++);
+      }
+    }
+    for (size_t j = 0; j < bb->insts.len; ++j) {
+      auto inst = reinterpret_cast<koopa_raw_value_t>(bb->insts.buffer[j]);
+      if (inst->name == nullptr && inst->ty->tag != KOOPA_RTT_UNIT) {
+        symbols.emplace(inst, symbol_pool++);
+      }
+    }
+  }
+}
+
+const string RawPrinter::GetType(koopa_raw_type_t ty) const {
+  switch (ty->tag) {
+    case KOOPA_RTT_INT32:
+      return "i32";
+    case KOOPA_RTT_POINTER:
+      return "*" + GetType(ty->data.pointer.base);
+    case KOOPA_RTT_ARRAY:
+      return "[" + GetType(ty->data.array.base) + ", " +
+             std::to_string(ty->data.array.len) + "]";
+    default:
+      // unit和函数类型不会单独出现
+      assert(false);
+      return "";
+  }
+}
+
+const string RawPrinter::GetValue(koopa_raw_value_t value) const {
+  const auto& kind = value->kind;
+  switch (kind.tag) {
+    case KOOPA_RVT_INTEGER:
+      return std::to_string(kind.data.integer.value);
+    case KOOPA_RVT_ZERO_INIT:
+      return "zeroinit";
+    case KOOPA_RVT_UNDEF:
+      return "undef";
+    case KOOPA_RVT_AGGREGATE: {
+      stringstream ss;
+      ss << "{";
+      auto& elems = kind.data.aggregate.elems;
+      auto base = value->ty->data.array.base;
+      bool first = true;
+      for (size_t i = 0; i < elems.len; ++i) {
+        auto elem = reinterpret_cast<koopa_raw_value_t>(elems.buffer[i]);
+        // 连续的0元素合成了一个zeroinit，文本里要展开
+        size_t count = 1;
+        if (elem->kind.tag == KOOPA_RVT_ZERO_INIT)
+          count = GetCellCount(elem->ty) / GetCellCount(base);
+        for (size_t j = 0; j < count; ++j) {
+          if (!first)
+            ss << ", ";
+          first = false;
+          if (count > 1 && base->tag == KOOPA_RTT_INT32)
+            ss << "0";
+          else if (count > 1)
+            ss << "zeroinit";
+          else
+            ss << GetValue(elem);
+        }
+      }
+      ss << "}";
+      return ss.str();
+    }
+    default:
+      break;
+  }
+  if (value->name != nullptr) {
+    return value->name;
+  }
+  return "%" + std::to_string(symbols.at(value));
+}
+
+const string RawPrinter::GetTarget(koopa_raw_basic_block_t bb,
+                                   const koopa_raw_slice_t& args) const {
+  string ret = bb->name;
+  if (args.len != 0) {
+    ret += "(";
+    for (size_t i = 0; i < args.len; ++i) {
+      if (i != 0)
+        ret += ", ";
+      ret += GetValue(reinterpret_cast<koopa_raw_value_t>(args.buffer[i]));
+    }
+    ret += ")";
+  }
+  return ret;
+}
+
+}  // namespace ir
@@ -0,0 +1,40 @@
+#pragma once
+
+#include <iostream>
+#include <map>
+#include <string>
+#include "koopa.h"
+#include "output_setting.h"
+
+namespace ir {
+
+using std::string, std::map;
+
+// 把内存中的raw program打印成koopa文本，只在-koopa时使用
+class RawPrinter {
+ public:
+  RawPrinter(ostream& os);
+  void PrintProgram(const koopa_raw_program_t& program);
+
+ private:
+  GenSettings setting;
+  // 本函数中无名值的编号
+  map<koopa_raw_value_t, int> symbols;
+
+  void PrintGlobalAlloc(koopa_raw_value_t value);
+  void PrintFunc(koopa_raw_function_t func);
+  void PrintBasicBlock(koopa_raw_basic_block_t bb);
+  void PrintInst(koopa_raw_value_t inst);
+
+  // 给函数中所有无名的非unit值编号，%0, %1, ...
+  void RegisterSymbols(koopa_raw_function_t func);
+  // 类型名，如i32, *[i32, 3]
+  const string GetType(koopa_raw_type_t ty) const;
+  // 值的引用：常数、名字或编号
+  const string GetValue(koopa_raw_value_t value) const;
+  // 跳转目标，如%label_0, %label_1(%2, 3)
+  const string GetTarget(koopa_raw_basic_block_t bb,
+                         const koopa_raw_slice_t& args) const;
+};
+
+}  // namespace ir
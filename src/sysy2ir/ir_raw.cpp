@@ -0,0 +1,372 @@
+#include "ir_raw.h"
+
+namespace ir {
+
+RawProgramManager::RawProgramManager()
+    : taken_values(0),
+      taken_funcs(0),
+      func_mark(),
+      cur_func(nullptr),
+      cur_bb(nullptr) {
+  types.push_back({});
+  types.back().tag = KOOPA_RTT_INT32;
+  int32_type = &types.back();
+  types.push_back({});
+  types.back().tag = KOOPA_RTT_UNIT;
+  unit_type = &types.back();
+}
+
+#pragma region type
+
+koopa_raw_type_t RawProgramManager::GetInt32Type() {
+  return int32_type;
+}
+
+koopa_raw_type_t RawProgramManager::GetUnitType() {
+  return unit_type;
+}
+
+koopa_raw_type_t RawProgramManager::GetPointerType(koopa_raw_type_t base) {
+  types.push_back({});
+  koopa_raw_type_kind_t& ty = types.back();
+  ty.tag = KOOPA_RTT_POINTER;
+  ty.data.pointer.base = base;
+  return &ty;
+}
+
+koopa_raw_type_t RawProgramManager::GetArrayType(koopa_raw_type_t base,
+                                                 size_t len) {
+  types.push_back({});
+  koopa_raw_type_kind_t& ty = types.back();
+  ty.tag = KOOPA_RTT_ARRAY;
+  ty.data.array.base = base;
+  ty.data.array.len = len;
+  return &ty;
+}
+
+koopa_raw_type_t RawProgramManager::GetFuncType(
+    const vector<koopa_raw_type_t>& params,
+    koopa_raw_type_t ret) {
+  vector<const void*> items(params.begin(), params.end());
+  types.push_back({});
+  koopa_raw_type_kind_t& ty = types.back();
+  ty.tag = KOOPA_RTT_FUNCTION;
+  ty.data.function.params = NewSlice(items, KOOPA_RSIK_TYPE);
+  ty.data.function.ret = ret;
+  return &ty;
+}
+
+#pragma endregion
+
+#pragma region memory
+
+const char* RawProgramManager::NewName(const string& name) {
+  names.push_back(name);
+  return names.back().c_str();
+}
+
+koopa_raw_slice_t RawProgramManager::NewSlice(
+    const vector<const void*>& items,
+    koopa_raw_slice_item_kind_t kind) {
+  koopa_raw_slice_t slice;
+  slice.kind = kind;
+  slice.len = items.size();
+  if (items.empty()) {
+    slice.buffer = nullptr;
+  } else {
+    // deque扩容不会移动已有元素，buffer一直有效
+    slices.push_back(items);
+    slice.buffer = slices.back().data();
+  }
+  return slice;
+}
+
+koopa_raw_slice_t RawProgramManager::NewSlice(
+    koopa_raw_slice_item_kind_t kind) {
+  koopa_raw_slice_t slice;
+  slice.buffer = nullptr;
+  slice.len = 0;
+  slice.kind = kind;
+  return slice;
+}
+
+#pragma endregion
+
+#pragma region value
+
+RawValue RawProgramManager::NewValue(koopa_raw_value_tag_t tag,
+                                     koopa_raw_type_t ty) {
+  values.push_back({});
+  RawValue value = &values.back();
+  value->ty = ty;
+  value->name = nullptr;
+  // 使用关系由需要的pass自行计算
+  value->used_by = NewSlice(KOOPA_RSIK_VALUE);
+  value->kind.tag = tag;
+  return value;
+}
+
+RawValue RawProgramManager::NewInteger(int value) {
+  RawValue v = NewValue(KOOPA_RVT_INTEGER, int32_type);
+  v->kind.data.integer.value = value;
+  return v;
+}
+
+RawValue RawProgramManager::NewZeroInit(koopa_raw_type_t ty) {
+  return NewValue(KOOPA_RVT_ZERO_INIT, ty);
+}
+
+RawValue RawProgramManager::NewAggregate(
+    const vector<koopa_raw_value_t>& elems,
+    koopa_raw_type_t ty) {
+  vector<const void*> items(elems.begin(), elems.end());
+  RawValue v = NewValue(KOOPA_RVT_AGGREGATE, ty);
+  v->kind.data.aggregate.elems = NewSlice(items, KOOPA_RSIK_VALUE);
+  return v;
+}
+
+RawValue RawProgramManager::NewUndef(koopa_raw_type_t ty) {
+  return NewValue(KOOPA_RVT_UNDEF, ty);
+}
+
+RawValue RawProgramManager::NewFuncArgRef(size_t index,
+                                          koopa_raw_type_t ty,
+                                          const string& name) {
+  RawValue v = NewValue(KOOPA_RVT_FUNC_ARG_REF, ty);
+  v->name = NewName(name);
+  v->kind.data.func_arg_ref.index = index;
+  return v;
+}
+
+RawValue RawProgramManager::NewBlockArgRef(size_t index,
+                                           koopa_raw_type_t ty) {
+  RawValue v = NewValue(KOOPA_RVT_BLOCK_ARG_REF, ty);
+  v->kind.data.block_arg_ref.index = index;
+  return v;
+}
+
+RawValue RawProgramManager::NewGlobalAlloc(const string& name,
+                                           koopa_raw_value_t init) {
+  RawValue v = NewValue(KOOPA_RVT_GLOBAL_ALLOC, GetPointerType(init->ty));
+  v->name = NewName(name);
+  v->kind.data.global_alloc.init = init;
+  return v;
+}
+
+RawValue RawProgramManager::NewAlloc(const string& name,
+                                     koopa_raw_type_t base) {
+  RawValue v = NewValue(KOOPA_RVT_ALLOC, GetPointerType(base));
+  v->name = NewName(name);
+  return v;
+}
+
+RawValue RawProgramManager::NewLoad(koopa_raw_value_t src) {
+  RawValue v = NewValue(KOOPA_RVT_LOAD, src->ty->data.pointer.base);
+  v->kind.data.load.src = src;
+  return v;
+}
+
+RawValue RawProgramManager::NewStore(koopa_raw_value_t value,
+                                     koopa_raw_value_t dest) {
+  RawValue v = NewValue(KOOPA_RVT_STORE, unit_type);
+  v->kind.data.store.value = value;
+  v->kind.data.store.dest = dest;
+  return v;
+}
+
+RawValue RawProgramManager::NewGetPtr(koopa_raw_value_t src,
+                                      koopa_raw_value_t index) {
+  RawValue v = NewValue(KOOPA_RVT_GET_PTR, src->ty);
+  v->kind.data.get_ptr.src = src;
+  v->kind.data.get_ptr.index = index;
+  return v;
+}
+
+RawValue RawProgramManager::NewGetElemPtr(koopa_raw_value_t src,
+                                          koopa_raw_value_t index) {
+  // *[T, n] -> *T
+  koopa_raw_type_t arr = src->ty->data.pointer.base;
+  RawValue v =
+      NewValue(KOOPA_RVT_GET_ELEM_PTR, GetPointerType(arr->data.array.base));
+  v->kind.data.get_elem_ptr.src = src;
+  v->kind.data.get_elem_ptr.index = index;
+  return v;
+}
+
+RawValue RawProgramManager::NewBinary(koopa_raw_binary_op_t op,
+                                      koopa_raw_value_t lhs,
+                                      koopa_raw_value_t rhs) {
+  RawValue v = NewValue(KOOPA_RVT_BINARY, int32_type);
+  v->kind.data.binary.op = op;
+  v->kind.data.binary.lhs = lhs;
+  v->kind.data.binary.rhs = rhs;
+  return v;
+}
+
+RawValue RawProgramManager::NewBranch(koopa_raw_value_t cond,
+                                      koopa_raw_basic_block_t true_bb,
+                                      koopa_raw_basic_block_t false_bb) {
+  RawValue v = NewValue(KOOPA_RVT_BRANCH, unit_type);
+  v->kind.data.branch.cond = cond;
+  v->kind.data.branch.true_bb = true_bb;
+  v->kind.data.branch.false_bb = false_bb;
+  v->kind.data.branch.true_args = NewSlice(KOOPA_RSIK_VALUE);
+  v->kind.data.branch.false_args = NewSlice(KOOPA_RSIK_VALUE);
+  return v;
+}
+
+RawValue RawProgramManager::NewJump(koopa_raw_basic_block_t target) {
+  RawValue v = NewValue(KOOPA_RVT_JUMP, unit_type);
+  v->kind.data.jump.target = target;
+  v->kind.data.jump.args = NewSlice(KOOPA_RSIK_VALUE);
+  return v;
+}
+
+RawValue RawProgramManager::NewCall(koopa_raw_function_t callee,
+                                    const vector<koopa_raw_value_t>& args) {
+  vector<const void*> items(args.begin(), args.end());
+  RawValue v = NewValue(KOOPA_RVT_CALL, callee->ty->data.function.ret);
+  v->kind.data.call.callee = callee;
+  v->kind.data.call.args = NewSlice(items, KOOPA_RSIK_VALUE);
+  return v;
+}
+
+RawValue RawProgramManager::NewReturn(koopa_raw_value_t value) {
+  RawValue v = NewValue(KOOPA_RVT_RETURN, unit_type);
+  v->kind.data.ret.value = value;
+  return v;
+}
+
+RawBB RawProgramManager::NewBasicBlock(const string& name) {
+  bbs.push_back({});
+  RawBB bb = &bbs.back();
+  bb->name = NewName(name);
+  bb->params = NewSlice(KOOPA_RSIK_VALUE);
+  bb->used_by = NewSlice(KOOPA_RSIK_VALUE);
+  bb->insts = NewSlice(KOOPA_RSIK_VALUE);
+  return bb;
+}
+
+RawFunc RawProgramManager::NewFunction(
+    const string& name,
+    koopa_raw_type_t ty,
+    const vector<koopa_raw_value_t>& params) {
+  vector<const void*> items(params.begin(), params.end());
+  funcs.push_back({});
+  RawFunc func = &funcs.back();
+  func->ty = ty;
+  func->name = NewName(name);
+  func->params = NewSlice(items, KOOPA_RSIK_VALUE);
+  func->bbs = NewSlice(KOOPA_RSIK_BASIC_BLOCK);
+  return func;
+}
+
+#pragma endregion
+
+#pragma region build
+
+void RawProgramManager::AddGlobalValue(koopa_raw_value_t value) {
+  global_values.push_back(value);
+}
+
+void RawProgramManager::AddFunction(RawFunc func) {
+  program_funcs.push_back(func);
+}
+
+void RawProgramManager::BeginFunction(RawFunc func) {
+  func_mark = {func,         types.size(),  values.size(),
+               bbs.size(),   names.size(),  slices.size()};
+  cur_func = func;
+  cur_bbs.clear();
+  cur_insts.clear();
+  cur_labels.clear();
+  cur_bb = nullptr;
+}
+
+RawBB RawProgramManager::GetBasicBlock(const string& name) {
+  auto it = cur_labels.find(name);
+  if (it != cur_labels.end()) {
+    return it->second;
+  }
+  RawBB bb = NewBasicBlock(name);
+  cur_labels.emplace(name, bb);
+  return bb;
+}
+
+void RawProgramManager::InsertBasicBlock(RawBB bb) {
+  cur_bbs.push_back(bb);
+  cur_bb = bb;
+}
+
+RawValue RawProgramManager::InsertInst(RawValue inst) {
+  cur_insts[cur_bb].push_back(inst);
+  return inst;
+}
+
+void RawProgramManager::EndFunction() {
+  vector<const void*> items;
+  for (RawBB bb : cur_bbs) {
+    bb->insts = NewSlice(cur_insts[bb], KOOPA_RSIK_VALUE);
+    items.push_back(bb);
+  }
+  cur_func->bbs = NewSlice(items, KOOPA_RSIK_BASIC_BLOCK);
+  cur_func = nullptr;
+  cur_bb = nullptr;
+}
+
+const koopa_raw_program_t RawProgramManager::GetProgram() {
+  koopa_raw_program_t program;
+  program.values = NewSlice(global_values, KOOPA_RSIK_VALUE);
+  program.funcs = NewSlice(program_funcs, KOOPA_RSIK_FUNCTION);
+  return program;
+}
+
+const koopa_raw_program_t RawProgramManager::TakePendingUnit() {
+  vector<const void*> unit_values(global_values.begin() + taken_values,
+                                  global_values.end());
+  vector<const void*> unit_funcs(program_funcs.begin() + taken_funcs,
+                                 program_funcs.end());
+  taken_values = global_values.size();
+  taken_funcs = program_funcs.size();
+
+  koopa_raw_program_t program;
+  program.values = NewSlice(unit_values, KOOPA_RSIK_VALUE);
+  program.funcs = NewSlice(unit_funcs, KOOPA_RSIK_FUNCTION);
+  return program;
+}
+
+void RawProgramManager::ReleaseFunction() {
+  if (func_mark.func == nullptr)
+    return;
+  // 函数的类型和参数在BeginFunction之前生成，调用者还要用
+  func_mark.func->bbs = NewSlice(KOOPA_RSIK_BASIC_BLOCK);
+  types.resize(func_mark.types);
+  values.resize(func_mark.values);
+  bbs.resize(func_mark.bbs);
+  names.resize(func_mark.names);
+  slices.resize(func_mark.slices);
+  func_mark = FuncMark();
+}
+
+void RawProgramManager::Adopt(RawProgramManager& other) {
+  // deque交换不移动元素，只交换内部的块
+  auto keep = std::make_unique<RawProgramManager>();
+  keep->types.swap(other.types);
+  keep->values.swap(other.values);
+  keep->bbs.swap(other.bbs);
+  keep->funcs.swap(other.funcs);
+  keep->names.swap(other.names);
+  keep->slices.swap(other.slices);
+  // other换到了新的int32和unit类型，之后还能接着用
+  std::swap(keep->int32_type, other.int32_type);
+  std::swap(keep->unit_type, other.unit_type);
+  for (auto& item : other.adopted) {
+    adopted.push_back(std::move(item));
+  }
+  other.adopted.clear();
+  adopted.push_back(std::move(keep));
+}
+
+#pragma endregion
+
+}  // namespace ir
@@ -0,0 +1,161 @@
+#pragma once
+
+#include <deque>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+#include "koopa.h"
+
+namespace ir {
+
+using std::string, std::vector, std::deque, std::map, std::unique_ptr;
+
+// raw结构体在koopa.h中都是const，自己构造的可以改
+typedef koopa_raw_value_data_t* RawValue;
+typedef koopa_raw_basic_block_data_t* RawBB;
+typedef koopa_raw_function_data_t* RawFunc;
+
+// 直接在内存中构造koopa raw program，不经过文本
+// 所有的类型、值、基本块、函数、slice都归它管，程序结束时统一释放
+class RawProgramManager {
+ public:
+  RawProgramManager();
+
+#pragma region type
+
+  koopa_raw_type_t GetInt32Type();
+  koopa_raw_type_t GetUnitType();
+  // *base
+  koopa_raw_type_t GetPointerType(koopa_raw_type_t base);
+  // [base, len]
+  koopa_raw_type_t GetArrayType(koopa_raw_type_t base, size_t len);
+  // (params): ret
+  koopa_raw_type_t GetFuncType(const vector<koopa_raw_type_t>& params,
+                               koopa_raw_type_t ret);
+
+#pragma endregion
+
+#pragma region memory
+
+  // 复制一份名字，生命周期和manager相同
+  const char* NewName(const string& name);
+  // 复制一份slice
+  koopa_raw_slice_t NewSlice(const vector<const void*>& items,
+                             koopa_raw_slice_item_kind_t kind);
+  koopa_raw_slice_t NewSlice(koopa_raw_slice_item_kind_t kind);
+
+#pragma endregion
+
+#pragma region value
+
+  // 生成一个值，不插入任何基本块
+  RawValue NewValue(koopa_raw_value_tag_t tag, koopa_raw_type_t ty);
+  RawValue NewInteger(int value);
+  RawValue NewZeroInit(koopa_raw_type_t ty);
+  RawValue NewAggregate(const vector<koopa_raw_value_t>& elems,
+                        koopa_raw_type_t ty);
+  RawValue NewUndef(koopa_raw_type_t ty);
+  RawValue NewFuncArgRef(size_t index,
+                         koopa_raw_type_t ty,
+                         const string& name);
+  // 基本块参数，不具名，打印时编号
+  RawValue NewBlockArgRef(size_t index, koopa_raw_type_t ty);
+  RawValue NewGlobalAlloc(const string& name, koopa_raw_value_t init);
+
+  RawValue NewAlloc(const string& name, koopa_raw_type_t base);
+  RawValue NewLoad(koopa_raw_value_t src);
+  RawValue NewStore(koopa_raw_value_t value, koopa_raw_value_t dest);
+  RawValue NewGetPtr(koopa_raw_value_t src, koopa_raw_value_t index);
+  RawValue NewGetElemPtr(koopa_raw_value_t src, koopa_raw_value_t index);
+  RawValue NewBinary(koopa_raw_binary_op_t op,
+                     koopa_raw_value_t lhs,
+                     koopa_raw_value_t rhs);
+  RawValue NewBranch(koopa_raw_value_t cond,
+                     koopa_raw_basic_block_t true_bb,
+                     koopa_raw_basic_block_t false_bb);
+  RawValue NewJump(koopa_raw_basic_block_t target);
+  RawValue NewCall(koopa_raw_function_t callee,
+                    const vector<koopa_raw_value_t>& args);
+  // value为nullptr时返回void
+  RawValue NewReturn(koopa_raw_value_t value);
+
+  RawBB NewBasicBlock(const string& name);
+  // 参数为func_arg_ref，bbs为空时是函数声明
+  RawFunc NewFunction(const string& name,
+                      koopa_raw_type_t ty,
+                      const vector<koopa_raw_value_t>& params);
+
+#pragma endregion
+
+#pragma region build
+
+  // 声明全局变量
+  void AddGlobalValue(koopa_raw_value_t value);
+  // 声明函数（定义或库函数声明）
+  void AddFunction(RawFunc func);
+
+  // 开始在函数中插入基本块
+  void BeginFunction(RawFunc func);
+  // 获取本函数中名为name的基本块，还没有就新建
+  RawBB GetBasicBlock(const string& name);
+  // 把基本块放在函数末尾，之后的指令插入到这个块中
+  void InsertBasicBlock(RawBB bb);
+  // 在当前基本块末尾插入指令
+  RawValue InsertInst(RawValue inst);
+  // 函数生成完毕，写回所有基本块和指令
+  void EndFunction();
+
+  // 获取生成的program
+  const koopa_raw_program_t GetProgram();
+
+  // 流式生成用
+  // 上次调用之后新加入的全局变量和函数
+  const koopa_raw_program_t TakePendingUnit();
+  // 释放最近一个函数的基本块、指令等内存，函数本身仍保留作为声明
+  // 开始生成函数之后分配的所有内存都会被释放，调用前后端必须已经处理完
+  void ReleaseFunction();
+
+  // 并行生成用
+  // 接管other分配的全部内存，已有的值、基本块等地址不变
+  void Adopt(RawProgramManager& other);
+
+#pragma endregion
+
+ private:
+  deque<koopa_raw_type_kind_t> types;
+  deque<koopa_raw_value_data_t> values;
+  deque<koopa_raw_basic_block_data_t> bbs;
+  deque<koopa_raw_function_data_t> funcs;
+  deque<string> names;
+  deque<vector<const void*>> slices;
+  // 从其他manager接管的内存
+  vector<unique_ptr<RawProgramManager>> adopted;
+
+  koopa_raw_type_t int32_type;
+  koopa_raw_type_t unit_type;
+
+  vector<const void*> global_values;
+  vector<const void*> program_funcs;
+  // 已经交出去的全局变量和函数个数
+  size_t taken_values;
+  size_t taken_funcs;
+
+  // BeginFunction时各个池的大小，ReleaseFunction时截断回去
+  struct FuncMark {
+    RawFunc func;
+    size_t types, values, bbs, names, slices;
+  } func_mark;
+
+  // 正在生成的函数
+  RawFunc cur_func;
+  // 函数中按顺序排列的基本块
+  vector<RawBB> cur_bbs;
+  // 每个基本块中的指令
+  map<RawBB, vector<const void*>> cur_insts;
+  // 标签名到基本块
+  map<string, RawBB> cur_labels;
+  RawBB cur_bb;
+};
+
+}  // namespace ir
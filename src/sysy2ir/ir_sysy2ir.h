@@ -6,10 +6,17 @@
 #include <sstream>
 #include <string>
 #include "ir_ast.h"
+#include "ir_print.h"
 
 using namespace std;
 
 namespace ir {
 /* core.cpp */
-string sysy2ir(const char* input, const char* output, bool output2file);
+// 生成内存中的raw program，jobs个线程并行生成函数
+const koopa_raw_program_t sysy2ir(const char* input, const int& jobs);
+// 流式生成，全局变量和每个函数生成完就交给handler
+// handler返回后函数体的内存被释放，不能再访问
+void sysy2ir(const char* input, const UnitHandler& handler);
+// 把raw program以文本形式写入文件，-koopa用
+void ir2file(const koopa_raw_program_t& program, const char* output);
 }  // namespace ir
\ No newline at end of file
@@ -2,64 +2,38 @@
 
 namespace ir {
 
-string BiOp2koopa(OpID id) {
-  const char* s;
+koopa_raw_binary_op_t BiOp2koopa(OpID id) {
   switch (id) {
     case BI_ADD:
-      s = "add";
-      break;
+      return KOOPA_RBO_ADD;
     case BI_SUB:
-      s = "sub";
-      break;
+      return KOOPA_RBO_SUB;
     case BI_MUL:
-      s = "mul";
-      break;
+      return KOOPA_RBO_MUL;
     case BI_DIV:
-      s = "div";
-      break;
+      return KOOPA_RBO_DIV;
     case BI_MOD:
-      s = "mod";
-      break;
+      return KOOPA_RBO_MOD;
     case LG_AND:
-      s = "and";
-      break;
+      return KOOPA_RBO_AND;
     case LG_OR:
-      s = "or";
-      break;
+      return KOOPA_RBO_OR;
     case LG_EQ:
-      s = "eq";
-      break;
+      return KOOPA_RBO_EQ;
     case LG_NEQ:
-      s = "ne";
-      break;
+      return KOOPA_RBO_NOT_EQ;
     case LG_LT:
-      s = "lt";
-      break;
+      return KOOPA_RBO_LT;
     case LG_LE:
-      s = "le";
-      break;
+      return KOOPA_RBO_LE;
     case LG_GT:
-      s = "gt";
-      break;
+      return KOOPA_RBO_GT;
     case LG_GE:
-      s = "ge";
-      break;
+      return KOOPA_RBO_GE;
     default:
-      s = "";
-      break;
+      assert(false);
+      return KOOPA_RBO_ADD;
   }
-  return string(s);
 }
 
-const string GetVarType(const VarType& ty) {
-  switch (ty) {
-    case VarType::e_int:
-      return string("i32");
-    case VarType::e_void:
-      return string("");
-    default:
-      return string("");
-  }
-}
-
-}  // namespace ir
\ No newline at end of file
+}  // namespace ir
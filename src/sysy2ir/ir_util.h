@@ -1,8 +1,10 @@
 #pragma once
 
+#include <cassert>
 #include <sstream>
 #include <string>
 #include <vector>
+#include "koopa.h"
 
 namespace ir {
 
@@ -32,7 +34,5 @@ enum OpID {
   LG_OR,
 };
 
-string BiOp2koopa(OpID id);
-
-const string GetVarType(const VarType& ty);
+koopa_raw_binary_op_t BiOp2koopa(OpID id);
 }  // namespace ir
\ No newline at end of file